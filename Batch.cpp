@@ -0,0 +1,415 @@
+#include "Batch.h"
+#include "ImageEncoders.h"
+#include "ShaderModuleLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+//-------------------------------------------------------------------------------------
+SBatchJob::SBatchJob()
+	: m_width(0)
+	, m_height(0)
+	, m_timeSeconds(0.0f)
+	, m_mouse(0.0f, 0.0f, 0.0f, 0.0f)
+	, m_compareThreshold(0)
+	, m_stopAtFirstFailure(false)
+	, m_line(0)
+{ }
+
+//-------------------------------------------------------------------------------------
+// Returns false at the end of the file. Line endings aren't kept.
+static bool ReadLine (FILE* file, std::string& line)
+{
+	line.clear();
+	int c;
+	while ((c = fgetc(file)) != EOF && c != '\n')
+	{
+		if (c != '\r')
+			line += (char)c;
+	}
+	return c != EOF || !line.empty();
+}
+
+//-------------------------------------------------------------------------------------
+static bool ParseFloat (const char* text, float& value)
+{
+	char* end;
+	value = strtof(text, &end);
+	return end != text && *end == 0;
+}
+
+//-------------------------------------------------------------------------------------
+// "x,y" or "x,y,z,w", like the components of iMouse
+static bool ParseMouse (const char* text, vec4& mouse)
+{
+	float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	size_t count = 0;
+	while (count < 4)
+	{
+		char* end;
+		values[count++] = strtof(text, &end);
+		if (end == text)
+			return false;
+		if (*end == 0)
+			break;
+		if (*end != ',')
+			return false;
+		text = end + 1;
+	}
+	if (count != 2 && count != 4)
+		return false;
+	mouse = vec4(values[0], values[1], values[2], values[3]);
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+static bool ParseSize (const char* text, long& width, long& height)
+{
+	char* end;
+	width = strtol(text, &end, 10);
+	if (end == text || (*end != 'x' && *end != 'X'))
+		return false;
+	text = end + 1;
+	height = strtol(text, &end, 10);
+	return end != text && *end == 0 && width > 0 && height > 0;
+}
+
+//-------------------------------------------------------------------------------------
+static bool ParseJobSetting (const std::string& token, SBatchJob& job)
+{
+	size_t equals = token.find('=');
+	if (equals == std::string::npos || equals + 1 == token.size())
+		return false;
+	std::string key = token.substr(0, equals);
+	const char* value = token.c_str() + equals + 1;
+
+	if (key == "shader")
+		job.m_shaderModuleFileName = strcmp(value, "-") ? value : "";
+	else if (key == "size")
+		return ParseSize(value, job.m_width, job.m_height);
+	else if (key == "time")
+		return ParseFloat(value, job.m_timeSeconds);
+	else if (key == "mouse")
+		return ParseMouse(value, job.m_mouse);
+	else if (key == "out")
+		job.m_outFileName = value;
+	else if (key == "ref")
+		job.m_referenceFileName = value;
+	else if (key == "threshold")
+	{
+		char* end;
+		job.m_compareThreshold = (int)strtol(value, &end, 10);
+		return *end == 0;
+	}
+	else
+		return false;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool LoadBatchManifest (const char* fileName, const SBatchJob& defaults, std::vector<SBatchJob>& jobs)
+{
+	FILE* file = fopen(fileName, "rt");
+	if (!file)
+	{
+		fprintf(stderr, "Could not open batch manifest %s\n", fileName);
+		return false;
+	}
+
+	jobs.clear();
+	bool ok = true;
+	std::string line;
+	for (size_t lineNumber = 1; ok && ReadLine(file, line); ++lineNumber)
+	{
+		SBatchJob job = defaults;
+		job.m_outFileName.clear();
+		job.m_referenceFileName.clear();
+		job.m_line = lineNumber;
+
+		bool anySettings = false;
+		size_t position = 0;
+		while (ok)
+		{
+			position = line.find_first_not_of(" \t", position);
+			if (position == std::string::npos || line[position] == '#')
+				break;
+			size_t end = std::min(line.find_first_of(" \t", position), line.size());
+			std::string token = line.substr(position, end - position);
+			position = end;
+
+			anySettings = true;
+			if (!ParseJobSetting(token, job))
+			{
+				fprintf(stderr, "%s(%zu): can't make sense of \"%s\"\n", fileName, lineNumber, token.c_str());
+				ok = false;
+			}
+		}
+		if (!ok || !anySettings)
+			continue;
+
+		if (job.m_outFileName.empty() && job.m_referenceFileName.empty())
+		{
+			fprintf(stderr, "%s(%zu): job has no out= file or ref= image\n", fileName, lineNumber);
+			ok = false;
+		}
+		else if (!job.m_outFileName.empty() && !FindImageEncoder(job.m_outFileName.c_str()))
+		{
+			fprintf(stderr, "%s(%zu): output file %s must be a %s\n", fileName, lineNumber, job.m_outFileName.c_str(), ImageEncoderExtensions());
+			ok = false;
+		}
+		else
+			jobs.push_back(job);
+	}
+	fclose(file);
+
+	if (ok && jobs.empty())
+	{
+		fprintf(stderr, "Batch manifest %s has no jobs\n", fileName);
+		ok = false;
+	}
+	return ok;
+}
+
+//-------------------------------------------------------------------------------------
+SFloatImage* SFramebufferPool::Acquire (long width, long height)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto sameSize = std::find_if(m_freeImages.begin(), m_freeImages.end(), [=](const SFloatImage* image)
+	{
+		return image->m_width == width && image->m_height == height;
+	});
+
+	// a free buffer of another size still saves an allocation if it's at least as big
+	if (sameSize == m_freeImages.end())
+	{
+		sameSize = std::max_element(m_freeImages.begin(), m_freeImages.end(), [](const SFloatImage* a, const SFloatImage* b)
+		{
+			return a->m_pixels.capacity() < b->m_pixels.capacity();
+		});
+	}
+
+	SFloatImage* image;
+	if (sameSize != m_freeImages.end())
+	{
+		image = *sameSize;
+		m_freeImages.erase(sameSize);
+	}
+	else
+	{
+		m_images.emplace_back(new SFloatImage);
+		image = m_images.back().get();
+	}
+	image->Resize(width, height);
+	return image;
+}
+
+//-------------------------------------------------------------------------------------
+void SFramebufferPool::Release (SFloatImage* image)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_freeImages.push_back(image);
+}
+
+//-------------------------------------------------------------------------------------
+size_t SFramebufferPool::GetNumAllocated () const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_images.size();
+}
+
+//-------------------------------------------------------------------------------------
+bool RunBatch (STaskScheduler& scheduler, const std::vector<SBatchJob>& jobs, const SRenderSettings& renderSettings, size_t jobsInFlight, SBatchResults& results)
+{
+	typedef std::chrono::steady_clock TClock;
+
+	results = SBatchResults();
+	results.m_jobs.resize(jobs.size());
+	results.m_jobsInFlight = std::max<size_t>(std::min(jobsInFlight, jobs.size()), 1);
+
+	// every module once, up front, so jobs sharing one share its code
+	std::map<std::string, std::unique_ptr<SShaderModuleLoader>> modules;
+	for (const SBatchJob& job : jobs)
+	{
+		if (job.m_shaderModuleFileName.empty() || modules.count(job.m_shaderModuleFileName))
+			continue;
+		std::unique_ptr<SShaderModuleLoader>& module = modules[job.m_shaderModuleFileName];
+		module.reset(new SShaderModuleLoader);
+		module->Load(job.m_shaderModuleFileName.c_str());
+	}
+
+	SRenderSettings jobSettings = renderSettings;
+	jobSettings.m_region = SRenderRegion();
+	jobSettings.m_progressiveLevels = 1;
+	jobSettings.m_costMap = nullptr;
+
+	SFramebufferPool framebuffers;
+	std::atomic<size_t> nextJob(0);
+
+	// each driver thread takes the next job and waits on its tiles and encoding; the
+	// shading itself all happens on the scheduler's threads
+	auto driveJobs = [&]()
+	{
+		SPassGraph graph;
+		for (size_t jobIndex = nextJob++; jobIndex < jobs.size(); jobIndex = nextJob++)
+		{
+			const SBatchJob& job = jobs[jobIndex];
+			SBatchJobResult& result = results.m_jobs[jobIndex];
+
+			// the job's passes, with its buffers starting from black
+			for (size_t pass = 0; pass < (size_t)EPass::Count; ++pass)
+				graph.DisablePass((EPass)pass);
+			if (job.m_shaderModuleFileName.empty())
+				DescribeShaderPasses(graph);
+			else
+			{
+				const SShaderModuleLoader& module = *modules.at(job.m_shaderModuleFileName);
+				if (!module.IsLoaded())
+					continue;
+				module.BindPasses(graph);
+			}
+			graph.Reset();
+
+			SRenderContext context = MakeRenderContext(job.m_width, job.m_height, job.m_timeSeconds);
+			context.m_iMouse = job.m_mouse;
+
+			// checked tile by tile as it renders
+			SImageComparison comparison;
+			SRenderSettings settings = jobSettings;
+			if (!job.m_referenceFileName.empty())
+			{
+				if (!comparison.LoadReference(job.m_referenceFileName.c_str()))
+				{
+					fprintf(stderr, "Could not load reference image %s\n", job.m_referenceFileName.c_str());
+					continue;
+				}
+				if (comparison.GetWidth() != job.m_width || comparison.GetHeight() != job.m_height)
+				{
+					fprintf(stderr, "Reference image %s is %ldx%ld, not %ldx%ld\n", job.m_referenceFileName.c_str(),
+						comparison.GetWidth(), comparison.GetHeight(), job.m_width, job.m_height);
+					continue;
+				}
+				comparison.m_threshold = job.m_compareThreshold;
+				comparison.m_stopAtFirstFailure = job.m_stopAtFirstFailure;
+				comparison.Reset();
+				settings.m_comparison = &comparison;
+			}
+
+			SFloatImage* image = framebuffers.Acquire(job.m_width, job.m_height);
+			TClock::time_point renderStart = TClock::now();
+			graph.Render(scheduler, *image, settings, context);
+			TClock::time_point saveStart = TClock::now();
+			bool saved = job.m_outFileName.empty() || SaveFloatImage(job.m_outFileName.c_str(), *image, &scheduler);
+			TClock::time_point saveEnd = TClock::now();
+			framebuffers.Release(image);
+
+			result.m_renderSeconds = std::chrono::duration<double>(saveStart - renderStart).count();
+			result.m_saveSeconds = std::chrono::duration<double>(saveEnd - saveStart).count();
+			result.m_compared = settings.m_comparison != nullptr;
+			if (result.m_compared)
+				result.m_comparison = comparison.GetResults();
+			result.m_succeeded = saved && (!result.m_compared || result.m_comparison.Passed());
+			if (!saved)
+				fprintf(stderr, "Could not write %s\n", job.m_outFileName.c_str());
+		}
+	};
+
+	TClock::time_point wallStart = TClock::now();
+	std::vector<std::thread> drivers;
+	for (size_t i = 1; i < results.m_jobsInFlight; ++i)
+		drivers.emplace_back(driveJobs);
+	driveJobs();
+	for (std::thread& driver : drivers)
+		driver.join();
+	results.m_wallSeconds = std::chrono::duration<double>(TClock::now() - wallStart).count();
+	results.m_framebuffersAllocated = framebuffers.GetNumAllocated();
+
+	return std::all_of(results.m_jobs.begin(), results.m_jobs.end(), [](const SBatchJobResult& result) { return result.m_succeeded; });
+}
+
+//-------------------------------------------------------------------------------------
+static double MegapixelsPerSecond (const SBatchJob& job, double seconds)
+{
+	return seconds > 0.0 ? double(job.m_width) * double(job.m_height) / seconds / 1e6 : 0.0;
+}
+
+//-------------------------------------------------------------------------------------
+static const char* ShaderName (const SBatchJob& job)
+{
+	return job.m_shaderModuleFileName.empty() ? "(built in)" : job.m_shaderModuleFileName.c_str();
+}
+
+//-------------------------------------------------------------------------------------
+void PrintBatchResults (FILE* file, const std::vector<SBatchJob>& jobs, const SBatchResults& results)
+{
+	fprintf(file, "line  %-24s %11s %8s %10s %8s %9s  output\n", "shader", "size", "time", "render ms", "Mpix/s", "save ms");
+
+	double pixels = 0.0;
+	size_t failed = 0;
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const SBatchJob& job = jobs[i];
+		const SBatchJobResult& result = results.m_jobs[i];
+		if (!result.m_succeeded && !result.m_compared)
+		{
+			fprintf(file, "%4zu  %-24s %5ldx%-5ld %8.3f %10s %8s %9s  %s\n", job.m_line, ShaderName(job),
+				job.m_width, job.m_height, job.m_timeSeconds, "failed", "", "", job.m_outFileName.c_str());
+			++failed;
+			continue;
+		}
+
+		fprintf(file, "%4zu  %-24s %5ldx%-5ld %8.3f %10.3f %8.2f %9.3f  %s\n", job.m_line, ShaderName(job),
+			job.m_width, job.m_height, job.m_timeSeconds, result.m_renderSeconds * 1e3,
+			MegapixelsPerSecond(job, result.m_renderSeconds), result.m_saveSeconds * 1e3, job.m_outFileName.c_str());
+		pixels += double(job.m_width) * double(job.m_height);
+
+		if (result.m_compared)
+		{
+			const SComparisonResults& comparison = result.m_comparison;
+			fprintf(file, "      %s %s: max error %d, mean error %.4f, PSNR %.2f dB%s\n", comparison.Passed() ? "matches" : "DIFFERS from",
+				job.m_referenceFileName.c_str(), comparison.m_maxError, comparison.MeanError(), comparison.PSNR(),
+				comparison.m_stoppedEarly ? ", stopped at the first failing tile" : "");
+		}
+		if (!result.m_succeeded)
+			++failed;
+	}
+
+	fprintf(file, "%zu jobs (%zu failed) in %.3f s, %.2f Mpixels/s overall, %zu at a time, %zu framebuffers allocated\n",
+		jobs.size(), failed, results.m_wallSeconds, results.m_wallSeconds > 0.0 ? pixels / results.m_wallSeconds / 1e6 : 0.0,
+		results.m_jobsInFlight, results.m_framebuffersAllocated);
+}
+
+//-------------------------------------------------------------------------------------
+bool WriteBatchReport (const char* fileName, const std::vector<SBatchJob>& jobs, const SBatchResults& results)
+{
+	FILE* file = fopen(fileName, "wt");
+	if (!file)
+		return false;
+
+	fprintf(file, "line,shader,width,height,time,mouseX,mouseY,mouseZ,mouseW,out,succeeded,renderSeconds,saveSeconds,megapixelsPerSecond,"
+		"ref,maxError,meanError,psnr\n");
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const SBatchJob& job = jobs[i];
+		const SBatchJobResult& result = results.m_jobs[i];
+		fprintf(file, "%zu,%s,%ld,%ld,%.9g,%.9g,%.9g,%.9g,%.9g,%s,%d,%.9g,%.9g,%.9g,",
+			job.m_line, job.m_shaderModuleFileName.c_str(), job.m_width, job.m_height, job.m_timeSeconds,
+			job.m_mouse.x, job.m_mouse.y, job.m_mouse.z, job.m_mouse.w, job.m_outFileName.c_str(),
+			result.m_succeeded ? 1 : 0, result.m_renderSeconds, result.m_saveSeconds,
+			MegapixelsPerSecond(job, result.m_renderSeconds));
+		if (result.m_compared)
+		{
+			fprintf(file, "%s,%d,%.9g,%.9g\n", job.m_referenceFileName.c_str(), result.m_comparison.m_maxError,
+				result.m_comparison.MeanError(), result.m_comparison.PSNR());
+		}
+		else
+			fprintf(file, ",,,\n");
+	}
+
+	bool ok = !ferror(file);
+	return fclose(file) == 0 && ok;
+}
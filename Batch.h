@@ -0,0 +1,99 @@
+#pragma once
+
+#include "FloatImage.h"
+#include "ImageCompare.h"
+#include "PassGraph.h"
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// One render of a batch: a shader at one set of uniforms, written to one file
+struct SBatchJob
+{
+	SBatchJob();
+
+	std::string m_shaderModuleFileName;     // empty for the built in shader
+	long m_width;
+	long m_height;
+	float m_timeSeconds;
+	vec4 m_mouse;
+	std::string m_outFileName;              // may be empty for jobs that are only compared
+
+	// a golden BMP to check the render against (see ImageCompare.h), or empty
+	std::string m_referenceFileName;
+	int m_compareThreshold;
+	bool m_stopAtFirstFailure;
+
+	size_t m_line;                          // of the manifest, for messages
+};
+
+//-------------------------------------------------------------------------------------
+// Read a batch manifest, one job per line made of key=value settings, e.g.
+//
+//     shader=water.so size=1920x1080 time=2.5 mouse=100,50,0,0 out=water_2.5.png
+//     shader=water.so size=640x360 ref=golden/water_640.bmp threshold=2
+//
+// A job needs an out file, a ref image to compare with, or both. Anything else left out
+// is taken from defaults, and shader=- is the built in shader. Blank lines and lines
+// starting with # are skipped. Returns false, after printing the line at fault, if the
+// manifest can't be read.
+bool LoadBatchManifest (const char* fileName, const SBatchJob& defaults, std::vector<SBatchJob>& jobs);
+
+//-------------------------------------------------------------------------------------
+// Float framebuffers handed out and taken back, so a batch allocates about as many as it
+// has jobs in flight rather than one per job. A buffer of the right size is reused
+// first, then any free buffer is resized. Thread safe.
+struct SFramebufferPool
+{
+	SFloatImage* Acquire (long width, long height);
+	void Release (SFloatImage* image);
+
+	size_t GetNumAllocated () const;
+
+private:
+	mutable std::mutex m_mutex;
+	std::vector<std::unique_ptr<SFloatImage>> m_images;
+	std::vector<SFloatImage*> m_freeImages;
+};
+
+//-------------------------------------------------------------------------------------
+struct SBatchJobResult
+{
+	SBatchJobResult()
+		: m_renderSeconds(0.0)
+		, m_saveSeconds(0.0)
+		, m_succeeded(false)
+		, m_compared(false)
+	{ }
+
+	double m_renderSeconds;     // from the job's first tile being queued to its last finishing
+	double m_saveSeconds;
+	bool m_succeeded;           // rendered, saved and (if it had a ref) matched
+
+	bool m_compared;
+	SComparisonResults m_comparison;
+};
+
+struct SBatchResults
+{
+	std::vector<SBatchJobResult> m_jobs;
+	double m_wallSeconds;
+	size_t m_jobsInFlight;
+	size_t m_framebuffersAllocated;
+};
+
+//-------------------------------------------------------------------------------------
+// Render and save every job on the one scheduler. jobsInFlight jobs run at once, so the
+// tiles of one job fill the threads that would otherwise idle at the end of another,
+// and the next job renders while the last one is being encoded. Each shader module is
+// loaded once for the whole batch. Region and progressive settings are ignored; every
+// job renders whole frames. Returns false if any job failed or didn't match its ref.
+bool RunBatch (STaskScheduler& scheduler, const std::vector<SBatchJob>& jobs, const SRenderSettings& renderSettings, size_t jobsInFlight, SBatchResults& results);
+
+void PrintBatchResults (FILE* file, const std::vector<SBatchJob>& jobs, const SBatchResults& results);
+
+// A CSV file with a row per job, replacing any file already there
+bool WriteBatchReport (const char* fileName, const std::vector<SBatchJob>& jobs, const SBatchResults& results);
@@ -0,0 +1,259 @@
+#include "Benchmark.h"
+#include "Settings.h"
+#include "SImageData.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+SBenchmarkSettings::SBenchmarkSettings()
+	: m_iterations(c_benchmarkIterations)
+	, m_warmupIterations(c_benchmarkWarmupIterations)
+	, m_timeRange(false)
+	, m_startSeconds(0.0f)
+	, m_endSeconds(0.0f)
+{ }
+
+//-------------------------------------------------------------------------------------
+// nearest rank percentile of sorted values
+static double Percentile (const std::vector<double>& sorted, double percent)
+{
+	if (sorted.empty())
+		return 0.0;
+	size_t rank = (size_t)ceil(percent / 100.0 * double(sorted.size()));
+	if (rank > 0)
+		--rank;
+	return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+//-------------------------------------------------------------------------------------
+static const char* RenderModeName (ERenderMode mode)
+{
+	return mode == ERenderMode::Packet ? "packet" : "scalar";
+}
+
+//-------------------------------------------------------------------------------------
+// How this harness was built, so runs of differently built ones can be told apart: eager
+// or lazy vector arithmetic (see GLSL_EXPRESSION_TEMPLATES), and whether the compiler was
+// optimizing, though not how far
+static const char* VectorArithmeticName () { return GLSL_EXPRESSION_TEMPLATES ? "lazy" : "eager"; }
+
+static bool IsOptimizedBuild ()
+{
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && !defined(_DEBUG))
+	return true;
+#else
+	return false;
+#endif
+}
+
+//-------------------------------------------------------------------------------------
+void RunBenchmark (STaskScheduler& scheduler, SPassGraph& passes, long width, long height, const SRenderSettings& renderSettings, float timeSeconds, const SBenchmarkSettings& benchmarkSettings, SBenchmarkResults& results)
+{
+	typedef std::chrono::steady_clock TClock;
+
+	results = SBenchmarkResults();
+	results.m_width = width;
+	results.m_height = height;
+	results.m_tileSize = renderSettings.m_tileSize;
+	results.m_mode = renderSettings.m_mode;
+	results.m_warmupIterations = benchmarkSettings.m_warmupIterations;
+
+	SImageData image;
+	AllocateImage(image, width, height);
+
+	size_t iterations = std::max<size_t>(benchmarkSettings.m_iterations, 1);
+	auto IterationTime = [&](size_t iteration)
+	{
+		if (!benchmarkSettings.m_timeRange || iterations < 2)
+			return benchmarkSettings.m_timeRange ? benchmarkSettings.m_startSeconds : timeSeconds;
+		float t = float(iteration) / float(iterations - 1);
+		return benchmarkSettings.m_startSeconds + (benchmarkSettings.m_endSeconds - benchmarkSettings.m_startSeconds) * t;
+	};
+
+	// warmups all render the first iteration's time so they exercise the same code paths
+	for (size_t i = 0; i < benchmarkSettings.m_warmupIterations; ++i)
+	{
+		SRenderContext context = MakeRenderContext(width, height, IterationTime(0));
+		passes.Render(scheduler, image, renderSettings, context);
+	}
+
+	// timed iterations start from the same buffer contents every run
+	passes.Reset();
+	scheduler.ResetThreadStats();
+	results.m_frameSeconds.reserve(iterations);
+
+	TClock::time_point wallStart = TClock::now();
+	for (size_t i = 0; i < iterations; ++i)
+	{
+		SRenderContext context = MakeRenderContext(width, height, IterationTime(i));
+		context.m_iFrame = (int)i;
+
+		TClock::time_point frameStart = TClock::now();
+		passes.Render(scheduler, image, renderSettings, context);
+		results.m_frameSeconds.push_back(std::chrono::duration<double>(TClock::now() - frameStart).count());
+	}
+	results.m_wallSeconds = std::chrono::duration<double>(TClock::now() - wallStart).count();
+
+	std::vector<double> sorted = results.m_frameSeconds;
+	std::sort(sorted.begin(), sorted.end());
+
+	double totalFrameSeconds = 0.0;
+	for (double seconds : sorted)
+		totalFrameSeconds += seconds;
+
+	double pixels = double(width) * double(height) * double(iterations);
+	results.m_megapixelsPerSecond = results.m_wallSeconds > 0.0 ? pixels / results.m_wallSeconds / 1e6 : 0.0;
+	results.m_meanFrameSeconds = totalFrameSeconds / double(iterations);
+	results.m_minFrameSeconds = sorted.front();
+	results.m_maxFrameSeconds = sorted.back();
+	results.m_p50FrameSeconds = Percentile(sorted, 50.0);
+	results.m_p95FrameSeconds = Percentile(sorted, 95.0);
+	results.m_p99FrameSeconds = Percentile(sorted, 99.0);
+
+	double busySeconds = 0.0;
+	for (const SThreadStats& stats : scheduler.GetThreadStats())
+	{
+		busySeconds += stats.m_busySeconds;
+		results.m_threadUtilization.push_back(results.m_wallSeconds > 0.0 ? stats.m_busySeconds / results.m_wallSeconds : 0.0);
+		results.m_threadTiles.push_back(stats.m_tasksRun);
+	}
+	results.m_busyNanosecondsPerPixel = busySeconds * 1e9 / pixels;
+}
+
+//-------------------------------------------------------------------------------------
+void PrintBenchmarkResults (FILE* file, const SBenchmarkResults& results)
+{
+	fprintf(file, "%ldx%ld %s, %zu threads, %zu pixel tiles, %zu iterations after %zu warmup\n",
+		results.m_width, results.m_height, RenderModeName(results.m_mode), results.m_threadUtilization.size(),
+		results.m_tileSize, results.m_frameSeconds.size(), results.m_warmupIterations);
+	fprintf(file, "  %s build, %s vector arithmetic\n", IsOptimizedBuild() ? "optimized" : "unoptimized", VectorArithmeticName());
+	fprintf(file, "  wall %.3f s, %.2f Mpixels/s, %.1f ns of thread time per pixel\n",
+		results.m_wallSeconds, results.m_megapixelsPerSecond, results.m_busyNanosecondsPerPixel);
+	fprintf(file, "  frame ms: mean %.3f  min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+		results.m_meanFrameSeconds * 1e3, results.m_minFrameSeconds * 1e3, results.m_p50FrameSeconds * 1e3,
+		results.m_p95FrameSeconds * 1e3, results.m_p99FrameSeconds * 1e3, results.m_maxFrameSeconds * 1e3);
+	for (size_t i = 0; i < results.m_threadUtilization.size(); ++i)
+		fprintf(file, "  thread %zu: %5.1f%% busy, %zu tiles\n", i, results.m_threadUtilization[i] * 100.0, results.m_threadTiles[i]);
+}
+
+//-------------------------------------------------------------------------------------
+static bool WriteJsonReport (FILE* file, const SBenchmarkResults& results)
+{
+	fprintf(file, "{\n");
+	fprintf(file, "  \"width\": %ld,\n  \"height\": %ld,\n", results.m_width, results.m_height);
+	fprintf(file, "  \"mode\": \"%s\",\n  \"tileSize\": %zu,\n", RenderModeName(results.m_mode), results.m_tileSize);
+	fprintf(file, "  \"threads\": %zu,\n", results.m_threadUtilization.size());
+	fprintf(file, "  \"optimized\": %s,\n  \"vectorArithmetic\": \"%s\",\n", IsOptimizedBuild() ? "true" : "false", VectorArithmeticName());
+	fprintf(file, "  \"iterations\": %zu,\n  \"warmupIterations\": %zu,\n", results.m_frameSeconds.size(), results.m_warmupIterations);
+	fprintf(file, "  \"wallSeconds\": %.9g,\n  \"megapixelsPerSecond\": %.9g,\n", results.m_wallSeconds, results.m_megapixelsPerSecond);
+	fprintf(file, "  \"busyNanosecondsPerPixel\": %.9g,\n", results.m_busyNanosecondsPerPixel);
+	fprintf(file, "  \"frameSeconds\": { \"mean\": %.9g, \"min\": %.9g, \"p50\": %.9g, \"p95\": %.9g, \"p99\": %.9g, \"max\": %.9g },\n",
+		results.m_meanFrameSeconds, results.m_minFrameSeconds, results.m_p50FrameSeconds,
+		results.m_p95FrameSeconds, results.m_p99FrameSeconds, results.m_maxFrameSeconds);
+
+	fprintf(file, "  \"threadUtilization\": [");
+	for (size_t i = 0; i < results.m_threadUtilization.size(); ++i)
+		fprintf(file, "%s%.6f", i > 0 ? ", " : "", results.m_threadUtilization[i]);
+	fprintf(file, "],\n  \"threadTiles\": [");
+	for (size_t i = 0; i < results.m_threadTiles.size(); ++i)
+		fprintf(file, "%s%zu", i > 0 ? ", " : "", results.m_threadTiles[i]);
+	fprintf(file, "],\n  \"samples\": [");
+	for (size_t i = 0; i < results.m_frameSeconds.size(); ++i)
+		fprintf(file, "%s%.9g", i > 0 ? ", " : "", results.m_frameSeconds[i]);
+	fprintf(file, "]\n}\n");
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+static const char* const c_csvHeader =
+	"width,height,mode,tileSize,threads,iterations,warmupIterations,wallSeconds,megapixelsPerSecond,"
+	"busyNanosecondsPerPixel,meanSeconds,minSeconds,p50Seconds,p95Seconds,p99Seconds,maxSeconds,"
+	"meanThreadUtilization,minThreadUtilization,optimized,vectorArithmetic";
+
+static bool WriteCsvRow (FILE* file, bool writeHeader, const SBenchmarkResults& results)
+{
+	double minUtilization = 1.0;
+	double meanUtilization = 0.0;
+	for (double utilization : results.m_threadUtilization)
+	{
+		minUtilization = std::min(minUtilization, utilization);
+		meanUtilization += utilization;
+	}
+	if (!results.m_threadUtilization.empty())
+		meanUtilization /= double(results.m_threadUtilization.size());
+	else
+		minUtilization = 0.0;
+
+	if (writeHeader)
+		fprintf(file, "%s\n", c_csvHeader);
+
+	fprintf(file, "%ld,%ld,%s,%zu,%zu,%zu,%zu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.6f,%.6f,%d,%s\n",
+		results.m_width, results.m_height, RenderModeName(results.m_mode), results.m_tileSize,
+		results.m_threadUtilization.size(), results.m_frameSeconds.size(), results.m_warmupIterations,
+		results.m_wallSeconds, results.m_megapixelsPerSecond, results.m_busyNanosecondsPerPixel,
+		results.m_meanFrameSeconds, results.m_minFrameSeconds, results.m_p50FrameSeconds,
+		results.m_p95FrameSeconds, results.m_p99FrameSeconds, results.m_maxFrameSeconds,
+		meanUtilization, minUtilization, IsOptimizedBuild() ? 1 : 0, VectorArithmeticName());
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+enum class ECsvFile
+{
+	New,        // doesn't exist or is empty, so needs the header
+	Matching,   // starts with this build's header, so rows can be appended
+	Different,  // has other columns, from an older or newer build
+};
+
+static ECsvFile CheckCsvFile (const char* fileName)
+{
+	FILE* existing = fopen(fileName, "rb");
+	if (!existing)
+		return ECsvFile::New;
+
+	// room for the header, its line ending and one more character to tell a longer line
+	std::string line(strlen(c_csvHeader) + 3, '\0');
+	bool empty = !fgets(&line[0], (int)line.size(), existing);
+	fclose(existing);
+	if (empty)
+		return ECsvFile::New;
+
+	line.resize(strcspn(line.c_str(), "\r\n"));
+	return line == c_csvHeader ? ECsvFile::Matching : ECsvFile::Different;
+}
+
+//-------------------------------------------------------------------------------------
+bool WriteBenchmarkReport (const char* fileName, const SBenchmarkResults& results)
+{
+	size_t length = strlen(fileName);
+	bool json = length >= 5 && !strcmp(fileName + length - 5, ".json");
+
+	// rows are only appended under the same columns. A .csv from a build with other ones
+	// is left alone, and the report goes in name_2.csv etc instead, the first that is new
+	// or has the same columns.
+	std::string reportName = fileName;
+	ECsvFile csvFile = json ? ECsvFile::New : CheckCsvFile(fileName);
+	for (int number = 2; csvFile == ECsvFile::Different; ++number)
+	{
+		std::string name = fileName;
+		size_t extension = name.find_last_of("./\\");
+		if (extension == std::string::npos || name[extension] != '.')
+			extension = name.size();
+		reportName = name.substr(0, extension) + "_" + std::to_string(number) + name.substr(extension);
+		csvFile = CheckCsvFile(reportName.c_str());
+	}
+	if (reportName != fileName)
+		fprintf(stderr, "%s has other columns, so the report is in %s\n", fileName, reportName.c_str());
+
+	bool writeHeader = !json && csvFile == ECsvFile::New;
+	FILE* file = fopen(reportName.c_str(), json ? "wt" : "at");
+	if (!file)
+		return false;
+
+	bool ok = json ? WriteJsonReport(file, results) : WriteCsvRow(file, writeHeader, results);
+	ok = !ferror(file) && ok;
+	return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "PassGraph.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+struct SBenchmarkSettings
+{
+	SBenchmarkSettings();
+
+	size_t m_iterations;
+	size_t m_warmupIterations;  // rendered first and left out of the statistics
+
+	// with a time range, iteration i is rendered at a time spread evenly from start to end
+	// (inclusive) so the whole animation is measured. Otherwise every iteration uses the
+	// single frame time.
+	bool m_timeRange;
+	float m_startSeconds;
+	float m_endSeconds;
+
+	// .json writes one object, anything else appends a row to a CSV file (header included
+	// when the file is new) so runs across commits can be compared
+	std::string m_reportFileName;
+};
+
+//-------------------------------------------------------------------------------------
+struct SBenchmarkResults
+{
+	long m_width;
+	long m_height;
+	size_t m_tileSize;
+	ERenderMode m_mode;
+	size_t m_warmupIterations;
+
+	std::vector<double> m_frameSeconds;  // one per measured iteration, in render order
+	double m_wallSeconds;
+	double m_megapixelsPerSecond;
+	double m_meanFrameSeconds;
+	double m_minFrameSeconds;
+	double m_maxFrameSeconds;
+	double m_p50FrameSeconds;
+	double m_p95FrameSeconds;
+	double m_p99FrameSeconds;
+	double m_busyNanosecondsPerPixel;  // thread time spent shading, divided by pixels shaded
+
+	std::vector<double> m_threadUtilization;  // fraction of the wall time each worker was busy
+	std::vector<size_t> m_threadTiles;
+};
+
+//-------------------------------------------------------------------------------------
+// Render every pass of width x height frames repeatedly on the scheduler and gather
+// timings. The images are discarded; nothing is written to disk.
+void RunBenchmark (STaskScheduler& scheduler, SPassGraph& passes, long width, long height, const SRenderSettings& renderSettings, float timeSeconds, const SBenchmarkSettings& benchmarkSettings, SBenchmarkResults& results);
+
+void PrintBenchmarkResults (FILE* file, const SBenchmarkResults& results);
+
+bool WriteBenchmarkReport (const char* fileName, const SBenchmarkResults& results);
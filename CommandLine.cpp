@@ -0,0 +1,412 @@
+#include "CommandLine.h"
+#include "ImageEncoders.h"
+#include "RenderCluster.h"
+#include "SImageData.h"
+#include "Settings.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------
+SCommandLine::SCommandLine()
+	: m_width((long)c_imageResolution[0])
+	, m_height((long)c_imageResolution[1])
+	, m_outFileName(s_outImageFileName)
+	, m_mapOutput(c_mapOutputFile)
+	, m_timeSeconds(c_timeSeconds)
+	, m_heatmapTopPixels(c_heatmapTopPixels)
+	, m_compareThreshold(c_compareThreshold)
+	, m_failFast(false)
+	, m_watch(false)
+	, m_numThreads(c_numThreads)
+	, m_pinThreads(false)
+	, m_reportShadedPixels(false)
+	, m_reportOpCounts(false)
+	, m_sequence(false)
+	, m_startSeconds(0.0f)
+	, m_endSeconds(0.0f)
+	, m_fps(30.0f)
+	, m_frameOutput(EFrameOutput::ImageFiles)
+	, m_writeQueueDepth(c_writeQueueDepth)
+	, m_reuseTiles(true)
+	, m_benchmark(false)
+	, m_batchJobsInFlight(c_batchJobsInFlight)
+	, m_workerPort(0)
+	, m_mathReport(false)
+{
+	m_renderSettings.m_tileSize = c_tileSize;
+	m_renderSettings.m_mode = c_packetMode ? ERenderMode::Packet : ERenderMode::Scalar;
+}
+
+//-------------------------------------------------------------------------------------
+static void PrintUsage (const char* exeName)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -out <file>                    output .bmp, .png, .pfm (float) or .exr (half). For sequences,\n"
+		"                                 a name with %%d in it or one that gets _<frame> added, or the\n"
+		"                                 y4m file\n"
+		"  -nomap                         write a single frame from memory instead of mapping the file\n"
+		"  -size <width> <height>         image resolution\n"
+		"  -time <seconds>                iGlobalTime of a single frame\n"
+		"  -region <x> <y> <w> <h>        only shade pixels in a rectangle (fragCoord, y up)\n"
+		"  -pixel <x> <y>                 only shade one pixel, to debug it\n"
+		"  -progressive [levels]          shade coarse to fine, writing the image after each level\n"
+		"  -supersample <max> [error]     antialias with up to max samples per pixel (a power of 2),\n"
+		"                                 adding them while a pixel's colour is noisier than error\n"
+		"  -sparse <step> [difference]    draft: shade every step'th pixel, then in full only where\n"
+		"                                 neighbouring ones differ by more than difference\n"
+		"  -shadedpixels                  print how many pixels were shaded\n"
+		"  -heatmap <file>                also save how long each pixel took to shade, as a .bmp\n"
+		"  -hotspots <count>              slowest pixels to list with -heatmap\n"
+		"  -opcounts                      count the ops a GPU would run per pixel, from the op counting\n"
+		"                                 build of the shader; -heatmap then shows ops instead of time\n"
+		"  -compare <file.bmp>            check the render against a reference image (at its size)\n"
+		"                                 and print max/mean error and PSNR instead of saving it\n"
+		"  -threshold <levels>            how far a channel may be off from the reference\n"
+		"  -failfast                      stop rendering at the first tile that doesn't match\n"
+		"  -diff <file.bmp>               save where the render and reference differ\n"
+		"  -shader <module>               render a shader built with ShaderModule.cpp (.dll or .so),\n"
+		"                                 reloading it between frames when it is rebuilt\n"
+		"  -watch                         keep rendering the frame again each time the module changes\n"
+		"  -sequence <start> <end> <fps>  render frames from start up to end seconds\n"
+		"  -y4m                           write a sequence as one y4m stream, -out - for stdout\n"
+		"  -queue <frames>                frames that may wait on the writer thread\n"
+		"  -noreuse                       shade every tile of every frame of a sequence, rather than\n"
+		"                                 keeping tiles that read no uniform that changed\n"
+		"  -threads <count>               render threads, 0 for one per hardware thread\n"
+		"  -pin                           pin each render thread to its own core\n"
+		"  -tile <pixels>                 tile width and height\n"
+		"  -scalar                        shade one pixel per mainImage() call\n"
+		"  -packet                        shade a SIMD packet of pixels per call\n"
+		"  -generic                       don't use the kernels compiled for fixed frame sizes\n"
+		"  -benchmark [iterations]        time repeated renders instead of saving an image\n"
+		"  -warmup <iterations>           untimed renders before a benchmark\n"
+		"  -benchtime <start> <end>       spread benchmark iterations over a time range\n"
+		"  -report <file>                 benchmark summary, .json or appended to a .csv; for -batch,\n"
+		"                                 a .csv of every job's timings\n"
+		"  -batch <manifest>              render the jobs of a manifest, one per line, e.g.\n"
+		"                                 shader=a.so size=640x360 time=1.5 mouse=10,20 out=a.png\n"
+		"  -jobs <count>                  batch jobs rendering at once\n"
+		"  -workers <host:port>,...       render on worker processes, spreading tiles over them\n"
+		"  -worker <port> [address]       be a worker, rendering tiles for whoever connects, on every\n"
+		"                                 network interface or only the one at address (127.0.0.1\n"
+		"                                 for this machine only)\n"
+		"  -mathreport                    print the error and speed of sin, pow etc in each math\n"
+		"                                 precision tier instead of rendering\n"
+		"  -help                          show this\n",
+		exeName);
+}
+
+//-------------------------------------------------------------------------------------
+bool ParseCommandLine (int argc, char** argv, SCommandLine& commandLine, int& exitCode)
+{
+	exitCode = 1;
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		int remaining = argc - i - 1;
+
+		if (!strcmp(arg, "-out") && remaining >= 1)
+			commandLine.m_outFileName = argv[++i];
+		else if (!strcmp(arg, "-nomap"))
+			commandLine.m_mapOutput = false;
+		else if (!strcmp(arg, "-size") && remaining >= 2)
+		{
+			commandLine.m_width = atol(argv[++i]);
+			commandLine.m_height = atol(argv[++i]);
+		}
+		else if (!strcmp(arg, "-time") && remaining >= 1)
+			commandLine.m_timeSeconds = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "-region") && remaining >= 4)
+		{
+			// a size of 0 would mean the whole image
+			long x = atol(argv[++i]);
+			long y = atol(argv[++i]);
+			long width = atol(argv[++i]);
+			long height = atol(argv[++i]);
+			if (x < 0 || y < 0 || width <= 0 || height <= 0)
+			{
+				fprintf(stderr, "Region must start at 0 or more and have a positive size\n");
+				return false;
+			}
+			SRenderRegion& region = commandLine.m_renderSettings.m_region;
+			region.m_x = (size_t)x;
+			region.m_y = (size_t)y;
+			region.m_width = (size_t)width;
+			region.m_height = (size_t)height;
+		}
+		else if (!strcmp(arg, "-pixel") && remaining >= 2)
+		{
+			SRenderRegion& region = commandLine.m_renderSettings.m_region;
+			region.m_x = (size_t)atol(argv[++i]);
+			region.m_y = (size_t)atol(argv[++i]);
+			region.m_width = 1;
+			region.m_height = 1;
+		}
+		else if (!strcmp(arg, "-progressive"))
+		{
+			commandLine.m_renderSettings.m_progressiveLevels = c_progressiveLevels;
+			if (remaining >= 1 && argv[i + 1][0] != '-')
+				commandLine.m_renderSettings.m_progressiveLevels = (size_t)atol(argv[++i]);
+		}
+		else if (!strcmp(arg, "-supersample") && remaining >= 1)
+		{
+			SSupersampleSettings& supersampling = commandLine.m_renderSettings.m_supersampling;
+			supersampling.m_maxSamples = (size_t)atol(argv[++i]);
+			supersampling.m_baseSamples = std::min(c_supersampleBaseSamples, supersampling.m_maxSamples);
+			supersampling.m_threshold = c_supersampleThreshold;
+			if (remaining >= 2 && argv[i + 1][0] != '-')
+				supersampling.m_threshold = (float)atof(argv[++i]);
+		}
+		else if (!strcmp(arg, "-sparse") && remaining >= 1)
+		{
+			SSparseSettings& sparse = commandLine.m_renderSettings.m_sparse;
+			sparse.m_step = (size_t)atol(argv[++i]);
+			sparse.m_threshold = c_sparseThreshold;
+			if (remaining >= 2 && argv[i + 1][0] != '-')
+				sparse.m_threshold = (float)atof(argv[++i]);
+		}
+		else if (!strcmp(arg, "-shadedpixels"))
+			commandLine.m_reportShadedPixels = true;
+		else if (!strcmp(arg, "-opcounts"))
+			commandLine.m_reportOpCounts = true;
+		else if (!strcmp(arg, "-heatmap") && remaining >= 1)
+			commandLine.m_heatmapFileName = argv[++i];
+		else if (!strcmp(arg, "-hotspots") && remaining >= 1)
+			commandLine.m_heatmapTopPixels = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-compare") && remaining >= 1)
+			commandLine.m_referenceFileName = argv[++i];
+		else if (!strcmp(arg, "-threshold") && remaining >= 1)
+			commandLine.m_compareThreshold = atoi(argv[++i]);
+		else if (!strcmp(arg, "-failfast"))
+			commandLine.m_failFast = true;
+		else if (!strcmp(arg, "-diff") && remaining >= 1)
+			commandLine.m_diffFileName = argv[++i];
+		else if (!strcmp(arg, "-shader") && remaining >= 1)
+			commandLine.m_shaderModuleFileName = argv[++i];
+		else if (!strcmp(arg, "-watch"))
+			commandLine.m_watch = true;
+		else if (!strcmp(arg, "-sequence") && remaining >= 3)
+		{
+			commandLine.m_sequence = true;
+			commandLine.m_startSeconds = (float)atof(argv[++i]);
+			commandLine.m_endSeconds = (float)atof(argv[++i]);
+			commandLine.m_fps = (float)atof(argv[++i]);
+		}
+		else if (!strcmp(arg, "-y4m"))
+			commandLine.m_frameOutput = EFrameOutput::Y4M;
+		else if (!strcmp(arg, "-queue") && remaining >= 1)
+			commandLine.m_writeQueueDepth = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-noreuse"))
+			commandLine.m_reuseTiles = false;
+		else if (!strcmp(arg, "-threads") && remaining >= 1)
+			commandLine.m_numThreads = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-tile") && remaining >= 1)
+			commandLine.m_renderSettings.m_tileSize = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-pin"))
+			commandLine.m_pinThreads = true;
+		else if (!strcmp(arg, "-scalar"))
+			commandLine.m_renderSettings.m_mode = ERenderMode::Scalar;
+		else if (!strcmp(arg, "-packet"))
+			commandLine.m_renderSettings.m_mode = ERenderMode::Packet;
+		else if (!strcmp(arg, "-generic"))
+			commandLine.m_renderSettings.m_fixedKernels = false;
+		else if (!strcmp(arg, "-benchmark"))
+		{
+			commandLine.m_benchmark = true;
+			if (remaining >= 1 && argv[i + 1][0] != '-')
+				commandLine.m_benchmarkSettings.m_iterations = (size_t)atol(argv[++i]);
+		}
+		else if (!strcmp(arg, "-warmup") && remaining >= 1)
+			commandLine.m_benchmarkSettings.m_warmupIterations = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-benchtime") && remaining >= 2)
+		{
+			commandLine.m_benchmarkSettings.m_timeRange = true;
+			commandLine.m_benchmarkSettings.m_startSeconds = (float)atof(argv[++i]);
+			commandLine.m_benchmarkSettings.m_endSeconds = (float)atof(argv[++i]);
+		}
+		else if (!strcmp(arg, "-report") && remaining >= 1)
+			commandLine.m_benchmarkSettings.m_reportFileName = argv[++i];
+		else if (!strcmp(arg, "-batch") && remaining >= 1)
+			commandLine.m_batchFileName = argv[++i];
+		else if (!strcmp(arg, "-jobs") && remaining >= 1)
+			commandLine.m_batchJobsInFlight = (size_t)atol(argv[++i]);
+		else if (!strcmp(arg, "-workers") && remaining >= 1)
+		{
+			std::string addresses = argv[++i];
+			for (size_t start = 0; start <= addresses.size(); )
+			{
+				size_t end = std::min(addresses.find(',', start), addresses.size());
+				if (end > start)
+					commandLine.m_workerAddresses.push_back(addresses.substr(start, end - start));
+				start = end + 1;
+			}
+		}
+		else if (!strcmp(arg, "-worker") && remaining >= 1)
+		{
+			long port = atol(argv[++i]);
+			if (port <= 0 || port > 65535)
+			{
+				fprintf(stderr, "Worker port must be 1 to 65535\n");
+				return false;
+			}
+			commandLine.m_workerPort = (uint16_t)port;
+			if (remaining >= 2 && argv[i + 1][0] != '-')
+				commandLine.m_workerInterface = argv[++i];
+		}
+		else if (!strcmp(arg, "-mathreport"))
+			commandLine.m_mathReport = true;
+		else if (!strcmp(arg, "-help") || !strcmp(arg, "-h") || !strcmp(arg, "/?"))
+		{
+			PrintUsage(argv[0]);
+			exitCode = 0;
+			return false;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown or incomplete option \"%s\"\n", arg);
+			PrintUsage(argv[0]);
+			return false;
+		}
+	}
+
+	bool batch = !commandLine.m_batchFileName.empty();
+	if (batch && (commandLine.m_sequence || commandLine.m_benchmark || commandLine.m_watch || !commandLine.m_referenceFileName.empty()))
+	{
+		fprintf(stderr, "-batch can't be combined with -sequence, -benchmark, -watch or -compare (give jobs a ref= instead)\n");
+		return false;
+	}
+
+	if (batch && commandLine.m_batchJobsInFlight == 0)
+	{
+		fprintf(stderr, "Batch jobs at once must be positive\n");
+		return false;
+	}
+
+	bool compare = !commandLine.m_referenceFileName.empty();
+	bool distributed = !commandLine.m_workerAddresses.empty();
+	if (distributed && (commandLine.m_workerPort != 0 || batch || compare || commandLine.m_benchmark || commandLine.m_watch
+		|| commandLine.m_reportShadedPixels || commandLine.m_reportOpCounts || !commandLine.m_heatmapFileName.empty()
+		|| commandLine.m_renderSettings.m_progressiveLevels > 1))
+	{
+		fprintf(stderr, "-workers renders single frames and sequences only, without -progressive, -heatmap, -opcounts or -shadedpixels\n");
+		return false;
+	}
+
+	if (!commandLine.m_heatmapFileName.empty() && (commandLine.m_sequence || commandLine.m_benchmark))
+	{
+		fprintf(stderr, "-heatmap can't be combined with -sequence or -benchmark\n");
+		return false;
+	}
+
+	if (commandLine.m_reportOpCounts && (commandLine.m_sequence || commandLine.m_benchmark))
+	{
+		fprintf(stderr, "-opcounts can't be combined with -sequence or -benchmark\n");
+		return false;
+	}
+
+	if (compare && (commandLine.m_sequence || commandLine.m_benchmark || commandLine.m_watch))
+	{
+		fprintf(stderr, "-compare can't be combined with -sequence, -benchmark or -watch\n");
+		return false;
+	}
+
+	if (!commandLine.m_diffFileName.empty() && (!compare || !IsBMPFileName(commandLine.m_diffFileName.c_str())))
+	{
+		fprintf(stderr, "-diff needs -compare, and writes a .bmp\n");
+		return false;
+	}
+
+	bool y4m = commandLine.m_sequence && commandLine.m_frameOutput == EFrameOutput::Y4M;
+	if (!commandLine.m_benchmark && !batch && !compare && !y4m && !commandLine.m_mathReport && commandLine.m_workerPort == 0 && !FindImageEncoder(commandLine.m_outFileName.c_str()))
+	{
+		fprintf(stderr, "Output file %s must be a %s\n", commandLine.m_outFileName.c_str(), ImageEncoderExtensions());
+		return false;
+	}
+
+	if (commandLine.m_watch && (commandLine.m_shaderModuleFileName.empty() || commandLine.m_sequence || commandLine.m_benchmark))
+	{
+		fprintf(stderr, "-watch needs -shader, and renders single frames only\n");
+		return false;
+	}
+
+	if (commandLine.m_width <= 0 || commandLine.m_height <= 0)
+	{
+		fprintf(stderr, "Image size must be positive\n");
+		return false;
+	}
+
+	if (distributed && uint64_t(commandLine.m_width) * uint64_t(commandLine.m_height) > SRenderCluster::c_maxFramePixels)
+	{
+		fprintf(stderr, "-workers frames can have at most %llu pixels\n", (unsigned long long)SRenderCluster::c_maxFramePixels);
+		return false;
+	}
+
+	// BMP sizes are 32 bit, so frames of over 4GB can't be saved as one
+	bool bmpOutput = !commandLine.m_benchmark && !batch && !compare && !y4m && IsBMPFileName(commandLine.m_outFileName.c_str());
+	if ((bmpOutput || !commandLine.m_heatmapFileName.empty()) && !FitsInBMP(commandLine.m_width, commandLine.m_height))
+	{
+		fprintf(stderr, "A %ldx%ld image is too big for a .bmp\n", commandLine.m_width, commandLine.m_height);
+		return false;
+	}
+
+	const SRenderSettings& renderSettings = commandLine.m_renderSettings;
+	const SRenderRegion& region = renderSettings.m_region;
+	if (!region.IsWholeImage()
+		&& (region.m_x >= (size_t)commandLine.m_width || region.m_width > (size_t)commandLine.m_width - region.m_x
+			|| region.m_y >= (size_t)commandLine.m_height || region.m_height > (size_t)commandLine.m_height - region.m_y))
+	{
+		fprintf(stderr, "Region doesn't fit in the %ldx%ld image\n", commandLine.m_width, commandLine.m_height);
+		return false;
+	}
+
+	if (renderSettings.m_progressiveLevels < 1 || renderSettings.m_progressiveLevels > 8)
+	{
+		fprintf(stderr, "Progressive levels must be 1 to 8\n");
+		return false;
+	}
+
+	// rounds of samples double until they reach the max, and only a power of 2 keeps the
+	// last one stratified like the others
+	const size_t maxSamples = renderSettings.m_supersampling.m_maxSamples;
+	if (maxSamples < 1 || maxSamples > 65536 || (maxSamples & (maxSamples - 1)) != 0 || !(renderSettings.m_supersampling.m_threshold >= 0.0f))
+	{
+		fprintf(stderr, "Supersamples must be a power of 2 from 1 to 65536, and the error 0 or more\n");
+		return false;
+	}
+
+	if (renderSettings.m_sparse.m_step < 1 || renderSettings.m_sparse.m_step > 16 || !(renderSettings.m_sparse.m_threshold >= 0.0f))
+	{
+		fprintf(stderr, "Sparse step must be 1 to 16, and the difference 0 or more\n");
+		return false;
+	}
+
+	if (renderSettings.m_sparse.IsEnabled() && renderSettings.m_progressiveLevels > 1)
+	{
+		fprintf(stderr, "-sparse can't be combined with -progressive\n");
+		return false;
+	}
+
+	if (commandLine.m_benchmark && commandLine.m_benchmarkSettings.m_iterations == 0)
+	{
+		fprintf(stderr, "Benchmark iterations must be positive\n");
+		return false;
+	}
+
+	if (commandLine.m_sequence && !(commandLine.m_fps > 0.0f && isfinite(commandLine.m_fps)))
+	{
+		fprintf(stderr, "Sequence fps must be positive\n");
+		return false;
+	}
+
+	if (commandLine.m_sequence && !(isfinite(commandLine.m_startSeconds) && isfinite(commandLine.m_endSeconds) && commandLine.m_endSeconds >= commandLine.m_startSeconds))
+	{
+		fprintf(stderr, "Sequence end must be a time at or after its start\n");
+		return false;
+	}
+
+	return true;
+}
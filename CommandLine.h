@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Benchmark.h"
+#include "FrameWriter.h"
+#include "Renderer.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// Everything main() needs to know about a run. Defaults come from Settings.h and can be
+// overridden on the command line without rebuilding.
+struct SCommandLine
+{
+	SCommandLine();
+
+	long m_width;
+	long m_height;
+	std::string m_outFileName;
+	bool m_mapOutput;
+	float m_timeSeconds;
+
+	// single frames can also save a per-pixel cost heatmap and list the slowest pixels
+	std::string m_heatmapFileName;
+	size_t m_heatmapTopPixels;
+
+	// check the render against a golden BMP instead of saving it, optionally stopping at
+	// the first tile that doesn't match and saving a picture of the differences
+	std::string m_referenceFileName;
+	int m_compareThreshold;
+	bool m_failFast;
+	std::string m_diffFileName;
+
+	// a shader module to render instead of the built in shader, and whether to keep
+	// rendering the frame again whenever the module is rebuilt
+	std::string m_shaderModuleFileName;
+	bool m_watch;
+
+	size_t m_numThreads;
+	bool m_pinThreads;
+	SRenderSettings m_renderSettings;
+
+	// print how many pixels a single frame, sequence or -compare render shaded, for -sparse
+	// and tile reuse
+	bool m_reportShadedPixels;
+
+	// count the ops a single frame's shader runs with its op counting build and print them
+	// per pixel (see glslCounted.h)
+	bool m_reportOpCounts;
+
+	// sequence rendering. Frames are rendered at m_startSeconds + frame / m_fps, up to
+	// but not including m_endSeconds.
+	bool m_sequence;
+	float m_startSeconds;
+	float m_endSeconds;
+	float m_fps;
+	EFrameOutput m_frameOutput;
+	size_t m_writeQueueDepth;
+	bool m_reuseTiles;          // see SRenderSettings::m_reuseTiles
+
+	// time repeated renders instead of writing an image
+	bool m_benchmark;
+	SBenchmarkSettings m_benchmarkSettings;
+
+	// render every job of a manifest (see Batch.h) instead of a single frame. The size,
+	// time and shader above are the defaults of jobs that don't give their own.
+	std::string m_batchFileName;
+	size_t m_batchJobsInFlight;
+
+	// render single frames and sequences on worker processes, "host:port" each (see
+	// RenderCluster.h), or be a worker waiting for coordinators on m_workerPort, of every
+	// network interface or only the one at m_workerInterface
+	std::vector<std::string> m_workerAddresses;
+	uint16_t m_workerPort;
+	std::string m_workerInterface;
+
+	// measure the error and speed of the math builtins in each precision tier instead of
+	// rendering (see glslMath.h)
+	bool m_mathReport;
+};
+
+//-------------------------------------------------------------------------------------
+// Returns false (after printing usage) if the arguments couldn't be parsed or usage was
+// asked for, in which case exitCode says what main() should return
+bool ParseCommandLine (int argc, char** argv, SCommandLine& commandLine, int& exitCode);
@@ -0,0 +1,84 @@
+#include "CostMap.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <math.h>
+
+//-------------------------------------------------------------------------------------
+// blue -> cyan -> green -> yellow -> red as t goes from 0 to 1
+static void HeatColor (float t, uint8* bgr)
+{
+	static const float c_ramp[5][3] =
+	{
+		{ 0.0f, 0.0f, 1.0f },
+		{ 0.0f, 1.0f, 1.0f },
+		{ 0.0f, 1.0f, 0.0f },
+		{ 1.0f, 1.0f, 0.0f },
+		{ 1.0f, 0.0f, 0.0f },
+	};
+
+	t = clamp(t, 0.0f, 1.0f) * 4.0f;
+	int index = std::min(int(t), 3);
+	float blend = t - float(index);
+	for (int channel = 0; channel < 3; ++channel)
+	{
+		float value = c_ramp[index][channel] + (c_ramp[index + 1][channel] - c_ramp[index][channel]) * blend;
+		bgr[2 - channel] = uint8(value * 255.0f);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool SaveCostHeatmap (const char* fileName, const SCostMap& costMap)
+{
+	if (costMap.m_ticks.empty())
+		return false;
+
+	auto range = std::minmax_element(costMap.m_ticks.begin(), costMap.m_ticks.end());
+	double logMin = log(double(*range.first) + 1.0);
+	double logMax = log(double(*range.second) + 1.0);
+	double scale = logMax > logMin ? 1.0 / (logMax - logMin) : 0.0;
+
+	SImageData image;
+	AllocateImage(image, costMap.m_width, costMap.m_height);
+	for (size_t y = 0; y < (size_t)costMap.m_height; ++y)
+	{
+		for (size_t x = 0; x < (size_t)costMap.m_width; ++x)
+		{
+			double ticks = double(costMap.m_ticks[y * (size_t)costMap.m_width + x]);
+			float t = float((log(ticks + 1.0) - logMin) * scale);
+			HeatColor(t, &image.m_pixels[y * image.m_pitch + x * 3]);
+		}
+	}
+	return SaveImage(fileName, image);
+}
+
+//-------------------------------------------------------------------------------------
+void PrintMostExpensivePixels (FILE* file, const SCostMap& costMap, size_t count)
+{
+	count = std::min(count, costMap.m_ticks.size());
+	if (count == 0)
+		return;
+
+	std::vector<size_t> order(costMap.m_ticks.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	std::partial_sort(order.begin(), order.begin() + count, order.end(), [&costMap](size_t a, size_t b)
+	{
+		return costMap.m_ticks[a] > costMap.m_ticks[b];
+	});
+
+	double totalTicks = 0.0;
+	for (uint64_t ticks : costMap.m_ticks)
+		totalTicks += double(ticks);
+	double meanTicks = totalTicks / double(costMap.m_ticks.size());
+
+	fprintf(file, "Most expensive pixels (mean %.0f %s per pixel):\n", meanTicks, costMap.m_unit);
+	for (size_t i = 0; i < count; ++i)
+	{
+		size_t index = order[i];
+		uint64_t ticks = costMap.m_ticks[index];
+		fprintf(file, "  pixel (%zu, %zu): %llu %s, %.1fx mean\n",
+			index % (size_t)costMap.m_width, index / (size_t)costMap.m_width,
+			(unsigned long long)ticks, costMap.m_unit, meanTicks > 0.0 ? double(ticks) / meanTicks : 0.0);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "SImageData.h"
+#include <stdio.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// How many ticks (see ReadCycleCounter) shading each pixel took, or with -opcounts how many
+// ops (see glslCounted.h) it ran. Laid out like the image
+// (row 0 is the bottom row, like fragCoord) so a hot spot can be found in the output at the same place.
+// Every pixel is written by exactly one tile, so render threads fill it without locking.
+struct SCostMap
+{
+	SCostMap()
+		: m_width(0)
+		, m_height(0)
+		, m_unit("ticks")
+	{ }
+
+	void Resize (long width, long height)
+	{
+		m_width = width;
+		m_height = height;
+		m_ticks.assign((size_t)width * (size_t)height, 0);
+	}
+
+	uint64_t& At (size_t x, size_t y) { return m_ticks[y * (size_t)m_width + x]; }
+
+	long m_width;
+	long m_height;
+	const char* m_unit;
+	std::vector<uint64_t> m_ticks;
+};
+
+//-------------------------------------------------------------------------------------
+// Save a false colour picture of the cost, from blue (cheapest) through green and yellow
+// to red (most expensive), on a log scale so one slow pixel doesn't hide the rest
+bool SaveCostHeatmap (const char* fileName, const SCostMap& costMap);
+
+//-------------------------------------------------------------------------------------
+// List the count most expensive pixels, by the pixel coordinates -pixel takes
+void PrintMostExpensivePixels (FILE* file, const SCostMap& costMap, size_t count);
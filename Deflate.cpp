@@ -0,0 +1,242 @@
+#include "Deflate.h"
+#include <string.h>
+
+// deflate length codes 257-285: the smallest length of each, and how many extra bits
+static const uint16_t c_lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t c_lengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+// distance codes 0-29
+static const uint16_t c_distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t c_distanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static const size_t c_windowSize = 32768;
+static const size_t c_minMatch = 3;
+static const size_t c_maxMatch = 258;
+static const size_t c_hashBits = 15;
+static const size_t c_maxChainLength = 16;
+
+//-------------------------------------------------------------------------------------
+// Deflate packs bits starting from the least significant bit of each byte
+struct SBitWriter
+{
+	SBitWriter(std::vector<uint8_t>& out)
+		: m_out(out)
+		, m_bits(0)
+		, m_numBits(0)
+	{ }
+
+	void Write (uint32_t value, size_t numBits)
+	{
+		m_bits |= uint64_t(value) << m_numBits;
+		m_numBits += numBits;
+		while (m_numBits >= 8)
+		{
+			m_out.push_back(uint8_t(m_bits));
+			m_bits >>= 8;
+			m_numBits -= 8;
+		}
+	}
+
+	// Huffman codes go most significant bit first
+	void WriteCode (uint32_t code, size_t numBits)
+	{
+		uint32_t reversed = 0;
+		for (size_t i = 0; i < numBits; ++i)
+			reversed |= ((code >> i) & 1) << (numBits - 1 - i);
+		Write(reversed, numBits);
+	}
+
+	void AlignToByte ()
+	{
+		if (m_numBits > 0)
+			Write(0, 8 - m_numBits);
+	}
+
+	std::vector<uint8_t>& m_out;
+	uint64_t m_bits;
+	size_t m_numBits;
+};
+
+//-------------------------------------------------------------------------------------
+// the fixed Huffman code of a literal/length symbol
+static void WriteFixedSymbol (SBitWriter& writer, size_t symbol)
+{
+	if (symbol < 144)
+		writer.WriteCode(uint32_t(0x30 + symbol), 8);
+	else if (symbol < 256)
+		writer.WriteCode(uint32_t(0x190 + symbol - 144), 9);
+	else if (symbol < 280)
+		writer.WriteCode(uint32_t(symbol - 256), 7);
+	else
+		writer.WriteCode(uint32_t(0xC0 + symbol - 280), 8);
+}
+
+//-------------------------------------------------------------------------------------
+static void WriteMatch (SBitWriter& writer, size_t length, size_t distance)
+{
+	size_t lengthCode = 28;
+	while (c_lengthBase[lengthCode] > length)
+		--lengthCode;
+	WriteFixedSymbol(writer, 257 + lengthCode);
+	writer.Write(uint32_t(length - c_lengthBase[lengthCode]), c_lengthExtraBits[lengthCode]);
+
+	size_t distanceCode = 29;
+	while (c_distanceBase[distanceCode] > distance)
+		--distanceCode;
+	writer.WriteCode(uint32_t(distanceCode), 5);
+	writer.Write(uint32_t(distance - c_distanceBase[distanceCode]), c_distanceExtraBits[distanceCode]);
+}
+
+//-------------------------------------------------------------------------------------
+static size_t Hash3 (const uint8_t* data)
+{
+	uint32_t value = uint32_t(data[0]) | (uint32_t(data[1]) << 8) | (uint32_t(data[2]) << 16);
+	return (value * 2654435761u) >> (32 - c_hashBits);
+}
+
+//-------------------------------------------------------------------------------------
+void DeflateSegment (const uint8_t* data, size_t size, bool lastSegment, std::vector<uint8_t>& out)
+{
+	out.reserve(out.size() + size / 2 + 64);
+	SBitWriter writer(out);
+
+	// one fixed Huffman block for the whole segment
+	writer.Write(lastSegment ? 1 : 0, 1);
+	writer.Write(1, 2);
+
+	// most recent position of each hash, and the previous position with the same hash
+	// for every position in the window. Positions are stored + 1 so 0 means none.
+	std::vector<uint32_t> head(size_t(1) << c_hashBits, 0);
+	std::vector<uint32_t> previous(c_windowSize, 0);
+
+	size_t position = 0;
+	while (position < size)
+	{
+		size_t bestLength = 0;
+		size_t bestDistance = 0;
+
+		if (position + c_minMatch <= size)
+		{
+			size_t hash = Hash3(data + position);
+			size_t maxLength = size - position < c_maxMatch ? size - position : c_maxMatch;
+
+			uint32_t candidate = head[hash];
+			for (size_t chain = 0; candidate != 0 && chain < c_maxChainLength; ++chain)
+			{
+				size_t candidatePosition = candidate - 1;
+				if (position - candidatePosition > c_windowSize - 1)
+					break;
+
+				const uint8_t* a = data + candidatePosition;
+				const uint8_t* b = data + position;
+				if (a[bestLength] == b[bestLength])
+				{
+					size_t length = 0;
+					while (length < maxLength && a[length] == b[length])
+						++length;
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestDistance = position - candidatePosition;
+						if (length == maxLength)
+							break;
+					}
+				}
+				candidate = previous[candidatePosition % c_windowSize];
+			}
+		}
+
+		size_t advance = 1;
+		if (bestLength >= c_minMatch)
+		{
+			WriteMatch(writer, bestLength, bestDistance);
+			advance = bestLength;
+		}
+		else
+			WriteFixedSymbol(writer, data[position]);
+
+		// every position we step over goes into the hash chains
+		for (size_t i = 0; i < advance; ++i, ++position)
+		{
+			if (position + c_minMatch <= size)
+			{
+				size_t hash = Hash3(data + position);
+				previous[position % c_windowSize] = head[hash];
+				head[hash] = uint32_t(position + 1);
+			}
+		}
+	}
+
+	// end of block
+	WriteFixedSymbol(writer, 256);
+
+	if (!lastSegment)
+	{
+		// an empty stored block, which ends on a byte boundary
+		writer.Write(0, 3);
+		writer.AlignToByte();
+		writer.Write(0x0000, 16);
+		writer.Write(0xFFFF, 16);
+	}
+	writer.AlignToByte();
+}
+
+//-------------------------------------------------------------------------------------
+static const uint32_t c_adlerModulus = 65521;
+
+uint32_t Adler32 (uint32_t adler, const uint8_t* data, size_t size)
+{
+	uint32_t a = adler & 0xFFFF;
+	uint32_t b = adler >> 16;
+	while (size > 0)
+	{
+		// the largest run that can't overflow 32 bits before taking the modulus
+		size_t run = size < 5552 ? size : 5552;
+		size -= run;
+		for (size_t i = 0; i < run; ++i)
+		{
+			a += *data++;
+			b += a;
+		}
+		a %= c_adlerModulus;
+		b %= c_adlerModulus;
+	}
+	return (b << 16) | a;
+}
+
+//-------------------------------------------------------------------------------------
+uint32_t Adler32Combine (uint32_t adler1, uint32_t adler2, size_t size2)
+{
+	uint64_t remainder = size2 % c_adlerModulus;
+	uint64_t a1 = adler1 & 0xFFFF;
+	uint64_t b1 = adler1 >> 16;
+	uint64_t a2 = adler2 & 0xFFFF;
+	uint64_t b2 = adler2 >> 16;
+
+	uint64_t a = (a1 + a2 + c_adlerModulus - 1) % c_adlerModulus;
+	uint64_t b = (b1 + b2 + remainder * a1 + c_adlerModulus - remainder) % c_adlerModulus;
+	return uint32_t((b << 16) | a);
+}
+
+//-------------------------------------------------------------------------------------
+uint32_t Crc32 (uint32_t crc, const uint8_t* data, size_t size)
+{
+	static uint32_t s_table[256];
+	static bool s_tableBuilt = []()
+	{
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t value = i;
+			for (int bit = 0; bit < 8; ++bit)
+				value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			s_table[i] = value;
+		}
+		return true;
+	}();
+	(void)s_tableBuilt;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+		crc = s_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// A small, fast deflate (RFC 1951) compressor: greedy LZ77 matching over a 32KB window,
+// coded with the fixed Huffman tables. It trades some compression for speed and for not
+// needing zlib.
+//
+// Data can be compressed as independent segments, on different threads, and the outputs
+// concatenated into one stream, like pigz does. Every segment but the last ends with an
+// empty stored block so it finishes on a byte boundary, and matches never reach back
+// into an earlier segment.
+void DeflateSegment (const uint8_t* data, size_t size, bool lastSegment, std::vector<uint8_t>& out);
+
+//-------------------------------------------------------------------------------------
+// Checksums for zlib streams and PNG chunks. Adler32Combine gives the checksum of two
+// pieces of data joined together from their separate checksums and the second's length.
+uint32_t Adler32 (uint32_t adler, const uint8_t* data, size_t size);
+uint32_t Adler32Combine (uint32_t adler1, uint32_t adler2, size_t size2);
+uint32_t Crc32 (uint32_t crc, const uint8_t* data, size_t size);
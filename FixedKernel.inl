@@ -0,0 +1,93 @@
+// One fixed size render kernel. mainFixed.cpp includes this once per size, with
+// FIXED_KERNEL naming the kernel's namespace and FIXED_KERNEL_SIZE giving its width, height.
+
+namespace FIXED_KERNEL
+{
+	const size_t c_size[2] = { FIXED_KERNEL_SIZE };
+	const float c_width = float(c_size[0]);
+	const float c_height = float(c_size[1]);
+}
+
+// the uniforms that are constants in this kernel. The vector ones are set again each
+// time, as the packet compile below changes them.
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (::vec3(::FIXED_KERNEL::c_width, ::FIXED_KERNEL::c_height, 1.0f))
+#define iDate               (ReadUniforms(c_uniformDate).m_iDate)
+
+#if SHADER_FIXED_STILL_FRAME
+#undef iGlobalTime
+#undef iTime
+#define iGlobalTime         (::c_timeSeconds)
+#define iTime               (::c_timeSeconds)
+#define iMouse              (::vec4(0.0f))
+#else
+#define iMouse              (ReadUniforms(c_uniformMouse).m_iMouse)
+#endif
+
+namespace Scalar
+{
+namespace FIXED_KERNEL
+{
+#include "main.cpp"
+}
+}
+
+// and again for packets, see mainPacket.cpp
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (Packet::vec3(::vec3(::FIXED_KERNEL::c_width, ::FIXED_KERNEL::c_height, 1.0f)))
+#define iDate               (Packet::vec4(ReadUniforms(c_uniformDate).m_iDate))
+
+#if SHADER_FIXED_STILL_FRAME
+#define iMouse              (Packet::vec4(::vec4(0.0f)))
+#else
+#define iMouse              (Packet::vec4(ReadUniforms(c_uniformMouse).m_iMouse))
+#endif
+
+#define float SFloatPacket
+
+namespace Packet
+{
+namespace FIXED_KERNEL
+{
+#include "main.cpp"
+}
+}
+
+#undef float
+
+namespace FIXED_KERNEL
+{
+	// calls this kernel's copies of mainImage() directly, so they can be inlined into the tile loops
+	struct SShaderCalls
+	{
+		static const size_t c_fixedTileSize = c_tileSize;
+		static const bool c_countsOps = false;
+
+		void Shade (vec4& fragColor, vec2 fragCoord) const { Scalar::FIXED_KERNEL::mainImage(fragColor, fragCoord); }
+		void ShadePacket (Packet::vec4& fragColor, Packet::vec2 fragCoord) const { Packet::FIXED_KERNEL::mainImage(fragColor, fragCoord); }
+		bool& PacketDivergedFlag () const { return PacketDiverged(); }
+		SShaderQuadSlot& QuadSlot () const { return CurrentShaderQuad(); }
+		uint64_t ReadCost () const { return ReadCycleCounter(); }
+	};
+
+	template <typename TTarget>
+	void RenderKernelTile (TTarget image, SCostMap* costMap, const STileJob& job, ERenderMode mode)
+	{
+		if (mode == ERenderMode::Packet)
+			RenderTilePacket(SShaderCalls(), image, costMap, job);
+		else
+			RenderTile(SShaderCalls(), image, costMap, job);
+	}
+
+#if SHADER_FIXED_STILL_FRAME
+	const uint32_t c_constantUniforms = c_uniformResolution | c_uniformTime | c_uniformMouse;
+#else
+	const uint32_t c_constantUniforms = c_uniformResolution;
+#endif
+
+	const SFixedKernel c_kernel = { c_size[0], c_size[1], c_constantUniforms, RenderKernelTile<const SImageView&>, RenderKernelTile<SFloatImage*> };
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// A float RGBA frame, straight out of the shader without clamping, so HDR values survive
+// until an encoder decides what to do with them. Rows are tightly packed and row 0 is
+// the bottom row, like fragCoord and BMP files.
+struct SFloatImage
+{
+	SFloatImage()
+		: m_width(0)
+		, m_height(0)
+	{ }
+
+	void Resize (long width, long height)
+	{
+		m_width = width;
+		m_height = height;
+		m_pixels.resize((size_t)width * (size_t)height * 4);
+	}
+
+	float* Row (size_t y) { return &m_pixels[y * (size_t)m_width * 4]; }
+	const float* Row (size_t y) const { return &m_pixels[y * (size_t)m_width * 4]; }
+
+	long m_width;
+	long m_height;
+	std::vector<float> m_pixels;
+};
@@ -0,0 +1,190 @@
+#include "FrameWriter.h"
+#include "ImageEncoders.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+//-------------------------------------------------------------------------------------
+SFrameWriter::SFrameWriter(const std::string& fileName, EFrameOutput output, float fps, size_t queueDepth, STaskScheduler* scheduler)
+	: m_fileName(fileName)
+	, m_output(output)
+	, m_fps(fps)
+	, m_queueDepth(queueDepth > 0 ? queueDepth : 1)
+	, m_scheduler(scheduler)
+	, m_stream(nullptr)
+	, m_framesSubmitted(0)
+	, m_framesWritten(0)
+	, m_failed(false)
+	, m_finishing(false)
+{
+	m_thread = std::thread(&SFrameWriter::WriterThread, this);
+}
+
+//-------------------------------------------------------------------------------------
+SFrameWriter::~SFrameWriter()
+{
+	if (m_thread.joinable())
+		Finish();
+}
+
+//-------------------------------------------------------------------------------------
+SFloatImage* SFrameWriter::AcquireFrame()
+{
+	// one frame being rendered plus up to m_queueDepth waiting on the writer
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this]() { return !m_freeFrames.empty() || m_buffers.size() < m_queueDepth + 1; });
+
+	if (!m_freeFrames.empty())
+	{
+		SFloatImage* frame = m_freeFrames.back();
+		m_freeFrames.pop_back();
+		return frame;
+	}
+
+	m_buffers.emplace_back(new SFloatImage);
+	return m_buffers.back().get();
+}
+
+//-------------------------------------------------------------------------------------
+void SFrameWriter::SubmitFrame(SFloatImage* frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingFrames.push_back(frame);
+		++m_framesSubmitted;
+	}
+	m_changed.notify_all();
+}
+
+//-------------------------------------------------------------------------------------
+bool SFrameWriter::Finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_finishing = true;
+	}
+	m_changed.notify_all();
+	m_thread.join();
+
+	if (m_stream && m_stream != stdout && fclose(m_stream) != 0)
+		m_failed = true;
+	else if (m_stream == stdout && fflush(stdout) != 0)
+		m_failed = true;
+	m_stream = nullptr;
+
+	return !m_failed;
+}
+
+//-------------------------------------------------------------------------------------
+std::string SFrameWriter::NumberedFileName(const std::string& fileName, size_t frameIndex)
+{
+	char buffer[1024];
+	if (fileName.find('%') != std::string::npos)
+	{
+		snprintf(buffer, sizeof(buffer), fileName.c_str(), int(frameIndex));
+		return buffer;
+	}
+
+	size_t extension = fileName.rfind('.');
+	if (extension == std::string::npos)
+		extension = fileName.length();
+	snprintf(buffer, sizeof(buffer), "%s_%05d%s", fileName.substr(0, extension).c_str(), int(frameIndex), fileName.substr(extension).c_str());
+	return buffer;
+}
+
+//-------------------------------------------------------------------------------------
+void SFrameWriter::WriterThread()
+{
+	while (true)
+	{
+		SFloatImage* frame;
+		size_t frameIndex;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this]() { return !m_pendingFrames.empty() || m_finishing; });
+			if (m_pendingFrames.empty())
+				return;
+			frame = m_pendingFrames.front();
+			frameIndex = m_framesWritten;
+		}
+
+		// once a write has failed, keep draining the queue so the renderer doesn't block
+		bool written = !m_failed && WriteFrame(*frame, frameIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!written)
+				m_failed = true;
+			m_pendingFrames.pop_front();
+			m_freeFrames.push_back(frame);
+			++m_framesWritten;
+		}
+		m_changed.notify_all();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool SFrameWriter::WriteFrame(const SFloatImage& frame, size_t frameIndex)
+{
+	if (m_output == EFrameOutput::ImageFiles)
+		return SaveFloatImage(NumberedFileName(m_fileName, frameIndex).c_str(), frame, m_scheduler);
+
+	// the stream header needs the frame size, so open it when the first frame shows up
+	if (!m_stream)
+	{
+		if (m_fileName == "-")
+		{
+			#ifdef _WIN32
+			_setmode(_fileno(stdout), _O_BINARY);
+			#endif
+			m_stream = stdout;
+		}
+		else
+		{
+			m_stream = fopen(m_fileName.c_str(), "wb");
+			if (!m_stream)
+				return false;
+		}
+
+		if (fprintf(m_stream, "YUV4MPEG2 W%ld H%ld F%d:1000 Ip A1:1 C444\n", frame.m_width, frame.m_height, int(m_fps * 1000.0f + 0.5f)) < 0)
+			return false;
+	}
+
+	return WriteY4MFrame(frame);
+}
+
+//-------------------------------------------------------------------------------------
+bool SFrameWriter::WriteY4MFrame(const SFloatImage& frame)
+{
+	// quantize each row to BGR like a BMP, then convert to full resolution Y, Cb and Cr
+	// planes (BT.601 video range). Frame rows are stored bottom up, y4m rows top down.
+	const size_t planeSize = size_t(frame.m_width) * size_t(frame.m_height);
+	m_planes.resize(planeSize * 3);
+	uint8* planeY = &m_planes[0];
+	uint8* planeU = planeY + planeSize;
+	uint8* planeV = planeU + planeSize;
+
+	m_row.resize(size_t(frame.m_width) * 3);
+	for (long y = 0; y < frame.m_height; ++y)
+	{
+		QuantizeRowBGR(frame.Row(size_t(frame.m_height - 1 - y)), &m_row[0], size_t(frame.m_width));
+		const uint8* pixel = &m_row[0];
+		for (long x = 0; x < frame.m_width; ++x)
+		{
+			int B = pixel[0];
+			int G = pixel[1];
+			int R = pixel[2];
+			pixel += 3;
+
+			*planeY++ = uint8(((66 * R + 129 * G + 25 * B + 128) >> 8) + 16);
+			*planeU++ = uint8(((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128);
+			*planeV++ = uint8(((112 * R - 94 * G - 18 * B + 128) >> 8) + 128);
+		}
+	}
+
+	return fputs("FRAME\n", m_stream) >= 0
+		&& fwrite(&m_planes[0], m_planes.size(), 1, m_stream) == 1;
+}
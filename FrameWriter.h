@@ -0,0 +1,75 @@
+#pragma once
+
+#include "FloatImage.h"
+#include "SImageData.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+enum class EFrameOutput
+{
+	ImageFiles,     // one numbered image per frame, in any format ImageEncoders.h has
+	Y4M,            // one YUV4MPEG2 (4:4:4) stream, "-" writes it to stdout
+};
+
+//-------------------------------------------------------------------------------------
+// Writes a sequence of frames on a background thread, so the next frame can render
+// while the previous one is encoded and written. Frames are rendered into buffers
+// handed out by AcquireFrame() and recycled once written, and at most queueDepth
+// frames wait to be written, so memory use doesn't grow with the length of the clip.
+// Frames are float, so they can be encoded to HDR formats; the encoders spread their work
+// over the scheduler if one is given.
+struct STaskScheduler;
+
+struct SFrameWriter
+{
+	SFrameWriter(const std::string& fileName, EFrameOutput output, float fps, size_t queueDepth, STaskScheduler* scheduler);
+	~SFrameWriter();
+
+	// Get a buffer to render the next frame into. Blocks while the write queue is full.
+	SFloatImage* AcquireFrame();
+
+	// Queue a frame from AcquireFrame() to be written. Frames must be submitted in order.
+	void SubmitFrame(SFloatImage* frame);
+
+	// Wait for every queued frame to be written. Returns false if any write failed.
+	bool Finish();
+
+	// The file name frame number frameIndex gets written to, for ImageFiles output. A file
+	// name containing a printf style %d is used as is, otherwise the frame number is
+	// inserted before the extension.
+	static std::string NumberedFileName(const std::string& fileName, size_t frameIndex);
+
+private:
+	void WriterThread();
+	bool WriteFrame(const SFloatImage& frame, size_t frameIndex);
+	bool WriteY4MFrame(const SFloatImage& frame);
+
+	std::string m_fileName;
+	EFrameOutput m_output;
+	float m_fps;
+	size_t m_queueDepth;
+
+	STaskScheduler* m_scheduler;
+
+	FILE* m_stream;
+	std::vector<uint8> m_planes;
+	std::vector<uint8> m_row;
+
+	std::vector<std::unique_ptr<SFloatImage>> m_buffers;
+	std::vector<SFloatImage*> m_freeFrames;
+	std::deque<SFloatImage*> m_pendingFrames;
+	size_t m_framesSubmitted;
+	size_t m_framesWritten;
+	bool m_failed;
+	bool m_finishing;
+
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::thread m_thread;
+};
@@ -0,0 +1,177 @@
+#include "ImageCompare.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+//-------------------------------------------------------------------------------------
+double SComparisonResults::MeanError () const
+{
+	return m_pixelsCompared > 0 ? double(m_sumError) / double(m_pixelsCompared * 3) : 0.0;
+}
+
+//-------------------------------------------------------------------------------------
+double SComparisonResults::PSNR () const
+{
+	if (m_sumSquaredError == 0)
+		return INFINITY;
+	double meanSquaredError = double(m_sumSquaredError) / double(m_pixelsCompared * 3);
+	return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+//-------------------------------------------------------------------------------------
+SImageComparison::SImageComparison()
+	: m_threshold(0)
+	, m_stopAtFirstFailure(false)
+	, m_makeDiffImage(false)
+	, m_stop(false)
+{ }
+
+//-------------------------------------------------------------------------------------
+bool SImageComparison::LoadReference (const char* fileName)
+{
+	if (MapImage(fileName, m_mappedReference))
+	{
+		m_reference = m_mappedReference.m_view;
+		return true;
+	}
+
+	// top down BMPs can't be used in place
+	if (!LoadImage(fileName, m_loadedReference))
+		return false;
+	m_reference = m_loadedReference;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+void SImageComparison::Reset ()
+{
+	m_results = SComparisonResults();
+	m_stop = false;
+	if (m_makeDiffImage)
+	{
+		AllocateImage(m_diffImage, m_reference.m_width, m_reference.m_height);
+		std::fill(m_diffImage.m_pixels.begin(), m_diffImage.m_pixels.end(), uint8(0));
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool SImageComparison::CompareTile (const SImageView& image, size_t minX, size_t minY, size_t maxX, size_t maxY)
+{
+	return CompareTilePixels([&image](size_t x, size_t y, uint8* bgr)
+	{
+		const uint8* pixel = &image.m_pixels[y * image.m_pitch + x * 3];
+		bgr[0] = pixel[0];
+		bgr[1] = pixel[1];
+		bgr[2] = pixel[2];
+	}, minX, minY, maxX, maxY);
+}
+
+//-------------------------------------------------------------------------------------
+bool SImageComparison::CompareTile (const SFloatImage& image, size_t minX, size_t minY, size_t maxX, size_t maxY)
+{
+	// quantized the way the renderer writes a BMP, so a float render of the same shader
+	// compares equal
+	return CompareTilePixels([&image](size_t x, size_t y, uint8* bgr)
+	{
+		const float* pixel = image.Row(y) + x * 4;
+		bgr[0] = uint8(clamp(pixel[2], 0.0f, 1.0f) * 255.0f);
+		bgr[1] = uint8(clamp(pixel[1], 0.0f, 1.0f) * 255.0f);
+		bgr[2] = uint8(clamp(pixel[0], 0.0f, 1.0f) * 255.0f);
+	}, minX, minY, maxX, maxY);
+}
+
+//-------------------------------------------------------------------------------------
+template <typename TReadPixel>
+bool SImageComparison::CompareTilePixels (const TReadPixel& readPixel, size_t minX, size_t minY, size_t maxX, size_t maxY)
+{
+	// the tile's totals are gathered without the lock and added in one go
+	SComparisonResults tile;
+	int worstError = -1;
+	size_t worstX = minX;
+	size_t worstY = minY;
+
+	for (size_t y = minY; y < maxY; ++y)
+	{
+		const uint8* referenceRow = &m_reference.m_pixels[y * m_reference.m_pitch];
+		uint8* diffRow = m_makeDiffImage ? &m_diffImage.m_pixels[y * m_diffImage.m_pitch] : nullptr;
+		for (size_t x = minX; x < maxX; ++x)
+		{
+			uint8 rendered[3];
+			readPixel(x, y, rendered);
+			const uint8* reference = referenceRow + x * 3;
+
+			int error = 0;
+			for (size_t channel = 0; channel < 3; ++channel)
+			{
+				int difference = abs(int(rendered[channel]) - int(reference[channel]));
+				error = std::max(error, difference);
+				tile.m_sumError += (uint64_t)difference;
+				tile.m_sumSquaredError += (uint64_t)(difference * difference);
+			}
+
+			if (error > m_threshold)
+				++tile.m_pixelsOverThreshold;
+			if (error > worstError)
+			{
+				worstError = error;
+				worstX = x;
+				worstY = y;
+			}
+
+			if (diffRow)
+			{
+				uint8* diff = diffRow + x * 3;
+				if (error > m_threshold)
+				{
+					diff[0] = 0;
+					diff[1] = 0;
+					diff[2] = 255;
+				}
+				else
+				{
+					for (size_t channel = 0; channel < 3; ++channel)
+						diff[channel] = error > 0 ? uint8(std::min(error * 32, 255)) : uint8(reference[channel] / 4);
+				}
+			}
+		}
+	}
+
+	const bool passed = tile.m_pixelsOverThreshold == 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_results.m_pixelsCompared += uint64_t(maxX - minX) * uint64_t(maxY - minY);
+		m_results.m_pixelsOverThreshold += tile.m_pixelsOverThreshold;
+		m_results.m_tilesCompared += 1;
+		m_results.m_maxError = std::max(m_results.m_maxError, worstError);
+		m_results.m_sumError += tile.m_sumError;
+		m_results.m_sumSquaredError += tile.m_sumSquaredError;
+		if (!passed && m_results.m_tilesFailed++ == 0)
+		{
+			m_results.m_firstFailureX = worstX;
+			m_results.m_firstFailureY = worstY;
+		}
+		if (!passed && m_stopAtFirstFailure)
+			m_results.m_stoppedEarly = true;
+	}
+
+	if (!passed && m_stopAtFirstFailure)
+		m_stop = true;
+	return passed;
+}
+
+//-------------------------------------------------------------------------------------
+void PrintComparisonResults (FILE* file, const SComparisonResults& results, int threshold)
+{
+	fprintf(file, "compared %llu pixels in %zu tiles: max error %d, mean error %.4f, PSNR %.2f dB\n",
+		(unsigned long long)results.m_pixelsCompared, results.m_tilesCompared, results.m_maxError, results.MeanError(), results.PSNR());
+	if (results.m_pixelsOverThreshold > 0)
+	{
+		fprintf(file, "  %llu pixels in %zu tiles off by more than %d, the worst of the first at pixel (%zu, %zu)\n",
+			(unsigned long long)results.m_pixelsOverThreshold, results.m_tilesFailed, threshold,
+			results.m_firstFailureX, results.m_firstFailureY);
+	}
+	if (results.m_stoppedEarly)
+		fprintf(file, "  stopped rendering at the first failing tile\n");
+	fprintf(file, "%s\n", results.Passed() ? "PASS" : "FAIL");
+}
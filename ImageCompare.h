@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FloatImage.h"
+#include "SImageData.h"
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------
+// What a comparison found, over the pixels compared so far. Errors are absolute
+// differences of 8 bit channel values, the way the image would be saved as a BMP.
+struct SComparisonResults
+{
+	SComparisonResults()
+		: m_pixelsCompared(0)
+		, m_pixelsOverThreshold(0)
+		, m_tilesCompared(0)
+		, m_tilesFailed(0)
+		, m_maxError(0)
+		, m_sumError(0)
+		, m_sumSquaredError(0)
+		, m_firstFailureX(0)
+		, m_firstFailureY(0)
+		, m_stoppedEarly(false)
+	{ }
+
+	double MeanError () const;
+
+	// peak signal to noise ratio in dB, infinite for identical images
+	double PSNR () const;
+
+	bool Passed () const { return m_pixelsOverThreshold == 0; }
+
+	uint64_t m_pixelsCompared;
+	uint64_t m_pixelsOverThreshold;
+	size_t m_tilesCompared;
+	size_t m_tilesFailed;
+	int m_maxError;
+	uint64_t m_sumError;
+	uint64_t m_sumSquaredError;
+
+	// the worst pixel of the first tile to fail, to debug it with -pixel
+	size_t m_firstFailureX;
+	size_t m_firstFailureY;
+
+	bool m_stoppedEarly;    // tiles were skipped after one failed
+};
+
+//-------------------------------------------------------------------------------------
+// Checks a render against a golden image tile by tile, as render threads finish each
+// tile (see SRenderSettings::m_comparison), so a mismatch can stop the frame instead of
+// waiting for all of it. Tiles are compared by whichever thread rendered them; each
+// tile takes the lock once to add its totals.
+struct SImageComparison
+{
+	SImageComparison();
+
+	// Map (or failing that, load) a 24 bit BMP to compare against. Renders must be its size.
+	bool LoadReference (const char* fileName);
+
+	long GetWidth () const { return m_reference.m_width; }
+	long GetHeight () const { return m_reference.m_height; }
+
+	// Forget any previous results before comparing another render, and set up the diff
+	// image if m_makeDiffImage is set
+	void Reset ();
+
+	// Compare [minX, maxX) x [minY, maxY) of a render. Returns false if any pixel was off
+	// by more than m_threshold.
+	bool CompareTile (const SImageView& image, size_t minX, size_t minY, size_t maxX, size_t maxY);
+	bool CompareTile (const SFloatImage& image, size_t minX, size_t minY, size_t maxX, size_t maxY);
+
+	// Set once a tile has failed with m_stopAtFirstFailure. Tiles that haven't started
+	// rendering check it and skip themselves.
+	bool ShouldStop () const { return m_stop.load(std::memory_order_relaxed); }
+
+	// Only meaningful once every tile is done
+	const SComparisonResults& GetResults () const { return m_results; }
+
+	// The same size as the reference. Identical pixels are the reference at a quarter
+	// brightness, so there's something to see, small differences are grey (amplified
+	// so a one level difference shows), and pixels over the threshold are red. Pixels
+	// that weren't compared are black.
+	const SImageData& GetDiffImage () const { return m_diffImage; }
+
+	int m_threshold;            // largest channel difference a pixel may have and still match
+	bool m_stopAtFirstFailure;
+	bool m_makeDiffImage;
+
+private:
+	template <typename TReadPixel>
+	bool CompareTilePixels (const TReadPixel& readPixel, size_t minX, size_t minY, size_t maxX, size_t maxY);
+
+	SMappedImage m_mappedReference;
+	SImageData m_loadedReference;
+	SImageView m_reference;
+
+	SImageData m_diffImage;
+	std::atomic<bool> m_stop;
+	std::mutex m_mutex;
+	SComparisonResults m_results;
+};
+
+//-------------------------------------------------------------------------------------
+void PrintComparisonResults (FILE* file, const SComparisonResults& results, int threshold);
@@ -0,0 +1,531 @@
+#include "ImageEncoders.h"
+#include "Deflate.h"
+#include "TaskScheduler.h"
+#include <ctype.h>
+#include <functional>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ENCODER_SSE2 1
+	#include <emmintrin.h>
+	#if defined(__SSSE3__) || defined(__AVX__)
+		#define ENCODER_SSSE3 1
+		#include <tmmintrin.h>
+	#endif
+#endif
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+	#define ENCODER_F16C 1
+	#include <immintrin.h>
+#endif
+
+//-------------------------------------------------------------------------------------
+// Clamps NaN to 0, like the SIMD version
+static uint8 QuantizeChannel (float value)
+{
+	value = value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+	return uint8(value * 255.0f);
+}
+
+//-------------------------------------------------------------------------------------
+template <bool BGR>
+static void QuantizeRow (const float* rgba, uint8* out, size_t count)
+{
+	size_t i = 0;
+
+#if ENCODER_SSE2
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	#if ENCODER_SSSE3
+	const __m128i order = BGR
+		? _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1)
+		: _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	#endif
+
+	// four pixels at a time: clamp, scale and truncate, then pack the 16 channels down to
+	// bytes and drop alpha
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels[4];
+		for (size_t j = 0; j < 4; ++j)
+		{
+			__m128 color = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(rgba + (i + j) * 4), zero), one);
+			pixels[j] = _mm_cvttps_epi32(_mm_mul_ps(color, scale));
+		}
+		__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(pixels[0], pixels[1]), _mm_packs_epi32(pixels[2], pixels[3]));
+
+		alignas(16) uint8 packed[16];
+	#if ENCODER_SSSE3
+		_mm_store_si128((__m128i*)packed, _mm_shuffle_epi8(bytes, order));
+		memcpy(out + i * 3, packed, 12);
+	#else
+		_mm_store_si128((__m128i*)packed, bytes);
+		for (size_t j = 0; j < 4; ++j)
+		{
+			out[(i + j) * 3 + 0] = packed[j * 4 + (BGR ? 2 : 0)];
+			out[(i + j) * 3 + 1] = packed[j * 4 + 1];
+			out[(i + j) * 3 + 2] = packed[j * 4 + (BGR ? 0 : 2)];
+		}
+	#endif
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		out[i * 3 + 0] = QuantizeChannel(rgba[i * 4 + (BGR ? 2 : 0)]);
+		out[i * 3 + 1] = QuantizeChannel(rgba[i * 4 + 1]);
+		out[i * 3 + 2] = QuantizeChannel(rgba[i * 4 + (BGR ? 0 : 2)]);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void QuantizeRowBGR (const float* rgba, uint8* bgr, size_t count)
+{
+	QuantizeRow<true>(rgba, bgr, count);
+}
+
+//-------------------------------------------------------------------------------------
+void QuantizeRowRGB (const float* rgba, uint8* rgb, size_t count)
+{
+	QuantizeRow<false>(rgba, rgb, count);
+}
+
+//-------------------------------------------------------------------------------------
+// Run work(firstRow, endRow) over numRows rows in strips, spread across the scheduler's
+// threads if there is one
+static void ForEachRowStrip (STaskScheduler* scheduler, size_t numRows, size_t rowsPerStrip, const std::function<void(size_t firstRow, size_t endRow)>& work)
+{
+	if (rowsPerStrip == 0)
+		rowsPerStrip = 1;
+
+	if (!scheduler || numRows <= rowsPerStrip)
+	{
+		work(0, numRows);
+		return;
+	}
+
+	STaskGroup group;
+	for (size_t firstRow = 0; firstRow < numRows; firstRow += rowsPerStrip)
+	{
+		size_t endRow = firstRow + rowsPerStrip < numRows ? firstRow + rowsPerStrip : numRows;
+		scheduler->Submit(group, [&work, firstRow, endRow](size_t) { work(firstRow, endRow); });
+	}
+	scheduler->Wait(group);
+}
+
+//-------------------------------------------------------------------------------------
+// strips of about this many bytes of output are a good size to hand to a thread
+static size_t RowsPerStrip (size_t bytesPerRow)
+{
+	const size_t c_stripBytes = 256 * 1024;
+	return bytesPerRow >= c_stripBytes ? 1 : c_stripBytes / bytesPerRow;
+}
+
+//-------------------------------------------------------------------------------------
+// BMP: quantized straight into the mapped file
+static bool EncodeBMP (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler)
+{
+	SMappedImage mappedImage;
+	if (!CreateMappedImage(fileName, image.m_width, image.m_height, mappedImage))
+		return false;
+
+	const SImageView& view = mappedImage.m_view;
+	ForEachRowStrip(scheduler, (size_t)image.m_height, RowsPerStrip((size_t)view.m_pitch), [&](size_t firstRow, size_t endRow)
+	{
+		for (size_t y = firstRow; y < endRow; ++y)
+			QuantizeRowBGR(image.Row(y), view.m_pixels + y * view.m_pitch, (size_t)image.m_width);
+	});
+	return mappedImage.m_file.Close();
+}
+
+//-------------------------------------------------------------------------------------
+// PFM: 32 bit float RGB, bottom row first. The -1 scale means little endian, which is
+// what every platform this builds on is.
+static bool EncodePFM (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler)
+{
+	char header[64];
+	int headerSize = snprintf(header, sizeof(header), "PF\n%ld %ld\n-1.0\n", image.m_width, image.m_height);
+	size_t rowBytes = (size_t)image.m_width * 3 * sizeof(float);
+
+	SMappedFile file;
+	if (headerSize <= 0 || !file.Create(fileName, (size_t)headerSize + rowBytes * (size_t)image.m_height))
+		return false;
+	memcpy(file.m_data, header, (size_t)headerSize);
+
+	uint8_t* pixels = file.m_data + headerSize;
+	ForEachRowStrip(scheduler, (size_t)image.m_height, RowsPerStrip(rowBytes), [&](size_t firstRow, size_t endRow)
+	{
+		for (size_t y = firstRow; y < endRow; ++y)
+		{
+			const float* source = image.Row(y);
+			uint8_t* dest = pixels + y * rowBytes;
+			for (size_t x = 0; x < (size_t)image.m_width; ++x, source += 4, dest += 3 * sizeof(float))
+				memcpy(dest, source, 3 * sizeof(float));
+		}
+	});
+	return file.Close();
+}
+
+//-------------------------------------------------------------------------------------
+// IEEE half with round to nearest even, overflowing to infinity
+static uint16_t FloatToHalf (float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	if (exponent == 0xFF)
+		return uint16_t(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+	int halfExponent = int(exponent) - 127 + 15;
+	if (halfExponent >= 31)
+		return uint16_t(sign | 0x7C00);
+
+	uint32_t half;
+	uint32_t shift;
+	if (halfExponent <= 0)
+	{
+		// denormal, or too small for a half at all
+		if (halfExponent < -10)
+			return uint16_t(sign);
+		mantissa |= 0x800000;
+		shift = uint32_t(14 - halfExponent);
+		half = mantissa >> shift;
+	}
+	else
+	{
+		shift = 13;
+		half = (uint32_t(halfExponent) << 10) | (mantissa >> shift);
+	}
+
+	// rounding up can carry into the exponent, which is still the right answer
+	uint32_t remainder = mantissa & ((1u << shift) - 1);
+	uint32_t halfway = 1u << (shift - 1);
+	if (remainder > halfway || (remainder == halfway && (half & 1)))
+		++half;
+	return uint16_t(sign | half);
+}
+
+//-------------------------------------------------------------------------------------
+// one channel of count RGBA pixels to halves
+static void ChannelToHalves (const float* rgba, size_t channel, uint16_t* halves, size_t count)
+{
+	size_t i = 0;
+#if ENCODER_F16C
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 values = _mm_setr_ps(rgba[i * 4 + channel], rgba[(i + 1) * 4 + channel], rgba[(i + 2) * 4 + channel], rgba[(i + 3) * 4 + channel]);
+		_mm_storel_epi64((__m128i*)(halves + i), _mm_cvtps_ph(values, 0));
+	}
+#endif
+	for (; i < count; ++i)
+		halves[i] = FloatToHalf(rgba[i * 4 + channel]);
+}
+
+//-------------------------------------------------------------------------------------
+static void AppendBytes (std::vector<uint8_t>& out, const void* data, size_t size)
+{
+	out.insert(out.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+}
+
+static void AppendLittleEndian (std::vector<uint8_t>& out, uint64_t value, size_t numBytes)
+{
+	for (size_t i = 0; i < numBytes; ++i)
+		out.push_back(uint8_t(value >> (i * 8)));
+}
+
+static void AppendAttribute (std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+	AppendBytes(out, name, strlen(name) + 1);
+	AppendBytes(out, type, strlen(type) + 1);
+	AppendLittleEndian(out, value.size(), 4);
+	AppendBytes(out, value.data(), value.size());
+}
+
+//-------------------------------------------------------------------------------------
+// OpenEXR: a single part scanline file of uncompressed half RGBA, which any EXR reader
+// opens. Scanline 0 is the top row. Every chunk is the same size, so the file is laid
+// out up front and rows are converted straight into the mapped file in parallel.
+static bool EncodeEXR (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler)
+{
+	const size_t width = (size_t)image.m_width;
+	const size_t height = (size_t)image.m_height;
+
+	std::vector<uint8_t> header = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+	std::vector<uint8_t> value;
+
+	// channels in alphabetical order, which is also the order of their data in a chunk
+	for (const char* channel : { "A", "B", "G", "R" })
+	{
+		AppendBytes(value, channel, 2);
+		AppendLittleEndian(value, 1, 4);    // HALF
+		AppendLittleEndian(value, 0, 4);    // pLinear and reserved
+		AppendLittleEndian(value, 1, 4);    // x and y sampling
+		AppendLittleEndian(value, 1, 4);
+	}
+	value.push_back(0);
+	AppendAttribute(header, "channels", "chlist", value);
+
+	AppendAttribute(header, "compression", "compression", { 0 });
+
+	value.clear();
+	AppendLittleEndian(value, 0, 4);
+	AppendLittleEndian(value, 0, 4);
+	AppendLittleEndian(value, width - 1, 4);
+	AppendLittleEndian(value, height - 1, 4);
+	AppendAttribute(header, "dataWindow", "box2i", value);
+	AppendAttribute(header, "displayWindow", "box2i", value);
+
+	AppendAttribute(header, "lineOrder", "lineOrder", { 0 });
+
+	float one = 1.0f;
+	value.assign((const uint8_t*)&one, (const uint8_t*)&one + 4);
+	AppendAttribute(header, "pixelAspectRatio", "float", value);
+	AppendAttribute(header, "screenWindowWidth", "float", value);
+	AppendAttribute(header, "screenWindowCenter", "v2f", std::vector<uint8_t>(8, 0));
+	header.push_back(0);
+
+	const size_t rowDataSize = width * 4 * sizeof(uint16_t);
+	const size_t chunkSize = 8 + rowDataSize;
+	const size_t firstChunk = header.size() + height * 8;
+
+	SMappedFile file;
+	if (!file.Create(fileName, firstChunk + chunkSize * height))
+		return false;
+	memcpy(file.m_data, header.data(), header.size());
+
+	ForEachRowStrip(scheduler, height, RowsPerStrip(chunkSize), [&](size_t firstRow, size_t endRow)
+	{
+		for (size_t line = firstRow; line < endRow; ++line)
+		{
+			uint64_t offset = firstChunk + line * chunkSize;
+			uint8_t* tableEntry = file.m_data + header.size() + line * 8;
+			for (size_t i = 0; i < 8; ++i)
+				tableEntry[i] = uint8_t(offset >> (i * 8));
+
+			uint8_t* chunk = file.m_data + offset;
+			for (size_t i = 0; i < 4; ++i)
+			{
+				chunk[i] = uint8_t(line >> (i * 8));
+				chunk[4 + i] = uint8_t(rowDataSize >> (i * 8));
+			}
+
+			// halves are stored little endian, which is the native order here
+			const float* row = image.Row(height - 1 - line);
+			uint16_t* halves = (uint16_t*)(chunk + 8);
+			const size_t channels[4] = { 3, 2, 1, 0 };
+			for (size_t i = 0; i < 4; ++i)
+				ChannelToHalves(row, channels[i], halves + i * width, width);
+		}
+	});
+	return file.Close();
+}
+
+//-------------------------------------------------------------------------------------
+// PNG row filters for 3 byte pixels. Each row gets whichever filter leaves the smallest
+// sum of absolute (signed) bytes, the usual cheap guess at what deflates best.
+static uint8 PaethPredictor (int a, int b, int c)
+{
+	int p = a + b - c;
+	int pa = p > a ? p - a : a - p;
+	int pb = p > b ? p - b : b - p;
+	int pc = p > c ? p - c : c - p;
+	if (pa <= pb && pa <= pc)
+		return uint8(a);
+	return uint8(pb <= pc ? b : c);
+}
+
+static void FilterRow (const uint8* row, const uint8* previous, size_t rowBytes, uint8* out)
+{
+	const size_t bpp = 3;
+	size_t bestFilter = 0;
+	uint64_t bestCost = ~uint64_t(0);
+	for (size_t filter = 0; filter < 5; ++filter)
+	{
+		uint64_t cost = 0;
+		for (size_t i = 0; i < rowBytes; ++i)
+		{
+			int left = i >= bpp ? row[i - bpp] : 0;
+			int up = previous[i];
+			int upLeft = i >= bpp ? previous[i - bpp] : 0;
+			uint8 predicted = 0;
+			switch (filter)
+			{
+				case 1: predicted = uint8(left); break;
+				case 2: predicted = uint8(up); break;
+				case 3: predicted = uint8((left + up) / 2); break;
+				case 4: predicted = PaethPredictor(left, up, upLeft); break;
+			}
+			int8_t residual = int8_t(uint8(row[i] - predicted));
+			cost += residual < 0 ? -residual : residual;
+		}
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestFilter = filter;
+		}
+	}
+
+	out[0] = uint8(bestFilter);
+	for (size_t i = 0; i < rowBytes; ++i)
+	{
+		int left = i >= bpp ? row[i - bpp] : 0;
+		int up = previous[i];
+		int upLeft = i >= bpp ? previous[i - bpp] : 0;
+		uint8 predicted = 0;
+		switch (bestFilter)
+		{
+			case 1: predicted = uint8(left); break;
+			case 2: predicted = uint8(up); break;
+			case 3: predicted = uint8((left + up) / 2); break;
+			case 4: predicted = PaethPredictor(left, up, upLeft); break;
+		}
+		out[1 + i] = uint8(row[i] - predicted);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+static bool WriteChunk (FILE* file, const char* type, const uint8_t* data, size_t size)
+{
+	uint8_t length[4] = { uint8_t(size >> 24), uint8_t(size >> 16), uint8_t(size >> 8), uint8_t(size) };
+	uint32_t crc = Crc32(Crc32(0, (const uint8_t*)type, 4), data, size);
+	uint8_t crcBytes[4] = { uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc) };
+	return fwrite(length, 4, 1, file) == 1
+		&& fwrite(type, 4, 1, file) == 1
+		&& (size == 0 || fwrite(data, size, 1, file) == 1)
+		&& fwrite(crcBytes, 4, 1, file) == 1;
+}
+
+//-------------------------------------------------------------------------------------
+// PNG: 8 bit RGB. Strips of rows are filtered and deflated on separate threads as
+// independent segments of one zlib stream, and each strip goes out as its own IDAT.
+static bool EncodePNG (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler)
+{
+	const size_t width = (size_t)image.m_width;
+	const size_t height = (size_t)image.m_height;
+	const size_t rowBytes = width * 3;
+	const size_t rowsPerStrip = RowsPerStrip(rowBytes + 1);
+	const size_t numStrips = (height + rowsPerStrip - 1) / rowsPerStrip;
+
+	struct SStrip
+	{
+		std::vector<uint8_t> m_compressed;
+		uint32_t m_adler;
+		size_t m_size;
+	};
+	std::vector<SStrip> strips(numStrips);
+
+	// PNG rows go top down, so PNG row r is image row height - 1 - r
+	ForEachRowStrip(scheduler, height, rowsPerStrip, [&](size_t firstRow, size_t endRow)
+	{
+		std::vector<uint8> row(rowBytes);
+		std::vector<uint8> previous(rowBytes, 0);
+		std::vector<uint8> filtered((endRow - firstRow) * (rowBytes + 1));
+
+		// filters look at the row above, even when it is in the previous strip
+		if (firstRow > 0)
+			QuantizeRowRGB(image.Row(height - firstRow), &previous[0], width);
+
+		for (size_t pngRow = firstRow; pngRow < endRow; ++pngRow)
+		{
+			QuantizeRowRGB(image.Row(height - 1 - pngRow), &row[0], width);
+			FilterRow(&row[0], &previous[0], rowBytes, &filtered[(pngRow - firstRow) * (rowBytes + 1)]);
+			row.swap(previous);
+		}
+
+		SStrip& strip = strips[firstRow / rowsPerStrip];
+		strip.m_adler = Adler32(1, &filtered[0], filtered.size());
+		strip.m_size = filtered.size();
+		DeflateSegment(&filtered[0], filtered.size(), endRow == height, strip.m_compressed);
+	});
+
+	FILE* file = fopen(fileName, "wb");
+	if (!file)
+		return false;
+
+	static const uint8_t c_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	uint8_t header[13] =
+	{
+		uint8_t(width >> 24), uint8_t(width >> 16), uint8_t(width >> 8), uint8_t(width),
+		uint8_t(height >> 24), uint8_t(height >> 16), uint8_t(height >> 8), uint8_t(height),
+		8, 2, 0, 0, 0   // 8 bits per channel, RGB, deflate, adaptive filtering, no interlace
+	};
+	bool written = fwrite(c_signature, sizeof(c_signature), 1, file) == 1
+		&& WriteChunk(file, "IHDR", header, sizeof(header));
+
+	// the zlib header goes in front of the first strip and the checksum after the last
+	uint32_t adler = strips[0].m_adler;
+	for (size_t i = 1; i < numStrips; ++i)
+		adler = Adler32Combine(adler, strips[i].m_adler, strips[i].m_size);
+
+	static const uint8_t c_zlibHeader[2] = { 0x78, 0x01 };
+	strips.front().m_compressed.insert(strips.front().m_compressed.begin(), c_zlibHeader, c_zlibHeader + 2);
+	for (int shift = 24; shift >= 0; shift -= 8)
+		strips.back().m_compressed.push_back(uint8_t(adler >> shift));
+
+	for (size_t i = 0; i < numStrips && written; ++i)
+		written = WriteChunk(file, "IDAT", strips[i].m_compressed.data(), strips[i].m_compressed.size());
+	written = written && WriteChunk(file, "IEND", nullptr, 0);
+
+	if (fclose(file) != 0)
+		written = false;
+	return written;
+}
+
+//-------------------------------------------------------------------------------------
+struct SImageEncoder
+{
+	const char* m_extension;
+	TImageEncoder m_encode;
+};
+
+static const SImageEncoder c_encoders[] =
+{
+	{ ".bmp", EncodeBMP },
+	{ ".png", EncodePNG },
+	{ ".pfm", EncodePFM },
+	{ ".exr", EncodeEXR },
+};
+
+//-------------------------------------------------------------------------------------
+TImageEncoder FindImageEncoder (const char* fileName)
+{
+	const char* extension = strrchr(fileName, '.');
+	if (!extension)
+		return nullptr;
+
+	for (const SImageEncoder& encoder : c_encoders)
+	{
+		size_t i = 0;
+		while (encoder.m_extension[i] && tolower((unsigned char)extension[i]) == encoder.m_extension[i])
+			++i;
+		if (!encoder.m_extension[i] && !extension[i])
+			return encoder.m_encode;
+	}
+	return nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+const char* ImageEncoderExtensions ()
+{
+	return ".bmp, .png, .pfm or .exr";
+}
+
+//-------------------------------------------------------------------------------------
+bool IsBMPFileName (const char* fileName)
+{
+	return FindImageEncoder(fileName) == EncodeBMP;
+}
+
+//-------------------------------------------------------------------------------------
+bool SaveFloatImage (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler)
+{
+	TImageEncoder encoder = FindImageEncoder(fileName);
+	if (!encoder || image.m_width <= 0 || image.m_height <= 0)
+		return false;
+	return encoder(fileName, image, scheduler);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "FloatImage.h"
+#include "SImageData.h"
+
+struct STaskScheduler;
+
+//-------------------------------------------------------------------------------------
+// Writes a float image to a file in one format. scheduler may be null, in which case
+// the encoder runs on the calling thread.
+typedef bool (*TImageEncoder)(const char* fileName, const SFloatImage& image, STaskScheduler* scheduler);
+
+//-------------------------------------------------------------------------------------
+// The encoder for a file name's extension (.bmp, .png, .pfm or .exr, in any case), or
+// null if there isn't one
+TImageEncoder FindImageEncoder (const char* fileName);
+
+// The supported extensions, for messages
+const char* ImageEncoderExtensions ();
+
+// Whether the file name is a .bmp, which can be rendered straight into the mapped file
+// without going through a float image
+bool IsBMPFileName (const char* fileName);
+
+//-------------------------------------------------------------------------------------
+// Encode with the encoder for the file name's extension
+bool SaveFloatImage (const char* fileName, const SFloatImage& image, STaskScheduler* scheduler);
+
+//-------------------------------------------------------------------------------------
+// Clamp count RGBA float pixels to 0-1 and convert them to 8 bit BGR (for BMP) or RGB
+// (for PNG), truncating like the scalar conversion always has. Uses SIMD where available.
+void QuantizeRowBGR (const float* rgba, uint8* bgr, size_t count);
+void QuantizeRowRGB (const float* rgba, uint8* rgb, size_t count);
@@ -0,0 +1,214 @@
+#include "MathReport.h"
+#include "glslPacket.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+static const size_t c_mathReportSamples = 1 << 16;
+static const size_t c_mathReportTimingRuns = 5;
+
+//-------------------------------------------------------------------------------------
+// One builtin: the inputs it is measured over, the double precision answer, the exact
+// tier's float version and the approximation of the other tiers. y is only used by
+// functions of two arguments.
+#define MATH_REPORT_FUNCTION(NAME, MIN_X, MAX_X, MIN_Y, MAX_Y, REFERENCE, EXACT, APPROX) \
+	struct SMathFunction_##NAME \
+	{ \
+		static const char* Name () { return #NAME; } \
+		static void Range (float range[4]) { range[0] = MIN_X; range[1] = MAX_X; range[2] = MIN_Y; range[3] = MAX_Y; } \
+		static double Reference (double x, double y) { (void)y; return REFERENCE; } \
+		static float Exact (float x, float y) { (void)y; return EXACT; } \
+		template <int TIER, typename T> static T Approx (T x, T y) { (void)y; return APPROX; } \
+	};
+
+MATH_REPORT_FUNCTION(sin, -100.0f, 100.0f, 0.0f, 0.0f, ::sin(x), std::sin(x), ApproxSin<TIER>(x))
+MATH_REPORT_FUNCTION(cos, -100.0f, 100.0f, 0.0f, 0.0f, ::cos(x), std::cos(x), ApproxCos<TIER>(x))
+MATH_REPORT_FUNCTION(tan, -1.5f, 1.5f, 0.0f, 0.0f, ::tan(x), std::tan(x), ApproxTan<TIER>(x))
+MATH_REPORT_FUNCTION(asin, -1.0f, 1.0f, 0.0f, 0.0f, ::asin(x), std::asin(x), ApproxAsin<TIER>(x))
+MATH_REPORT_FUNCTION(acos, -1.0f, 1.0f, 0.0f, 0.0f, ::acos(x), std::acos(x), ApproxAcos<TIER>(x))
+MATH_REPORT_FUNCTION(atan, -20.0f, 20.0f, 0.0f, 0.0f, ::atan(x), std::atan(x), ApproxAtan<TIER>(x))
+MATH_REPORT_FUNCTION(atan2, -10.0f, 10.0f, -10.0f, 10.0f, ::atan2(x, y), std::atan2(x, y), ApproxAtan2<TIER>(x, y))
+MATH_REPORT_FUNCTION(exp, -80.0f, 80.0f, 0.0f, 0.0f, ::exp(x), std::exp(x), ApproxExp<TIER>(x))
+MATH_REPORT_FUNCTION(log, 1e-3f, 1e3f, 0.0f, 0.0f, ::log(x), std::log(x), ApproxLog<TIER>(x))
+MATH_REPORT_FUNCTION(exp2, -120.0f, 120.0f, 0.0f, 0.0f, ::exp2(x), std::exp2(x), ApproxExp2<TIER>(x))
+MATH_REPORT_FUNCTION(log2, 1e-3f, 1e3f, 0.0f, 0.0f, ::log2(x), std::log2(x), ApproxLog2<TIER>(x))
+MATH_REPORT_FUNCTION(pow, 1e-3f, 10.0f, -8.0f, 8.0f, ::pow(x, y), std::pow(x, y), ApproxPow<TIER>(x, y))
+MATH_REPORT_FUNCTION(sinh, -10.0f, 10.0f, 0.0f, 0.0f, ::sinh(x), std::sinh(x), ApproxSinh<TIER>(x))
+MATH_REPORT_FUNCTION(cosh, -10.0f, 10.0f, 0.0f, 0.0f, ::cosh(x), std::cosh(x), ApproxCosh<TIER>(x))
+MATH_REPORT_FUNCTION(tanh, -20.0f, 20.0f, 0.0f, 0.0f, ::tanh(x), std::tanh(x), ApproxTanh<TIER>(x))
+MATH_REPORT_FUNCTION(asinh, -100.0f, 100.0f, 0.0f, 0.0f, ::asinh(x), std::asinh(x), ApproxAsinh<TIER>(x))
+MATH_REPORT_FUNCTION(acosh, 1.0f, 100.0f, 0.0f, 0.0f, ::acosh(x), std::acosh(x), ApproxAcosh<TIER>(x))
+MATH_REPORT_FUNCTION(atanh, -0.99f, 0.99f, 0.0f, 0.0f, ::atanh(x), std::atanh(x), ApproxAtanh<TIER>(x))
+MATH_REPORT_FUNCTION(inversesqrt, 1e-3f, 1e3f, 0.0f, 0.0f, 1.0 / ::sqrt(x), MathInverseSqrt(x), MathInverseSqrt(x))
+MATH_REPORT_FUNCTION(mod, -100.0f, 100.0f, 0.1f, 10.0f, x - y * ::floor(x / y), ExactMod(x, y), ApproxMod(x, y))
+MATH_REPORT_FUNCTION(fract, -100.0f, 100.0f, 0.0f, 0.0f, x - ::floor(x), MathFract(x), MathFract(x))
+
+#undef MATH_REPORT_FUNCTION
+
+//-------------------------------------------------------------------------------------
+// Units in the last place of a float near value
+static double UnitInLastPlace (double value)
+{
+	float magnitude = fabsf(float(value));
+	if (magnitude < FLT_MIN)
+		return ldexp(1.0, -149);
+	int exponent;
+	frexpf(magnitude, &exponent);
+	return ldexp(1.0, exponent - 24);
+}
+
+//-------------------------------------------------------------------------------------
+// The fastest of a few runs of function over every sample, in nanoseconds per sample
+template <typename F>
+static double TimeSamples (size_t samples, const F& function)
+{
+	typedef std::chrono::steady_clock TClock;
+
+	double best = 0.0;
+	for (size_t run = 0; run < c_mathReportTimingRuns; ++run)
+	{
+		TClock::time_point start = TClock::now();
+		function();
+		double nanoseconds = std::chrono::duration<double, std::nano>(TClock::now() - start).count() / double(samples);
+		if (run == 0 || nanoseconds < best)
+			best = nanoseconds;
+	}
+	return best;
+}
+
+//-------------------------------------------------------------------------------------
+// Runs one tier of a function over the samples on floats and on packets, and compares
+// the float results against the reference
+template <typename SCALAR, typename PACKET>
+static SMathReportRow MeasureTier (const char* name, int tier, const std::vector<float>& x, const std::vector<float>& y,
+	const std::vector<double>& reference, const SCALAR& scalar, const PACKET& packet)
+{
+	const size_t samples = x.size();
+	std::vector<float> scalarResults(samples);
+	std::vector<float> packetResults(samples);
+
+	SMathReportRow row;
+	row.m_function = name;
+	row.m_tier = tier;
+	row.m_scalarNanoseconds = TimeSamples(samples, [&]()
+	{
+		for (size_t i = 0; i < samples; ++i)
+			scalarResults[i] = scalar(x[i], y[i]);
+	});
+	row.m_packetNanoseconds = TimeSamples(samples, [&]()
+	{
+		for (size_t i = 0; i < samples; i += GLSL_PACKET_WIDTH)
+			packet(SFloatPacket::Load(&x[i]), SFloatPacket::Load(&y[i])).Store(&packetResults[i]);
+	});
+	row.m_packetMatchesScalar = memcmp(scalarResults.data(), packetResults.data(), samples * sizeof(float)) == 0;
+
+	row.m_maxAbsoluteError = 0.0;
+	row.m_maxUlpError = 0.0;
+	for (size_t i = 0; i < samples; ++i)
+	{
+		double result = scalarResults[i];
+		bool resultFinite = std::isfinite(result);
+		bool referenceFinite = std::isfinite(reference[i]);
+		if (!resultFinite && !referenceFinite)
+			continue;
+
+		double error = resultFinite && referenceFinite ? fabs(result - reference[i]) : HUGE_VAL;
+		row.m_maxAbsoluteError = std::max(row.m_maxAbsoluteError, error);
+		row.m_maxUlpError = std::max(row.m_maxUlpError, error / UnitInLastPlace(reference[i]));
+	}
+	return row;
+}
+
+//-------------------------------------------------------------------------------------
+template <typename FUNCTION>
+static void MeasureFunction (std::vector<SMathReportRow>& rows)
+{
+	float range[4];
+	FUNCTION::Range(range);
+
+	// x sweeps the range evenly, y is spread over its range by a fixed pseudo random sequence
+	std::vector<float> x(c_mathReportSamples);
+	std::vector<float> y(c_mathReportSamples);
+	std::vector<double> reference(c_mathReportSamples);
+	uint32_t random = 12345;
+	for (size_t i = 0; i < c_mathReportSamples; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		x[i] = range[0] + (range[1] - range[0]) * (float(i) + 0.5f) / float(c_mathReportSamples);
+		y[i] = range[2] + (range[3] - range[2]) * float(random >> 8) / float(1 << 24);
+		reference[i] = FUNCTION::Reference(x[i], y[i]);
+	}
+
+	rows.push_back(MeasureTier(FUNCTION::Name(), GLSL_MATH_EXACT, x, y, reference,
+		[](float a, float b) { return FUNCTION::Exact(a, b); },
+		[](const SFloatPacket& a, const SFloatPacket& b) { return PacketPerLane(a, b, FUNCTION::Exact); }));
+	rows.push_back(MeasureTier(FUNCTION::Name(), GLSL_MATH_GPU, x, y, reference,
+		[](float a, float b) { return FUNCTION::template Approx<GLSL_MATH_GPU>(a, b); },
+		[](const SFloatPacket& a, const SFloatPacket& b) { return FUNCTION::template Approx<GLSL_MATH_GPU>(a, b); }));
+	rows.push_back(MeasureTier(FUNCTION::Name(), GLSL_MATH_FAST, x, y, reference,
+		[](float a, float b) { return FUNCTION::template Approx<GLSL_MATH_FAST>(a, b); },
+		[](const SFloatPacket& a, const SFloatPacket& b) { return FUNCTION::template Approx<GLSL_MATH_FAST>(a, b); }));
+}
+
+//-------------------------------------------------------------------------------------
+void RunMathReport (std::vector<SMathReportRow>& rows)
+{
+	rows.clear();
+	MeasureFunction<SMathFunction_sin>(rows);
+	MeasureFunction<SMathFunction_cos>(rows);
+	MeasureFunction<SMathFunction_tan>(rows);
+	MeasureFunction<SMathFunction_asin>(rows);
+	MeasureFunction<SMathFunction_acos>(rows);
+	MeasureFunction<SMathFunction_atan>(rows);
+	MeasureFunction<SMathFunction_atan2>(rows);
+	MeasureFunction<SMathFunction_exp>(rows);
+	MeasureFunction<SMathFunction_log>(rows);
+	MeasureFunction<SMathFunction_exp2>(rows);
+	MeasureFunction<SMathFunction_log2>(rows);
+	MeasureFunction<SMathFunction_pow>(rows);
+	MeasureFunction<SMathFunction_sinh>(rows);
+	MeasureFunction<SMathFunction_cosh>(rows);
+	MeasureFunction<SMathFunction_tanh>(rows);
+	MeasureFunction<SMathFunction_asinh>(rows);
+	MeasureFunction<SMathFunction_acosh>(rows);
+	MeasureFunction<SMathFunction_atanh>(rows);
+	MeasureFunction<SMathFunction_inversesqrt>(rows);
+	MeasureFunction<SMathFunction_mod>(rows);
+	MeasureFunction<SMathFunction_fract>(rows);
+}
+
+//-------------------------------------------------------------------------------------
+static const char* MathTierName (int tier)
+{
+	switch (tier)
+	{
+		case GLSL_MATH_GPU: return "gpu";
+		case GLSL_MATH_FAST: return "fast";
+		default: return "exact";
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void PrintMathReport (FILE* file, const std::vector<SMathReportRow>& rows)
+{
+	fprintf(file, "this build uses the %s tier, %d lane packets\n", MathTierName(GLSL_MATH_PRECISION), GLSL_PACKET_WIDTH);
+	fprintf(file, "%-12s %-6s %14s %14s %10s %12s  %s\n", "function", "tier", "max abs error", "max ulp error", "scalar ns", "packet ns/px", "packet == scalar");
+	for (const SMathReportRow& row : rows)
+	{
+		fprintf(file, "%-12s %-6s %14.3g %14.3g %10.2f %12.2f  %s\n", row.m_function, MathTierName(row.m_tier),
+			row.m_maxAbsoluteError, row.m_maxUlpError, row.m_scalarNanoseconds, row.m_packetNanoseconds,
+			row.m_packetMatchesScalar ? "yes" : "NO");
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool MathReportPassed (const std::vector<SMathReportRow>& rows)
+{
+	for (const SMathReportRow& row : rows)
+	{
+		if (!row.m_packetMatchesScalar)
+			return false;
+	}
+	return true;
+}
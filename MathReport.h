@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// How one builtin does in one precision tier of glslMath.h, against the C library in
+// double precision over a sweep of typical inputs
+struct SMathReportRow
+{
+	const char* m_function;
+	int m_tier;                     // GLSL_MATH_EXACT, _GPU or _FAST
+	double m_maxAbsoluteError;
+	double m_maxUlpError;           // in units of the last place of the float result
+	double m_scalarNanoseconds;     // per call on a float
+	double m_packetNanoseconds;     // per lane, on packets
+	bool m_packetMatchesScalar;     // every lane gave the same bits as the float version
+};
+
+//-------------------------------------------------------------------------------------
+// Measure every tiered builtin in every tier, whichever tier this build uses. Single
+// threaded, and takes a second or two.
+void RunMathReport (std::vector<SMathReportRow>& rows);
+
+void PrintMathReport (FILE* file, const std::vector<SMathReportRow>& rows);
+
+// Whether packets and floats agreed in every tier
+bool MathReportPassed (const std::vector<SMathReportRow>& rows);
@@ -0,0 +1,29 @@
+#include "OpCountReport.h"
+
+//-------------------------------------------------------------------------------------
+void PrintOpCountReport (FILE* file, const SOpCountReport& report)
+{
+	const uint64_t pixels = report.m_pixels;
+	if (pixels == 0)
+	{
+		fprintf(file, "No ops counted: the shader has no op counting build (see SHADER_OP_COUNTS in Settings.h, or SHADER_MODULE_OP_COUNTS for modules)\n");
+		return;
+	}
+
+	const struct { const char* m_name; uint64_t m_count; } c_rows[] =
+	{
+		{ "ALU", report.m_alu },
+		{ "transcendental", report.m_transcendentals },
+		{ "branch", report.m_branches },
+		{ "texture", report.m_textures },
+	};
+
+	fprintf(file, "Ops per shaded pixel, over %llu pixels:\n", (unsigned long long)pixels);
+	uint64_t total = 0;
+	for (const auto& row : c_rows)
+	{
+		fprintf(file, "  %-16s %10.1f  (%llu in all)\n", row.m_name, double(row.m_count) / double(pixels), (unsigned long long)row.m_count);
+		total += row.m_count;
+	}
+	fprintf(file, "  %-16s %10.1f  (%llu in all)\n", "total", double(total) / double(pixels), (unsigned long long)total);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "glslAdapters.h"
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------
+// What the op counting build (see glslCounted.h) ran over a render. Tiles add what their
+// thread counted once they are done, so render threads only meet here once per tile.
+struct SOpCountReport
+{
+	SOpCountReport()
+		: m_alu(0)
+		, m_transcendentals(0)
+		, m_branches(0)
+		, m_textures(0)
+		, m_pixels(0)
+	{ }
+
+	// Add the ops counted from before to after, while shading pixels pixels
+	void Add (const SOpCounts& before, const SOpCounts& after, uint64_t pixels)
+	{
+		m_alu += after.m_alu - before.m_alu;
+		m_transcendentals += after.m_transcendentals - before.m_transcendentals;
+		m_branches += after.m_branches - before.m_branches;
+		m_textures += after.m_textures - before.m_textures;
+		m_pixels += pixels;
+	}
+
+	std::atomic<uint64_t> m_alu;
+	std::atomic<uint64_t> m_transcendentals;
+	std::atomic<uint64_t> m_branches;
+	std::atomic<uint64_t> m_textures;
+	std::atomic<uint64_t> m_pixels;
+};
+
+//-------------------------------------------------------------------------------------
+// The ops per shaded pixel and in all, by kind
+void PrintOpCountReport (FILE* file, const SOpCountReport& report);
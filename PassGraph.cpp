@@ -0,0 +1,232 @@
+#include "PassGraph.h"
+#include <algorithm>
+#include <stdio.h>
+
+//-------------------------------------------------------------------------------------
+SPassGraph::SPassGraph()
+{
+	for (size_t buffer = 0; buffer < c_numBufferPasses; ++buffer)
+		m_current[buffer] = 0;
+	SetPass(EPass::Image, c_mainShader);
+}
+
+//-------------------------------------------------------------------------------------
+SShaderPass& SPassGraph::SetPass (EPass pass, const SShader& shader)
+{
+	SShaderPass& shaderPass = m_passes[(size_t)pass];
+	shaderPass.m_enabled = true;
+	shaderPass.m_shader = shader;
+	m_imageHistory.Clear();
+	return shaderPass;
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::DisablePass (EPass pass)
+{
+	m_passes[(size_t)pass] = SShaderPass();
+	m_imageHistory.Clear();
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::Reset ()
+{
+	for (size_t buffer = 0; buffer < c_numBufferPasses; ++buffer)
+	{
+		for (STexture& texture : m_buffers[buffer])
+			texture.Clear();
+	}
+	m_imageHistory.Clear();
+}
+
+//-------------------------------------------------------------------------------------
+const STexture* SPassGraph::LoadTexture (const char* fileName)
+{
+	std::unique_ptr<STexture>& texture = m_textures[fileName];
+	if (!texture)
+	{
+		texture.reset(new STexture);
+		if (!::LoadTexture(fileName, *texture))
+			fprintf(stderr, "Could not load texture %s\n", fileName);
+	}
+	return texture->m_levels.empty() ? nullptr : texture.get();
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::Render (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel)
+{
+	RenderPasses(scheduler, EPassSelection::All, &image, image.m_width, image.m_height, settings, context, onLevel);
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::Render (STaskScheduler& scheduler, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel)
+{
+	RenderPasses(scheduler, EPassSelection::All, &image, image.m_width, image.m_height, settings, context, onLevel);
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::RenderBuffers (STaskScheduler& scheduler, long width, long height, const SRenderSettings& settings, const SRenderContext& context)
+{
+	RenderPasses(scheduler, EPassSelection::Buffers, (SFloatImage*)nullptr, width, height, settings, context, TProgressCallback());
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::RenderImage (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	RenderPasses(scheduler, EPassSelection::Image, &image, image.m_width, image.m_height, settings, context, TProgressCallback());
+}
+
+//-------------------------------------------------------------------------------------
+void SPassGraph::RenderImage (STaskScheduler& scheduler, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	RenderPasses(scheduler, EPassSelection::Image, &image, image.m_width, image.m_height, settings, context, TProgressCallback());
+}
+
+//-------------------------------------------------------------------------------------
+bool SPassGraph::HasBufferPasses () const
+{
+	for (size_t buffer = 0; buffer < c_numBufferPasses; ++buffer)
+	{
+		if (m_passes[buffer].m_enabled)
+			return true;
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------------------
+// TImage is a const SImageView or an SFloatImage, and image is null when only the buffers
+// are rendered. Once they have been, the halves have swapped, so the image pass on its
+// own finds this frame's buffers in the current half rather than the other one.
+template <typename TImage>
+void SPassGraph::RenderPasses (STaskScheduler& scheduler, EPassSelection selection, TImage* image, long width, long height, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel)
+{
+	const size_t numPasses = (size_t)EPass::Count;
+	const bool renderBuffers = selection != EPassSelection::Image;
+	const bool renderImage = selection != EPassSelection::Buffers;
+
+	// Shadertoy buffers are the size of the screen
+	for (size_t buffer = 0; buffer < c_numBufferPasses && renderBuffers; ++buffer)
+	{
+		if (!m_passes[buffer].m_enabled)
+			continue;
+		for (STexture& texture : m_buffers[buffer])
+			texture.Resize(width, height);
+	}
+
+	// A pass has to wait for the buffers it reads this frame's output of, so it goes in the
+	// wave after the last of them. Passes in the same wave render together.
+	size_t wave[numPasses];
+	size_t numWaves = 0;
+	SRenderContext passContexts[numPasses];
+	uint32_t changingChannels = 0;
+	for (size_t pass = 0; pass < numPasses; ++pass)
+	{
+		const SShaderPass& shaderPass = m_passes[pass];
+		if (!shaderPass.m_enabled || (pass == (size_t)EPass::Image ? !renderImage : !renderBuffers))
+			continue;
+
+		wave[pass] = 0;
+		passContexts[pass] = context;
+		for (size_t channel = 0; channel < 4; ++channel)
+		{
+			const SChannelInput& input = shaderPass.m_channels[channel];
+			const STexture* texture = input.m_texture;
+
+			size_t buffer = (size_t)input.m_buffer;
+			if (buffer < c_numBufferPasses && m_passes[buffer].m_enabled)
+			{
+				if (pass == (size_t)EPass::Image)
+					changingChannels |= c_uniformChannel0 << channel;
+				bool thisFrame = buffer < pass;
+				if (thisFrame && renderBuffers)
+					wave[pass] = std::max(wave[pass], wave[buffer] + 1);
+				texture = &m_buffers[buffer][thisFrame && renderBuffers ? 1 - m_current[buffer] : m_current[buffer]];
+			}
+
+			if (!texture)
+				continue;
+
+			SSampler2D& sampler = passContexts[pass].m_iChannel[channel];
+			sampler.m_texture = texture;
+			sampler.m_filter = input.m_filter;
+			sampler.m_wrap = input.m_wrap;
+			passContexts[pass].m_iChannelResolution[channel] = vec3(float(texture->m_width), float(texture->m_height), 1.0f);
+		}
+		numWaves = std::max(numWaves, wave[pass] + 1);
+	}
+
+	// buffers are always rendered whole, as the image pass may read them anywhere, and
+	// with every pixel shaded once, as they may hold state rather than colours
+	SRenderSettings bufferSettings = settings;
+	bufferSettings.m_region = SRenderRegion();
+	bufferSettings.m_pixelStep = 1;
+	bufferSettings.m_skipStep = 0;
+	bufferSettings.m_comparison = nullptr;
+	bufferSettings.m_supersampling = SSupersampleSettings();
+	bufferSettings.m_sparse = SSparseSettings();
+	bufferSettings.m_shadedPixels = nullptr;
+	bufferSettings.m_tileHistory = nullptr;
+
+	// the image pass's progressive levels go from a pixel step of 2^(levels - 1) down to 1
+	const size_t numLevels = std::max<size_t>(settings.m_progressiveLevels, 1);
+	SRenderSettings imageSettings = bufferSettings;
+	imageSettings.m_region = settings.m_region;
+	imageSettings.m_comparison = settings.m_comparison;
+	imageSettings.m_supersampling = settings.m_supersampling;
+	imageSettings.m_sparse = settings.m_sparse;
+	imageSettings.m_shadedPixels = settings.m_shadedPixels;
+	imageSettings.m_pixelStep = size_t(1) << (numLevels - 1);
+
+	// tiles are only kept from whole frames rendered in one go
+	if (settings.m_reuseTiles && numLevels == 1 && !settings.m_sparse.IsEnabled() && !settings.m_comparison)
+	{
+		m_imageHistory.m_changingChannels = changingChannels;
+		imageSettings.m_tileHistory = &m_imageHistory;
+	}
+
+	// nothing reads the buffers being written in a wave, so the tasks of a whole wave can
+	// go to the scheduler at once. Later levels of the image pass follow on their own.
+	for (size_t waveIndex = 0; waveIndex < numWaves; ++waveIndex)
+	{
+		STaskGroup group;
+		bool imageInWave = false;
+		for (size_t pass = 0; pass < numPasses; ++pass)
+		{
+			const SShaderPass& shaderPass = m_passes[pass];
+			if (!shaderPass.m_enabled || (pass == (size_t)EPass::Image ? !renderImage : !renderBuffers) || wave[pass] != waveIndex)
+				continue;
+
+			if (pass == (size_t)EPass::Image)
+			{
+				SubmitRenderImage(scheduler, group, shaderPass.m_shader, *image, imageSettings, passContexts[pass]);
+				imageInWave = true;
+			}
+			else
+				SubmitRenderPass(scheduler, group, shaderPass.m_shader, m_buffers[pass][1 - m_current[pass]], bufferSettings, passContexts[pass]);
+		}
+		scheduler.Wait(group);
+
+		if (!imageInWave)
+			continue;
+
+		const size_t imagePass = (size_t)EPass::Image;
+		for (size_t level = 0; level < numLevels; ++level)
+		{
+			if (level > 0)
+			{
+				imageSettings.m_skipStep = imageSettings.m_pixelStep;
+				imageSettings.m_pixelStep /= 2;
+				STaskGroup levelGroup;
+				SubmitRenderImage(scheduler, levelGroup, m_passes[imagePass].m_shader, *image, imageSettings, passContexts[imagePass]);
+				scheduler.Wait(levelGroup);
+			}
+			if (onLevel)
+				onLevel(level, numLevels);
+		}
+	}
+
+	for (size_t buffer = 0; buffer < c_numBufferPasses && renderBuffers; ++buffer)
+	{
+		if (m_passes[buffer].m_enabled)
+			m_current[buffer] = 1 - m_current[buffer];
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Renderer.h"
+#include "Texture.h"
+#include "TileHistory.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// Shadertoy's passes, in the order they run within a frame
+enum class EPass
+{
+	BufferA,
+	BufferB,
+	BufferC,
+	BufferD,
+	Image,
+
+	Count
+};
+
+static const size_t c_numBufferPasses = (size_t)EPass::Image;
+
+//-------------------------------------------------------------------------------------
+// What one iChannel of a pass reads, and how it is filtered and wrapped. The defaults
+// match Shadertoy's.
+struct SChannelInput
+{
+	SChannelInput()
+		: m_buffer(EPass::Count)
+		, m_texture(nullptr)
+		, m_filter(ETextureFilter::Linear)
+		, m_wrap(ETextureWrap::Clamp)
+	{ }
+
+	// A buffer that runs earlier in the frame is read as it is this frame. The pass's own
+	// buffer, or one that runs later, is read as it was at the end of the previous frame.
+	static SChannelInput Buffer (EPass buffer, ETextureFilter filter = ETextureFilter::Linear, ETextureWrap wrap = ETextureWrap::Clamp)
+	{
+		SChannelInput input;
+		input.m_buffer = buffer;
+		input.m_filter = filter;
+		input.m_wrap = wrap;
+		return input;
+	}
+
+	// A texture loaded with SPassGraph::LoadTexture()
+	static SChannelInput Texture (const STexture* texture, ETextureFilter filter = ETextureFilter::Mipmap, ETextureWrap wrap = ETextureWrap::Repeat)
+	{
+		SChannelInput input;
+		input.m_texture = texture;
+		input.m_filter = filter;
+		input.m_wrap = wrap;
+		return input;
+	}
+
+	EPass m_buffer;             // EPass::Count when not reading a buffer
+	const STexture* m_texture;
+	ETextureFilter m_filter;
+	ETextureWrap m_wrap;
+};
+
+//-------------------------------------------------------------------------------------
+struct SShaderPass
+{
+	SShaderPass()
+		: m_enabled(false)
+	{ }
+
+	bool m_enabled;
+	SShader m_shader;
+	SChannelInput m_channels[4];
+};
+
+//-------------------------------------------------------------------------------------
+// Called after each progressive level of the image pass has finished, with the level
+// just rendered (numLevels - 1 being the full resolution image)
+typedef std::function<void(size_t level, size_t numLevels)> TProgressCallback;
+
+//-------------------------------------------------------------------------------------
+// The passes of a shader and the float RGBA buffers that Buffer A-D render into. Each
+// buffer is double buffered: a frame renders into one half while passes that want the
+// previous frame read the other, and the halves swap at the end of the frame instead of
+// being copied. Buffers are kept from frame to frame (which is what makes feedback
+// effects work) and only reallocated when the resolution changes.
+struct SPassGraph
+{
+	SPassGraph();
+
+	// Enable a pass. The image pass is enabled with mainImage() of main.cpp to begin with.
+	SShaderPass& SetPass (EPass pass, const SShader& shader);
+
+	// Switch a pass off and unbind its channels. Its buffer keeps its contents in case the
+	// pass is enabled again.
+	void DisablePass (EPass pass);
+
+	// Render every enabled pass of one frame, the image pass into image. Passes that don't
+	// read each other's output from this frame render at the same time. The settings'
+	// region and progressive levels only apply to the image pass; onLevel (if set) sees
+	// each level's image as soon as it's done.
+	void Render (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel = TProgressCallback());
+	void Render (STaskScheduler& scheduler, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel = TProgressCallback());
+
+	// Or render a frame in two halves: the buffer passes, for an image of width x height,
+	// then the image pass as many times as needed (for different regions, say) before the
+	// next frame's buffers. RenderBuffers() followed by one RenderImage() is the same as
+	// Render().
+	void RenderBuffers (STaskScheduler& scheduler, long width, long height, const SRenderSettings& settings, const SRenderContext& context);
+	void RenderImage (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context);
+	void RenderImage (STaskScheduler& scheduler, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context);
+
+	// Whether any buffer pass is enabled, so frames depend on the ones before them
+	bool HasBufferPasses () const;
+
+	// Clear the buffers to black, like restarting the shader. Tiles kept for
+	// SRenderSettings::m_reuseTiles are forgotten, as they are whenever a pass changes.
+	void Reset ();
+
+	// Load a BMP for use as a channel input, once however many channels use it. Returns
+	// nullptr (which samples as black) if it can't be loaded.
+	const STexture* LoadTexture (const char* fileName);
+
+private:
+	enum class EPassSelection
+	{
+		All,
+		Buffers,
+		Image,
+	};
+
+	template <typename TImage>
+	void RenderPasses (STaskScheduler& scheduler, EPassSelection selection, TImage* image, long width, long height, const SRenderSettings& settings, const SRenderContext& context, const TProgressCallback& onLevel);
+
+	SShaderPass m_passes[(size_t)EPass::Count];
+	STexture m_buffers[c_numBufferPasses][2];
+	size_t m_current[c_numBufferPasses];    // which half holds the last finished frame
+	STileHistory m_imageHistory;            // the image pass's tiles, for m_reuseTiles
+	std::map<std::string, std::unique_ptr<STexture>> m_textures;
+};
+
+//-------------------------------------------------------------------------------------
+// Set up the passes of the shader being debugged. Edit ShaderPasses.cpp to add buffer
+// passes and bind their iChannels.
+void DescribeShaderPasses (SPassGraph& graph);
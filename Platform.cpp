@@ -0,0 +1,900 @@
+#include "Platform.h"
+#include <algorithm>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#if !defined(__x86_64__) || !defined(__ELF__) || defined(PLATFORM_FIBER_UCONTEXT)
+#include <ucontext.h>
+#endif
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#endif
+#endif
+
+//-------------------------------------------------------------------------------------
+bool PinCurrentThreadToCore (size_t core)
+{
+	size_t numCores = std::thread::hardware_concurrency();
+	if (numCores > 0)
+		core %= numCores;
+
+#ifdef _WIN32
+	if (core >= sizeof(DWORD_PTR) * 8)
+		return false;
+	return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	CPU_SET(core, &cpuSet);
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+	// no portable way to pin threads, e.g. on macOS
+	(void)core;
+	return false;
+#endif
+}
+
+#ifdef _WIN32
+
+//-------------------------------------------------------------------------------------
+SMappedFile::SMappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+	, m_writing(false)
+{ }
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::OpenRead (const char* fileName)
+{
+	Close();
+
+	m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER fileSize;
+	if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	m_data = m_mapping ? (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!m_data)
+	{
+		Close();
+		return false;
+	}
+	m_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::Create (const char* fileName, size_t size)
+{
+	Close();
+	if (size == 0)
+		return false;
+
+	m_file = CreateFileA(fileName, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	// mapping more than the file holds grows the file to that size, allocating its disk
+	// space
+	ULARGE_INTEGER mappingSize;
+	mappingSize.QuadPart = size;
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+	m_data = m_mapping ? (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+	if (!m_data)
+	{
+		Close();
+		return false;
+	}
+	m_size = size;
+	m_writing = true;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::Close ()
+{
+	bool closed = true;
+	if (m_data && m_writing && (!FlushViewOfFile(m_data, 0) || !FlushFileBuffers(m_file)))
+	{
+		fprintf(stderr, "Couldn't write mapped file (error %lu)\n", GetLastError());
+		closed = false;
+	}
+	if (m_data && !UnmapViewOfFile(m_data))
+		closed = false;
+	if (m_mapping && !CloseHandle(m_mapping))
+		closed = false;
+	if (m_file != INVALID_HANDLE_VALUE && !CloseHandle(m_file))
+		closed = false;
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+	m_writing = false;
+	return closed;
+}
+
+#else
+
+//-------------------------------------------------------------------------------------
+SMappedFile::SMappedFile()
+	: m_data(nullptr)
+	, m_size(0)
+	, m_file(-1)
+	, m_writing(false)
+{ }
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::OpenRead (const char* fileName)
+{
+	Close();
+
+	m_file = open(fileName, O_RDONLY);
+	struct stat fileStat;
+	if (m_file < 0 || fstat(m_file, &fileStat) != 0 || fileStat.st_size <= 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	m_data = (uint8_t*)data;
+	m_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::Create (const char* fileName, size_t size)
+{
+	Close();
+	if (size == 0)
+		return false;
+
+	m_file = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (m_file < 0)
+		return false;
+
+	// allocate the blocks now: a file only grown with ftruncate is sparse, and a full disk
+	// would then show up as SIGBUS on whichever render thread first wrote to a page
+#ifdef __APPLE__
+	fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)size, 0 };
+	int error = fcntl(m_file, F_PREALLOCATE, &store) == -1 || ftruncate(m_file, (off_t)size) != 0 ? errno : 0;
+#else
+	int error = posix_fallocate(m_file, 0, (off_t)size);
+#endif
+	if (error != 0)
+	{
+		fprintf(stderr, "Couldn't allocate %zu bytes for %s: %s\n", size, fileName, strerror(error));
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	m_data = (uint8_t*)data;
+	m_size = size;
+	m_writing = true;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SMappedFile::Close ()
+{
+	bool closed = true;
+	if (m_data && m_writing && msync(m_data, m_size, MS_SYNC) != 0)
+	{
+		fprintf(stderr, "Couldn't write mapped file: %s\n", strerror(errno));
+		closed = false;
+	}
+	if (m_data && munmap(m_data, m_size) != 0)
+		closed = false;
+	if (m_file >= 0 && close(m_file) != 0)
+		closed = false;
+
+	m_data = nullptr;
+	m_size = 0;
+	m_file = -1;
+	m_writing = false;
+	return closed;
+}
+
+#endif
+
+//-------------------------------------------------------------------------------------
+SMappedFile::~SMappedFile()
+{
+	Close();
+}
+
+//-------------------------------------------------------------------------------------
+SFiber::SFiber()
+	: m_state(nullptr)
+{ }
+
+//-------------------------------------------------------------------------------------
+SSharedLibrary::SSharedLibrary()
+	: m_handle(nullptr)
+{ }
+
+//-------------------------------------------------------------------------------------
+SSharedLibrary::~SSharedLibrary()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+//-------------------------------------------------------------------------------------
+bool SSharedLibrary::Open (const char* fileName)
+{
+	Close();
+	m_handle = LoadLibraryA(fileName);
+	if (!m_handle)
+		fprintf(stderr, "Could not load %s (error %lu)\n", fileName, (unsigned long)GetLastError());
+	return m_handle != nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+void SSharedLibrary::Close ()
+{
+	if (m_handle)
+		FreeLibrary((HMODULE)m_handle);
+	m_handle = nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+void* SSharedLibrary::FindSymbol (const char* name) const
+{
+	return m_handle ? (void*)GetProcAddress((HMODULE)m_handle, name) : nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+struct SFiberState
+{
+	void* m_fiber;
+	void* m_caller;
+	void (*m_function)(void* argument);
+	void* m_argument;
+};
+
+static void CALLBACK FiberEntry (void* parameter)
+{
+	SFiberState& state = *(SFiberState*)parameter;
+	state.m_function(state.m_argument);
+}
+
+//-------------------------------------------------------------------------------------
+bool SFiber::Create (size_t stackSize, void (*function)(void* argument), void* argument)
+{
+	SFiberState* state = new (std::nothrow) SFiberState;
+	if (!state)
+		return false;
+	state->m_caller = nullptr;
+	state->m_function = function;
+	state->m_argument = argument;
+	state->m_fiber = CreateFiber(stackSize, FiberEntry, state);
+	if (!state->m_fiber)
+	{
+		delete state;
+		return false;
+	}
+	m_state = state;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+SFiber::~SFiber()
+{
+	if (SFiberState* state = (SFiberState*)m_state)
+	{
+		DeleteFiber(state->m_fiber);
+		delete state;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Resume ()
+{
+	// only a fiber can switch to another one
+	if (!IsThreadAFiber())
+		ConvertThreadToFiber(nullptr);
+
+	SFiberState& state = *(SFiberState*)m_state;
+	state.m_caller = GetCurrentFiber();
+	SwitchToFiber(state.m_fiber);
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Suspend ()
+{
+	SwitchToFiber(((SFiberState*)m_state)->m_caller);
+}
+
+//-------------------------------------------------------------------------------------
+bool GetFileModifiedTime (const char* fileName, uint64_t& modifiedTime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileName, GetFileExInfoStandard, &attributes))
+		return false;
+	modifiedTime = (uint64_t(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool GetExecutableFileName (char* fileName, size_t size)
+{
+	DWORD length = GetModuleFileNameA(nullptr, fileName, (DWORD)size);
+	return length > 0 && length < size;
+}
+
+#else
+
+//-------------------------------------------------------------------------------------
+bool SSharedLibrary::Open (const char* fileName)
+{
+	Close();
+
+	// dlopen only searches the library path for names without a slash
+	std::string path = strchr(fileName, '/') ? fileName : std::string("./") + fileName;
+	m_handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!m_handle)
+		fprintf(stderr, "Could not load %s: %s\n", fileName, dlerror());
+	return m_handle != nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+void SSharedLibrary::Close ()
+{
+	if (m_handle)
+		dlclose(m_handle);
+	m_handle = nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+void* SSharedLibrary::FindSymbol (const char* name) const
+{
+	return m_handle ? dlsym(m_handle, name) : nullptr;
+}
+
+//-------------------------------------------------------------------------------------
+// Fiber stacks are mapped rather than allocated, with an inaccessible guard page below
+// them, so a shader that runs off the end of one crashes there instead of quietly writing
+// over whatever is next. Pages are only committed as the stack grows into them. Returns
+// the lowest usable byte, or null if there isn't the address space.
+static char* AllocateFiberStack (size_t stackSize)
+{
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t mappingSize = (stackSize + pageSize - 1) / pageSize * pageSize + pageSize;
+	void* mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mapping == MAP_FAILED)
+		return nullptr;
+	if (mprotect(mapping, pageSize, PROT_NONE) != 0)
+	{
+		munmap(mapping, mappingSize);
+		return nullptr;
+	}
+	return (char*)mapping + pageSize;
+}
+
+static void FreeFiberStack (char* stack, size_t stackSize)
+{
+	const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	const size_t mappingSize = (stackSize + pageSize - 1) / pageSize * pageSize + pageSize;
+	munmap(stack - pageSize, mappingSize);
+}
+
+#if defined(__x86_64__) && defined(__ELF__) && !defined(PLATFORM_FIBER_UCONTEXT)
+
+// swapcontext() makes a system call to swap the signal mask each time, which costs more
+// than a quad of simple pixels, so x86-64 switches stacks itself. Only the registers the
+// SysV ABI says a call preserves are saved: rbx, rbp and r12-r15. The SSE and x87
+// control words are left alone, since nothing here changes them between switches.
+//
+// PlatformSwitchStack(void** saveStack, void* loadStack)
+asm(R"(
+	.text
+	.p2align 4
+	.type PlatformSwitchStack, @function
+PlatformSwitchStack:
+	pushq %rbp
+	pushq %rbx
+	pushq %r12
+	pushq %r13
+	pushq %r14
+	pushq %r15
+	movq %rsp, (%rdi)
+	movq %rsi, %rsp
+	popq %r15
+	popq %r14
+	popq %r13
+	popq %r12
+	popq %rbx
+	popq %rbp
+	ret
+	.size PlatformSwitchStack, .-PlatformSwitchStack
+
+	.p2align 4
+	.type PlatformFiberStart, @function
+PlatformFiberStart:
+	movq %r12, %rdi
+	callq *%r13
+	ud2
+	.size PlatformFiberStart, .-PlatformFiberStart
+)");
+
+extern "C" void PlatformSwitchStack (void** saveStack, void* loadStack);
+extern "C" void PlatformFiberStart ();
+
+struct SFiberState
+{
+	void* m_stackPointer;
+	void* m_callerStackPointer;
+	void (*m_function)(void* argument);
+	void* m_argument;
+	char* m_stack;
+	size_t m_stackSize;
+};
+
+static void FiberEntry (void* parameter)
+{
+	SFiberState& state = *(SFiberState*)parameter;
+	state.m_function(state.m_argument);
+}
+
+//-------------------------------------------------------------------------------------
+bool SFiber::Create (size_t stackSize, void (*function)(void* argument), void* argument)
+{
+	char* stack = AllocateFiberStack(stackSize);
+	SFiberState* state = stack ? new (std::nothrow) SFiberState : nullptr;
+	if (!state)
+	{
+		if (stack)
+			FreeFiberStack(stack, stackSize);
+		return false;
+	}
+	state->m_function = function;
+	state->m_argument = argument;
+	state->m_stack = stack;
+	state->m_stackSize = stackSize;
+
+	// a frame for PlatformSwitchStack() to pop: r15-r12, rbx, rbp, then
+	// PlatformFiberStart() to return into, which calls FiberEntry(r12) with the stack
+	// aligned to 16 bytes like a call would
+	uint64_t* top = (uint64_t*)(uintptr_t(state->m_stack + stackSize) & ~uintptr_t(15));
+	uint64_t* frame = top - 9;
+	frame[0] = 0;                               // r15
+	frame[1] = 0;                               // r14
+	frame[2] = uint64_t(uintptr_t(FiberEntry)); // r13
+	frame[3] = uint64_t(uintptr_t(state));      // r12
+	frame[4] = 0;                               // rbx
+	frame[5] = 0;                               // rbp
+	frame[6] = uint64_t(uintptr_t(PlatformFiberStart));
+	frame[7] = 0;
+	frame[8] = 0;
+	state->m_stackPointer = frame;
+	m_state = state;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Resume ()
+{
+	SFiberState& state = *(SFiberState*)m_state;
+	PlatformSwitchStack(&state.m_callerStackPointer, state.m_stackPointer);
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Suspend ()
+{
+	SFiberState& state = *(SFiberState*)m_state;
+	PlatformSwitchStack(&state.m_stackPointer, state.m_callerStackPointer);
+}
+
+#else
+
+//-------------------------------------------------------------------------------------
+struct SFiberState
+{
+	ucontext_t m_context;
+	ucontext_t m_caller;
+	void (*m_function)(void* argument);
+	void* m_argument;
+	char* m_stack;
+	size_t m_stackSize;
+};
+
+// makecontext() only passes ints, so Create() hands the state over here and switches to
+// the fiber once to pick it up
+static thread_local SFiberState* s_startingFiber = nullptr;
+
+static void FiberEntry ()
+{
+	SFiberState& state = *s_startingFiber;
+	swapcontext(&state.m_context, &state.m_caller);
+	state.m_function(state.m_argument);
+}
+
+//-------------------------------------------------------------------------------------
+bool SFiber::Create (size_t stackSize, void (*function)(void* argument), void* argument)
+{
+	char* stack = AllocateFiberStack(stackSize);
+	SFiberState* state = stack ? new (std::nothrow) SFiberState : nullptr;
+	if (!state || getcontext(&state->m_context) != 0)
+	{
+		if (stack)
+			FreeFiberStack(stack, stackSize);
+		delete state;
+		return false;
+	}
+	state->m_function = function;
+	state->m_argument = argument;
+	state->m_stack = stack;
+	state->m_stackSize = stackSize;
+	state->m_context.uc_stack.ss_sp = state->m_stack;
+	state->m_context.uc_stack.ss_size = stackSize;
+	state->m_context.uc_link = nullptr;
+	makecontext(&state->m_context, FiberEntry, 0);
+	m_state = state;
+
+	s_startingFiber = state;
+	Resume();
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Resume ()
+{
+	SFiberState& state = *(SFiberState*)m_state;
+	swapcontext(&state.m_caller, &state.m_context);
+}
+
+//-------------------------------------------------------------------------------------
+void SFiber::Suspend ()
+{
+	SFiberState& state = *(SFiberState*)m_state;
+	swapcontext(&state.m_context, &state.m_caller);
+}
+
+#endif
+
+//-------------------------------------------------------------------------------------
+SFiber::~SFiber()
+{
+	if (SFiberState* state = (SFiberState*)m_state)
+	{
+		FreeFiberStack(state->m_stack, state->m_stackSize);
+		delete state;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool GetFileModifiedTime (const char* fileName, uint64_t& modifiedTime)
+{
+	struct stat fileStat;
+	if (stat(fileName, &fileStat) != 0)
+		return false;
+	#if defined(__APPLE__)
+	modifiedTime = uint64_t(fileStat.st_mtimespec.tv_sec) * 1000000000 + uint64_t(fileStat.st_mtimespec.tv_nsec);
+	#else
+	modifiedTime = uint64_t(fileStat.st_mtim.tv_sec) * 1000000000 + uint64_t(fileStat.st_mtim.tv_nsec);
+	#endif
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool GetExecutableFileName (char* fileName, size_t size)
+{
+#if defined(__APPLE__)
+	uint32_t bufferSize = (uint32_t)size;
+	return _NSGetExecutablePath(fileName, &bufferSize) == 0;
+#else
+	ssize_t length = readlink("/proc/self/exe", fileName, size);
+	if (length <= 0 || (size_t)length >= size)
+		return false;
+	fileName[length] = 0;
+	return true;
+#endif
+}
+
+#endif
+
+#ifdef _WIN32
+
+typedef SOCKET TSocketHandle;
+static const TSocketHandle c_invalidSocket = INVALID_SOCKET;
+static const int c_sendFlags = 0;
+
+// Winsock has to be started before the first socket, and is left running until exit
+static bool StartSockets ()
+{
+	static const bool s_started = []()
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+	return s_started;
+}
+
+static void CloseSocketHandle (TSocketHandle handle) { closesocket(handle); }
+static int LastSocketError () { return WSAGetLastError(); }
+static bool WasInterrupted () { return false; }
+
+//-------------------------------------------------------------------------------------
+bool SSocket::SetTimeout (unsigned milliseconds)
+{
+	DWORD timeout = milliseconds;
+	return setsockopt((TSocketHandle)m_socket, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout)) == 0
+		&& setsockopt((TSocketHandle)m_socket, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout)) == 0;
+}
+
+//-------------------------------------------------------------------------------------
+void SSocket::Shutdown ()
+{
+	if (IsOpen())
+		shutdown((TSocketHandle)m_socket, SD_BOTH);
+}
+
+#else
+
+typedef int TSocketHandle;
+static const TSocketHandle c_invalidSocket = -1;
+
+// a closed connection fails the send instead of killing the process, with a flag where
+// there is one and SO_NOSIGPIPE on each socket (macOS) otherwise
+#ifdef MSG_NOSIGNAL
+static const int c_sendFlags = MSG_NOSIGNAL;
+#else
+static const int c_sendFlags = 0;
+#endif
+
+static bool StartSockets () { return true; }
+static void CloseSocketHandle (TSocketHandle handle) { close(handle); }
+static int LastSocketError () { return errno; }
+static bool WasInterrupted () { return errno == EINTR; }
+
+//-------------------------------------------------------------------------------------
+bool SSocket::SetTimeout (unsigned milliseconds)
+{
+	timeval timeout;
+	timeout.tv_sec = milliseconds / 1000;
+	timeout.tv_usec = (milliseconds % 1000) * 1000;
+	return setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0
+		&& setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) == 0;
+}
+
+//-------------------------------------------------------------------------------------
+void SSocket::Shutdown ()
+{
+	if (IsOpen())
+		shutdown(m_socket, SHUT_RDWR);
+}
+
+#endif
+
+//-------------------------------------------------------------------------------------
+// Settings every connection gets, whichever end made it
+static void SetUpConnection (TSocketHandle handle)
+{
+	int on = 1;
+	setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+	setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+//-------------------------------------------------------------------------------------
+SSocket::SSocket()
+	: m_socket(c_invalidSocket)
+{ }
+
+//-------------------------------------------------------------------------------------
+SSocket::~SSocket()
+{
+	Close();
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::IsOpen () const
+{
+	return (TSocketHandle)m_socket != c_invalidSocket;
+}
+
+//-------------------------------------------------------------------------------------
+void SSocket::Close ()
+{
+	if (IsOpen())
+		CloseSocketHandle((TSocketHandle)m_socket);
+	m_socket = c_invalidSocket;
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::Listen (uint16_t port, const char* interfaceAddress)
+{
+	Close();
+	if (!StartSockets())
+	{
+		fprintf(stderr, "Could not start sockets\n");
+		return false;
+	}
+
+	TSocketHandle handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (handle == c_invalidSocket)
+	{
+		fprintf(stderr, "Could not create a socket (error %d)\n", LastSocketError());
+		return false;
+	}
+
+	// so a worker can be restarted on its port straight away
+	int on = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+	if (interfaceAddress)
+	{
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+		addrinfo* addresses = nullptr;
+		if (getaddrinfo(interfaceAddress, nullptr, &hints, &addresses) != 0 || !addresses)
+		{
+			fprintf(stderr, "Could not find the address %s to listen on\n", interfaceAddress);
+			CloseSocketHandle(handle);
+			return false;
+		}
+		address.sin_addr = ((const sockaddr_in*)addresses->ai_addr)->sin_addr;
+		freeaddrinfo(addresses);
+	}
+	if (bind(handle, (const sockaddr*)&address, sizeof(address)) != 0 || listen(handle, SOMAXCONN) != 0)
+	{
+		fprintf(stderr, "Could not listen on port %u (error %d)\n", (unsigned)port, LastSocketError());
+		CloseSocketHandle(handle);
+		return false;
+	}
+	m_socket = handle;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::Accept (SSocket& connection)
+{
+	connection.Close();
+	TSocketHandle handle;
+	do
+		handle = accept((TSocketHandle)m_socket, nullptr, nullptr);
+	while (handle == c_invalidSocket && WasInterrupted());
+	if (handle == c_invalidSocket)
+		return false;
+
+	SetUpConnection(handle);
+	connection.m_socket = handle;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::Connect (const char* host, uint16_t port)
+{
+	Close();
+	if (!StartSockets())
+	{
+		fprintf(stderr, "Could not start sockets\n");
+		return false;
+	}
+
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	std::string service = std::to_string((unsigned)port);
+	int error = getaddrinfo(host, service.c_str(), &hints, &addresses);
+	if (error != 0)
+	{
+		fprintf(stderr, "Could not look up %s (%s)\n", host, gai_strerror(error));
+		return false;
+	}
+
+	// a name can have several addresses, e.g. localhost as both ::1 and 127.0.0.1, and
+	// the worker may only be listening on one
+	for (addrinfo* address = addresses; address && !IsOpen(); address = address->ai_next)
+	{
+		TSocketHandle handle = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (handle == c_invalidSocket)
+			continue;
+		if (connect(handle, address->ai_addr, (int)address->ai_addrlen) != 0)
+		{
+			error = LastSocketError();
+			CloseSocketHandle(handle);
+			continue;
+		}
+		SetUpConnection(handle);
+		m_socket = handle;
+	}
+	freeaddrinfo(addresses);
+
+	if (!IsOpen())
+		fprintf(stderr, "Could not connect to %s:%u (error %d)\n", host, (unsigned)port, error);
+	return IsOpen();
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::Send (const void* data, size_t size)
+{
+	const char* bytes = (const char*)data;
+	while (size > 0)
+	{
+		int sent = (int)send((TSocketHandle)m_socket, bytes, (int)std::min<size_t>(size, 1 << 30), c_sendFlags);
+		if (sent <= 0)
+		{
+			if (sent < 0 && WasInterrupted())
+				continue;
+			return false;
+		}
+		bytes += sent;
+		size -= (size_t)sent;
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool SSocket::Receive (void* data, size_t size)
+{
+	char* bytes = (char*)data;
+	while (size > 0)
+	{
+		int received = (int)recv((TSocketHandle)m_socket, bytes, (int)std::min<size_t>(size, 1 << 30), 0);
+		if (received <= 0)
+		{
+			if (received < 0 && WasInterrupted())
+				continue;
+			return false;
+		}
+		bytes += received;
+		size -= (size_t)received;
+	}
+	return true;
+}
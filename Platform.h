@@ -0,0 +1,179 @@
+#pragma once
+
+// The few operating system specific things the harness needs, behind one interface for
+// Windows and POSIX systems.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PLATFORM_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PLATFORM_HAS_RDTSC 1
+#else
+#include <chrono>
+#define PLATFORM_HAS_RDTSC 0
+#endif
+
+//-------------------------------------------------------------------------------------
+// Restrict the calling thread to one logical core (wrapping around if core is past the
+// last one). Returns false if the OS refused.
+bool PinCurrentThreadToCore (size_t core);
+
+//-------------------------------------------------------------------------------------
+// A file mapped into memory, so it can be read or written in place without copying it
+// through a buffer. Unmapped when closed or destroyed.
+struct SMappedFile
+{
+	SMappedFile();
+	~SMappedFile();
+
+	// Map an existing file read only
+	bool OpenRead (const char* fileName);
+
+	// Create (or truncate) a file of the given size and map it for writing. Its disk space
+	// is allocated up front, so this fails if the disk is full rather than the first
+	// write to a page of it.
+	bool Create (const char* fileName, size_t size);
+
+	// Flushes a file being written to disk before unmapping it, printing why to stderr if
+	// that fails. Returns false if it couldn't be written or closed cleanly.
+	bool Close ();
+
+	uint8_t* m_data;
+	size_t m_size;
+
+private:
+	SMappedFile(const SMappedFile&) = delete;
+	SMappedFile& operator = (const SMappedFile&) = delete;
+
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+	bool m_writing;
+};
+
+//-------------------------------------------------------------------------------------
+// A shared library (.dll or .so) loaded into the process. Unloaded when closed or
+// destroyed, after which nothing found in it may be used.
+struct SSharedLibrary
+{
+	SSharedLibrary();
+	~SSharedLibrary();
+
+	// Returns false (after printing why to stderr) if it couldn't be loaded
+	bool Open (const char* fileName);
+	void Close ();
+
+	// The address of an exported function or variable, or null
+	void* FindSymbol (const char* name) const;
+
+	bool IsOpen () const { return m_handle != nullptr; }
+
+private:
+	SSharedLibrary(const SSharedLibrary&) = delete;
+	SSharedLibrary& operator = (const SSharedLibrary&) = delete;
+
+	void* m_handle;
+};
+
+//-------------------------------------------------------------------------------------
+// A function running on a stack of its own, which the thread that made it switches into
+// and back out of explicitly. The function runs from the first Resume() and must never
+// return; it hands control back with Suspend() instead.
+struct SFiber
+{
+	SFiber();
+	~SFiber();
+
+	// Returns false if the stack couldn't be allocated
+	bool Create (size_t stackSize, void (*function)(void* argument), void* argument);
+
+	// Run the fiber until it suspends. Only from the thread that created it.
+	void Resume ();
+
+	// Called on the fiber, to switch back to where it was resumed from
+	void Suspend ();
+
+	bool IsCreated () const { return m_state != nullptr; }
+
+private:
+	SFiber(const SFiber&) = delete;
+	SFiber& operator = (const SFiber&) = delete;
+
+	void* m_state;
+};
+
+//-------------------------------------------------------------------------------------
+// When a file was last written, in units that are only good for telling whether it has
+// changed. Returns false if the file doesn't exist.
+bool GetFileModifiedTime (const char* fileName, uint64_t& modifiedTime);
+
+//-------------------------------------------------------------------------------------
+// The path of the running program's own executable. Returns false if it can't be found
+// or doesn't fit in size characters.
+bool GetExecutableFileName (char* fileName, size_t size);
+
+//-------------------------------------------------------------------------------------
+// A TCP connection, or a socket listening for them. Closed when destroyed. Calls block,
+// and fail rather than raise SIGPIPE when the other end has gone away.
+struct SSocket
+{
+	SSocket();
+	~SSocket();
+
+	// Listen on a port of every network interface, or only of the one with the given IPv4
+	// address or host name. Returns false (after printing why to stderr) if the port can't
+	// be had.
+	bool Listen (uint16_t port, const char* interfaceAddress = nullptr);
+
+	// Wait for a connection to a listening socket
+	bool Accept (SSocket& connection);
+
+	// Connect to a host name or address. Returns false (after printing why to stderr) if
+	// it couldn't. Small messages are sent straight away rather than held back to be
+	// batched, as both ends wait on each other's replies.
+	bool Connect (const char* host, uint16_t port);
+
+	// Make a Send() or Receive() that gets nowhere for this long fail, 0 for never
+	bool SetTimeout (unsigned milliseconds);
+
+	// Send or receive exactly size bytes. Returns false on an error, a timeout or the
+	// connection closing.
+	bool Send (const void* data, size_t size);
+	bool Receive (void* data, size_t size);
+
+	// Make calls blocked on the socket in other threads fail, without closing it yet
+	void Shutdown ();
+	void Close ();
+
+	bool IsOpen () const;
+
+private:
+	SSocket(const SSocket&) = delete;
+	SSocket& operator = (const SSocket&) = delete;
+
+#ifdef _WIN32
+	uintptr_t m_socket;
+#else
+	int m_socket;
+#endif
+};
+
+//-------------------------------------------------------------------------------------
+// A cheap, monotonic tick count for measuring short stretches of code on one thread. The
+// CPU timestamp counter where there is one, nanoseconds otherwise. Ticks are only
+// comparable with each other, not with wall time.
+inline uint64_t ReadCycleCounter ()
+{
+#if PLATFORM_HAS_RDTSC
+	return __rdtsc();
+#else
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
@@ -0,0 +1,95 @@
+#include "QuadRunner.h"
+#include "Settings.h"
+
+//-------------------------------------------------------------------------------------
+SQuadRunner::SQuadRunner()
+	: m_shadePixel(nullptr)
+	, m_shader(nullptr)
+	, m_fragCoords(nullptr)
+	, m_colors(nullptr)
+	, m_running(0)
+	, m_waiting(0)
+{
+	m_exchange = Exchange;
+	m_invocation = 0;
+	m_exchanges = 0;
+	m_posted[0] = 0;
+	m_posted[1] = 0;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		m_invocations[i].m_runner = this;
+		m_invocations[i].m_index = i;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+SQuadRunner& SQuadRunner::ForCurrentThread ()
+{
+	static thread_local SQuadRunner s_runner;
+	return s_runner;
+}
+
+//-------------------------------------------------------------------------------------
+void SQuadRunner::InvocationMain (void* argument)
+{
+	SInvocation& invocation = *(SInvocation*)argument;
+	SQuadRunner& runner = *invocation.m_runner;
+	for (;;)
+	{
+		runner.m_shadePixel(runner.m_shader, runner.m_colors[invocation.m_index], runner.m_fragCoords[invocation.m_index]);
+		runner.m_running &= ~(1u << invocation.m_index);
+		invocation.m_fiber.Suspend();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void SQuadRunner::Exchange (SShaderQuad& quad)
+{
+	SQuadRunner& runner = static_cast<SQuadRunner&>(quad);
+	SInvocation& invocation = runner.m_invocations[runner.m_invocation];
+	runner.m_waiting |= 1u << invocation.m_index;
+	invocation.m_fiber.Suspend();
+}
+
+//-------------------------------------------------------------------------------------
+void SQuadRunner::Run (SShaderQuadSlot& slot, TShadePixel shadePixel, const void* shader, const vec2 fragCoords[4], vec4 colors[4])
+{
+	for (SInvocation& invocation : m_invocations)
+	{
+		if (!invocation.m_fiber.IsCreated() && !invocation.m_fiber.Create(c_quadFiberStackSize, InvocationMain, &invocation))
+		{
+			// no memory for the stacks: shade the pixels alone, with derivatives of 0
+			for (size_t i = 0; i < 4; ++i)
+				shadePixel(shader, colors[i], fragCoords[i]);
+			return;
+		}
+	}
+
+	m_shadePixel = shadePixel;
+	m_shader = shader;
+	m_fragCoords = fragCoords;
+	m_colors = colors;
+	m_exchanges = 0;
+	m_running = 0xf;
+
+	slot.m_quad = this;
+
+	// each round runs every pixel up to its next derivative (or its end), then publishes
+	// the values they posted for the next round to read
+	while (m_running)
+	{
+		m_waiting = 0;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			if (m_running & (1u << i))
+			{
+				m_invocation = i;
+				m_invocations[i].m_fiber.Resume();
+			}
+		}
+		m_posted[m_exchanges & 1] = m_waiting;
+		++m_exchanges;
+	}
+
+	slot.m_quad = nullptr;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// Runs the four pixels of a 2x2 quad through the scalar shader in lockstep, so dFdx(),
+// dFdy() and fwidth() can see each other's values the way they do on a GPU. Each pixel's
+// mainImage() runs on a fiber of its own. A derivative posts the pixel's value and
+// suspends it; once every pixel of the quad that is still running has posted, they are
+// resumed in turn and read their neighbours' values. So a quad costs about what its four
+// pixels cost one at a time, plus two fiber switches per pixel per derivative.
+//
+// Pixels that return early, or reach different derivative calls after a divergent
+// branch, pair up with whatever the others post next; GLSL leaves derivatives in
+// non-uniform control flow undefined as well.
+
+#include "glslAdapters.h"
+#include "Platform.h"
+
+//-------------------------------------------------------------------------------------
+struct SQuadRunner : SShaderQuad
+{
+	typedef void (*TShadePixel)(const void* shader, vec4& fragColor, vec2 fragCoord);
+
+	SQuadRunner();
+
+	// Shade the quad's pixels at fragCoords into colors, both in the order of
+	// SShaderQuad::m_invocation. slot is the shader's CurrentShaderQuad().
+	void Run (SShaderQuadSlot& slot, TShadePixel shadePixel, const void* shader, const vec2 fragCoords[4], vec4 colors[4]);
+
+	// The calling thread's runner. Its fibers are made the first time a quad runs.
+	static SQuadRunner& ForCurrentThread ();
+
+private:
+	struct SInvocation
+	{
+		SQuadRunner* m_runner;
+		size_t m_index;
+		SFiber m_fiber;
+	};
+
+	static void InvocationMain (void* argument);
+	static void Exchange (SShaderQuad& quad);
+
+	SInvocation m_invocations[4];
+	TShadePixel m_shadePixel;
+	const void* m_shader;
+	const vec2* m_fragCoords;
+	vec4* m_colors;
+	uint32_t m_running;         // invocations that haven't returned from mainImage() yet
+	uint32_t m_waiting;         // invocations suspended in an exchange
+};
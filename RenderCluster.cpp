@@ -0,0 +1,690 @@
+#include "RenderCluster.h"
+#include "Deflate.h"
+#include "Settings.h"
+#include "TileHistory.h"
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <cmath>
+#include <stdlib.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------
+// What a worker sends as soon as a coordinator connects, so neither end talks to
+// something that isn't a worker of the same version with the same shader
+const uint32_t c_remoteMagic = 0x52545348;     // "HSTR"
+const uint32_t c_remoteVersion = 2;
+
+struct SRemoteHello
+{
+	uint32_t m_magic;
+	uint32_t m_version;
+	uint64_t m_shader;          // see GetShaderIdentity()
+};
+
+static_assert(sizeof(SRemoteHello) == 16, "the hello is sent as is, so it can't have padding");
+
+//-------------------------------------------------------------------------------------
+// Everything a worker needs to render one tile. Every field is 4 bytes and sent as is,
+// so both ends need the same byte order (little endian, on everything the harness builds
+// for). The worker answers with a uint32_t that is 1 if it rendered the tile, followed
+// by the tile's rows bottom up and tightly packed.
+//
+// The buffer passes are rendered once per frame on each worker, the first time it sees
+// the frame's number, so with buffer passes every worker has to be sent every frame in
+// order. A 0 x 0 tile at 0, 0 renders just the buffers, for frames the worker has no
+// tiles of, and isn't answered.
+struct SRemoteTileRequest
+{
+	uint32_t m_width;           // of the frame
+	uint32_t m_height;
+	uint32_t m_x;               // the tile, within it
+	uint32_t m_y;
+	uint32_t m_tileWidth;
+	uint32_t m_tileHeight;
+	uint32_t m_floatPixels;     // 1 for float RGBA pixels, 0 for 24 bit BGR
+	uint32_t m_frameNumber;     // counting from 0 for each coordinator
+
+	float m_time;
+	float m_timeDelta;
+	int32_t m_frame;
+	float m_mouse[4];
+	float m_date[4];
+
+	uint32_t m_mode;            // an ERenderMode
+	uint32_t m_fixedKernels;
+	uint32_t m_tileSize;
+	uint32_t m_baseSamples;
+	uint32_t m_maxSamples;
+	float m_sampleThreshold;
+	uint32_t m_sparseStep;
+	float m_sparseThreshold;
+};
+
+static_assert(sizeof(SRemoteTileRequest) == 27 * 4, "tile requests are sent as is, so they can't have padding");
+
+//-------------------------------------------------------------------------------------
+static bool IsBuffersOnlyRequest (const SRemoteTileRequest& request)
+{
+	return request.m_tileWidth == 0 && request.m_tileHeight == 0 && request.m_x == 0 && request.m_y == 0;
+}
+
+//-------------------------------------------------------------------------------------
+static bool IsValidTileRequest (const SRemoteTileRequest& request)
+{
+	bool finite = std::isfinite(request.m_time) && std::isfinite(request.m_timeDelta)
+		&& std::isfinite(request.m_sampleThreshold) && std::isfinite(request.m_sparseThreshold);
+	for (size_t component = 0; component < 4; ++component)
+		finite = finite && std::isfinite(request.m_mouse[component]) && std::isfinite(request.m_date[component]);
+
+	return finite && request.m_width > 0 && request.m_width <= 65536 && request.m_height > 0 && request.m_height <= 65536
+		&& uint64_t(request.m_width) * request.m_height <= SRenderCluster::c_maxFramePixels
+		&& (IsBuffersOnlyRequest(request)
+			|| (request.m_tileWidth > 0 && request.m_tileWidth <= request.m_width && request.m_x <= request.m_width - request.m_tileWidth
+				&& request.m_tileHeight > 0 && request.m_tileHeight <= request.m_height && request.m_y <= request.m_height - request.m_tileHeight))
+		&& request.m_floatPixels <= 1 && request.m_mode <= (uint32_t)ERenderMode::Packet && request.m_tileSize > 0
+		&& request.m_maxSamples >= 1 && request.m_maxSamples <= 65536 && request.m_baseSamples >= 1 && request.m_baseSamples <= request.m_maxSamples
+		&& request.m_sparseStep >= 1 && request.m_sparseStep <= 16;
+}
+
+//-------------------------------------------------------------------------------------
+// Which shader a harness renders: the module it has loaded, or else the one built into
+// it, told apart by the size and CRC-32 of the executable. Harnesses built separately
+// don't match even from the same source, as different compilers can round differently.
+static uint64_t GetShaderIdentity (const SShaderModuleLoader& shaderModule)
+{
+	if (shaderModule.IsLoaded())
+		return shaderModule.GetIdentity();
+
+	static const uint64_t s_executableIdentity = []()
+	{
+		char fileName[4096];
+		SMappedFile executable;
+		if (!GetExecutableFileName(fileName, sizeof(fileName)) || !executable.OpenRead(fileName))
+		{
+			fprintf(stderr, "Could not read the harness executable, so its shader can't be told apart from others\n");
+			return uint64_t(0);
+		}
+		return (uint64_t(executable.m_size) << 32) | Crc32(0, executable.m_data, executable.m_size);
+	}();
+	return s_executableIdentity;
+}
+
+//-------------------------------------------------------------------------------------
+// Copy a width x height tile at x, y out of an image into tightly packed rows, or back
+template <typename TImage>
+static void CopyTileOut (const TImage& image, size_t x, size_t y, size_t width, size_t height, size_t pixelBytes, uint8_t* pixels)
+{
+	for (size_t row = 0; row < height; ++row)
+		memcpy(pixels + row * width * pixelBytes, PixelBytes(image, x, y + row), width * pixelBytes);
+}
+
+template <typename TImage>
+static void CopyTileIn (const TImage& image, size_t x, size_t y, size_t width, size_t height, size_t pixelBytes, const uint8_t* pixels)
+{
+	for (size_t row = 0; row < height; ++row)
+		memcpy(PixelBytes(image, x, y + row), pixels + row * width * pixelBytes, width * pixelBytes);
+}
+
+//-------------------------------------------------------------------------------------
+// The settings and uniforms a request is rendered with
+static SRenderSettings MakeRemoteSettings (const SRemoteTileRequest& request)
+{
+	SRenderSettings settings;
+	settings.m_tileSize = request.m_tileSize;
+	settings.m_mode = (ERenderMode)request.m_mode;
+	settings.m_fixedKernels = request.m_fixedKernels != 0;
+	settings.m_region.m_x = request.m_x;
+	settings.m_region.m_y = request.m_y;
+	settings.m_region.m_width = request.m_tileWidth;
+	settings.m_region.m_height = request.m_tileHeight;
+	settings.m_supersampling.m_baseSamples = request.m_baseSamples;
+	settings.m_supersampling.m_maxSamples = request.m_maxSamples;
+	settings.m_supersampling.m_threshold = request.m_sampleThreshold;
+	settings.m_sparse.m_step = request.m_sparseStep;
+	settings.m_sparse.m_threshold = request.m_sparseThreshold;
+	return settings;
+}
+
+//-------------------------------------------------------------------------------------
+static SRenderContext MakeRemoteContext (const SRemoteTileRequest& request)
+{
+	SRenderContext context = MakeRenderContext((long)request.m_width, (long)request.m_height, request.m_time);
+	context.m_iTimeDelta = request.m_timeDelta;
+	context.m_iFrame = request.m_frame;
+	context.m_iMouse = vec4(request.m_mouse[0], request.m_mouse[1], request.m_mouse[2], request.m_mouse[3]);
+	context.m_iDate = vec4(request.m_date[0], request.m_date[1], request.m_date[2], request.m_date[3]);
+	return context;
+}
+
+//-------------------------------------------------------------------------------------
+// Render the tile a request asks for into pixels, once the buffers are at its frame.
+// Frames are rendered at their whole size, with only the tile's region of them shaded.
+static void RenderRemoteTile (STaskScheduler& scheduler, SPassGraph& passes, const SRemoteTileRequest& request, SImageData& image, SFloatImage& floatImage, std::vector<uint8_t>& pixels)
+{
+	const SRenderSettings settings = MakeRemoteSettings(request);
+	const SRenderContext context = MakeRemoteContext(request);
+	const size_t pixelBytes = request.m_floatPixels ? 4 * sizeof(float) : 3;
+	pixels.resize((size_t)request.m_tileWidth * request.m_tileHeight * pixelBytes);
+	if (request.m_floatPixels)
+	{
+		if (floatImage.m_width != (long)request.m_width || floatImage.m_height != (long)request.m_height)
+			floatImage.Resize((long)request.m_width, (long)request.m_height);
+		passes.RenderImage(scheduler, floatImage, settings, context);
+		CopyTileOut(&floatImage, request.m_x, request.m_y, request.m_tileWidth, request.m_tileHeight, pixelBytes, pixels.data());
+	}
+	else
+	{
+		if (image.m_width != (long)request.m_width || image.m_height != (long)request.m_height)
+			AllocateImage(image, (long)request.m_width, (long)request.m_height);
+		SImageView view(image);
+		passes.RenderImage(scheduler, view, settings, context);
+		CopyTileOut(view, request.m_x, request.m_y, request.m_tileWidth, request.m_tileHeight, pixelBytes, pixels.data());
+	}
+}
+
+//-------------------------------------------------------------------------------------
+int RunRenderWorker (STaskScheduler& scheduler, SPassGraph& passes, SShaderModuleLoader& shaderModule, uint16_t port, const char* interfaceAddress)
+{
+	SSocket listener;
+	if (!listener.Listen(port, interfaceAddress))
+		return 1;
+	fprintf(stderr, "Worker listening on port %u\n", (unsigned)port);
+
+	SImageData image;
+	SFloatImage floatImage;
+	std::vector<uint8_t> pixels;
+	while (true)
+	{
+		// whatever made accepting fail (running out of file descriptors, say) may take a
+		// while to clear up
+		SSocket connection;
+		if (!listener.Accept(connection))
+		{
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			continue;
+		}
+
+		// a coordinator that vanishes without closing the connection is given up on too,
+		// rather than keeping the worker from the next one forever
+		connection.SetTimeout(c_remoteIdleSeconds * 1000);
+
+		// a rebuilt shader module takes over from the next coordinator, and its frames
+		// start over from cleared buffers
+		shaderModule.ReloadIfChanged(passes);
+		passes.Reset();
+		fprintf(stderr, "Coordinator connected\n");
+
+		SRemoteHello hello = { c_remoteMagic, c_remoteVersion, GetShaderIdentity(shaderModule) };
+		bool connected = connection.Send(&hello, sizeof(hello));
+		size_t tiles = 0;
+		uint32_t nextFrame = 0;     // the one after the frame the buffers were last rendered for
+		SRemoteTileRequest request;
+		while (connected && connection.Receive(&request, sizeof(request)))
+		{
+			// buffers can stay at a frame or move on to the next, but not skip any
+			bool feedback = passes.HasBufferPasses();
+			if (!IsValidTileRequest(request) || (feedback && request.m_frameNumber != nextFrame && request.m_frameNumber + 1 != nextFrame))
+			{
+				fprintf(stderr, "Bad tile request, dropping the coordinator\n");
+				uint32_t rendered = 0;
+				connection.Send(&rendered, sizeof(rendered));
+				break;
+			}
+
+			if (request.m_frameNumber + 1 != nextFrame)
+			{
+				passes.RenderBuffers(scheduler, (long)request.m_width, (long)request.m_height, MakeRemoteSettings(request), MakeRemoteContext(request));
+				nextFrame = request.m_frameNumber + 1;
+			}
+			if (IsBuffersOnlyRequest(request))
+				continue;
+
+			RenderRemoteTile(scheduler, passes, request, image, floatImage, pixels);
+			uint32_t rendered = 1;
+			connected = connection.Send(&rendered, sizeof(rendered)) && connection.Send(pixels.data(), pixels.size());
+			++tiles;
+		}
+		fprintf(stderr, "Coordinator gone after %zu tiles\n", tiles);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+struct SRenderCluster::SWorker
+{
+	SWorker()
+		: m_tilesRendered(0)
+		, m_tilesBeaten(0)
+		, m_lost(false)
+		, m_nextFrame(0)
+	{ }
+
+	std::string m_address;
+	SSocket m_socket;
+	std::thread m_thread;
+
+	size_t m_tilesRendered;
+	size_t m_tilesBeaten;       // rendered after another worker's copy had come back
+	bool m_lost;
+	uint32_t m_nextFrame;       // the one after the last frame it was sent tiles of
+};
+
+//-------------------------------------------------------------------------------------
+struct SRenderCluster::SFrame
+{
+	struct STile
+	{
+		size_t m_x;
+		size_t m_y;
+		size_t m_width;
+		size_t m_height;
+
+		size_t m_copiesOut;     // with workers, at most two once tiles are handed out twice
+		SWorker* m_worker;      // the last worker it was handed to
+		bool m_done;
+	};
+
+	SRenderContext m_context;
+	long m_width;
+	long m_height;
+	SImageView m_image;
+	SFloatImage* m_floatImage;  // used instead of m_image when set
+	size_t m_pixelBytes;
+
+	uint32_t m_number;
+	SRemoteTileRequest m_request;   // with a 0 x 0 tile, for just the buffers; tiles fill in their own
+
+	std::vector<STile> m_tiles;
+	size_t m_tilesLeft;
+};
+
+//-------------------------------------------------------------------------------------
+SRenderCluster::SRenderCluster()
+	: m_workersLeft(0)
+	, m_feedback(false)
+	, m_nextFrameNumber(0)
+	, m_stopping(false)
+{ }
+
+//-------------------------------------------------------------------------------------
+SRenderCluster::~SRenderCluster()
+{
+	// workers may still be rendering second copies of tiles that are long done, which
+	// nobody waits for
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_changed.notify_all();
+	for (std::unique_ptr<SWorker>& worker : m_workers)
+		worker->m_socket.Shutdown();
+	for (std::unique_ptr<SWorker>& worker : m_workers)
+		worker->m_thread.join();
+}
+
+//-------------------------------------------------------------------------------------
+bool SRenderCluster::Connect (const std::vector<std::string>& addresses, const SRenderSettings& settings, const SPassGraph& passes, const SShaderModuleLoader& shaderModule)
+{
+	assert(m_workers.empty());
+	m_settings = settings;
+	m_feedback = passes.HasBufferPasses();
+	const uint64_t shader = GetShaderIdentity(shaderModule);
+
+	for (const std::string& address : addresses)
+	{
+		size_t colon = address.rfind(':');
+		long port = colon != std::string::npos ? atol(address.c_str() + colon + 1) : 0;
+		if (port <= 0 || port > 65535)
+		{
+			fprintf(stderr, "Worker %s should be host:port, leaving it out\n", address.c_str());
+			continue;
+		}
+
+		std::unique_ptr<SWorker> worker(new SWorker);
+		worker->m_address = address;
+		if (!worker->m_socket.Connect(address.substr(0, colon).c_str(), (uint16_t)port))
+		{
+			fprintf(stderr, "Leaving out worker %s\n", address.c_str());
+			continue;
+		}
+
+		SRemoteHello hello;
+		worker->m_socket.SetTimeout(c_remoteTimeoutSeconds * 1000);
+		if (!worker->m_socket.Receive(&hello, sizeof(hello)) || hello.m_magic != c_remoteMagic || hello.m_version != c_remoteVersion)
+		{
+			fprintf(stderr, "%s isn't a worker of this version of the harness, leaving it out\n", address.c_str());
+			continue;
+		}
+		if (hello.m_shader != shader)
+		{
+			fprintf(stderr, "Worker %s has a different shader, leaving it out\n", address.c_str());
+			continue;
+		}
+		m_workers.push_back(std::move(worker));
+	}
+
+	if (m_workers.empty())
+	{
+		fprintf(stderr, "No workers to render on\n");
+		return false;
+	}
+
+	m_workersLeft = m_workers.size();
+	for (std::unique_ptr<SWorker>& worker : m_workers)
+	{
+		SWorker* workerPointer = worker.get();
+		worker->m_thread = std::thread([this, workerPointer]() { WorkerThread(*workerPointer); });
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::SubmitFrame (const SImageView& image, const SRenderContext& context)
+{
+	std::shared_ptr<SFrame> frame = std::make_shared<SFrame>();
+	frame->m_context = context;
+	frame->m_width = image.m_width;
+	frame->m_height = image.m_height;
+	frame->m_image = image;
+	frame->m_floatImage = nullptr;
+	frame->m_pixelBytes = 3;
+	SubmitTiles(frame);
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::SubmitFrame (SFloatImage& image, const SRenderContext& context)
+{
+	std::shared_ptr<SFrame> frame = std::make_shared<SFrame>();
+	frame->m_context = context;
+	frame->m_width = image.m_width;
+	frame->m_height = image.m_height;
+	frame->m_floatImage = &image;
+	frame->m_pixelBytes = 4 * sizeof(float);
+	SubmitTiles(frame);
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::SubmitTiles (const std::shared_ptr<SFrame>& frame)
+{
+	// the region, clipped to the frame
+	const size_t width = (size_t)frame->m_width;
+	const size_t height = (size_t)frame->m_height;
+	const SRenderRegion& region = m_settings.m_region;
+	const size_t minX = region.IsWholeImage() ? 0 : std::min(region.m_x, width);
+	const size_t minY = region.IsWholeImage() ? 0 : std::min(region.m_y, height);
+	const size_t maxX = region.IsWholeImage() ? width : std::min(region.m_x + region.m_width, width);
+	const size_t maxY = region.IsWholeImage() ? height : std::min(region.m_y + region.m_height, height);
+
+	// tiles are a whole number of the workers' own tiles, on the same grid, so they are
+	// shaded just as a local render would shade them. Smaller frames get smaller tiles,
+	// so each worker can have several.
+	const size_t localTileSize = std::max<size_t>(m_settings.m_tileSize, 1);
+	size_t tileSize = std::max<size_t>(c_remoteTileSize / localTileSize, 1) * localTileSize;
+	auto countTiles = [=](size_t size) { return ((maxX + size - 1) / size - minX / size) * ((maxY + size - 1) / size - minY / size); };
+	while (tileSize / 2 >= localTileSize && (tileSize / 2) % localTileSize == 0 && countTiles(tileSize) < c_remoteTilesPerWorker * m_workers.size())
+		tileSize /= 2;
+
+	for (size_t tileY = minY / tileSize * tileSize; tileY < maxY; tileY += tileSize)
+	{
+		for (size_t tileX = minX / tileSize * tileSize; tileX < maxX; tileX += tileSize)
+		{
+			SFrame::STile tile;
+			tile.m_x = std::max(tileX, minX);
+			tile.m_y = std::max(tileY, minY);
+			tile.m_width = std::min(tileX + tileSize, maxX) - tile.m_x;
+			tile.m_height = std::min(tileY + tileSize, maxY) - tile.m_y;
+			tile.m_copiesOut = 0;
+			tile.m_worker = nullptr;
+			tile.m_done = false;
+			frame->m_tiles.push_back(tile);
+		}
+	}
+	frame->m_tilesLeft = frame->m_tiles.size();
+
+	const SRenderContext& context = frame->m_context;
+	SRemoteTileRequest& request = frame->m_request;
+	request.m_width = (uint32_t)frame->m_width;
+	request.m_height = (uint32_t)frame->m_height;
+	request.m_x = 0;
+	request.m_y = 0;
+	request.m_tileWidth = 0;
+	request.m_tileHeight = 0;
+	request.m_floatPixels = frame->m_floatImage ? 1 : 0;
+	request.m_time = context.m_iGlobalTime;
+	request.m_timeDelta = context.m_iTimeDelta;
+	request.m_frame = context.m_iFrame;
+	for (size_t component = 0; component < 4; ++component)
+	{
+		request.m_mouse[component] = context.m_iMouse[component];
+		request.m_date[component] = context.m_iDate[component];
+	}
+	request.m_mode = (uint32_t)m_settings.m_mode;
+	request.m_fixedKernels = m_settings.m_fixedKernels ? 1 : 0;
+	request.m_tileSize = (uint32_t)m_settings.m_tileSize;
+	request.m_baseSamples = (uint32_t)m_settings.m_supersampling.m_baseSamples;
+	request.m_maxSamples = (uint32_t)m_settings.m_supersampling.m_maxSamples;
+	request.m_sampleThreshold = m_settings.m_supersampling.m_threshold;
+	request.m_sparseStep = (uint32_t)m_settings.m_sparse.m_step;
+	request.m_sparseThreshold = m_settings.m_sparse.m_threshold;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		frame->m_number = m_nextFrameNumber++;
+		request.m_frameNumber = frame->m_number;
+		if (m_feedback)
+			m_bufferFrames.push_back(frame);
+		m_frames.push_back(frame);
+		for (size_t tile = 0; tile < frame->m_tiles.size(); ++tile)
+			m_pendingTiles.push_back(STileRef{ frame, tile });
+	}
+	m_changed.notify_all();
+}
+
+//-------------------------------------------------------------------------------------
+bool SRenderCluster::WaitForFrame ()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(!m_frames.empty());
+	std::shared_ptr<SFrame> frame = m_frames.front();
+	m_changed.wait(lock, [&]() { return frame->m_tilesLeft == 0 || m_workersLeft == 0; });
+	m_frames.pop_front();
+	return frame->m_tilesLeft == 0;
+}
+
+//-------------------------------------------------------------------------------------
+// Returns false once the cluster is stopping, or when there is nothing to hand out and
+// the worker has tiles of its own to get on with (wait is false)
+bool SRenderCluster::TakeTile (SWorker& worker, bool wait, STileRef& tile)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stopping)
+	{
+		// with buffer passes, a worker can't go back to a frame once its buffers have moved
+		// on, so frames are rendered one at a time. Tiles given back by lost workers are of
+		// that frame too, and go to the front.
+		const SFrame* onlyFrame = nullptr;
+		if (m_feedback)
+		{
+			for (const std::shared_ptr<SFrame>& frame : m_frames)
+			{
+				if (frame->m_tilesLeft > 0)
+				{
+					onlyFrame = frame.get();
+					break;
+				}
+			}
+		}
+
+		if (!m_pendingTiles.empty() && (!onlyFrame || m_pendingTiles.front().m_frame.get() == onlyFrame))
+		{
+			tile = m_pendingTiles.front();
+			m_pendingTiles.pop_front();
+			SFrame::STile& frameTile = tile.m_frame->m_tiles[tile.m_tile];
+			++frameTile.m_copiesOut;
+			frameTile.m_worker = &worker;
+			return true;
+		}
+		if (!wait)
+			return false;
+
+		// everything is handed out, so rather than sit idle, render a copy of the oldest
+		// tile that only one other worker has
+		for (const std::shared_ptr<SFrame>& frame : m_frames)
+		{
+			if (onlyFrame && frame.get() != onlyFrame)
+				continue;
+			for (size_t index = 0; index < frame->m_tiles.size(); ++index)
+			{
+				SFrame::STile& frameTile = frame->m_tiles[index];
+				if (frameTile.m_done || frameTile.m_copiesOut != 1 || frameTile.m_worker == &worker)
+					continue;
+				++frameTile.m_copiesOut;
+				frameTile.m_worker = &worker;
+				tile = STileRef{ frame, index };
+				return true;
+			}
+		}
+		m_changed.wait(lock);
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::FinishTile (SWorker& worker, const STileRef& tile, const std::vector<uint8_t>& pixels)
+{
+	SFrame& frame = *tile.m_frame;
+	SFrame::STile& frameTile = frame.m_tiles[tile.m_tile];
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--frameTile.m_copiesOut;
+		if (frameTile.m_done)
+		{
+			++worker.m_tilesBeaten;
+			return;
+		}
+		frameTile.m_done = true;
+		++worker.m_tilesRendered;
+	}
+
+	// only the first copy back gets here, so tiles are written outside the lock
+	if (frame.m_floatImage)
+		CopyTileIn(frame.m_floatImage, frameTile.m_x, frameTile.m_y, frameTile.m_width, frameTile.m_height, frame.m_pixelBytes, pixels.data());
+	else
+		CopyTileIn(frame.m_image, frameTile.m_x, frameTile.m_y, frameTile.m_width, frameTile.m_height, frame.m_pixelBytes, pixels.data());
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		--frame.m_tilesLeft;
+	}
+	m_changed.notify_all();
+}
+
+//-------------------------------------------------------------------------------------
+// Hand the tiles a worker had back out, unless another worker has them too
+void SRenderCluster::LoseWorker (SWorker& worker, const std::deque<STileRef>& tiles)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_stopping)
+		{
+			worker.m_lost = true;
+			fprintf(stderr, "Lost worker %s, its tiles go to the others\n", worker.m_address.c_str());
+		}
+		for (auto tile = tiles.rbegin(); tile != tiles.rend(); ++tile)
+		{
+			SFrame::STile& frameTile = tile->m_frame->m_tiles[tile->m_tile];
+			if (--frameTile.m_copiesOut == 0 && !frameTile.m_done)
+				m_pendingTiles.push_front(*tile);
+		}
+		if (--m_workersLeft == 0 && !m_stopping)
+			fprintf(stderr, "Every worker was lost\n");
+	}
+	m_changed.notify_all();
+}
+
+//-------------------------------------------------------------------------------------
+// With buffer passes, the frames before the given one that a worker's buffers still have
+// to go through, as it had no tiles of them. Frames every worker is past are forgotten.
+void SRenderCluster::TakeSkippedFrames (SWorker& worker, uint32_t frameNumber, std::vector<std::shared_ptr<SFrame>>& frames)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	frames.clear();
+	for (const std::shared_ptr<SFrame>& frame : m_bufferFrames)
+	{
+		if (frame->m_number >= worker.m_nextFrame && frame->m_number < frameNumber)
+			frames.push_back(frame);
+	}
+	worker.m_nextFrame = std::max(worker.m_nextFrame, frameNumber + 1);
+
+	while (!m_bufferFrames.empty())
+	{
+		uint32_t oldest = m_bufferFrames.front()->m_number;
+		bool needed = false;
+		for (const std::unique_ptr<SWorker>& other : m_workers)
+			needed = needed || (!other->m_lost && other->m_nextFrame <= oldest);
+		if (needed)
+			break;
+		m_bufferFrames.pop_front();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::WorkerThread (SWorker& worker)
+{
+	std::deque<STileRef> sent;
+	std::vector<std::shared_ptr<SFrame>> skippedFrames;
+	std::vector<uint8_t> pixels;
+	while (true)
+	{
+		// keep a few tiles queued on the worker, so it goes straight from one to the next
+		bool connected = true;
+		STileRef tile;
+		while (connected && sent.size() < c_remoteTilesInFlight && TakeTile(worker, sent.empty(), tile))
+		{
+			sent.push_back(tile);
+			const SFrame& frame = *tile.m_frame;
+			const SFrame::STile& frameTile = frame.m_tiles[tile.m_tile];
+			if (m_feedback)
+			{
+				TakeSkippedFrames(worker, frame.m_number, skippedFrames);
+				for (const std::shared_ptr<SFrame>& skippedFrame : skippedFrames)
+					connected = connected && worker.m_socket.Send(&skippedFrame->m_request, sizeof(skippedFrame->m_request));
+			}
+
+			SRemoteTileRequest request = frame.m_request;
+			request.m_x = (uint32_t)frameTile.m_x;
+			request.m_y = (uint32_t)frameTile.m_y;
+			request.m_tileWidth = (uint32_t)frameTile.m_width;
+			request.m_tileHeight = (uint32_t)frameTile.m_height;
+			connected = connected && worker.m_socket.Send(&request, sizeof(request));
+		}
+		if (sent.empty())
+			return;
+
+		// tiles come back in the order they were sent
+		const SFrame& frame = *sent.front().m_frame;
+		const SFrame::STile& frameTile = frame.m_tiles[sent.front().m_tile];
+		pixels.resize(frameTile.m_width * frameTile.m_height * frame.m_pixelBytes);
+		uint32_t rendered = 0;
+		if (!connected || !worker.m_socket.Receive(&rendered, sizeof(rendered)) || rendered != 1 || !worker.m_socket.Receive(pixels.data(), pixels.size()))
+		{
+			LoseWorker(worker, sent);
+			return;
+		}
+		FinishTile(worker, sent.front(), pixels);
+		sent.pop_front();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void SRenderCluster::PrintWorkers (FILE* file) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (const std::unique_ptr<SWorker>& worker : m_workers)
+	{
+		fprintf(file, "worker %s: %zu tiles", worker->m_address.c_str(), worker->m_tilesRendered);
+		if (worker->m_tilesBeaten > 0)
+			fprintf(file, ", %zu more another worker finished first", worker->m_tilesBeaten);
+		fputs(worker->m_lost ? ", then lost\n" : "\n", file);
+	}
+}
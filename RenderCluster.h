@@ -0,0 +1,103 @@
+#pragma once
+
+// Rendering frames on other processes, on this machine or others. A worker (-worker
+// <port>) is the harness with the same shader, waiting for a coordinator to connect
+// over TCP. The coordinator (-workers <host:port>,...) cuts each frame into tiles and
+// hands them out to whichever worker asks for more, a couple at a time so a worker never
+// waits on the network between them, and copies the pixels that come back into the
+// frame. Faster workers simply come back more often, so the load follows their speed.
+//
+// A worker that drops its connection or takes longer than c_remoteTimeoutSeconds to
+// answer is given up on, and its tiles go back to the others. Once no tiles are left to
+// hand out, idle workers also render tiles still out on another worker, so one slow
+// worker can't hold up the end of a frame. Whichever copy comes back first is kept.
+// Workers only talk to a coordinator with the same shader (module, or else executable).
+// There is no authentication: anyone who can reach a worker's port can have it render, so
+// workers should only listen on trusted networks, or on 127.0.0.1 behind an SSH tunnel.
+//
+// A tile is rendered as an SRenderSettings::m_region of the frame, so frames come out bit
+// for bit as they would locally, except that -sparse grids start at each tile. Each
+// worker renders the buffer passes whole, once per frame, and keeps them from one frame
+// to the next just as a local render does, so feedback carries through a sequence. That
+// means going through every frame in order, so with buffer passes a frame's tiles are
+// all handed out before the next frame's, rather than a couple of frames at once.
+
+#include "PassGraph.h"
+#include "Platform.h"
+#include "ShaderModuleLoader.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// Accept coordinators on a port one after another, and render the tiles they ask for.
+// The port is on every network interface unless interfaceAddress names one. Only returns
+// (1) if the port can't be listened on.
+int RunRenderWorker (STaskScheduler& scheduler, SPassGraph& passes, SShaderModuleLoader& shaderModule, uint16_t port, const char* interfaceAddress);
+
+//-------------------------------------------------------------------------------------
+// The coordinator's end: connections to the workers, and the tiles of the frames being
+// rendered on them
+struct SRenderCluster
+{
+	SRenderCluster();
+	~SRenderCluster();
+
+	// Frames can have at most this many pixels, as each worker keeps a whole frame of
+	// float pixels (and of every buffer pass) for it: 1GB of them
+	static const uint64_t c_maxFramePixels = 64 * 1024 * 1024;
+
+	// Connect to workers at "host:port" addresses, which render with the settings' mode,
+	// supersampling etc. The passes and module are this end's copy of the shader, which
+	// the workers' must match. Workers that can't be reached or don't match are left out
+	// with a warning; returns false if none are left.
+	bool Connect (const std::vector<std::string>& addresses, const SRenderSettings& settings, const SPassGraph& passes, const SShaderModuleLoader& shaderModule);
+
+	// Hand out the tiles of a frame (only those in the settings' region), without waiting
+	// for them. The image must stay alive until WaitForFrame() has returned for it.
+	void SubmitFrame (const SImageView& image, const SRenderContext& context);
+	void SubmitFrame (SFloatImage& image, const SRenderContext& context);
+
+	// Wait for the oldest frame submitted and not yet waited for to be complete. Returns
+	// false if every worker was lost before it was.
+	bool WaitForFrame ();
+
+	// How many tiles each worker rendered, and which were lost
+	void PrintWorkers (FILE* file) const;
+
+private:
+	struct SFrame;
+	struct SWorker;
+
+	struct STileRef
+	{
+		std::shared_ptr<SFrame> m_frame;
+		size_t m_tile;
+	};
+
+	void SubmitTiles (const std::shared_ptr<SFrame>& frame);
+	void WorkerThread (SWorker& worker);
+	bool TakeTile (SWorker& worker, bool wait, STileRef& tile);
+	void TakeSkippedFrames (SWorker& worker, uint32_t frameNumber, std::vector<std::shared_ptr<SFrame>>& frames);
+	void FinishTile (SWorker& worker, const STileRef& tile, const std::vector<uint8_t>& pixels);
+	void LoseWorker (SWorker& worker, const std::deque<STileRef>& tiles);
+
+	SRenderSettings m_settings;
+	std::vector<std::unique_ptr<SWorker>> m_workers;
+	size_t m_workersLeft;
+	bool m_feedback;            // the shader has buffer passes, so frames go in order
+
+	std::deque<std::shared_ptr<SFrame>> m_frames;   // submitted and not yet waited for
+	std::deque<STileRef> m_pendingTiles;            // not yet handed to any worker
+	std::deque<std::shared_ptr<SFrame>> m_bufferFrames;  // with m_feedback, frames some worker's buffers haven't been through
+	uint32_t m_nextFrameNumber;
+	bool m_stopping;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_changed;
+};
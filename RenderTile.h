@@ -0,0 +1,653 @@
+#pragma once
+
+// The loops that shade a tile of pixels, shared by the generic render kernel in
+// Renderer.cpp and the fixed size kernels of mainFixed.cpp. They are templated on how
+// the shader is called: SShaderPointers goes through an SShader's function pointers,
+// while a fixed kernel calls its own copy of the shader directly, so it can be inlined
+// into the loops along with that kernel's constant uniforms. A cost map gets what the
+// shader's ReadCost() goes up by while a pixel is shaded: ticks, or for SShaderCounter
+// the ops the op counting build ran.
+//
+// Pixels are shaded in the 2x2 quads dFdx() etc work across, each starting on even
+// coordinates: packets start on a quad, and the scalar path walks the tile a quad at a
+// time. Scalar pixels are shaded alone until the shader asks for a derivative, then that
+// tile's quads go through an SQuadRunner.
+//
+// fragCoord is the pixel's centre, x + 0.5, as on Shadertoy. With supersampling, each
+// pixel is instead shaded at a number of points within it (see Supersampling.h), a round
+// of samples at a time, and its colour is their mean.
+//
+// A sparse render (see SparseRender.h) runs a tile twice, as a coarse and then a refine
+// pass, with the tile's pixels picked by the pass.
+
+#include "Renderer.h"
+#include "glslPacket.h"
+#include "Platform.h"
+#include "QuadRunner.h"
+#include "SparseRender.h"
+#include "Supersampling.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// The pixels a tile task renders: the tile clipped to the region. Shaded pixels are one
+// per step x step block, counted from the region's corner, and each fills its block out
+// to the edge of the region, so blocks can reach past the tile.
+struct STileJob
+{
+	size_t m_minX;
+	size_t m_minY;
+	size_t m_maxX;
+	size_t m_maxY;
+	size_t m_originX;
+	size_t m_originY;
+	size_t m_regionMaxX;
+	size_t m_regionMaxY;
+	size_t m_step;
+	size_t m_skipStep;
+	SSupersampleSettings m_supersampling;
+
+	// the tile's pass of a sparse render, and the grid the passes share
+	ESparsePass m_sparsePass;
+	SSparseGrid* m_sparseGrid;
+
+	// when set, the number of pixels shaded (rather than filled or interpolated) is added
+	std::atomic<uint64_t>* m_shadedPixels;
+};
+
+//-------------------------------------------------------------------------------------
+// Calls a shader through the function pointers of an SShader. Tiles of any size.
+struct SShaderPointers
+{
+	static const size_t c_fixedTileSize = 0;
+	static const bool c_countsOps = false;
+
+	explicit SShaderPointers (const SShader& shader)
+		: m_shader(shader)
+	{ }
+
+	void Shade (vec4& fragColor, vec2 fragCoord) const { m_shader.m_mainImage(fragColor, fragCoord); }
+	void ShadePacket (Packet::vec4& fragColor, Packet::vec2 fragCoord) const { m_shader.m_packetMainImage(fragColor, fragCoord); }
+	bool& PacketDivergedFlag () const { return m_shader.m_packetDiverged ? m_shader.m_packetDiverged() : PacketDiverged(); }
+	SShaderQuadSlot& QuadSlot () const { return m_shader.m_shaderQuad ? m_shader.m_shaderQuad() : CurrentShaderQuad(); }
+	uint64_t ReadCost () const { return ReadCycleCounter(); }
+
+	const SShader& m_shader;
+};
+
+//-------------------------------------------------------------------------------------
+// Calls the op counting build of an SShader (see glslCounted.h) for single pixels, with
+// the ops it has counted on this thread as its cost
+struct SShaderCounter : SShaderPointers
+{
+	static const bool c_countsOps = true;
+
+	explicit SShaderCounter (const SShader& shader)
+		: SShaderPointers(shader)
+	{ }
+
+	void Shade (vec4& fragColor, vec2 fragCoord) const
+	{
+		Counted::vec4 color;
+		m_shader.m_countedMainImage(color, Counted::vec2(fragCoord));
+		fragColor = vec4(color);
+	}
+	uint64_t ReadCost () const { return QuadSlot().m_opCounts.Total(); }
+};
+
+//-------------------------------------------------------------------------------------
+inline void WritePixel (const SImageView& image, size_t x, size_t y, const vec4& fragColor)
+{
+	uint8* pixel = &image.m_pixels[y * image.m_pitch + x * 3];
+
+	// write the output color.  Note that the color channels are reversed!
+	pixel[0] = uint8(clamp(fragColor[2], 0.0f, 1.0f) * 255.0f);
+	pixel[1] = uint8(clamp(fragColor[1], 0.0f, 1.0f) * 255.0f);
+	pixel[2] = uint8(clamp(fragColor[0], 0.0f, 1.0f) * 255.0f);
+}
+
+//-------------------------------------------------------------------------------------
+inline void WritePixel (STexture* texture, size_t x, size_t y, const vec4& fragColor)
+{
+	texture->At(x, y) = fragColor;
+}
+
+//-------------------------------------------------------------------------------------
+inline void WritePixel (SFloatImage* image, size_t x, size_t y, const vec4& fragColor)
+{
+	float* pixel = image->Row(y) + x * 4;
+	for (size_t channel = 0; channel < 4; ++channel)
+		pixel[channel] = fragColor[channel];
+}
+
+//-------------------------------------------------------------------------------------
+// Whether the job shades every pixel of a whole size x size tile once, so it can be
+// looped over with bounds known at compile time
+inline bool IsFullTile (const STileJob& job, size_t size)
+{
+	return size > 0 && size % 2 == 0 && job.m_step == 1 && job.m_skipStep == 0 && job.m_maxX - job.m_minX == size && job.m_maxY - job.m_minY == size
+		&& job.m_minX % 2 == 0 && job.m_minY % 2 == 0 && !job.m_supersampling.IsEnabled() && job.m_sparsePass == ESparsePass::None;
+}
+
+//-------------------------------------------------------------------------------------
+inline bool IsInTile (const STileJob& job, size_t x, size_t y)
+{
+	return x >= job.m_minX && x < job.m_maxX && y >= job.m_minY && y < job.m_maxY;
+}
+
+//-------------------------------------------------------------------------------------
+// Whether the job shades pixel x, y itself, rather than leaving it to another tile,
+// filling it from a shaded pixel's block or having shaded it in a coarser level
+inline bool IsShadedPixel (const STileJob& job, size_t x, size_t y)
+{
+	if (!IsInTile(job, x, y))
+		return false;
+	if ((x - job.m_originX) % job.m_step != 0 || (y - job.m_originY) % job.m_step != 0)
+		return false;
+	return !(job.m_skipStep && (x - job.m_originX) % job.m_skipStep == 0 && (y - job.m_originY) % job.m_skipStep == 0);
+}
+
+//-------------------------------------------------------------------------------------
+inline void CountShadedPixels (const STileJob& job, size_t count)
+{
+	if (job.m_shadedPixels)
+		*job.m_shadedPixels += count;
+}
+
+//-------------------------------------------------------------------------------------
+// The fragCoord pixel x, y is shaded at for a sample: its centre, unless supersampling
+inline vec2 SampleCoord (const STileJob& job, size_t x, size_t y, size_t sample)
+{
+	if (!job.m_supersampling.IsEnabled())
+		return vec2(float(x) + 0.5f, float(y) + 0.5f);
+	vec2 offset = SupersampleOffset(x & ~size_t(1), y & ~size_t(1), sample);
+	return vec2(float(x) + offset.x, float(y) + offset.y);
+}
+
+//-------------------------------------------------------------------------------------
+// Shade the N pixels set in wanted into colors: once, or when supersampling, in rounds of
+// samples until each has enough. shadeSample(sample, active, sampleColors) shades sample
+// number sample of the pixels set in active.
+template <size_t N, typename TShadeSample>
+void ShadeSamples (const SSupersampleSettings& settings, uint32_t wanted, vec4 colors[N], const TShadeSample& shadeSample)
+{
+	if (!settings.IsEnabled())
+	{
+		shadeSample(0, wanted, colors);
+		return;
+	}
+
+	SPixelSamples pixelSamples[N];
+	vec4 sampleColors[N];
+	uint32_t active = wanted;
+	for (size_t count = 0; active; )
+	{
+		size_t next = settings.NextSampleCount(count);
+		for (size_t sample = count; sample < next; ++sample)
+		{
+			shadeSample(sample, active, sampleColors);
+			for (size_t i = 0; i < N; ++i)
+			{
+				if (active & (1u << i))
+					pixelSamples[i].Add(sampleColors[i]);
+			}
+		}
+		count = next;
+
+		for (size_t i = 0; i < N; ++i)
+		{
+			if ((active & (1u << i)) && !pixelSamples[i].NeedsMore(settings))
+				active &= ~(1u << i);
+		}
+	}
+
+	for (size_t i = 0; i < N; ++i)
+	{
+		if (wanted & (1u << i))
+			colors[i] = pixelSamples[i].Mean();
+	}
+}
+
+//-------------------------------------------------------------------------------------
+template <typename TTarget>
+void WriteBlock (const TTarget& image, const STileJob& job, size_t x, size_t y, const vec4& fragColor)
+{
+	const size_t maxX = std::min(x + job.m_step, job.m_regionMaxX);
+	const size_t maxY = std::min(y + job.m_step, job.m_regionMaxY);
+	for (size_t blockY = y; blockY < maxY; ++blockY)
+	{
+		for (size_t blockX = x; blockX < maxX; ++blockX)
+			WritePixel(image, blockX, blockY, fragColor);
+	}
+}
+
+//-------------------------------------------------------------------------------------
+template <typename SHADER>
+void ShadeWithShader (const void* shader, vec4& fragColor, vec2 fragCoord)
+{
+	static_cast<const SHADER*>(shader)->Shade(fragColor, fragCoord);
+}
+
+//-------------------------------------------------------------------------------------
+// Shade the pixels of a quad that are set in wanted (one bit per SShaderQuad::m_invocation)
+// at fragCoords into colors, adding their cost to ticks when timed. They are shaded one at
+// a time until a pixel asks for a derivative, which sets useQuads and from then on all
+// four are shaded together.
+template <typename SHADER>
+void ShadeQuad (const SHADER& shader, const vec2 fragCoords[4], uint32_t wanted, bool timed, vec4 colors[4], uint64_t ticks[4], bool& useQuads)
+{
+	SShaderQuadSlot& slot = shader.QuadSlot();
+	if (!useQuads)
+	{
+		slot.m_derivativesUsed = false;
+		const SOpCounts opCounts = SHADER::c_countsOps ? slot.m_opCounts : SOpCounts();
+		uint64_t pixelTicks[4] = { 0, 0, 0, 0 };
+		for (size_t i = 0; i < 4; ++i)
+		{
+			if (!(wanted & (1u << i)))
+				continue;
+			uint64_t start = timed ? shader.ReadCost() : 0;
+			shader.Shade(colors[i], fragCoords[i]);
+			if (timed)
+				pixelTicks[i] = shader.ReadCost() - start;
+		}
+
+		// pixels that got 0 for a derivative are shaded again below. That took time, but
+		// their ops are thrown away along with the results.
+		if (SHADER::c_countsOps && slot.m_derivativesUsed)
+			slot.m_opCounts = opCounts;
+		else
+		{
+			for (size_t i = 0; i < 4; ++i)
+				ticks[i] += pixelTicks[i];
+		}
+		if (!slot.m_derivativesUsed)
+			return;
+		useQuads = true;
+	}
+
+	// the quad's cost is shared by the pixels it was shaded for
+	uint64_t start = timed ? shader.ReadCost() : 0;
+	SQuadRunner::ForCurrentThread().Run(slot, ShadeWithShader<SHADER>, &shader, fragCoords, colors);
+	if (timed)
+	{
+		uint64_t elapsed = shader.ReadCost() - start;
+		size_t pixels = 0;
+		for (size_t i = 0; i < 4; ++i)
+			pixels += (wanted >> i) & 1;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			if (wanted & (1u << i))
+				ticks[i] += elapsed / pixels;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+// Shade the pixels of the tile's quads that isWanted(x, y) picks, handing each one's
+// colour to write(x, y, color). Returns how many were shaded.
+template <typename SHADER, typename TWanted, typename TWrite>
+size_t ShadeTileQuads (const SHADER& shader, SCostMap* costMap, const STileJob& job, const TWanted& isWanted, const TWrite& write)
+{
+	vec4 colors[4];
+	uint64_t ticks[4] = { 0, 0, 0, 0 };
+	vec2 fragCoords[4];
+	bool useQuads = false;
+	size_t shaded = 0;
+
+	const bool timed = costMap != nullptr;
+	for (size_t quadY = job.m_minY & ~size_t(1); quadY < job.m_maxY; quadY += 2)
+	{
+		for (size_t quadX = job.m_minX & ~size_t(1); quadX < job.m_maxX; quadX += 2)
+		{
+			uint32_t wanted = 0;
+			for (size_t i = 0; i < 4; ++i)
+			{
+				if (isWanted(quadX + (i & 1), quadY + (i >> 1)))
+					wanted |= 1u << i;
+			}
+			if (!wanted)
+				continue;
+
+			ShadeSamples<4>(job.m_supersampling, wanted, colors, [&](size_t sample, uint32_t active, vec4 sampleColors[4])
+			{
+				for (size_t i = 0; i < 4; ++i)
+					fragCoords[i] = SampleCoord(job, quadX + (i & 1), quadY + (i >> 1), sample);
+				ShadeQuad(shader, fragCoords, active, timed, sampleColors, ticks, useQuads);
+			});
+
+			for (size_t i = 0; i < 4; ++i)
+			{
+				if (!(wanted & (1u << i)))
+					continue;
+
+				const size_t x = quadX + (i & 1);
+				const size_t y = quadY + (i >> 1);
+				if (costMap)
+				{
+					costMap->At(x, y) += ticks[i];
+					ticks[i] = 0;
+				}
+				write(x, y, colors[i]);
+				++shaded;
+			}
+		}
+	}
+	return shaded;
+}
+
+//-------------------------------------------------------------------------------------
+// Shade sample number sample of the lanes set in active of the packet whose first lane is
+// at packetX, packetY (even coordinates) into colors, adding each lane's share of the
+// time to ticks when timed
+template <typename SHADER>
+void ShadePacketSample (const SHADER& shader, const STileJob& job, size_t packetX, size_t packetY, size_t sample, uint32_t active, bool timed, vec4 colors[GLSL_PACKET_WIDTH], uint64_t ticks[GLSL_PACKET_WIDTH], bool& useQuads)
+{
+	float laneX[GLSL_PACKET_WIDTH];
+	float laneY[GLSL_PACKET_WIDTH];
+	float laneColor[4][GLSL_PACKET_WIDTH];
+	bool& packetDiverged = shader.PacketDivergedFlag();
+
+	// lanes that hang off the edge of the tile repeat the last pixel of its last quad, so
+	// they don't make the packet diverge. Their results are thrown away, as are those of
+	// lanes before the tile's first pixel, which are in its first quad.
+	const size_t lastX = (job.m_maxX - 1) | 1;
+	const size_t lastY = (job.m_maxY - 1) | 1;
+	for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+	{
+		size_t x = packetX + lane % c_packetWidthPixels;
+		size_t y = packetY + lane / c_packetWidthPixels;
+		vec2 fragCoord = SampleCoord(job, x < lastX ? x : lastX, y < lastY ? y : lastY, sample);
+		laneX[lane] = fragCoord.x;
+		laneY[lane] = fragCoord.y;
+	}
+
+	uint64_t packetStart = timed ? shader.ReadCost() : 0;
+
+	Packet::vec4 fragColor;
+	packetDiverged = false;
+	shader.ShadePacket(fragColor, Packet::vec2(SFloatPacket::Load(laneX), SFloatPacket::Load(laneY)));
+	bool diverged = packetDiverged;
+
+	// the packet's time is shared by the lanes it was shaded for
+	if (timed)
+	{
+		size_t lanes = 0;
+		for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+			lanes += (active >> lane) & 1;
+		uint64_t laneTicks = (shader.ReadCost() - packetStart) / lanes;
+		for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+		{
+			if (active & (1u << lane))
+				ticks[lane] += laneTicks;
+		}
+	}
+
+	// lanes went different ways at a branch, so shade the pixels again on the scalar
+	// path, a quad at a time
+	if (diverged)
+	{
+		vec2 fragCoords[4];
+		vec4 quadColors[4];
+		size_t quadLanes[4];
+		for (size_t quadY = packetY; quadY < packetY + c_packetHeightPixels; quadY += 2)
+		{
+			for (size_t quadX = packetX; quadX < packetX + c_packetWidthPixels; quadX += 2)
+			{
+				uint32_t quadActive = 0;
+				for (size_t i = 0; i < 4; ++i)
+				{
+					quadLanes[i] = (quadY - packetY + (i >> 1)) * c_packetWidthPixels + quadX - packetX + (i & 1);
+					if (active & (1u << quadLanes[i]))
+						quadActive |= 1u << i;
+					fragCoords[i] = SampleCoord(job, quadX + (i & 1), quadY + (i >> 1), sample);
+				}
+				if (!quadActive)
+					continue;
+
+				uint64_t quadTicks[4] = { 0, 0, 0, 0 };
+				ShadeQuad(shader, fragCoords, quadActive, timed, quadColors, quadTicks, useQuads);
+				for (size_t i = 0; i < 4; ++i)
+				{
+					if (!(quadActive & (1u << i)))
+						continue;
+					colors[quadLanes[i]] = quadColors[i];
+					ticks[quadLanes[i]] += quadTicks[i];
+				}
+			}
+		}
+		return;
+	}
+
+	for (size_t channel = 0; channel < 4; ++channel)
+		fragColor[channel].Store(laneColor[channel]);
+
+	for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+	{
+		if (active & (1u << lane))
+			colors[lane] = vec4(laneColor[0][lane], laneColor[1][lane], laneColor[2][lane], laneColor[3][lane]);
+	}
+}
+
+
+//-------------------------------------------------------------------------------------
+// The lanes of the packet whose first lane is at packetX, packetY that are in the tile
+inline uint32_t PacketLanesInTile (const STileJob& job, size_t packetX, size_t packetY)
+{
+	uint32_t lanes = 0;
+	for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+	{
+		if (IsInTile(job, packetX + lane % c_packetWidthPixels, packetY + lane / c_packetWidthPixels))
+			lanes |= 1u << lane;
+	}
+	return lanes;
+}
+
+//-------------------------------------------------------------------------------------
+// Shade the packet whose first lane is at packetX, packetY (even coordinates), writing
+// the lanes set in wanted, which must be inside the tile
+template <typename SHADER, typename TTarget>
+void RenderPacket (const SHADER& shader, const TTarget& image, SCostMap* costMap, const STileJob& job, size_t packetX, size_t packetY, uint32_t wanted, bool& useQuads)
+{
+	vec4 colors[GLSL_PACKET_WIDTH];
+	uint64_t ticks[GLSL_PACKET_WIDTH] = {};
+
+	ShadeSamples<GLSL_PACKET_WIDTH>(job.m_supersampling, wanted, colors, [&](size_t sample, uint32_t active, vec4 sampleColors[GLSL_PACKET_WIDTH])
+	{
+		ShadePacketSample(shader, job, packetX, packetY, sample, active, costMap != nullptr, sampleColors, ticks, useQuads);
+	});
+
+	for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+	{
+		if (!(wanted & (1u << lane)))
+			continue;
+
+		size_t x = packetX + lane % c_packetWidthPixels;
+		size_t y = packetY + lane / c_packetWidthPixels;
+		WritePixel(image, x, y, colors[lane]);
+		if (costMap)
+			costMap->At(x, y) += ticks[lane];
+	}
+}
+
+//-------------------------------------------------------------------------------------
+// A sparse render's coarse pass: shade the tile's grid pixels into the grid
+template <typename SHADER>
+void RenderSparseCoarse (const SHADER& shader, SCostMap* costMap, const STileJob& job)
+{
+	SSparseGrid& grid = *job.m_sparseGrid;
+	size_t shaded = ShadeTileQuads(shader, costMap, job,
+		[&](size_t x, size_t y) { return IsInTile(job, x, y) && grid.IsGridPixel(x, y); },
+		[&](size_t x, size_t y, const vec4& color) { grid.At(x, y) = color; });
+	CountShadedPixels(job, shaded);
+}
+
+//-------------------------------------------------------------------------------------
+// A sparse render's refine pass: shade the tile's pixels in blocks that need it, with
+// packets if asked, and interpolate the rest from the grid
+template <typename SHADER, typename TTarget>
+void RenderSparseRefine (const SHADER& shader, const TTarget& image, SCostMap* costMap, const STileJob& job, bool packets)
+{
+	const SSparseGrid& grid = *job.m_sparseGrid;
+	const size_t width = job.m_maxX - job.m_minX;
+
+	const size_t firstBlockX = grid.m_x.Block(job.m_minX);
+	const size_t firstBlockY = grid.m_y.Block(job.m_minY);
+	const size_t blocksX = grid.m_x.Block(job.m_maxX - 1) - firstBlockX + 1;
+	const size_t blocksY = grid.m_y.Block(job.m_maxY - 1) - firstBlockY + 1;
+	std::vector<uint8_t> refineBlocks;
+	grid.FindRefinedBlocks(firstBlockX, firstBlockY, blocksX, blocksY, refineBlocks);
+
+	// interpolate the blocks the tile touches that are smooth, and mark the pixels of the
+	// rest for shading, but for their grid pixels
+	std::vector<uint8_t> refined(width * (job.m_maxY - job.m_minY), 0);
+	for (size_t blockY = firstBlockY; blockY < firstBlockY + blocksY; ++blockY)
+	{
+		const size_t minY = std::max(grid.m_y.Line(blockY), job.m_minY);
+		const size_t maxY = std::min(grid.m_y.BlockEnd(blockY), job.m_maxY);
+		for (size_t blockX = firstBlockX; blockX < firstBlockX + blocksX; ++blockX)
+		{
+			const size_t minX = std::max(grid.m_x.Line(blockX), job.m_minX);
+			const size_t maxX = std::min(grid.m_x.BlockEnd(blockX), job.m_maxX);
+			if (!refineBlocks[(blockY - firstBlockY) * blocksX + blockX - firstBlockX])
+			{
+				grid.InterpolateBlock(blockX, blockY, minX, minY, maxX, maxY,
+					[&](size_t x, size_t y, const vec4& color) { WritePixel(image, x, y, color); });
+				continue;
+			}
+
+			for (size_t y = minY; y < maxY; ++y)
+			{
+				for (size_t x = minX; x < maxX; ++x)
+				{
+					if (grid.IsGridPixel(x, y))
+						WritePixel(image, x, y, grid.Line(grid.m_x.LineIndex(x), grid.m_y.LineIndex(y)));
+					else
+						refined[(y - job.m_minY) * width + x - job.m_minX] = 1;
+				}
+			}
+		}
+	}
+
+	auto isRefined = [&](size_t x, size_t y) { return IsInTile(job, x, y) && refined[(y - job.m_minY) * width + x - job.m_minX]; };
+
+	if (!packets)
+	{
+		size_t shaded = ShadeTileQuads(shader, costMap, job, isRefined,
+			[&](size_t x, size_t y, const vec4& color) { WritePixel(image, x, y, color); });
+		CountShadedPixels(job, shaded);
+		return;
+	}
+
+	bool useQuads = false;
+	size_t shaded = 0;
+	for (size_t packetY = job.m_minY & ~size_t(1); packetY < job.m_maxY; packetY += c_packetHeightPixels)
+	{
+		for (size_t packetX = job.m_minX & ~size_t(1); packetX < job.m_maxX; packetX += c_packetWidthPixels)
+		{
+			uint32_t wanted = 0;
+			for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+			{
+				if (isRefined(packetX + lane % c_packetWidthPixels, packetY + lane / c_packetWidthPixels))
+				{
+					wanted |= 1u << lane;
+					++shaded;
+				}
+			}
+			if (wanted)
+				RenderPacket(shader, image, costMap, job, packetX, packetY, wanted, useQuads);
+		}
+	}
+	CountShadedPixels(job, shaded);
+}
+
+//-------------------------------------------------------------------------------------
+template <typename SHADER, typename TTarget>
+void RenderTile (const SHADER& shader, const TTarget& image, SCostMap* costMap, const STileJob& job)
+{
+	if (job.m_sparsePass == ESparsePass::Coarse)
+	{
+		RenderSparseCoarse(shader, costMap, job);
+		return;
+	}
+	if (job.m_sparsePass == ESparsePass::Refine)
+	{
+		RenderSparseRefine(shader, image, costMap, job, false);
+		return;
+	}
+
+	// a fixed kernel's whole tiles, without timing
+	if (!costMap && IsFullTile(job, SHADER::c_fixedTileSize))
+	{
+		vec4 colors[4];
+		uint64_t ticks[4] = { 0, 0, 0, 0 };
+		vec2 fragCoords[4];
+		bool useQuads = false;
+		for (size_t y = 0; y < SHADER::c_fixedTileSize; y += 2)
+		{
+			for (size_t x = 0; x < SHADER::c_fixedTileSize; x += 2)
+			{
+				for (size_t i = 0; i < 4; ++i)
+					fragCoords[i] = vec2(float(job.m_minX + x + (i & 1)) + 0.5f, float(job.m_minY + y + (i >> 1)) + 0.5f);
+				ShadeQuad(shader, fragCoords, 0xf, false, colors, ticks, useQuads);
+				for (size_t i = 0; i < 4; ++i)
+					WritePixel(image, job.m_minX + x + (i & 1), job.m_minY + y + (i >> 1), colors[i]);
+			}
+		}
+		CountShadedPixels(job, SHADER::c_fixedTileSize * SHADER::c_fixedTileSize);
+		return;
+	}
+
+	size_t shaded = ShadeTileQuads(shader, costMap, job,
+		[&](size_t x, size_t y) { return IsShadedPixel(job, x, y); },
+		[&](size_t x, size_t y, const vec4& color)
+		{
+			if (job.m_step == 1)
+				WritePixel(image, x, y, color);
+			else
+				WriteBlock(image, job, x, y, color);
+		});
+	CountShadedPixels(job, shaded);
+}
+
+//-------------------------------------------------------------------------------------
+// Packets shade every pixel of the tile. Coarse progressive levels and the coarse pass of
+// a sparse render, whose pixels aren't next to each other, go through RenderTile()
+// instead.
+template <typename SHADER, typename TTarget>
+void RenderTilePacket (const SHADER& shader, const TTarget& image, SCostMap* costMap, const STileJob& job)
+{
+	if (job.m_step > 1 || job.m_sparsePass == ESparsePass::Coarse)
+	{
+		RenderTile(shader, image, costMap, job);
+		return;
+	}
+	if (job.m_sparsePass == ESparsePass::Refine)
+	{
+		RenderSparseRefine(shader, image, costMap, job, true);
+		return;
+	}
+
+	bool useQuads = false;
+
+	// a fixed kernel's whole tiles are a constant number of packets
+	if (IsFullTile(job, SHADER::c_fixedTileSize) && SHADER::c_fixedTileSize % c_packetWidthPixels == 0 && SHADER::c_fixedTileSize % c_packetHeightPixels == 0)
+	{
+		const uint32_t allLanes = uint32_t((uint64_t(1) << GLSL_PACKET_WIDTH) - 1);
+		for (size_t y = 0; y < SHADER::c_fixedTileSize; y += c_packetHeightPixels)
+		{
+			for (size_t x = 0; x < SHADER::c_fixedTileSize; x += c_packetWidthPixels)
+				RenderPacket(shader, image, costMap, job, job.m_minX + x, job.m_minY + y, allLanes, useQuads);
+		}
+		CountShadedPixels(job, SHADER::c_fixedTileSize * SHADER::c_fixedTileSize);
+		return;
+	}
+
+	for (size_t packetY = job.m_minY & ~size_t(1); packetY < job.m_maxY; packetY += c_packetHeightPixels)
+	{
+		for (size_t packetX = job.m_minX & ~size_t(1); packetX < job.m_maxX; packetX += c_packetWidthPixels)
+			RenderPacket(shader, image, costMap, job, packetX, packetY, PacketLanesInTile(job, packetX, packetY), useQuads);
+	}
+	CountShadedPixels(job, (job.m_maxX - job.m_minX) * (job.m_maxY - job.m_minY));
+}
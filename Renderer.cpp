@@ -0,0 +1,301 @@
+#include "Renderer.h"
+#include "OpCountReport.h"
+#include "RenderTile.h"
+#include "TileHistory.h"
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+void AllocateImage (SImageData& image, long width, long height)
+{
+	image.m_width = width;
+	image.m_height = height;
+	image.m_pitch = image.m_width * 3;
+	if (image.m_pitch & 3)
+	{
+		image.m_pitch &= ~3;
+		image.m_pitch += 4;
+	}
+	image.m_pixels.resize(image.m_pitch*image.m_height);
+}
+
+//-------------------------------------------------------------------------------------
+SRenderContext MakeRenderContext (long width, long height, float timeSeconds)
+{
+	SRenderContext context;
+	context.m_iGlobalTime = timeSeconds;
+	context.m_iResolution = vec3(float(width), float(height), 1.0f);
+	context.m_iMouse = vec4(0.0f);
+
+	// year, month (0 based), day, seconds since midnight
+	time_t now = time(nullptr);
+	tm localNow = *localtime(&now);
+	context.m_iDate = vec4(
+		float(localNow.tm_year + 1900),
+		float(localNow.tm_mon),
+		float(localNow.tm_mday),
+		float(localNow.tm_hour * 3600 + localNow.tm_min * 60 + localNow.tm_sec)
+	);
+	return context;
+}
+
+//-------------------------------------------------------------------------------------
+static void CompareTile (SImageComparison* comparison, const SImageView& image, const STileJob& job)
+{
+	comparison->CompareTile(image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+static void CompareTile (SImageComparison* comparison, SFloatImage* image, const STileJob& job)
+{
+	comparison->CompareTile(*image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+// buffers have no reference to compare against
+static void CompareTile (SImageComparison*, STexture*, const STileJob&)
+{
+}
+
+//-------------------------------------------------------------------------------------
+static void RenderFixedTile (const SFixedKernel& kernel, const SImageView& image, SCostMap* costMap, const STileJob& job, ERenderMode mode)
+{
+	kernel.m_renderImageTile(image, costMap, job, mode);
+}
+
+static void RenderFixedTile (const SFixedKernel& kernel, SFloatImage* image, SCostMap* costMap, const STileJob& job, ERenderMode mode)
+{
+	kernel.m_renderFloatImageTile(image, costMap, job, mode);
+}
+
+// buffer passes have no fixed kernels, so this is never called
+static void RenderFixedTile (const SFixedKernel&, STexture*, SCostMap*, const STileJob&, ERenderMode)
+{
+}
+
+//-------------------------------------------------------------------------------------
+static void StoreTile (STileHistory& history, size_t tile, uint32_t uniformsRead, const SImageView& image, const STileJob& job)
+{
+	history.StoreTile(tile, uniformsRead, image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+static void StoreTile (STileHistory& history, size_t tile, uint32_t uniformsRead, SFloatImage* image, const STileJob& job)
+{
+	history.StoreTile(tile, uniformsRead, image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+static void RestoreTile (const STileHistory& history, const SImageView& image, const STileJob& job)
+{
+	history.RestoreTile(image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+static void RestoreTile (const STileHistory& history, SFloatImage* image, const STileJob& job)
+{
+	history.RestoreTile(image, job.m_minX, job.m_minY, job.m_maxX, job.m_maxY);
+}
+
+static size_t PixelSize (const SImageView&) { return 3; }
+static size_t PixelSize (SFloatImage*) { return 4 * sizeof(float); }
+
+// buffer passes aren't given a tile history, so these are never called
+static void StoreTile (STileHistory&, size_t, uint32_t, STexture*, const STileJob&) { }
+static void RestoreTile (const STileHistory&, STexture*, const STileJob&) { }
+static size_t PixelSize (STexture*) { return sizeof(vec4); }
+
+//-------------------------------------------------------------------------------------
+// Shade a tile with the shader's op counting build, adding what it ran to report. Counted
+// pixels are shaded one at a time whatever the render mode.
+template <typename TTarget>
+static void RenderCountedTile (const SShader& shader, TTarget image, SCostMap* costMap, const STileJob& job, SOpCountReport* report)
+{
+	SShaderCounter counter(shader);
+	std::atomic<uint64_t> shadedPixels(0);
+	STileJob countedJob = job;
+	countedJob.m_shadedPixels = &shadedPixels;
+
+	const SOpCounts before = counter.QuadSlot().m_opCounts;
+	RenderTile(counter, image, costMap, countedJob);
+	report->Add(before, counter.QuadSlot().m_opCounts, shadedPixels);
+	CountShadedPixels(job, shadedPixels);
+}
+
+//-------------------------------------------------------------------------------------
+// A sparse render of one image pass, kept alive by its tasks until the last one is done
+struct SSparseRender
+{
+	SSparseRender (const STileJob& region, const SSparseSettings& settings, const std::vector<STileJob>& tiles)
+		: m_grid(region.m_originX, region.m_originY, region.m_regionMaxX, region.m_regionMaxY, settings)
+		, m_tiles(tiles)
+		, m_coarseTilesLeft(tiles.size())
+	{ }
+
+	SSparseGrid m_grid;
+	std::vector<STileJob> m_tiles;
+	std::atomic<size_t> m_coarseTilesLeft;
+};
+
+//-------------------------------------------------------------------------------------
+// TTarget is an SImageView, an STexture* or an SFloatImage*, all cheap to copy into each tile's task
+template <typename TTarget>
+static void SubmitTiles (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, TTarget image, long imageWidth, long imageHeight, const SRenderSettings& settings, const SRenderContext& context)
+{
+	const size_t tileSize = settings.m_tileSize > 0 ? settings.m_tileSize : 1;
+	const ERenderMode mode = settings.m_mode;
+	SCostMap* costMap = settings.m_costMap;
+	SImageComparison* comparison = settings.m_comparison;
+
+	// counting ops needs the shader's op counting build. Without one, the cost map would
+	// get ticks where ops are asked for, so it is left alone.
+	SOpCountReport* opCounts = shader.m_countedMainImage ? settings.m_opCounts : nullptr;
+	if (settings.m_opCounts && !opCounts)
+		costMap = nullptr;
+
+	// the shader compiled with this frame's uniforms as constants, if there is one
+	const SFixedKernel* fixedKernel = settings.m_fixedKernels && !opCounts && shader.m_findFixedKernel ? shader.m_findFixedKernel(context) : nullptr;
+
+	const size_t width = (size_t)imageWidth;
+	const size_t height = (size_t)imageHeight;
+
+	// the region, clipped to the image
+	STileJob region;
+	const SRenderRegion& settingsRegion = settings.m_region;
+	region.m_originX = settingsRegion.IsWholeImage() ? 0 : std::min(settingsRegion.m_x, width);
+	region.m_originY = settingsRegion.IsWholeImage() ? 0 : std::min(settingsRegion.m_y, height);
+	region.m_regionMaxX = settingsRegion.IsWholeImage() ? width : std::min(settingsRegion.m_x + settingsRegion.m_width, width);
+	region.m_regionMaxY = settingsRegion.IsWholeImage() ? height : std::min(settingsRegion.m_y + settingsRegion.m_height, height);
+	region.m_step = settings.m_pixelStep > 0 ? settings.m_pixelStep : 1;
+	region.m_skipStep = settings.m_skipStep;
+	region.m_supersampling = settings.m_supersampling;
+	region.m_sparsePass = ESparsePass::None;
+	region.m_sparseGrid = nullptr;
+	region.m_shadedPixels = settings.m_shadedPixels;
+
+	auto renderTile = [shader, fixedKernel, image, context, mode, costMap, comparison, opCounts](const STileJob& job)
+	{
+		if (comparison && comparison->ShouldStop())
+			return;
+
+		SRenderContextBinding binding(context, shader.m_renderContext ? shader.m_renderContext() : CurrentRenderContext());
+		if (opCounts)
+			RenderCountedTile(shader, image, costMap, job, opCounts);
+		else if (fixedKernel)
+			RenderFixedTile(*fixedKernel, image, costMap, job, mode);
+		else if (mode == ERenderMode::Packet)
+			RenderTilePacket(SShaderPointers(shader), image, costMap, job);
+		else
+			RenderTile(SShaderPointers(shader), image, costMap, job);
+
+		// coarse progressive levels and sparse passes aren't final yet; the last level has a
+		// step of 1
+		if (comparison && job.m_step == 1 && job.m_sparsePass != ESparsePass::Coarse)
+			CompareTile(comparison, image, job);
+	};
+
+	// tiles are submitted in row order and dealt round robin, so every worker starts with
+	// a spread of cheap and expensive screen regions, and stealing evens out the rest.
+	// Tiles stay on the same grid whatever the region, and only those it touches are queued.
+	std::vector<STileJob> jobs;
+	for (size_t tileY = region.m_originY / tileSize * tileSize; tileY < region.m_regionMaxY; tileY += tileSize)
+	{
+		for (size_t tileX = region.m_originX / tileSize * tileSize; tileX < region.m_regionMaxX; tileX += tileSize)
+		{
+			STileJob job = region;
+			job.m_minX = std::max(tileX, region.m_originX);
+			job.m_minY = std::max(tileY, region.m_originY);
+			job.m_maxX = std::min(tileX + tileSize, region.m_regionMaxX);
+			job.m_maxY = std::min(tileY + tileSize, region.m_regionMaxY);
+			jobs.push_back(job);
+		}
+	}
+
+	// with a tile history, each tile is copied from it if none of the uniforms it read last
+	// frame have changed, and otherwise shaded with a note of the uniforms it reads
+	STileHistory* history = settings.m_tileHistory;
+	if (history && region.m_step == 1 && !settings.m_sparse.IsEnabled())
+	{
+		history->BeginFrame(context, imageWidth, imageHeight, PixelSize(image), settings, jobs.size());
+		for (size_t tile = 0; tile < jobs.size(); ++tile)
+		{
+			const STileJob& job = jobs[tile];
+			scheduler.Submit(group, [renderTile, job, tile, history, shader, fixedKernel, image](size_t)
+			{
+				if (history->CanReuse(tile))
+				{
+					RestoreTile(*history, image, job);
+					return;
+				}
+
+				SShaderQuadSlot& slot = SShaderPointers(shader).QuadSlot();
+				slot.m_uniformsRead = 0;
+				renderTile(job);
+				StoreTile(*history, tile, slot.m_uniformsRead | (fixedKernel ? fixedKernel->m_constantUniforms : 0), image, job);
+			});
+		}
+		return;
+	}
+
+	if (!settings.m_sparse.IsEnabled() || region.m_step > 1 || jobs.empty())
+	{
+		for (const STileJob& job : jobs)
+			scheduler.Submit(group, [renderTile, job](size_t) { renderTile(job); });
+		return;
+	}
+
+	// a sparse render's refine pass reads grid pixels from neighbouring tiles, so the last
+	// tile to finish the coarse pass queues the refine pass, in the same group
+	std::shared_ptr<SSparseRender> sparse = std::make_shared<SSparseRender>(region, settings.m_sparse, jobs);
+	STaskScheduler* sparseScheduler = &scheduler;
+	STaskGroup* sparseGroup = &group;
+	for (const STileJob& job : jobs)
+	{
+		STileJob coarseJob = job;
+		coarseJob.m_sparsePass = ESparsePass::Coarse;
+		coarseJob.m_sparseGrid = &sparse->m_grid;
+		scheduler.Submit(group, [renderTile, coarseJob, sparse, sparseScheduler, sparseGroup](size_t)
+		{
+			renderTile(coarseJob);
+			if (sparse->m_coarseTilesLeft.fetch_sub(1) != 1)
+				return;
+
+			for (const STileJob& job : sparse->m_tiles)
+			{
+				STileJob refineJob = job;
+				refineJob.m_sparsePass = ESparsePass::Refine;
+				refineJob.m_sparseGrid = &sparse->m_grid;
+				sparseScheduler->Submit(*sparseGroup, [renderTile, refineJob, sparse](size_t) { renderTile(refineJob); });
+			}
+		});
+	}
+}
+
+//-------------------------------------------------------------------------------------
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	SubmitRenderImage(scheduler, group, c_mainShader, image, settings, context);
+}
+
+//-------------------------------------------------------------------------------------
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	SubmitTiles(scheduler, group, shader, image, image.m_width, image.m_height, settings, context);
+}
+
+//-------------------------------------------------------------------------------------
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	SubmitTiles(scheduler, group, shader, &image, image.m_width, image.m_height, settings, context);
+}
+
+//-------------------------------------------------------------------------------------
+void SubmitRenderPass (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, STexture& target, const SRenderSettings& settings, const SRenderContext& context)
+{
+	SubmitTiles(scheduler, group, shader, &target, target.m_width, target.m_height, settings, context);
+}
+
+//-------------------------------------------------------------------------------------
+void RenderImage (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context)
+{
+	STaskGroup group;
+	SubmitRenderImage(scheduler, group, image, settings, context);
+	scheduler.Wait(group);
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "glslAdapters.h"
+#include "glslPacket.h"
+#include "glslCounted.h"
+#include "CostMap.h"
+#include "FloatImage.h"
+#include "ImageCompare.h"
+#include "Settings.h"
+#include "SImageData.h"
+#include "SparseRender.h"
+#include "Supersampling.h"
+#include "TaskScheduler.h"
+#include "Texture.h"
+#include <atomic>
+
+//-------------------------------------------------------------------------------------
+enum class ERenderMode
+{
+	Scalar,     // one mainImage() call per pixel, for stepping through shader code
+	Packet,     // GLSL_PACKET_WIDTH pixels per call with SIMD, see glslPacket.h
+};
+
+//-------------------------------------------------------------------------------------
+typedef void (*TMainImage)(vec4& fragColor, vec2 fragCoord);
+typedef void (*TPacketMainImage)(Packet::vec4& fragColor, Packet::vec2 fragCoord);
+typedef void (*TCountedMainImage)(Counted::vec4& fragColor, Counted::vec2 fragCoord);
+typedef const SRenderContext*& (*TRenderContextSlot)();
+typedef bool& (*TPacketDivergedFlag)();
+typedef SShaderQuadSlot& (*TShaderQuadSlot)();
+
+struct STileJob;
+struct STileHistory;
+struct SOpCountReport;
+
+// The shader compiled a second time for one frame size, with that size (and optionally
+// the other uniforms of a still frame) as constants. See mainFixed.cpp.
+struct SFixedKernel
+{
+	size_t m_width;
+	size_t m_height;
+
+	// the uniforms compiled in as constants, which its tiles depend on without reading them
+	uint32_t m_constantUniforms;
+
+	void (*m_renderImageTile)(const SImageView& image, SCostMap* costMap, const STileJob& job, ERenderMode mode);
+	void (*m_renderFloatImageTile)(SFloatImage* image, SCostMap* costMap, const STileJob& job, ERenderMode mode);
+};
+
+typedef const SFixedKernel* (*TFindFixedKernel)(const SRenderContext& context);
+
+// A shader's entry point, compiled both for single pixels and for packets of pixels, and
+// optionally counting its operations (null without)
+struct SShader
+{
+	TMainImage m_mainImage;
+	TPacketMainImage m_packetMainImage;
+	TCountedMainImage m_countedMainImage;
+
+	// The thread locals the shader's code reads its render context from, flags packet
+	// divergence in and finds its 2x2 quad through. Null means this executable's own; a
+	// shader module has its own copies.
+	TRenderContextSlot m_renderContext;
+	TPacketDivergedFlag m_packetDiverged;
+	TShaderQuadSlot m_shaderQuad;
+
+	// Returns the fixed kernel for a frame's uniforms, or null to use the generic one.
+	// Null for shaders without fixed kernels.
+	TFindFixedKernel m_findFixedKernel;
+};
+
+// The fixed kernels of main.cpp, for the frame sizes listed in Settings.h
+const SFixedKernel* FindFixedKernel (const SRenderContext& context);
+
+// mainImage() of main.cpp
+#if SHADER_OP_COUNTS
+const SShader c_mainShader = { Scalar::mainImage, Packet::mainImage, Counted::mainImage, nullptr, nullptr, nullptr, FindFixedKernel };
+#else
+const SShader c_mainShader = { Scalar::mainImage, Packet::mainImage, nullptr, nullptr, nullptr, nullptr, FindFixedKernel };
+#endif
+
+//-------------------------------------------------------------------------------------
+// A rectangle of pixels, y = 0 being the bottom row as for fragCoord. A width or height
+// of 0 means the whole image.
+struct SRenderRegion
+{
+	SRenderRegion()
+		: m_x(0)
+		, m_y(0)
+		, m_width(0)
+		, m_height(0)
+	{ }
+
+	bool IsWholeImage () const { return m_width == 0 || m_height == 0; }
+
+	size_t m_x;
+	size_t m_y;
+	size_t m_width;
+	size_t m_height;
+};
+
+//-------------------------------------------------------------------------------------
+struct SRenderSettings
+{
+	SRenderSettings()
+		: m_tileSize(16)
+		, m_mode(ERenderMode::Scalar)
+		, m_progressiveLevels(1)
+		, m_pixelStep(1)
+		, m_skipStep(0)
+		, m_costMap(nullptr)
+		, m_comparison(nullptr)
+		, m_fixedKernels(true)
+		, m_shadedPixels(nullptr)
+		, m_reuseTiles(false)
+		, m_tileHistory(nullptr)
+		, m_opCounts(nullptr)
+	{ }
+
+	size_t m_tileSize;      // width and height in pixels of the tiles handed to threads
+	ERenderMode m_mode;
+
+	// only the image pass's pixels inside the region are shaded, the rest of the image is
+	// left as it was (blank, for a new image). Buffer passes still render in full, since
+	// the region can read them anywhere.
+	SRenderRegion m_region;
+
+	// SPassGraph renders the image pass in this many levels, each with half the pixel
+	// step of the one before: 1/16 of the pixels, then 1/4, then all of them for 3 levels.
+	// Every pixel is shaded once in scalar mode; packet mode reshades the last level in
+	// full so the final image is exactly a packet mode render.
+	size_t m_progressiveLevels;
+
+	// shade one pixel of each m_pixelStep square block (counted from the region's corner)
+	// and fill the block with it, skipping pixels that also lie on the m_skipStep grid as
+	// a coarser level already shaded them. Set by SPassGraph for each progressive level.
+	size_t m_pixelStep;
+	size_t m_skipStep;
+
+	// when set (and sized to the image), adds how long each pixel took to shade, so
+	// every pass of a frame counts. Packet mode splits a packet's time evenly across its
+	// pixels.
+	SCostMap* m_costMap;
+
+	// when set, each tile of the image is checked against the comparison's reference as
+	// soon as its last level is written, and tiles are skipped once it says to stop.
+	// Buffer passes aren't compared.
+	SImageComparison* m_comparison;
+
+	// use the shader's fixed kernel for frames whose size and uniforms it was compiled
+	// for. It shades the same pixels as the generic kernel, only faster.
+	bool m_fixedKernels;
+
+	// shade each pixel of the image pass at several points and average them, taking more
+	// samples where the colour varies (see Supersampling.h). Off by default: one sample at
+	// the pixel centre. Buffer passes always take one.
+	SSupersampleSettings m_supersampling;
+
+	// shade the image pass on a coarse grid and interpolate between, shading only around
+	// edges in full (see SparseRender.h). Only for renders without progressive levels.
+	SSparseSettings m_sparse;
+
+	// when set, adds how many of the image pass's pixels were shaded, rather than filled
+	// from a coarser level or interpolated. Samples and the other pixels of 2x2 quads
+	// that were only shaded for their derivatives aren't counted.
+	std::atomic<uint64_t>* m_shadedPixels;
+
+	// SPassGraph keeps the image pass's tiles from frame to frame, and only shades those
+	// again that read a uniform that changed (see TileHistory.h). For renders without
+	// progressive levels, -sparse or a comparison.
+	bool m_reuseTiles;
+
+	// the history SPassGraph keeps, when set tiles are reused from it and stored into it
+	STileHistory* m_tileHistory;
+
+	// when set, passes with an op counting build (see glslCounted.h) shade with it, one
+	// pixel at a time and without fixed kernels, and add the ops they ran to the report.
+	// The cost map then gets each pixel's ops rather than its time, and passes without
+	// one are left out of it.
+	SOpCountReport* m_opCounts;
+};
+
+//-------------------------------------------------------------------------------------
+// Size the image's pixel buffer for a width x height 24 bit BMP (rows padded to 4 bytes)
+void AllocateImage (SImageData& image, long width, long height);
+
+//-------------------------------------------------------------------------------------
+// Fill out the uniforms for a width x height frame at the given time. iDate is taken
+// from the system clock, like Shadertoy does.
+SRenderContext MakeRenderContext (long width, long height, float timeSeconds);
+
+//-------------------------------------------------------------------------------------
+// Queue the tiles of a frame on the scheduler as part of group, without waiting for
+// them. Each tile binds its own copy of context on whichever thread runs it, so any
+// number of frames (with different uniforms) can be in flight at once. The image's
+// pixels (an SImageData or a mapped file) must stay alive until the group has been
+// waited on.
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context);
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context);
+
+// Or into a float image, unclamped, for encoders that keep more than 8 bits. The image
+// must already be sized.
+void SubmitRenderImage (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, SFloatImage& image, const SRenderSettings& settings, const SRenderContext& context);
+
+//-------------------------------------------------------------------------------------
+// The same for a buffer pass: the shader's output goes into a float texture as is,
+// without being clamped or converted to 8 bits
+void SubmitRenderPass (STaskScheduler& scheduler, STaskGroup& group, const SShader& shader, STexture& target, const SRenderSettings& settings, const SRenderContext& context);
+
+//-------------------------------------------------------------------------------------
+// Render mainImage() into image, split into tiles that are run on the scheduler's worker
+// threads. Every pixel is shaded exactly as the serial loop did it, so the result doesn't
+// depend on the thread count or tile size.
+void RenderImage (STaskScheduler& scheduler, const SImageView& image, const SRenderSettings& settings, const SRenderContext& context);
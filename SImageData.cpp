@@ -1,6 +1,162 @@
 #include "SImageData.h"
-#include <windows.h> // for BITMAPFILEHEADER
+#include <algorithm>
+#include <stdio.h>
 
+// The BMP file and info headers. They are read and written a field at a time in little
+// endian order, so this doesn't depend on <windows.h> or on struct packing.
+struct SBitmapFileHeader
+{
+    uint16_t bfType;
+    uint32_t bfSize;
+    uint16_t bfReserved1;
+    uint16_t bfReserved2;
+    uint32_t bfOffBits;
+};
+
+struct SBitmapInfoHeader
+{
+    uint32_t biSize;
+    int32_t biWidth;
+    int32_t biHeight;
+    uint16_t biPlanes;
+    uint16_t biBitCount;
+    uint32_t biCompression;
+    uint32_t biSizeImage;
+    int32_t biXPelsPerMeter;
+    int32_t biYPelsPerMeter;
+    uint32_t biClrUsed;
+    uint32_t biClrImportant;
+};
+
+static const size_t c_fileHeaderSize = 14;
+static const size_t c_infoHeaderSize = 40;
+
+//-------------------------------------------------------------------------------------
+static uint32_t ReadLittleEndian (const uint8*& data, size_t numBytes)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < numBytes; ++i)
+        value |= uint32_t(data[i]) << (i * 8);
+    data += numBytes;
+    return value;
+}
+
+//-------------------------------------------------------------------------------------
+static void WriteLittleEndian (uint8*& data, uint32_t value, size_t numBytes)
+{
+    for (size_t i = 0; i < numBytes; ++i)
+        data[i] = uint8(value >> (i * 8));
+    data += numBytes;
+}
+
+//-------------------------------------------------------------------------------------
+static void ParseHeaders (const uint8* bytes, SBitmapFileHeader& header, SBitmapInfoHeader& infoHeader)
+{
+    const uint8* data = bytes;
+    header.bfType = (uint16_t)ReadLittleEndian(data, 2);
+    header.bfSize = ReadLittleEndian(data, 4);
+    header.bfReserved1 = (uint16_t)ReadLittleEndian(data, 2);
+    header.bfReserved2 = (uint16_t)ReadLittleEndian(data, 2);
+    header.bfOffBits = ReadLittleEndian(data, 4);
+
+    infoHeader.biSize = ReadLittleEndian(data, 4);
+    infoHeader.biWidth = (int32_t)ReadLittleEndian(data, 4);
+    infoHeader.biHeight = (int32_t)ReadLittleEndian(data, 4);
+    infoHeader.biPlanes = (uint16_t)ReadLittleEndian(data, 2);
+    infoHeader.biBitCount = (uint16_t)ReadLittleEndian(data, 2);
+    infoHeader.biCompression = ReadLittleEndian(data, 4);
+    infoHeader.biSizeImage = ReadLittleEndian(data, 4);
+    infoHeader.biXPelsPerMeter = (int32_t)ReadLittleEndian(data, 4);
+    infoHeader.biYPelsPerMeter = (int32_t)ReadLittleEndian(data, 4);
+    infoHeader.biClrUsed = ReadLittleEndian(data, 4);
+    infoHeader.biClrImportant = ReadLittleEndian(data, 4);
+}
+
+//-------------------------------------------------------------------------------------
+static bool ReadHeaders (FILE *file, SBitmapFileHeader& header, SBitmapInfoHeader& infoHeader)
+{
+    uint8 bytes[c_fileHeaderSize + c_infoHeaderSize];
+    if (fread(bytes, sizeof(bytes), 1, file) != 1)
+        return false;
+
+    ParseHeaders(bytes, header, infoHeader);
+    return true;
+}
+
+//-------------------------------------------------------------------------------------
+static void SerializeHeaders (uint8* bytes, const SBitmapFileHeader& header, const SBitmapInfoHeader& infoHeader)
+{
+    uint8* data = bytes;
+    WriteLittleEndian(data, header.bfType, 2);
+    WriteLittleEndian(data, header.bfSize, 4);
+    WriteLittleEndian(data, header.bfReserved1, 2);
+    WriteLittleEndian(data, header.bfReserved2, 2);
+    WriteLittleEndian(data, header.bfOffBits, 4);
+
+    WriteLittleEndian(data, infoHeader.biSize, 4);
+    WriteLittleEndian(data, (uint32_t)infoHeader.biWidth, 4);
+    WriteLittleEndian(data, (uint32_t)infoHeader.biHeight, 4);
+    WriteLittleEndian(data, infoHeader.biPlanes, 2);
+    WriteLittleEndian(data, infoHeader.biBitCount, 2);
+    WriteLittleEndian(data, infoHeader.biCompression, 4);
+    WriteLittleEndian(data, infoHeader.biSizeImage, 4);
+    WriteLittleEndian(data, (uint32_t)infoHeader.biXPelsPerMeter, 4);
+    WriteLittleEndian(data, (uint32_t)infoHeader.biYPelsPerMeter, 4);
+    WriteLittleEndian(data, infoHeader.biClrUsed, 4);
+    WriteLittleEndian(data, infoHeader.biClrImportant, 4);
+}
+
+//-------------------------------------------------------------------------------------
+static bool WriteHeaders (FILE *file, const SBitmapFileHeader& header, const SBitmapInfoHeader& infoHeader)
+{
+    uint8 bytes[c_fileHeaderSize + c_infoHeaderSize];
+    SerializeHeaders(bytes, header, infoHeader);
+    return fwrite(bytes, sizeof(bytes), 1, file) == 1;
+}
+
+//-------------------------------------------------------------------------------------
+static long PaddedPitch (long width)
+{
+    long pitch = width*3;
+    if (pitch & 3)
+    {
+        pitch &= ~3;
+        pitch += 4;
+    }
+    return pitch;
+}
+
+//-------------------------------------------------------------------------------------
+bool FitsInBMP (long width, long height)
+{
+    return width > 0 && height > 0 && (uint64_t)PaddedPitch(width)*(uint64_t)height + c_fileHeaderSize + c_infoHeaderSize <= UINT32_MAX;
+}
+
+//-------------------------------------------------------------------------------------
+// The headers of an uncompressed, bottom up, 24 bit image
+static void MakeHeaders (long width, long height, uint32_t sizeImage, SBitmapFileHeader& header, SBitmapInfoHeader& infoHeader)
+{
+    header.bfType = 0x4D42;
+    header.bfReserved1 = 0;
+    header.bfReserved2 = 0;
+    header.bfOffBits = c_fileHeaderSize + c_infoHeaderSize;
+ 
+    infoHeader.biSize = c_infoHeaderSize;
+    infoHeader.biWidth = width;
+    infoHeader.biHeight = height;
+    infoHeader.biPlanes = 1;
+    infoHeader.biBitCount = 24;
+    infoHeader.biCompression = 0;
+    infoHeader.biSizeImage = sizeImage;
+    infoHeader.biXPelsPerMeter = 0;
+    infoHeader.biYPelsPerMeter = 0;
+    infoHeader.biClrUsed = 0;
+    infoHeader.biClrImportant = 0;
+ 
+    header.bfSize = infoHeader.biSizeImage + header.bfOffBits;
+}
+
+//-------------------------------------------------------------------------------------
 bool LoadImage (const char *fileName, SImageData& imageData)
 {
     // open the file if we can
@@ -10,41 +166,60 @@ bool LoadImage (const char *fileName, SImageData& imageData)
         return false;
  
     // read the headers if we can
-    BITMAPFILEHEADER header;
-    BITMAPINFOHEADER infoHeader;
-    if (fread(&header, sizeof(header), 1, file) != 1 ||
-        fread(&infoHeader, sizeof(infoHeader), 1, file) != 1 ||
-        header.bfType != 0x4D42 || infoHeader.biBitCount != 24)
+    SBitmapFileHeader header;
+    SBitmapInfoHeader infoHeader;
+    if (!ReadHeaders(file, header, infoHeader) ||
+        header.bfType != 0x4D42 || infoHeader.biBitCount != 24 || infoHeader.biCompression != 0 ||
+        infoHeader.biWidth <= 0 || infoHeader.biHeight == 0 || infoHeader.biHeight == INT32_MIN)
     {
         fclose(file);
         return false;
     }
  
-    // read in our pixel data if we can. Note that it's in BGR order, and width is padded to the next power of 4
-    imageData.m_pixels.resize(infoHeader.biSizeImage);
+    long width = infoHeader.biWidth;
+    long height = infoHeader.biHeight < 0 ? -(long)infoHeader.biHeight : infoHeader.biHeight;
+    long pitch = PaddedPitch(width);
+
+    // the pixels have to be in the file, before anything is allocated for them
+    long fileSize = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    if (fileSize < 0 || header.bfOffBits + (uint64_t)pitch*height > (uint64_t)fileSize)
+    {
+        fclose(file);
+        return false;
+    }
+
+    imageData.m_width = width;
+    imageData.m_height = height;
+    imageData.m_pitch = pitch;
+
+    // read in our pixel data if we can. Note that it's in BGR order, and width is padded to the next power of 4.
+    // biSizeImage is allowed to be 0 for uncompressed images, so the size comes from the pitch.
+    imageData.m_pixels.resize(imageData.m_pitch*imageData.m_height);
     fseek(file, header.bfOffBits, SEEK_SET);
-    if (fread(&imageData.m_pixels[0], imageData.m_pixels.size(), 1, file) != 1)
+    if (imageData.m_pixels.empty() || fread(&imageData.m_pixels[0], imageData.m_pixels.size(), 1, file) != 1)
     {
         fclose(file);
         return false;
     }
- 
-    imageData.m_width = infoHeader.biWidth;
-    imageData.m_height = infoHeader.biHeight;
- 
-    imageData.m_pitch = imageData.m_width*3;
-    if (imageData.m_pitch & 3)
+
+    // a negative height means the rows are stored top down. Flip them so row 0 is the bottom like usual.
+    if (infoHeader.biHeight < 0)
     {
-        imageData.m_pitch &= ~3;
-        imageData.m_pitch += 4;
+        for (long y = 0; y < imageData.m_height / 2; ++y)
+            std::swap_ranges(&imageData.m_pixels[y*imageData.m_pitch], &imageData.m_pixels[y*imageData.m_pitch] + imageData.m_pitch,
+                &imageData.m_pixels[(imageData.m_height - 1 - y)*imageData.m_pitch]);
     }
  
     fclose(file);
     return true;
 }
  
+//-------------------------------------------------------------------------------------
 bool SaveImage (const char *fileName, const SImageData &image)
 {
+    if (!FitsInBMP(image.m_width, image.m_height))
+        return false;
+
     // open the file if we can
     FILE *file;
     file = fopen(fileName, "wb");
@@ -52,32 +227,69 @@ bool SaveImage (const char *fileName, const SImageData &image)
         return false;
  
     // make the header info
-    BITMAPFILEHEADER header;
-    BITMAPINFOHEADER infoHeader;
- 
-    header.bfType = 0x4D42;
-    header.bfReserved1 = 0;
-    header.bfReserved2 = 0;
-    header.bfOffBits = 54;
- 
-    infoHeader.biSize = 40;
-    infoHeader.biWidth = image.m_width;
-    infoHeader.biHeight = image.m_height;
-    infoHeader.biPlanes = 1;
-    infoHeader.biBitCount = 24;
-    infoHeader.biCompression = 0;
-    infoHeader.biSizeImage = image.m_pixels.size();
-    infoHeader.biXPelsPerMeter = 0;
-    infoHeader.biYPelsPerMeter = 0;
-    infoHeader.biClrUsed = 0;
-    infoHeader.biClrImportant = 0;
- 
-    header.bfSize = infoHeader.biSizeImage + header.bfOffBits;
+    SBitmapFileHeader header;
+    SBitmapInfoHeader infoHeader;
+    MakeHeaders(image.m_width, image.m_height, (uint32_t)image.m_pixels.size(), header, infoHeader);
  
     // write the data and close the file
-    fwrite(&header, sizeof(header), 1, file);
-    fwrite(&infoHeader, sizeof(infoHeader), 1, file);
-    fwrite(&image.m_pixels[0], infoHeader.biSizeImage, 1, file);
-    fclose(file);
+    bool written = WriteHeaders(file, header, infoHeader) &&
+        fwrite(&image.m_pixels[0], infoHeader.biSizeImage, 1, file) == 1;
+    if (fclose(file) != 0)
+        written = false;
+    return written;
+}
+
+//-------------------------------------------------------------------------------------
+bool MapImage (const char *fileName, SMappedImage& image)
+{
+    image.m_view = SImageView();
+    if (!image.m_file.OpenRead(fileName) || image.m_file.m_size < c_fileHeaderSize + c_infoHeaderSize)
+    {
+        image.m_file.Close();
+        return false;
+    }
+
+    SBitmapFileHeader header;
+    SBitmapInfoHeader infoHeader;
+    ParseHeaders(image.m_file.m_data, header, infoHeader);
+
+    // only bottom up images can be used in place, since rows are addressed bottom first
+    long width = infoHeader.biWidth;
+    long height = infoHeader.biHeight;
+    long pitch = PaddedPitch(width);
+    if (header.bfType != 0x4D42 || infoHeader.biBitCount != 24 || infoHeader.biCompression != 0 ||
+        width <= 0 || height <= 0 || header.bfOffBits + (uint64_t)pitch*height > image.m_file.m_size)
+    {
+        image.m_file.Close();
+        return false;
+    }
+
+    image.m_view.m_width = width;
+    image.m_view.m_height = height;
+    image.m_view.m_pitch = pitch;
+    image.m_view.m_pixels = image.m_file.m_data + header.bfOffBits;
+    return true;
+}
+
+//-------------------------------------------------------------------------------------
+bool CreateMappedImage (const char *fileName, long width, long height, SMappedImage& image)
+{
+    image.m_view = SImageView();
+    if (!FitsInBMP(width, height))
+        return false;
+
+    long pitch = PaddedPitch(width);
+    SBitmapFileHeader header;
+    SBitmapInfoHeader infoHeader;
+    MakeHeaders(width, height, (uint32_t)(pitch*height), header, infoHeader);
+
+    if (!image.m_file.Create(fileName, header.bfSize))
+        return false;
+    SerializeHeaders(image.m_file.m_data, header, infoHeader);
+
+    image.m_view.m_width = width;
+    image.m_view.m_height = height;
+    image.m_view.m_pitch = pitch;
+    image.m_view.m_pixels = image.m_file.m_data + header.bfOffBits;
     return true;
-}
\ No newline at end of file
+}
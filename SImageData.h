@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Platform.h"
 #include <vector>
 #include <stdint.h>
 
@@ -18,6 +19,49 @@ struct SImageData
     std::vector<uint8> m_pixels;
 };
 
+// The 24 bit BGR rows of an image, wherever they are stored: in an SImageData or in a
+// memory mapped BMP file. Row 0 is the bottom row. Doesn't own the pixels.
+struct SImageView
+{
+    SImageView()
+        : m_width(0)
+        , m_height(0)
+        , m_pitch(0)
+        , m_pixels(nullptr)
+    { }
+
+    SImageView(SImageData& image)
+        : m_width(image.m_width)
+        , m_height(image.m_height)
+        , m_pitch(image.m_pitch)
+        , m_pixels(image.m_pixels.empty() ? nullptr : &image.m_pixels[0])
+    { }
+
+    long m_width;
+    long m_height;
+    long m_pitch;
+    uint8* m_pixels;
+};
+
+// A BMP file mapped into memory, with a view of the pixels inside it
+struct SMappedImage
+{
+    SMappedFile m_file;
+    SImageView m_view;
+};
+
+// Whether a width x height 24 bit image fits in a BMP, whose sizes are 32 bit
+bool FitsInBMP (long width, long height);
+
 bool LoadImage (const char *fileName, SImageData& imageData);
 
-bool SaveImage (const char *fileName, const SImageData &image);
\ No newline at end of file
+bool SaveImage (const char *fileName, const SImageData &image);
+
+// Map a 24 bit BMP read only, so its pixels can be used in place without being copied.
+// The view's pixels must not be written to.
+bool MapImage (const char *fileName, SMappedImage& image);
+
+// Create a width x height 24 bit BMP at its full size and map it, so the pixels can be
+// rendered straight into the file. The contents are only certain to be written once
+// m_file.Close() returns true.
+bool CreateMappedImage (const char *fileName, long width, long height, SMappedImage& image);
\ No newline at end of file
@@ -1,5 +1,66 @@
 #pragma once
 
 const size_t c_imageResolution[2] = { 512, 256 };
-const char *s_outImageFileName = "out.bmp";
-const float c_timeSeconds = 0.0f;
\ No newline at end of file
+const char * const s_outImageFileName = "out.bmp";
+const float c_timeSeconds = 0.0f;
+
+const size_t c_numThreads = 0;  // 0 means one render thread per hardware thread
+const size_t c_tileSize = 16;   // width and height in pixels of the tiles handed to render threads
+const size_t c_quadFiberStackSize = 1024 * 1024;  // stack of each pixel of a 2x2 quad, when scalar shading needs dFdx() etc
+const bool c_mapOutputFile = true;  // render single frames straight into a memory mapped output file
+const size_t c_writeQueueDepth = 2;  // sequence frames that may wait to be written while the next renders
+
+const size_t c_progressiveLevels = 3;  // levels of -progressive when no count is given: 1/16, 1/4 then all pixels
+
+const size_t c_supersampleBaseSamples = 4;  // samples every pixel gets with -supersample, one per quarter of it
+const float c_supersampleThreshold = 0.002f;  // standard error of a pixel's colour -supersample stops at, about half an 8 bit level
+
+const float c_sparseThreshold = 0.02f;  // r, g or b difference between neighbouring -sparse grid pixels that makes their blocks shade in full
+
+const size_t c_heatmapTopPixels = 10;  // slowest pixels listed when a heatmap is written
+
+const int c_compareThreshold = 1;  // 8 bit levels a channel may be off from a -compare reference and still match
+
+const size_t c_benchmarkIterations = 20;       // renders timed by -benchmark when no count is given
+const size_t c_benchmarkWarmupIterations = 2;  // untimed renders first, to warm caches and wake threads
+
+const size_t c_batchJobsInFlight = 2;  // -batch jobs rendering at once, so one's tail and encoding overlap the next
+
+const size_t c_remoteTileSize = 128;  // largest tiles -workers hands out, halved while a frame has too few for every worker to get several
+const size_t c_remoteTilesPerWorker = 8;  // tiles each worker should get a frame at least, so faster ones can take more
+const size_t c_remoteTilesInFlight = 2;  // tiles queued on each worker, so it starts the next one as soon as one is done
+const size_t c_remoteFramesInFlight = 2;  // sequence frames handed out at once, so workers don't wait on a frame's last tile
+const unsigned c_remoteTimeoutSeconds = 60;  // how long a worker may take to answer before its tiles go to the others
+const unsigned c_remoteIdleSeconds = 600;  // how long a worker waits on a silent coordinator before dropping it
+
+// Buffer passes of the shader, like the Buffer A-D tabs on Shadertoy. Set one to 1 once
+// its source is in bufferA.cpp etc, and bind channels in ShaderPasses.cpp.
+#define SHADER_BUFFER_A 0
+#define SHADER_BUFFER_B 0
+#define SHADER_BUFFER_C 0
+#define SHADER_BUFFER_D 0
+
+// Frame sizes (width, height) that get a render kernel of their own, with the shader
+// compiled again for just that size so iResolution folds into it as a constant. See
+// mainFixed.cpp. Frames of other sizes, and -generic, use the one compiled in
+// mainScalar.cpp and mainPacket.cpp. Up to 4.
+#define SHADER_FIXED_SIZE_0 c_imageResolution[0], c_imageResolution[1]
+#define SHADER_FIXED_SIZE_1 1920, 1080
+#define SHADER_FIXED_SIZE_2 3840, 2160
+
+// Set to 1 to also compile the fixed kernels with iTime at c_timeSeconds and iMouse at 0,
+// for shaders whose branches depend on them. The kernels are then only used for frames at
+// that time with the mouse up.
+#define SHADER_FIXED_STILL_FRAME 1
+
+// Set to 0 to leave out the op counting build of the shader (see mainCounted.cpp), which
+// only -opcounts uses, and save compiling the shader once more
+#define SHADER_OP_COUNTS 1
+
+// Shade a packet of pixels per mainImage() call with SIMD (see glslPacket.h). Debug builds
+// default to one pixel per call so shader code can be stepped through.
+#ifdef _DEBUG
+const bool c_packetMode = false;
+#else
+const bool c_packetMode = true;
+#endif
\ No newline at end of file
@@ -0,0 +1,192 @@
+// Builds a shader as a module the harness loads with -shader and reloads whenever the
+// module file changes. This file is not part of the harness: build it on its own as a
+// shared library, either with the ShaderModule project of the solution (which builds
+// main.cpp) or naming the shader's source, e.g.
+//
+//     g++ -std=c++14 -O2 -march=native -ffp-contract=off -shared -fPIC -fvisibility=hidden
+//         -DSHADER_MODULE_IMAGE='"myshader.cpp"' ShaderModule.cpp -o myshader.so
+//
+// Buffer passes are added with SHADER_MODULE_BUFFER_A to _D, each naming a source with its
+// code inside namespace BufferA etc, like for ShaderPasses.cpp. To bind channels, define
+// SHADER_MODULE_DESCRIBE as the name of a function in one of the sources that takes an
+// SShaderModuleExports& and fills in the m_channels of its passes. The sources are
+// compiled inside namespace Scalar, like mainScalar.cpp does, and again for packets.
+// Define SHADER_MODULE_OP_COUNTS to compile them a third time for -opcounts, like
+// mainCounted.cpp.
+
+#include "ShaderModule.h"
+
+#ifndef SHADER_MODULE_IMAGE
+#define SHADER_MODULE_IMAGE "main.cpp"
+#endif
+
+namespace Scalar
+{
+#include SHADER_MODULE_IMAGE
+#ifdef SHADER_MODULE_BUFFER_A
+#include SHADER_MODULE_BUFFER_A
+#endif
+#ifdef SHADER_MODULE_BUFFER_B
+#include SHADER_MODULE_BUFFER_B
+#endif
+#ifdef SHADER_MODULE_BUFFER_C
+#include SHADER_MODULE_BUFFER_C
+#endif
+#ifdef SHADER_MODULE_BUFFER_D
+#include SHADER_MODULE_BUFFER_D
+#endif
+}
+
+// the same sources again for packets, the way mainPacket.cpp compiles them
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (Packet::vec3(ReadUniforms(c_uniformResolution).m_iResolution))
+#define iMouse              (Packet::vec4(ReadUniforms(c_uniformMouse).m_iMouse))
+#define iDate               (Packet::vec4(ReadUniforms(c_uniformDate).m_iDate))
+
+#define float SFloatPacket
+
+namespace Packet
+{
+#include SHADER_MODULE_IMAGE
+#ifdef SHADER_MODULE_BUFFER_A
+#include SHADER_MODULE_BUFFER_A
+#endif
+#ifdef SHADER_MODULE_BUFFER_B
+#include SHADER_MODULE_BUFFER_B
+#endif
+#ifdef SHADER_MODULE_BUFFER_C
+#include SHADER_MODULE_BUFFER_C
+#endif
+#ifdef SHADER_MODULE_BUFFER_D
+#include SHADER_MODULE_BUFFER_D
+#endif
+}
+
+#undef float
+
+#ifdef SHADER_MODULE_OP_COUNTS
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (Counted::vec3(ReadUniforms(c_uniformResolution).m_iResolution))
+#define iMouse              (Counted::vec4(ReadUniforms(c_uniformMouse).m_iMouse))
+#define iDate               (Counted::vec4(ReadUniforms(c_uniformDate).m_iDate))
+
+#define float SCountedFloat
+
+namespace Counted
+{
+#include SHADER_MODULE_IMAGE
+#ifdef SHADER_MODULE_BUFFER_A
+#include SHADER_MODULE_BUFFER_A
+#endif
+#ifdef SHADER_MODULE_BUFFER_B
+#include SHADER_MODULE_BUFFER_B
+#endif
+#ifdef SHADER_MODULE_BUFFER_C
+#include SHADER_MODULE_BUFFER_C
+#endif
+#ifdef SHADER_MODULE_BUFFER_D
+#include SHADER_MODULE_BUFFER_D
+#endif
+}
+
+#undef float
+
+#define SHADER_MODULE_COUNTED(MAIN_IMAGE) Counted::MAIN_IMAGE
+#else
+#define SHADER_MODULE_COUNTED(MAIN_IMAGE) nullptr
+#endif
+
+//-------------------------------------------------------------------------------------
+// Texture lookups are the harness's
+static SShaderModuleImports s_imports;
+
+vec4 texture (const SSampler2D& sampler, const vec2& uv)
+{
+	return s_imports.m_texture(sampler, uv);
+}
+
+vec4 texture (const SSampler2D& sampler, const vec2& uv, float bias)
+{
+	return s_imports.m_textureBias(sampler, uv, bias);
+}
+
+vec4 textureLod (const SSampler2D& sampler, const vec2& uv, float lod)
+{
+	return s_imports.m_textureLod(sampler, uv, lod);
+}
+
+vec4 texelFetch (const SSampler2D& sampler, const ivec2& texel, int lod)
+{
+	return s_imports.m_texelFetch(sampler, texel, lod);
+}
+
+ivec2 textureSize (const SSampler2D& sampler, int lod)
+{
+	return s_imports.m_textureSize(sampler, lod);
+}
+
+//-------------------------------------------------------------------------------------
+static void Connect (const SShaderModuleImports& imports)
+{
+	s_imports = imports;
+}
+
+//-------------------------------------------------------------------------------------
+static void SetPass (SShaderModuleExports& exports, size_t pass, void (*mainImage)(vec4&, vec2), void (*packetMainImage)(Packet::vec4&, Packet::vec2), void (*countedMainImage)(Counted::vec4&, Counted::vec2))
+{
+	SShaderModulePass& modulePass = exports.m_passes[pass];
+	modulePass.m_mainImage = mainImage;
+	modulePass.m_packetMainImage = packetMainImage;
+	modulePass.m_countedMainImage = countedMainImage;
+}
+
+//-------------------------------------------------------------------------------------
+static SShaderModuleExports DescribeModule ()
+{
+	SShaderModuleExports exports;
+	exports.m_version = c_shaderModuleVersion;
+	exports.m_renderContextSize = (uint32_t)sizeof(SRenderContext);
+	exports.m_renderContext = CurrentRenderContext;
+	exports.m_packetDiverged = PacketDiverged;
+	exports.m_shaderQuad = CurrentShaderQuad;
+	exports.m_connect = Connect;
+
+	for (SShaderModulePass& pass : exports.m_passes)
+	{
+		pass.m_mainImage = nullptr;
+		pass.m_packetMainImage = nullptr;
+		pass.m_countedMainImage = nullptr;
+		for (SShaderModuleChannel& channel : pass.m_channels)
+			channel = { -1, nullptr, ETextureFilter::Linear, ETextureWrap::Clamp };
+	}
+
+#ifdef SHADER_MODULE_BUFFER_A
+	SetPass(exports, 0, Scalar::BufferA::mainImage, Packet::BufferA::mainImage, SHADER_MODULE_COUNTED(BufferA::mainImage));
+#endif
+#ifdef SHADER_MODULE_BUFFER_B
+	SetPass(exports, 1, Scalar::BufferB::mainImage, Packet::BufferB::mainImage, SHADER_MODULE_COUNTED(BufferB::mainImage));
+#endif
+#ifdef SHADER_MODULE_BUFFER_C
+	SetPass(exports, 2, Scalar::BufferC::mainImage, Packet::BufferC::mainImage, SHADER_MODULE_COUNTED(BufferC::mainImage));
+#endif
+#ifdef SHADER_MODULE_BUFFER_D
+	SetPass(exports, 3, Scalar::BufferD::mainImage, Packet::BufferD::mainImage, SHADER_MODULE_COUNTED(BufferD::mainImage));
+#endif
+	SetPass(exports, 4, Scalar::mainImage, Packet::mainImage, SHADER_MODULE_COUNTED(mainImage));
+
+#ifdef SHADER_MODULE_DESCRIBE
+	Scalar::SHADER_MODULE_DESCRIBE(exports);
+#endif
+	return exports;
+}
+
+//-------------------------------------------------------------------------------------
+SHADER_MODULE_EXPORT const SShaderModuleExports* GetShaderModule ()
+{
+	static const SShaderModuleExports s_exports = DescribeModule();
+	return &s_exports;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// The interface between the harness and a shader compiled on its own as a shared library
+// (.dll or .so), so shaders can be rebuilt and reloaded without restarting the harness.
+// ShaderModule.cpp is the module side; ShaderModuleLoader.h is the harness side. Both
+// have to be built from the same headers and with the same compiler, since vectors and
+// the render context are passed as they are.
+
+#include "glslAdapters.h"
+#include "glslPacket.h"
+#include "glslCounted.h"
+
+// Bump when anything below, SRenderContext or the vector types change layout
+static const uint32_t c_shaderModuleVersion = 4;
+
+// Buffer A-D then Image, in the order of EPass
+static const size_t c_shaderModulePasses = 5;
+
+#ifdef _WIN32
+	#define SHADER_MODULE_EXPORT extern "C" __declspec(dllexport)
+#else
+	#define SHADER_MODULE_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+//-------------------------------------------------------------------------------------
+// What the harness lends a module: the texture lookups of Texture.cpp, so textures and
+// buffers loaded by the harness can be sampled without the module linking them in
+struct SShaderModuleImports
+{
+	vec4 (*m_texture)(const SSampler2D& sampler, const vec2& uv);
+	vec4 (*m_textureBias)(const SSampler2D& sampler, const vec2& uv, float bias);
+	vec4 (*m_textureLod)(const SSampler2D& sampler, const vec2& uv, float lod);
+	vec4 (*m_texelFetch)(const SSampler2D& sampler, const ivec2& texel, int lod);
+	ivec2 (*m_textureSize)(const SSampler2D& sampler, int lod);
+};
+
+//-------------------------------------------------------------------------------------
+// What one iChannel of a module's pass reads: a buffer pass, or a BMP texture file the
+// harness loads and keeps between reloads
+struct SShaderModuleChannel
+{
+	int m_buffer;                   // EPass of a Buffer A-D pass, or -1
+	const char* m_textureFileName;  // or null
+	ETextureFilter m_filter;
+	ETextureWrap m_wrap;
+};
+
+//-------------------------------------------------------------------------------------
+struct SShaderModulePass
+{
+	// null for passes the module doesn't have. The op counting build is only there when
+	// the module was built with SHADER_MODULE_OP_COUNTS.
+	void (*m_mainImage)(vec4& fragColor, vec2 fragCoord);
+	void (*m_packetMainImage)(Packet::vec4& fragColor, Packet::vec2 fragCoord);
+	void (*m_countedMainImage)(Counted::vec4& fragColor, Counted::vec2 fragCoord);
+	SShaderModuleChannel m_channels[4];
+};
+
+//-------------------------------------------------------------------------------------
+struct SShaderModuleExports
+{
+	uint32_t m_version;             // c_shaderModuleVersion
+	uint32_t m_renderContextSize;   // sizeof(SRenderContext), as a cheap layout check
+	SShaderModulePass m_passes[c_shaderModulePasses];
+
+	// the module's own copies of the thread locals in glslAdapters.h and glslPacket.h
+	const SRenderContext*& (*m_renderContext)();
+	bool& (*m_packetDiverged)();
+	SShaderQuadSlot& (*m_shaderQuad)();
+
+	// called once by the harness before any pass runs
+	void (*m_connect)(const SShaderModuleImports& imports);
+};
+
+//-------------------------------------------------------------------------------------
+// The one function a module exports
+typedef const SShaderModuleExports* (*TGetShaderModule)();
+#define SHADER_MODULE_ENTRY_POINT "GetShaderModule"
@@ -0,0 +1,182 @@
+#include "ShaderModuleLoader.h"
+#include "Deflate.h"
+#include <stdio.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------------------
+SShaderModuleLoader::SShaderModuleLoader()
+	: m_exports(nullptr)
+	, m_loadedTime(0)
+	, m_seenTime(0)
+	, m_numLoads(0)
+	, m_identity(0)
+{ }
+
+//-------------------------------------------------------------------------------------
+SShaderModuleLoader::~SShaderModuleLoader()
+{
+	m_library.reset();
+	if (!m_libraryCopy.empty())
+		remove(m_libraryCopy.c_str());
+}
+
+//-------------------------------------------------------------------------------------
+bool SShaderModuleLoader::Load (const char* fileName, SPassGraph& graph)
+{
+	return LoadFile(fileName, &graph);
+}
+
+//-------------------------------------------------------------------------------------
+bool SShaderModuleLoader::Load (const char* fileName)
+{
+	return LoadFile(fileName, nullptr);
+}
+
+//-------------------------------------------------------------------------------------
+bool SShaderModuleLoader::LoadFile (const char* fileName, SPassGraph* graph)
+{
+	m_fileName = fileName;
+	if (!GetFileModifiedTime(fileName, m_loadedTime))
+	{
+		fprintf(stderr, "Could not find shader module %s\n", fileName);
+		return false;
+	}
+	m_seenTime = m_loadedTime;
+	return LoadCurrentFile(graph);
+}
+
+//-------------------------------------------------------------------------------------
+bool SShaderModuleLoader::ReloadIfChanged (SPassGraph& graph)
+{
+	uint64_t modifiedTime;
+	if (m_fileName.empty() || !GetFileModifiedTime(m_fileName.c_str(), modifiedTime) || modifiedTime == m_loadedTime)
+		return false;
+
+	// still being written?
+	if (modifiedTime != m_seenTime)
+	{
+		m_seenTime = modifiedTime;
+		return false;
+	}
+
+	m_loadedTime = modifiedTime;
+	if (!LoadCurrentFile(&graph))
+		return false;
+	fprintf(stderr, "Reloaded %s\n", m_fileName.c_str());
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+// Also returns the identity of what was copied, which is what gets loaded however the
+// original changes afterwards
+static bool CopyWholeFile (const char* fromFileName, const char* toFileName, uint64_t& identity)
+{
+	SMappedFile from;
+	SMappedFile to;
+	if (!from.OpenRead(fromFileName) || !to.Create(toFileName, from.m_size))
+		return false;
+	memcpy(to.m_data, from.m_data, from.m_size);
+	identity = (uint64_t(from.m_size) << 32) | Crc32(0, from.m_data, from.m_size);
+	return to.Close();
+}
+
+//-------------------------------------------------------------------------------------
+// The scalar texture lookups are overloaded, so each needs picking out by its type
+static SShaderModuleImports MakeImports ()
+{
+	SShaderModuleImports imports;
+	imports.m_texture = static_cast<vec4 (*)(const SSampler2D&, const vec2&)>(texture);
+	imports.m_textureBias = static_cast<vec4 (*)(const SSampler2D&, const vec2&, float)>(texture);
+	imports.m_textureLod = static_cast<vec4 (*)(const SSampler2D&, const vec2&, float)>(textureLod);
+	imports.m_texelFetch = static_cast<vec4 (*)(const SSampler2D&, const ivec2&, int)>(texelFetch);
+	imports.m_textureSize = static_cast<ivec2 (*)(const SSampler2D&, int)>(textureSize);
+	return imports;
+}
+
+//-------------------------------------------------------------------------------------
+static SChannelInput MakeChannelInput (const SShaderModuleChannel& channel, SPassGraph& graph)
+{
+	if (channel.m_buffer >= 0 && channel.m_buffer < (int)c_numBufferPasses)
+		return SChannelInput::Buffer((EPass)channel.m_buffer, channel.m_filter, channel.m_wrap);
+	if (channel.m_textureFileName)
+		return SChannelInput::Texture(graph.LoadTexture(channel.m_textureFileName), channel.m_filter, channel.m_wrap);
+	return SChannelInput();
+}
+
+//-------------------------------------------------------------------------------------
+bool SShaderModuleLoader::LoadCurrentFile (SPassGraph* graph)
+{
+	static_assert(c_shaderModulePasses == (size_t)EPass::Count, "Shader module passes must match EPass");
+
+	// a new name for every load, as the previous copy is still loaded until this one
+	// has replaced it
+	char suffix[32];
+	snprintf(suffix, sizeof(suffix), ".%zu.loaded", m_numLoads++);
+	std::string libraryCopy = m_fileName + suffix;
+	uint64_t identity = 0;
+	if (!CopyWholeFile(m_fileName.c_str(), libraryCopy.c_str(), identity))
+	{
+		fprintf(stderr, "Could not copy shader module %s to %s\n", m_fileName.c_str(), libraryCopy.c_str());
+		return false;
+	}
+
+	std::unique_ptr<SSharedLibrary> library(new SSharedLibrary);
+	const SShaderModuleExports* exports = nullptr;
+	if (library->Open(libraryCopy.c_str()))
+	{
+		TGetShaderModule getShaderModule = (TGetShaderModule)library->FindSymbol(SHADER_MODULE_ENTRY_POINT);
+		exports = getShaderModule ? getShaderModule() : nullptr;
+		if (!exports)
+			fprintf(stderr, "%s doesn't export " SHADER_MODULE_ENTRY_POINT "()\n", m_fileName.c_str());
+		else if (exports->m_version != c_shaderModuleVersion || exports->m_renderContextSize != sizeof(SRenderContext))
+		{
+			fprintf(stderr, "%s was built against different harness headers (version %u, expected %u)\n",
+				m_fileName.c_str(), exports->m_version, c_shaderModuleVersion);
+			exports = nullptr;
+		}
+	}
+
+	if (!exports)
+	{
+		library.reset();
+		remove(libraryCopy.c_str());
+		return false;
+	}
+
+#ifndef _WIN32
+	// a loaded library outlives its file here, so the copy needn't be left lying around
+	remove(libraryCopy.c_str());
+	libraryCopy.clear();
+#endif
+
+	exports->m_connect(MakeImports());
+	m_exports = exports;
+	m_identity = identity;
+	if (graph)
+		BindPasses(*graph);
+
+	// the graph (if there is one) no longer points into the old module
+	m_library = std::move(library);
+	if (!m_libraryCopy.empty())
+		remove(m_libraryCopy.c_str());
+	m_libraryCopy = libraryCopy;
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+void SShaderModuleLoader::BindPasses (SPassGraph& graph) const
+{
+	for (size_t pass = 0; pass < c_shaderModulePasses; ++pass)
+	{
+		const SShaderModulePass& modulePass = m_exports->m_passes[pass];
+		if (!modulePass.m_mainImage || !modulePass.m_packetMainImage)
+		{
+			graph.DisablePass((EPass)pass);
+			continue;
+		}
+
+		SShaderPass& shaderPass = graph.SetPass((EPass)pass, { modulePass.m_mainImage, modulePass.m_packetMainImage, modulePass.m_countedMainImage, m_exports->m_renderContext, m_exports->m_packetDiverged, m_exports->m_shaderQuad, nullptr });
+		for (size_t channel = 0; channel < 4; ++channel)
+			shaderPass.m_channels[channel] = MakeChannelInput(modulePass.m_channels[channel], graph);
+	}
+}
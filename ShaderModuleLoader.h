@@ -0,0 +1,53 @@
+#pragma once
+
+#include "PassGraph.h"
+#include "Platform.h"
+#include "ShaderModule.h"
+#include <memory>
+#include <string>
+
+//-------------------------------------------------------------------------------------
+// A shader module (see ShaderModule.h) plugged into a pass graph, and reloaded when its
+// file changes. The library is loaded from a copy of the file, so the original can be
+// rebuilt while the copy is in use (Windows won't let a loaded DLL be overwritten, and
+// POSIX systems may not notice that a library file with the same name has changed).
+// Reloading only swaps the graph's shaders, so its buffers, textures and the scheduler's
+// threads all carry on as they were.
+struct SShaderModuleLoader
+{
+	SShaderModuleLoader();
+	~SShaderModuleLoader();
+
+	// Load a module and point the graph's passes at it. Returns false (saying why on
+	// stderr) if it couldn't be loaded, leaving the graph as it was.
+	bool Load (const char* fileName, SPassGraph& graph);
+
+	// Or load it without touching any graph, to point graphs at with BindPasses()
+	bool Load (const char* fileName);
+	void BindPasses (SPassGraph& graph) const;
+
+	// Reload the module if its file has changed since it was loaded, and has stopped
+	// changing since the last call, so a half written file isn't picked up. Only call
+	// between frames. If the new version won't load, the old one stays in use until the
+	// file changes again. Returns true if the module was reloaded.
+	bool ReloadIfChanged (SPassGraph& graph);
+
+	bool IsLoaded () const { return m_library != nullptr; }
+
+	// The size and CRC-32 of the loaded module's file, for telling whether another
+	// process has loaded the same one
+	uint64_t GetIdentity () const { return m_identity; }
+
+private:
+	bool LoadFile (const char* fileName, SPassGraph* graph);
+	bool LoadCurrentFile (SPassGraph* graph);
+
+	std::string m_fileName;
+	std::unique_ptr<SSharedLibrary> m_library;
+	const SShaderModuleExports* m_exports;
+	std::string m_libraryCopy;
+	uint64_t m_loadedTime;      // modified time of the file that was last tried
+	uint64_t m_seenTime;        // modified time at the last check
+	size_t m_numLoads;
+	uint64_t m_identity;
+};
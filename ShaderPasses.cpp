@@ -0,0 +1,74 @@
+// The passes of the shader being debugged, like the tabs along the top of a Shadertoy.
+//
+// main.cpp is the Image tab. To add Buffer A, set SHADER_BUFFER_A to 1 in Settings.h and
+// put the Buffer A source in bufferA.cpp, set out like main.cpp but with the code inside
+// namespace BufferA { } so its functions don't clash with the other passes. Like main.cpp
+// it isn't compiled on its own; mainScalar.cpp, mainPacket.cpp and mainCounted.cpp pick
+// it up. Then bind the iChannels of each pass below, the way the channel slots under each
+// tab are set up on Shadertoy.
+// Channels can also read 24 bit BMP textures, for example:
+//
+//     image.m_channels[1] = SChannelInput::Texture(graph.LoadTexture("noise.bmp"));
+
+#include "PassGraph.h"
+#include "Settings.h"
+
+#if SHADER_OP_COUNTS
+#define COUNTED_MAIN_IMAGE(PASS) Counted::PASS::mainImage
+#else
+#define COUNTED_MAIN_IMAGE(PASS) nullptr
+#endif
+
+#if SHADER_BUFFER_A
+namespace Scalar { namespace BufferA { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+namespace Packet { namespace BufferA { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#if SHADER_OP_COUNTS
+namespace Counted { namespace BufferA { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#endif
+#endif
+#if SHADER_BUFFER_B
+namespace Scalar { namespace BufferB { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+namespace Packet { namespace BufferB { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#if SHADER_OP_COUNTS
+namespace Counted { namespace BufferB { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#endif
+#endif
+#if SHADER_BUFFER_C
+namespace Scalar { namespace BufferC { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+namespace Packet { namespace BufferC { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#if SHADER_OP_COUNTS
+namespace Counted { namespace BufferC { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#endif
+#endif
+#if SHADER_BUFFER_D
+namespace Scalar { namespace BufferD { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+namespace Packet { namespace BufferD { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#if SHADER_OP_COUNTS
+namespace Counted { namespace BufferD { void mainImage(vec4& fragColor, vec2 fragCoord); } }
+#endif
+#endif
+
+//-------------------------------------------------------------------------------------
+void DescribeShaderPasses (SPassGraph& graph)
+{
+#if SHADER_BUFFER_A
+	SShaderPass& bufferA = graph.SetPass(EPass::BufferA, { Scalar::BufferA::mainImage, Packet::BufferA::mainImage, COUNTED_MAIN_IMAGE(BufferA), nullptr, nullptr, nullptr, nullptr });
+	bufferA.m_channels[0] = SChannelInput::Buffer(EPass::BufferA);   // for example, its own previous frame
+#endif
+#if SHADER_BUFFER_B
+	SShaderPass& bufferB = graph.SetPass(EPass::BufferB, { Scalar::BufferB::mainImage, Packet::BufferB::mainImage, COUNTED_MAIN_IMAGE(BufferB), nullptr, nullptr, nullptr, nullptr });
+#endif
+#if SHADER_BUFFER_C
+	SShaderPass& bufferC = graph.SetPass(EPass::BufferC, { Scalar::BufferC::mainImage, Packet::BufferC::mainImage, COUNTED_MAIN_IMAGE(BufferC), nullptr, nullptr, nullptr, nullptr });
+#endif
+#if SHADER_BUFFER_D
+	SShaderPass& bufferD = graph.SetPass(EPass::BufferD, { Scalar::BufferD::mainImage, Packet::BufferD::mainImage, COUNTED_MAIN_IMAGE(BufferD), nullptr, nullptr, nullptr, nullptr });
+#endif
+
+#if SHADER_BUFFER_A
+	SShaderPass& image = graph.SetPass(EPass::Image, c_mainShader);
+	image.m_channels[0] = SChannelInput::Buffer(EPass::BufferA);
+#else
+	graph.SetPass(EPass::Image, c_mainShader);
+#endif
+}
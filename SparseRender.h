@@ -0,0 +1,228 @@
+#pragma once
+
+// Sparse rendering, for cheap drafts of shaders with large smooth areas. The image pass
+// goes over its tiles twice. The coarse pass shades the pixels on a grid every m_step
+// pixels (plus the region's last row and column) and keeps their colours in an
+// SSparseGrid. Once every tile's grid pixels are in, the refine pass looks at each
+// m_step x m_step block between grid lines, and the grid pixels around it and its eight
+// neighbours. Where those change linearly along the grid lines (to within m_threshold
+// in r, g or b) the block's pixels are interpolated from its corners, and otherwise
+// they are all shaded. So smooth gradients are interpolated too, while edges and
+// silhouettes that cross the grid come out exactly as in a full render. Detail small
+// enough to fall between grid pixels can be missed altogether.
+
+#include "glslAdapters.h"
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+struct SSparseSettings
+{
+	SSparseSettings()
+		: m_step(1)
+		, m_threshold(0.0f)
+	{ }
+
+	bool IsEnabled () const { return m_step > 1; }
+
+	size_t m_step;
+	float m_threshold;
+};
+
+//-------------------------------------------------------------------------------------
+// Which tile pass of a sparse render a tile job is
+enum class ESparsePass
+{
+	None,
+	Coarse,
+	Refine,
+};
+
+//-------------------------------------------------------------------------------------
+// The grid lines along one axis of a region: every step pixels from its start, and its
+// last pixel
+struct SSparseAxis
+{
+	void Init (size_t origin, size_t max, size_t step)
+	{
+		m_origin = origin;
+		m_max = max;
+		m_step = step;
+		m_lines = max > origin + 1 ? (max - origin - 2) / step + 2 : 1;
+	}
+
+	size_t Line (size_t index) const { return std::min(m_origin + index * m_step, m_max - 1); }
+	bool IsLine (size_t pixel) const { return (pixel - m_origin) % m_step == 0 || pixel == m_max - 1; }
+	size_t LineIndex (size_t pixel) const { return pixel == m_max - 1 ? m_lines - 1 : (pixel - m_origin) / m_step; }
+
+	// the block a pixel is in, which lies between lines block and block + 1. The last
+	// block also has the pixels of its end line.
+	size_t Block (size_t pixel) const { return m_lines > 1 ? std::min((pixel - m_origin) / m_step, m_lines - 2) : 0; }
+	size_t BlockEnd (size_t block) const { return block + 2 >= m_lines ? m_max : Line(block + 1); }
+
+	size_t m_origin;
+	size_t m_max;
+	size_t m_step;
+	size_t m_lines;
+};
+
+//-------------------------------------------------------------------------------------
+// The colours of the grid pixels of a region, written by the coarse pass and read by
+// the refine pass
+struct SSparseGrid
+{
+	SSparseGrid (size_t originX, size_t originY, size_t maxX, size_t maxY, const SSparseSettings& settings)
+		: m_threshold(settings.m_threshold)
+	{
+		m_x.Init(originX, maxX, settings.m_step);
+		m_y.Init(originY, maxY, settings.m_step);
+		m_colors.resize(m_x.m_lines * m_y.m_lines);
+	}
+
+	bool IsGridPixel (size_t x, size_t y) const { return m_x.IsLine(x) && m_y.IsLine(y); }
+	vec4& At (size_t x, size_t y) { return m_colors[m_y.LineIndex(y) * m_x.m_lines + m_x.LineIndex(x)]; }
+	const vec4& Line (size_t lineX, size_t lineY) const { return m_colors[lineY * m_x.m_lines + lineX]; }
+
+	// Which of blocksX x blocksY blocks from firstBlockX, firstBlockY need their pixels
+	// shaded, into refine (row by row): along the grid lines from one line before the
+	// block to one line after it, some grid pixel is further than the threshold from
+	// halfway between its neighbours. With fewer than three lines along an axis, any
+	// difference along it counts.
+	void FindRefinedBlocks (size_t firstBlockX, size_t firstBlockY, size_t blocksX, size_t blocksY, std::vector<uint8_t>& refine) const
+	{
+		// test each grid pixel around the blocks once: bit 0 for along x, bit 1 for along y
+		const size_t minX = firstBlockX > 0 ? firstBlockX - 1 : 0;
+		const size_t minY = firstBlockY > 0 ? firstBlockY - 1 : 0;
+		const size_t maxX = std::min(firstBlockX + blocksX + 2, m_x.m_lines);
+		const size_t maxY = std::min(firstBlockY + blocksY + 2, m_y.m_lines);
+		const size_t width = maxX - minX;
+		const bool bendsX = m_x.m_lines >= 3;
+		const bool bendsY = m_y.m_lines >= 3;
+		std::vector<uint8_t> tests(width * (maxY - minY), 0);
+		for (size_t lineY = minY; lineY < maxY; ++lineY)
+		{
+			for (size_t lineX = minX; lineX < maxX; ++lineX)
+			{
+				const vec4& color = Line(lineX, lineY);
+				uint8_t& test = tests[(lineY - minY) * width + lineX - minX];
+				if (bendsX ? lineX > 0 && lineX + 1 < m_x.m_lines && IsBent(Line(lineX - 1, lineY), color, Line(lineX + 1, lineY))
+					: lineX + 1 < m_x.m_lines && Differs(color, Line(lineX + 1, lineY)))
+					test |= 1;
+				if (bendsY ? lineY > 0 && lineY + 1 < m_y.m_lines && IsBent(Line(lineX, lineY - 1), color, Line(lineX, lineY + 1))
+					: lineY + 1 < m_y.m_lines && Differs(color, Line(lineX, lineY + 1)))
+					test |= 2;
+			}
+		}
+
+		// a bend counts for a block if it is in the middle of three lines around it, a
+		// difference if it is between two of them
+		refine.assign(blocksX * blocksY, 0);
+		for (size_t block = 0; block < blocksX * blocksY; ++block)
+		{
+			const size_t blockX = firstBlockX + block % blocksX;
+			const size_t blockY = firstBlockY + block / blocksX;
+			const size_t aroundMinX = blockX > 0 ? blockX - 1 : 0;
+			const size_t aroundMinY = blockY > 0 ? blockY - 1 : 0;
+			const size_t aroundMaxX = std::min(blockX + 3, m_x.m_lines);
+			const size_t aroundMaxY = std::min(blockY + 3, m_y.m_lines);
+			for (size_t lineY = aroundMinY; lineY < aroundMaxY && !refine[block]; ++lineY)
+			{
+				for (size_t lineX = aroundMinX; lineX < aroundMaxX; ++lineX)
+				{
+					const uint8_t test = tests[(lineY - minY) * width + lineX - minX];
+					if (((test & 1) && (bendsX ? lineX > aroundMinX && lineX + 1 < aroundMaxX : lineX + 1 < aroundMaxX))
+						|| ((test & 2) && (bendsY ? lineY > aroundMinY && lineY + 1 < aroundMaxY : lineY + 1 < aroundMaxY)))
+					{
+						refine[block] = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// Whether the middle of three grid pixels is further than the threshold from halfway
+	// between the other two, in r, g or b clamped as they are displayed. The last line
+	// may be closer than the others, so near the end of the region this is an estimate.
+	// A channel that is NaN in all three is flat, as interpolating it gives NaN too, and
+	// one that is NaN in only some of them is bent.
+	bool IsBent (const vec4& first, const vec4& middle, const vec4& last) const
+	{
+		for (size_t channel = 0; channel < 3; ++channel)
+		{
+			if (isnan(first[channel]) && isnan(middle[channel]) && isnan(last[channel]))
+				continue;
+			float bend = clamp(first[channel], 0.0f, 1.0f) + clamp(last[channel], 0.0f, 1.0f) - 2.0f * clamp(middle[channel], 0.0f, 1.0f);
+			if (!(fabsf(bend) <= 2.0f * m_threshold))
+				return true;
+		}
+		return false;
+	}
+
+	bool Differs (const vec4& a, const vec4& b) const
+	{
+		for (size_t channel = 0; channel < 3; ++channel)
+		{
+			if (isnan(a[channel]) && isnan(b[channel]))
+				continue;
+			if (!(fabsf(clamp(a[channel], 0.0f, 1.0f) - clamp(b[channel], 0.0f, 1.0f)) <= m_threshold))
+				return true;
+		}
+		return false;
+	}
+
+	// Interpolate the pixels from minX, minY up to maxX, maxY of a block from its corners,
+	// handing each one's colour to write(x, y, color). Grid pixels get their own colour.
+	template <typename TWrite>
+	void InterpolateBlock (size_t blockX, size_t blockY, size_t minX, size_t minY, size_t maxX, size_t maxY, const TWrite& write) const
+	{
+		const size_t nextX = std::min(blockX + 1, m_x.m_lines - 1);
+		const size_t nextY = std::min(blockY + 1, m_y.m_lines - 1);
+		const vec4& bottomLeft = Line(blockX, blockY);
+		const vec4& bottomRight = Line(nextX, blockY);
+		const vec4& topLeft = Line(blockX, nextY);
+		const vec4& topRight = Line(nextX, nextY);
+
+		const size_t startX = m_x.Line(blockX);
+		const size_t startY = m_y.Line(blockY);
+		const size_t endX = m_x.Line(nextX);
+		const size_t endY = m_y.Line(nextY);
+		const float scaleX = endX > startX ? 1.0f / float(endX - startX) : 0.0f;
+		const float scaleY = endY > startY ? 1.0f / float(endY - startY) : 0.0f;
+
+		for (size_t y = minY; y < maxY; ++y)
+		{
+			const float fractionY = float(y - startY) * scaleY;
+			float left[4];
+			float right[4];
+			for (size_t channel = 0; channel < 4; ++channel)
+			{
+				left[channel] = bottomLeft[channel] + (topLeft[channel] - bottomLeft[channel]) * fractionY;
+				right[channel] = bottomRight[channel] + (topRight[channel] - bottomRight[channel]) * fractionY;
+			}
+
+			const bool lineY = y == startY || y == endY;
+			for (size_t x = minX; x < maxX; ++x)
+			{
+				if (lineY && (x == startX || x == endX))
+				{
+					write(x, y, Line(x == startX ? blockX : nextX, y == startY ? blockY : nextY));
+					continue;
+				}
+				const float fractionX = float(x - startX) * scaleX;
+				write(x, y, vec4(
+					left[0] + (right[0] - left[0]) * fractionX,
+					left[1] + (right[1] - left[1]) * fractionX,
+					left[2] + (right[2] - left[2]) * fractionX,
+					left[3] + (right[3] - left[3]) * fractionX));
+			}
+		}
+	}
+
+	SSparseAxis m_x;
+	SSparseAxis m_y;
+	float m_threshold;
+	std::vector<vec4> m_colors;
+};
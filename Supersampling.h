@@ -0,0 +1,129 @@
+#pragma once
+
+// Adaptive supersampling. Each pixel is first shaded at m_baseSamples points spread over
+// it, then at twice as many, and so on up to m_maxSamples, for as long as the standard
+// error of its mean colour is above m_threshold. Flat areas stop at the base samples,
+// while edges and fine detail get the most.
+//
+// The points are a (0,2) sequence (van der Corput and the second Sobol dimension), so
+// the first 4 fall one in each quarter of the pixel, the first 16 one in each cell of a
+// 4x4 grid, and so on. The sequence is XOR scrambled by a hash of the pixel's 2x2 quad,
+// which keeps that stratification but decorrelates neighbouring quads. All four pixels
+// of a quad use the same point for a sample, so dFdx() etc still see neighbours exactly
+// one pixel apart. A pixel's points depend on nothing but its position, so renders are
+// the same whatever the thread count, tile size or render mode.
+
+#include "glslAdapters.h"
+#include <algorithm>
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------
+struct SSupersampleSettings
+{
+	SSupersampleSettings()
+		: m_baseSamples(1)
+		, m_maxSamples(1)
+		, m_threshold(0.0f)
+	{ }
+
+	bool IsEnabled () const { return m_maxSamples > 1; }
+
+	// samples a pixel has after the round of samples that follows count of them
+	size_t NextSampleCount (size_t count) const { return count == 0 ? std::min(m_baseSamples, m_maxSamples) : std::min(count * 2, m_maxSamples); }
+
+	size_t m_baseSamples;
+	size_t m_maxSamples;
+
+	// standard error of the mean of each of a pixel's r, g and b (clamped to 0..1, as they
+	// are displayed) below which it takes no more samples
+	float m_threshold;
+};
+
+//-------------------------------------------------------------------------------------
+inline uint32_t SupersampleHash (uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352du;
+	value ^= value >> 15;
+	value *= 0x846ca68bu;
+	value ^= value >> 16;
+	return value;
+}
+
+//-------------------------------------------------------------------------------------
+// Where sample number sample of the pixels of the quad at quadX, quadY (even coordinates)
+// is, as an offset from the pixel's bottom left corner. The offsets are on a 1/256 grid,
+// so adding them to a pixel coordinate is exact.
+inline vec2 SupersampleOffset (size_t quadX, size_t quadY, size_t sample)
+{
+	uint32_t scramble = SupersampleHash(uint32_t(quadX >> 1) ^ SupersampleHash(uint32_t(quadY >> 1)));
+
+	// van der Corput: the bits of the sample number reversed
+	uint32_t x = uint32_t(sample);
+	x = (x << 16) | (x >> 16);
+	x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+	x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+	x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+	x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+	x ^= scramble;
+
+	// Sobol's second dimension
+	uint32_t y = SupersampleHash(scramble);
+	for (uint32_t bits = uint32_t(sample), direction = 1u << 31; bits; bits >>= 1, direction ^= direction >> 1)
+	{
+		if (bits & 1)
+			y ^= direction;
+	}
+
+	return vec2((float(x >> 24) + 0.5f) * (1.0f / 256.0f), (float(y >> 24) + 0.5f) * (1.0f / 256.0f));
+}
+
+//-------------------------------------------------------------------------------------
+// The running sums of one pixel's samples
+struct SPixelSamples
+{
+	SPixelSamples()
+		: m_count(0)
+		, m_sum(0.0f)
+		, m_sumSquares(0.0f)
+		, m_clampedSum(0.0f)
+	{ }
+
+	void Add (const vec4& color)
+	{
+		++m_count;
+		m_sum += color;
+		for (size_t channel = 0; channel < 3; ++channel)
+		{
+			float value = clamp(color[channel], 0.0f, 1.0f);
+			m_sumSquares[channel] += value * value;
+			m_clampedSum[channel] += value;
+		}
+	}
+
+	bool NeedsMore (const SSupersampleSettings& settings) const
+	{
+		if (m_count >= settings.m_maxSamples)
+			return false;
+		if (m_count < 2)
+			return true;
+
+		// the variance of the mean is the samples' variance over their count
+		const float count = float(m_count);
+		const float limit = settings.m_threshold * settings.m_threshold * count * (count - 1.0f);
+		for (size_t channel = 0; channel < 3; ++channel)
+		{
+			float sumOfSquaredDeviations = m_sumSquares[channel] - m_clampedSum[channel] * m_clampedSum[channel] / count;
+			if (sumOfSquaredDeviations > limit)
+				return true;
+		}
+		return false;
+	}
+
+	vec4 Mean () const { return m_sum / float(m_count); }
+
+	size_t m_count;
+	vec4 m_sum;
+	vec3 m_sumSquares;
+	vec3 m_clampedSum;
+};
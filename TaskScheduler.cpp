@@ -0,0 +1,161 @@
+#include "TaskScheduler.h"
+#include "Platform.h"
+#include <chrono>
+
+// which scheduler (if any) the current thread is a worker of, and its index in it
+static thread_local STaskScheduler* s_currentScheduler = nullptr;
+static thread_local size_t s_currentThreadIndex = 0;
+
+//-------------------------------------------------------------------------------------
+STaskScheduler::STaskScheduler(size_t numThreads, bool pinThreads)
+	: m_queuedTasks(0)
+	, m_nextQueue(0)
+	, m_shutdown(false)
+{
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	for (size_t i = 0; i < numThreads; ++i)
+		m_queues.emplace_back(new SWorkerQueue);
+
+	for (size_t i = 0; i < numThreads; ++i)
+		m_threads.emplace_back(&STaskScheduler::WorkerThread, this, i, pinThreads);
+}
+
+//-------------------------------------------------------------------------------------
+STaskScheduler::~STaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_shutdown = true;
+	}
+	m_wake.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+//-------------------------------------------------------------------------------------
+void STaskScheduler::Submit(STaskGroup& group, TTask task)
+{
+	group.m_pending.fetch_add(1);
+
+	size_t queueIndex = (s_currentScheduler == this)
+		? s_currentThreadIndex
+		: m_nextQueue.fetch_add(1) % m_queues.size();
+
+	// bump the count under the sleep lock so a worker about to sleep can't miss it
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queuedTasks.fetch_add(1);
+	}
+
+	{
+		SWorkerQueue& queue = *m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		queue.m_tasks.push_back({ std::move(task), &group });
+	}
+	m_wake.notify_one();
+}
+
+//-------------------------------------------------------------------------------------
+void STaskScheduler::Wait(STaskGroup& group)
+{
+	std::unique_lock<std::mutex> lock(group.m_mutex);
+	group.m_done.wait(lock, [&group]() { return group.m_pending.load() == 0; });
+}
+
+//-------------------------------------------------------------------------------------
+std::vector<SThreadStats> STaskScheduler::GetThreadStats() const
+{
+	std::vector<SThreadStats> stats(m_queues.size());
+	for (size_t i = 0; i < m_queues.size(); ++i)
+	{
+		stats[i].m_busySeconds = double(m_queues[i]->m_busyNanoseconds.load()) / 1e9;
+		stats[i].m_tasksRun = (size_t)m_queues[i]->m_tasksRun.load();
+	}
+	return stats;
+}
+
+//-------------------------------------------------------------------------------------
+void STaskScheduler::ResetThreadStats()
+{
+	for (const std::unique_ptr<SWorkerQueue>& queue : m_queues)
+	{
+		queue->m_busyNanoseconds = 0;
+		queue->m_tasksRun = 0;
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool STaskScheduler::PopOrSteal(size_t threadIndex, STask& task)
+{
+	// our own work first, oldest first, so tiles come out roughly in submission order
+	{
+		SWorkerQueue& queue = *m_queues[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (!queue.m_tasks.empty())
+		{
+			task = std::move(queue.m_tasks.front());
+			queue.m_tasks.pop_front();
+			m_queuedTasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// then steal the newest task of the next worker that has any
+	for (size_t offset = 1; offset < m_queues.size(); ++offset)
+	{
+		SWorkerQueue& queue = *m_queues[(threadIndex + offset) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		if (!queue.m_tasks.empty())
+		{
+			task = std::move(queue.m_tasks.back());
+			queue.m_tasks.pop_back();
+			m_queuedTasks.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//-------------------------------------------------------------------------------------
+void STaskScheduler::WorkerThread(size_t threadIndex, bool pinThread)
+{
+	s_currentScheduler = this;
+	s_currentThreadIndex = threadIndex;
+
+	if (pinThread)
+		PinCurrentThreadToCore(threadIndex);
+
+	SWorkerQueue& ownQueue = *m_queues[threadIndex];
+
+	while (true)
+	{
+		STask task;
+		if (PopOrSteal(threadIndex, task))
+		{
+			auto start = std::chrono::steady_clock::now();
+			task.m_function(threadIndex);
+			auto busy = std::chrono::steady_clock::now() - start;
+			ownQueue.m_busyNanoseconds += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+			ownQueue.m_tasksRun += 1;
+
+			// decrement under the group lock so the group can't be destroyed by a waiter
+			// between us hitting zero and notifying
+			STaskGroup& group = *task.m_group;
+			std::lock_guard<std::mutex> lock(group.m_mutex);
+			if (group.m_pending.fetch_sub(1) == 1)
+				group.m_done.notify_all();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_shutdown || m_queuedTasks.load() > 0; });
+		if (m_shutdown && m_queuedTasks.load() == 0)
+			return;
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+// A task receives the index of the worker thread running it, in [0, GetNumThreads())
+typedef std::function<void(size_t threadIndex)> TTask;
+
+//-------------------------------------------------------------------------------------
+// Tracks a batch of submitted tasks so the submitter can wait for all of them to finish
+struct STaskGroup
+{
+	STaskGroup()
+		: m_pending(0)
+	{ }
+
+	std::atomic<size_t> m_pending;
+	std::mutex m_mutex;
+	std::condition_variable m_done;
+};
+
+//-------------------------------------------------------------------------------------
+// How much work one worker thread did since the scheduler started or the stats were reset
+struct SThreadStats
+{
+	double m_busySeconds;
+	size_t m_tasksRun;
+};
+
+//-------------------------------------------------------------------------------------
+// A fixed pool of worker threads, each owning a deque of tasks. Workers run their own
+// tasks in submission order and steal from the back of other workers' deques when they
+// run dry, so expensive tasks near the end of a batch don't leave threads idle.
+struct STaskScheduler
+{
+	// numThreads of 0 means one worker per hardware thread. pinThreads puts worker i on
+	// core i, so timings are stable on busy machines.
+	explicit STaskScheduler(size_t numThreads = 0, bool pinThreads = false);
+	~STaskScheduler();
+
+	size_t GetNumThreads() const { return m_threads.size(); }
+
+	// Queue a task as part of a group. Tasks submitted from a worker go to that worker's
+	// deque, tasks submitted from elsewhere are dealt round robin across the workers.
+	void Submit(STaskGroup& group, TTask task);
+
+	// Block until every task submitted to the group has finished running
+	void Wait(STaskGroup& group);
+
+	// Time each worker spent running tasks, and how many it ran
+	std::vector<SThreadStats> GetThreadStats() const;
+	void ResetThreadStats();
+
+private:
+	struct STask
+	{
+		TTask m_function;
+		STaskGroup* m_group;
+	};
+
+	static const size_t c_cacheLineSize = 64;
+
+	// a worker's tasks and stats. Each is allocated separately, and padded by a cache line
+	// at either end so no other worker's queue (or anything else on the heap) can share a
+	// cache line with it, wherever the allocator puts it. alignas(64) wouldn't do, as new
+	// only honours it from C++17.
+	struct SWorkerQueue
+	{
+		SWorkerQueue()
+			: m_busyNanoseconds(0)
+			, m_tasksRun(0)
+		{ }
+
+		char m_paddingBefore[c_cacheLineSize];
+		std::mutex m_mutex;
+		std::deque<STask> m_tasks;
+		std::atomic<uint64_t> m_busyNanoseconds;
+		std::atomic<uint64_t> m_tasksRun;
+		char m_paddingAfter[c_cacheLineSize];
+	};
+
+	void WorkerThread(size_t threadIndex, bool pinThread);
+	bool PopOrSteal(size_t threadIndex, STask& task);
+
+	std::vector<std::unique_ptr<SWorkerQueue>> m_queues;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<size_t> m_queuedTasks;
+	std::atomic<size_t> m_nextQueue;
+	bool m_shutdown;
+};
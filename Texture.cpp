@@ -0,0 +1,179 @@
+#include "Texture.h"
+#include "SImageData.h"
+#include <algorithm>
+
+//-------------------------------------------------------------------------------------
+void STexture::Clear ()
+{
+	for (STextureLevel& level : m_levels)
+		std::fill(level.m_texels.begin(), level.m_texels.end(), vec4(0.0f));
+}
+
+//-------------------------------------------------------------------------------------
+void STexture::GenerateMips ()
+{
+	if (m_levels.empty())
+		return;
+	m_levels.resize(1);
+
+	while (m_levels.back().m_width > 1 || m_levels.back().m_height > 1)
+	{
+		m_levels.emplace_back();
+		const STextureLevel& source = m_levels[m_levels.size() - 2];
+		STextureLevel& level = m_levels.back();
+		level.Resize(std::max(source.m_width / 2, 1L), std::max(source.m_height / 2, 1L));
+
+		// odd sizes lose their last row or column, like most GPU drivers
+		size_t maxX = (size_t)source.m_width - 1;
+		size_t maxY = (size_t)source.m_height - 1;
+		for (size_t y = 0; y < (size_t)level.m_height; ++y)
+		{
+			for (size_t x = 0; x < (size_t)level.m_width; ++x)
+			{
+				size_t x0 = std::min(x * 2, maxX);
+				size_t x1 = std::min(x * 2 + 1, maxX);
+				size_t y0 = std::min(y * 2, maxY);
+				size_t y1 = std::min(y * 2 + 1, maxY);
+				level.At(x, y) = (source.At(x0, y0) + source.At(x1, y0) + source.At(x0, y1) + source.At(x1, y1)) * 0.25f;
+			}
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+bool LoadTexture (const char* fileName, STexture& texture)
+{
+	// the pixels are read straight out of the mapped file, falling back to a copy for
+	// BMPs that can't be used in place (top down ones)
+	SMappedImage mappedImage;
+	SImageData loadedImage;
+	SImageView image;
+	if (MapImage(fileName, mappedImage))
+		image = mappedImage.m_view;
+	else if (LoadImage(fileName, loadedImage))
+		image = loadedImage;
+	else
+		return false;
+
+	texture.Resize(image.m_width, image.m_height);
+	texture.Clear();
+	for (size_t y = 0; y < (size_t)image.m_height; ++y)
+	{
+		const uint8* pixel = &image.m_pixels[y * image.m_pitch];
+		for (size_t x = 0; x < (size_t)image.m_width; ++x, pixel += 3)
+			texture.At(x, y) = vec4(float(pixel[2]) / 255.0f, float(pixel[1]) / 255.0f, float(pixel[0]) / 255.0f, 1.0f);
+	}
+	texture.GenerateMips();
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+static long WrapTexel (long coord, long size, ETextureWrap wrap)
+{
+	if (wrap == ETextureWrap::Repeat)
+	{
+		coord %= size;
+		return coord < 0 ? coord + size : coord;
+	}
+	return coord < 0 ? 0 : (coord >= size ? size - 1 : coord);
+}
+
+//-------------------------------------------------------------------------------------
+static vec4 SampleNearest (const STextureLevel& level, const vec2& uv, ETextureWrap wrap)
+{
+	long x = WrapTexel((long)std::floor(uv.x * float(level.m_width)), level.m_width, wrap);
+	long y = WrapTexel((long)std::floor(uv.y * float(level.m_height)), level.m_height, wrap);
+	return level.At((size_t)x, (size_t)y);
+}
+
+//-------------------------------------------------------------------------------------
+static vec4 SampleBilinear (const STextureLevel& level, const vec2& uv, ETextureWrap wrap)
+{
+	// texel centres are at half integer coordinates
+	float x = uv.x * float(level.m_width) - 0.5f;
+	float y = uv.y * float(level.m_height) - 0.5f;
+	float x0 = std::floor(x);
+	float y0 = std::floor(y);
+	float fractX = x - x0;
+	float fractY = y - y0;
+
+	size_t left = (size_t)WrapTexel((long)x0, level.m_width, wrap);
+	size_t right = (size_t)WrapTexel((long)x0 + 1, level.m_width, wrap);
+	size_t bottom = (size_t)WrapTexel((long)y0, level.m_height, wrap);
+	size_t top = (size_t)WrapTexel((long)y0 + 1, level.m_height, wrap);
+
+	vec4 bottomColor = mix(level.At(left, bottom), level.At(right, bottom), fractX);
+	vec4 topColor = mix(level.At(left, top), level.At(right, top), fractX);
+	return mix(bottomColor, topColor, fractY);
+}
+
+//-------------------------------------------------------------------------------------
+static vec4 Sample (const SSampler2D& sampler, const vec2& uv, float lod)
+{
+	const STexture* texture = sampler.m_texture;
+	if (!texture || texture->m_levels.empty() || texture->m_width <= 0 || texture->m_height <= 0)
+		return vec4(0.0f);
+
+	switch (sampler.m_filter)
+	{
+		case ETextureFilter::Nearest:
+			return SampleNearest(texture->m_levels[0], uv, sampler.m_wrap);
+		case ETextureFilter::Linear:
+			return SampleBilinear(texture->m_levels[0], uv, sampler.m_wrap);
+		case ETextureFilter::Mipmap:
+		default:
+		{
+			// trilinear: blend the two nearest levels. Textures without mips (buffers) only
+			// have level 0.
+			float maxLod = float(texture->m_levels.size() - 1);
+			lod = lod < 0.0f ? 0.0f : (lod > maxLod ? maxLod : lod);
+			size_t level = (size_t)lod;
+			float blend = lod - float(level);
+			vec4 color = SampleBilinear(texture->m_levels[level], uv, sampler.m_wrap);
+			if (blend > 0.0f && level + 1 < texture->m_levels.size())
+				color = mix(color, SampleBilinear(texture->m_levels[level + 1], uv, sampler.m_wrap), blend);
+			return color;
+		}
+	}
+}
+
+//-------------------------------------------------------------------------------------
+vec4 texture (const SSampler2D& sampler, const vec2& uv)
+{
+	return Sample(sampler, uv, 0.0f);
+}
+
+//-------------------------------------------------------------------------------------
+vec4 texture (const SSampler2D& sampler, const vec2& uv, float bias)
+{
+	return Sample(sampler, uv, bias);
+}
+
+//-------------------------------------------------------------------------------------
+vec4 textureLod (const SSampler2D& sampler, const vec2& uv, float lod)
+{
+	return Sample(sampler, uv, lod);
+}
+
+//-------------------------------------------------------------------------------------
+// Texels outside the texture, or levels it doesn't have, read as black
+vec4 texelFetch (const SSampler2D& sampler, const ivec2& texel, int lod)
+{
+	const STexture* texture = sampler.m_texture;
+	if (!texture || lod < 0 || (size_t)lod >= texture->m_levels.size())
+		return vec4(0.0f);
+
+	const STextureLevel& level = texture->m_levels[(size_t)lod];
+	if (texel.x < 0 || texel.y < 0 || texel.x >= level.m_width || texel.y >= level.m_height)
+		return vec4(0.0f);
+	return level.At((size_t)texel.x, (size_t)texel.y);
+}
+
+//-------------------------------------------------------------------------------------
+ivec2 textureSize (const SSampler2D& sampler, int lod)
+{
+	const STexture* texture = sampler.m_texture;
+	if (!texture || lod < 0 || (size_t)lod >= texture->m_levels.size())
+		return ivec2(0, 0);
+	return ivec2((int)texture->m_levels[(size_t)lod].m_width, (int)texture->m_levels[(size_t)lod].m_height);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "glslAdapters.h"
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+// One mip level of a texture. Texels are stored in 8x8 tiles, row by row, and in Morton
+// (Z) order within a tile, so the 2x2 texels a bilinear lookup reads, and lookups near
+// each other in any direction, are almost always in the same few cache lines. Row-major
+// storage would put vertical neighbours a whole row apart.
+struct STextureLevel
+{
+	static const size_t c_tileShift = 3;
+	static const size_t c_tileSize = size_t(1) << c_tileShift;
+	static const size_t c_tileMask = c_tileSize - 1;
+
+	STextureLevel()
+		: m_width(0)
+		, m_height(0)
+		, m_tilesPerRow(0)
+	{ }
+
+	void Resize (long width, long height)
+	{
+		m_width = width;
+		m_height = height;
+		m_tilesPerRow = ((size_t)width + c_tileMask) >> c_tileShift;
+		size_t tileRows = ((size_t)height + c_tileMask) >> c_tileShift;
+		m_texels.assign(m_tilesPerRow * tileRows << (2 * c_tileShift), vec4(0.0f));
+	}
+
+	// spread the low 3 bits of v out to every other bit
+	static size_t SpreadBits (size_t v)
+	{
+		return (v & 1) | ((v & 2) << 1) | ((v & 4) << 2);
+	}
+
+	size_t Index (size_t x, size_t y) const
+	{
+		size_t tile = (y >> c_tileShift) * m_tilesPerRow + (x >> c_tileShift);
+		return (tile << (2 * c_tileShift)) | SpreadBits(x & c_tileMask) | (SpreadBits(y & c_tileMask) << 1);
+	}
+
+	const vec4& At (size_t x, size_t y) const { return m_texels[Index(x, y)]; }
+	vec4& At (size_t x, size_t y) { return m_texels[Index(x, y)]; }
+
+	long m_width;
+	long m_height;
+	size_t m_tilesPerRow;
+	std::vector<vec4> m_texels;
+};
+
+//-------------------------------------------------------------------------------------
+// A float RGBA image that shaders read through an iChannel, with an optional mip chain.
+// Row 0 is the bottom row, so a buffer pass's output reads back at the fragCoord it was
+// written at, and bottom-up BMP files load the right way up.
+struct STexture
+{
+	STexture()
+		: m_width(0)
+		, m_height(0)
+	{ }
+
+	// Resizing clears to black and drops any mips. Resizing to the current size keeps
+	// the contents.
+	void Resize (long width, long height)
+	{
+		if (width == m_width && height == m_height && !m_levels.empty())
+			return;
+		m_width = width;
+		m_height = height;
+		m_levels.resize(1);
+		m_levels[0].Resize(width, height);
+	}
+
+	void Clear ();
+
+	// Box filter level 0 down to 1x1. Done once after loading, not per frame.
+	void GenerateMips ();
+
+	// write access to the top level, for render passes
+	const vec4& At (size_t x, size_t y) const { return m_levels[0].At(x, y); }
+	vec4& At (size_t x, size_t y) { return m_levels[0].At(x, y); }
+
+	long m_width;
+	long m_height;
+	std::vector<STextureLevel> m_levels;
+};
+
+//-------------------------------------------------------------------------------------
+// Load a 24 bit BMP as a texture, with mips. Colors are 0-1 and alpha is 1.
+bool LoadTexture (const char* fileName, STexture& texture);
@@ -0,0 +1,46 @@
+#include "TileHistory.h"
+
+//-------------------------------------------------------------------------------------
+STileHistory::STileHistory()
+	: m_changingChannels(0)
+	, m_width(0)
+	, m_height(0)
+	, m_pixelBytes(0)
+	, m_changedUniforms(c_uniformAll)
+{ }
+
+//-------------------------------------------------------------------------------------
+void STileHistory::Clear ()
+{
+	m_tiles.clear();
+}
+
+//-------------------------------------------------------------------------------------
+// Whether tiles rendered with a and b hold the same pixels for the same uniforms
+static bool RendersAlike (const SRenderSettings& a, const SRenderSettings& b)
+{
+	const SRenderRegion& regionA = a.m_region;
+	const SRenderRegion& regionB = b.m_region;
+	const SSupersampleSettings& samplesA = a.m_supersampling;
+	const SSupersampleSettings& samplesB = b.m_supersampling;
+	return a.m_tileSize == b.m_tileSize && a.m_mode == b.m_mode && a.m_fixedKernels == b.m_fixedKernels
+		&& regionA.m_x == regionB.m_x && regionA.m_y == regionB.m_y && regionA.m_width == regionB.m_width && regionA.m_height == regionB.m_height
+		&& samplesA.m_baseSamples == samplesB.m_baseSamples && samplesA.m_maxSamples == samplesB.m_maxSamples && samplesA.m_threshold == samplesB.m_threshold;
+}
+
+//-------------------------------------------------------------------------------------
+void STileHistory::BeginFrame (const SRenderContext& context, long width, long height, size_t pixelBytes, const SRenderSettings& settings, size_t numTiles)
+{
+	if ((size_t)width != m_width || (size_t)height != m_height || pixelBytes != m_pixelBytes || numTiles != m_tiles.size() || !RendersAlike(settings, m_settings))
+	{
+		m_width = (size_t)width;
+		m_height = (size_t)height;
+		m_pixelBytes = pixelBytes;
+		m_settings = settings;
+		m_tiles.assign(numTiles, STile());
+		m_pixels.resize(m_width * m_height * m_pixelBytes);
+	}
+
+	m_changedUniforms = ChangedUniforms(context, m_context) | m_changingChannels;
+	m_context = context;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// Temporal tile reuse, for sequences. While a tile of the image pass is shaded, the
+// shader notes each uniform it reads (see ReadUniforms() in glslAdapters.h). The history
+// keeps those along with a copy of the tile's pixels, and when none of them differ in the
+// next frame the tile is copied back rather than shaded again: a tile of sky that only
+// reads iResolution is shaded once for a whole sequence, while one that reads iTime is
+// shaded every frame. A shader's output only depends on fragCoord and its uniforms, so
+// the frame is bit for bit what shading every tile would give.
+//
+// A channel counts as changed when it samples something else, or every frame when its
+// texture is rendered again each frame (a buffer). Anything else that could change the
+// pixels, like the frame size, tile grid, render mode or supersampling, makes the history
+// forget every tile.
+
+#include "Renderer.h"
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------
+inline uint8_t* PixelBytes (const SImageView& image, size_t x, size_t y) { return image.m_pixels + y * image.m_pitch + x * 3; }
+inline uint8_t* PixelBytes (SFloatImage* image, size_t x, size_t y) { return (uint8_t*)(image->Row(y) + x * 4); }
+
+//-------------------------------------------------------------------------------------
+struct STileHistory
+{
+	STileHistory();
+
+	// Forget every tile, for when the passes change
+	void Clear ();
+
+	// Start a frame of numTiles tiles of a width x height image, pixelBytes a pixel. Tiles
+	// are kept from the last frame if it was laid out and rendered the same way.
+	void BeginFrame (const SRenderContext& context, long width, long height, size_t pixelBytes, const SRenderSettings& settings, size_t numTiles);
+
+	bool CanReuse (size_t tile) const { return m_tiles[tile].m_stored && !(m_tiles[tile].m_uniformsRead & m_changedUniforms); }
+
+	// Keep the pixels from minX, minY up to maxX, maxY of a tile just shaded, and the
+	// uniforms that shading it read
+	template <typename TImage>
+	void StoreTile (size_t tile, uint32_t uniformsRead, const TImage& image, size_t minX, size_t minY, size_t maxX, size_t maxY)
+	{
+		for (size_t y = minY; y < maxY; ++y)
+			memcpy(&m_pixels[(y * m_width + minX) * m_pixelBytes], PixelBytes(image, minX, y), (maxX - minX) * m_pixelBytes);
+		m_tiles[tile].m_stored = true;
+		m_tiles[tile].m_uniformsRead = uniformsRead;
+	}
+
+	// Copy the stored pixels of a tile that CanReuse() back into image
+	template <typename TImage>
+	void RestoreTile (const TImage& image, size_t minX, size_t minY, size_t maxX, size_t maxY) const
+	{
+		for (size_t y = minY; y < maxY; ++y)
+			memcpy(PixelBytes(image, minX, y), &m_pixels[(y * m_width + minX) * m_pixelBytes], (maxX - minX) * m_pixelBytes);
+	}
+
+	// channels (c_uniformChannel0 etc) whose textures are rendered again every frame, so
+	// their contents change even when what they sample doesn't. Set by SPassGraph.
+	uint32_t m_changingChannels;
+
+private:
+	struct STile
+	{
+		bool m_stored;
+		uint32_t m_uniformsRead;
+	};
+
+	// what the last frame was rendered with
+	SRenderContext m_context;
+	size_t m_width;
+	size_t m_height;
+	size_t m_pixelBytes;
+	SRenderSettings m_settings;
+
+	uint32_t m_changedUniforms;
+	std::vector<STile> m_tiles;
+	std::vector<uint8_t> m_pixels;
+};
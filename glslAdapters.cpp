@@ -1,41 +1,378 @@
 #include "glslAdapters.h"
-#include "Settings.h"
+#include "Batch.h"
+#include "Benchmark.h"
+#include "CommandLine.h"
+#include "FrameWriter.h"
+#include "ImageCompare.h"
+#include "ImageEncoders.h"
+#include "MathReport.h"
+#include "OpCountReport.h"
+#include "PassGraph.h"
+#include "RenderCluster.h"
 #include "SImageData.h"
+#include "Renderer.h"
+#include "ShaderModuleLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <thread>
 
-float iGlobalTime = c_timeSeconds;
-vec3 iResolution(float(c_imageResolution[0]), float(c_imageResolution[1]), 1.0f);
-vec4 iMouse(0.0f);
+//-------------------------------------------------------------------------------------
+// For -shadedpixels: how many of the pixels the image pass covers in frames frames
+// mainImage() was called for
+static void PrintShadedPixels (FILE* file, uint64_t shadedPixels, const SRenderSettings& settings, long width, long height, size_t frames = 1)
+{
+	const SRenderRegion& region = settings.m_region;
+	uint64_t pixels = uint64_t(frames) * (region.IsWholeImage()
+		? uint64_t(width) * uint64_t(height)
+		: uint64_t(std::min(region.m_x + region.m_width, (size_t)width) - region.m_x) * uint64_t(std::min(region.m_y + region.m_height, (size_t)height) - region.m_y));
+	fprintf(file, "shaded %llu of %llu pixels (%.1f%%)\n", (unsigned long long)shadedPixels, (unsigned long long)pixels,
+		pixels > 0 ? 100.0 * double(shadedPixels) / double(pixels) : 0.0);
+}
+
+//-------------------------------------------------------------------------------------
+// Frames render here, or on the cluster's workers when it is given
+static int RenderSequence (STaskScheduler& scheduler, SPassGraph& passes, SShaderModuleLoader& shaderModule, const SCommandLine& commandLine, SRenderCluster* cluster)
+{
+	// at least one frame, and few enough to fit a size_t whatever the times
+	double frames = ceil((double(commandLine.m_endSeconds) - double(commandLine.m_startSeconds)) * double(commandLine.m_fps));
+	size_t frameCount = frames >= 1.0 ? (size_t)std::min(frames, 1e9) : 1;
+
+	// frame N is encoded and written on the writer's thread while frame N+1 renders here.
+	// Workers have a few frames at once, which the writer needs buffers for too.
+	size_t framesInFlight = cluster ? c_remoteFramesInFlight : 1;
+	SFrameWriter writer(commandLine.m_outFileName, commandLine.m_frameOutput, commandLine.m_fps, commandLine.m_writeQueueDepth + framesInFlight - 1, &scheduler);
+	std::deque<SFloatImage*> renderingFrames;
+	bool rendered = true;
+
+	// tiles that only read uniforms that stay the same are shaded once for the sequence
+	SRenderSettings renderSettings = commandLine.m_renderSettings;
+	renderSettings.m_reuseTiles = commandLine.m_reuseTiles;
+	std::atomic<uint64_t> shadedPixels(0);
+	if (commandLine.m_reportShadedPixels)
+		renderSettings.m_shadedPixels = &shadedPixels;
+
+	for (size_t frameIndex = 0; frameIndex < frameCount && rendered; ++frameIndex)
+	{
+		// a rebuilt shader module takes over from the next frame, buffers and all. Workers
+		// only pick one up for their next coordinator.
+		if (!cluster)
+			shaderModule.ReloadIfChanged(passes);
+
+		SFloatImage* frame = writer.AcquireFrame();
+		frame->Resize(commandLine.m_width, commandLine.m_height);
+
+		float timeSeconds = commandLine.m_startSeconds + float(frameIndex) / commandLine.m_fps;
+		SRenderContext context = MakeRenderContext(commandLine.m_width, commandLine.m_height, timeSeconds);
+		context.m_iFrame = (int)frameIndex;
+		context.m_iTimeDelta = 1.0f / commandLine.m_fps;
+
+		if (!cluster)
+		{
+			passes.Render(scheduler, *frame, renderSettings, context);
+			writer.SubmitFrame(frame);
+			fprintf(stderr, "\rframe %zu / %zu", frameIndex + 1, frameCount);
+			continue;
+		}
+
+		cluster->SubmitFrame(*frame, context);
+		renderingFrames.push_back(frame);
+		while (renderingFrames.size() >= framesInFlight || (frameIndex + 1 == frameCount && !renderingFrames.empty()))
+		{
+			rendered = cluster->WaitForFrame();
+			if (!rendered)
+				break;
+			writer.SubmitFrame(renderingFrames.front());
+			renderingFrames.pop_front();
+			fprintf(stderr, "\rframe %zu / %zu", frameIndex + 1 - renderingFrames.size(), frameCount);
+		}
+	}
+	fprintf(stderr, "\n");
+	if (renderSettings.m_shadedPixels)
+		PrintShadedPixels(stdout, shadedPixels, renderSettings, commandLine.m_width, commandLine.m_height, frameCount);
+
+	if (!writer.Finish())
+	{
+		fprintf(stderr, "Could not write frames to %s\n", commandLine.m_outFileName.c_str());
+		return 1;
+	}
+	return rendered ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+static int BenchmarkRenders (STaskScheduler& scheduler, SPassGraph& passes, const SCommandLine& commandLine)
+{
+	SBenchmarkResults results;
+	RunBenchmark(scheduler, passes, commandLine.m_width, commandLine.m_height, commandLine.m_renderSettings,
+		commandLine.m_timeSeconds, commandLine.m_benchmarkSettings, results);
+	PrintBenchmarkResults(stdout, results);
+
+	const std::string& reportFileName = commandLine.m_benchmarkSettings.m_reportFileName;
+	if (!reportFileName.empty() && !WriteBenchmarkReport(reportFileName.c_str(), results))
+	{
+		fprintf(stderr, "Could not write %s\n", reportFileName.c_str());
+		return 1;
+	}
+	return 0;
+}
+
+//-------------------------------------------------------------------------------------
+// Returns 0 if the render matched the reference, 1 if not or it couldn't be checked
+static int CompareWithReference (STaskScheduler& scheduler, SPassGraph& passes, const SCommandLine& commandLine)
+{
+	SImageComparison comparison;
+	if (!comparison.LoadReference(commandLine.m_referenceFileName.c_str()))
+	{
+		fprintf(stderr, "Could not load reference image %s (a 24 bit BMP)\n", commandLine.m_referenceFileName.c_str());
+		return 1;
+	}
+	comparison.m_threshold = commandLine.m_compareThreshold;
+	comparison.m_stopAtFirstFailure = commandLine.m_failFast;
+	comparison.m_makeDiffImage = !commandLine.m_diffFileName.empty();
+	comparison.Reset();
+
+	// the render is only checked, never saved, so it can live in memory
+	SImageData image;
+	AllocateImage(image, comparison.GetWidth(), comparison.GetHeight());
+
+	SRenderSettings renderSettings = commandLine.m_renderSettings;
+	renderSettings.m_comparison = &comparison;
+	std::atomic<uint64_t> shadedPixels(0);
+	if (commandLine.m_reportShadedPixels)
+		renderSettings.m_shadedPixels = &shadedPixels;
+	SRenderContext context = MakeRenderContext(comparison.GetWidth(), comparison.GetHeight(), commandLine.m_timeSeconds);
+	passes.Render(scheduler, image, renderSettings, context);
+
+	const SComparisonResults& results = comparison.GetResults();
+	PrintComparisonResults(stdout, results, comparison.m_threshold);
+	if (renderSettings.m_shadedPixels)
+		PrintShadedPixels(stdout, shadedPixels, renderSettings, comparison.GetWidth(), comparison.GetHeight());
+
+	if (comparison.m_makeDiffImage && !SaveImage(commandLine.m_diffFileName.c_str(), comparison.GetDiffImage()))
+	{
+		fprintf(stderr, "Could not write %s\n", commandLine.m_diffFileName.c_str());
+		return 1;
+	}
+	return results.Passed() ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+static int RenderBatch (STaskScheduler& scheduler, const SCommandLine& commandLine)
+{
+	SBatchJob defaults;
+	defaults.m_shaderModuleFileName = commandLine.m_shaderModuleFileName;
+	defaults.m_width = commandLine.m_width;
+	defaults.m_height = commandLine.m_height;
+	defaults.m_timeSeconds = commandLine.m_timeSeconds;
+	defaults.m_compareThreshold = commandLine.m_compareThreshold;
+	defaults.m_stopAtFirstFailure = commandLine.m_failFast;
+
+	std::vector<SBatchJob> jobs;
+	if (!LoadBatchManifest(commandLine.m_batchFileName.c_str(), defaults, jobs))
+		return 1;
+
+	SBatchResults results;
+	bool succeeded = RunBatch(scheduler, jobs, commandLine.m_renderSettings, commandLine.m_batchJobsInFlight, results);
+	PrintBatchResults(stdout, jobs, results);
+
+	const std::string& reportFileName = commandLine.m_benchmarkSettings.m_reportFileName;
+	if (!reportFileName.empty() && !WriteBatchReport(reportFileName.c_str(), jobs, results))
+	{
+		fprintf(stderr, "Could not write %s\n", reportFileName.c_str());
+		return 1;
+	}
+	return succeeded ? 0 : 1;
+}
+
+//-------------------------------------------------------------------------------------
+// For progressive renders: say when each level is done and write the image so far with
+// save after every level but the last, which is saved as usual. A mapped output file
+// needs no save, since the levels land in it as they render.
+static TProgressCallback ReportProgressLevels (const SRenderSettings& settings, const char* fileName, const std::function<bool()>& save)
+{
+	if (settings.m_progressiveLevels <= 1)
+		return TProgressCallback();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return [start, fileName, save](size_t level, size_t numLevels)
+	{
+		if (save && level + 1 < numLevels && !save())
+			fprintf(stderr, "Could not write %s\n", fileName);
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		fprintf(stderr, "level %zu / %zu done after %.1f ms\n", level + 1, numLevels, milliseconds);
+	};
+}
 
-int main(int agrc, char** argv)
+//-------------------------------------------------------------------------------------
+// The frame renders here, or on the cluster's workers when it is given
+static int RenderSingleFrame (STaskScheduler& scheduler, SPassGraph& passes, const SCommandLine& commandLine, SRenderCluster* cluster = nullptr)
 {
-	SImageData outImage;
-	outImage.m_width = (long)c_imageResolution[0];
-	outImage.m_height = (long)c_imageResolution[1];
-	outImage.m_pitch = outImage.m_width * 3;
-	if (outImage.m_pitch & 3)
+	SRenderSettings renderSettings = commandLine.m_renderSettings;
+	SCostMap costMap;
+	if (!commandLine.m_heatmapFileName.empty())
 	{
-		outImage.m_pitch &= ~3;
-		outImage.m_pitch += 4;
+		costMap.Resize(commandLine.m_width, commandLine.m_height);
+		renderSettings.m_costMap = &costMap;
 	}
-	outImage.m_pixels.resize(outImage.m_pitch*outImage.m_height);
+	std::atomic<uint64_t> shadedPixels(0);
+	if (commandLine.m_reportShadedPixels)
+		renderSettings.m_shadedPixels = &shadedPixels;
+	SOpCountReport opCounts;
+	if (commandLine.m_reportOpCounts)
+	{
+		renderSettings.m_opCounts = &opCounts;
+		costMap.m_unit = "ops";
+	}
+
+	SRenderContext context = MakeRenderContext(commandLine.m_width, commandLine.m_height, commandLine.m_timeSeconds);
+	const char* outFileName = commandLine.m_outFileName.c_str();
 
-	vec4 fragColor(0.0f, 0.0f, 0.0f, 0.0f);
-	
-	for (size_t y = 0; y < c_imageResolution[1]; ++y)
+	bool rendered = true;
+	bool saved;
+	if (IsBMPFileName(outFileName))
 	{
-		uint8* pixelRow = &outImage.m_pixels[y * outImage.m_pitch];
-		for (size_t x = 0; x < c_imageResolution[0]; ++x)
+		// render straight into the mapped output file if we can, so the frame is never held
+		// in memory twice, and otherwise into a buffer that gets saved afterwards
+		SMappedImage mappedImage;
+		SImageData outImage;
+		SImageView target;
+		if (commandLine.m_mapOutput && CreateMappedImage(outFileName, commandLine.m_width, commandLine.m_height, mappedImage))
+			target = mappedImage.m_view;
+		else
 		{
-			mainImage(fragColor, vec2(x,y));
+			AllocateImage(outImage, commandLine.m_width, commandLine.m_height);
+			target = outImage;
+		}
 
-			// write the output color.  Note that the color channels are reversed!
-			pixelRow[0] = uint8(clamp(fragColor[2], 0.0f, 1.0f) * 255.0f);
-			pixelRow[1] = uint8(clamp(fragColor[1], 0.0f, 1.0f) * 255.0f);
-			pixelRow[2] = uint8(clamp(fragColor[0], 0.0f, 1.0f) * 255.0f);
-			pixelRow += 3;
+		std::function<bool()> save;
+		if (!mappedImage.m_view.m_pixels)
+			save = [&]() { return SaveImage(outFileName, outImage); };
+		if (cluster)
+		{
+			cluster->SubmitFrame(target, context);
+			rendered = cluster->WaitForFrame();
 		}
+		else
+			passes.Render(scheduler, target, renderSettings, context, ReportProgressLevels(renderSettings, outFileName, save));
+		saved = mappedImage.m_view.m_pixels
+			? mappedImage.m_file.Close()
+			: SaveImage(outFileName, outImage);
 	}
+	else
+	{
+		// other formats keep the shader's unclamped float output until they encode it
+		SFloatImage outImage;
+		outImage.Resize(commandLine.m_width, commandLine.m_height);
+		std::function<bool()> save = [&]() { return SaveFloatImage(outFileName, outImage, &scheduler); };
+		if (cluster)
+		{
+			cluster->SubmitFrame(outImage, context);
+			rendered = cluster->WaitForFrame();
+		}
+		else
+			passes.Render(scheduler, outImage, renderSettings, context, ReportProgressLevels(renderSettings, outFileName, save));
+		saved = SaveFloatImage(outFileName, outImage, &scheduler);
+	}
+	if (!saved)
+	{
+		fprintf(stderr, "Could not write %s\n", commandLine.m_outFileName.c_str());
+		return 1;
+	}
+	if (!rendered)
+	{
+		fprintf(stderr, "%s is incomplete, as no workers were left to render it\n", outFileName);
+		return 1;
+	}
+
+	if (renderSettings.m_shadedPixels)
+		PrintShadedPixels(stdout, shadedPixels, renderSettings, commandLine.m_width, commandLine.m_height);
+
+	if (renderSettings.m_opCounts)
+		PrintOpCountReport(stdout, opCounts);
 
-	SaveImage(s_outImageFileName, outImage);
+	if (renderSettings.m_costMap)
+	{
+		PrintMostExpensivePixels(stdout, costMap, commandLine.m_heatmapTopPixels);
+		if (!SaveCostHeatmap(commandLine.m_heatmapFileName.c_str(), costMap))
+		{
+			fprintf(stderr, "Could not write %s\n", commandLine.m_heatmapFileName.c_str());
+			return 1;
+		}
+	}
 	return 0;
 }
+
+//-------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+	SCommandLine commandLine;
+	int exitCode;
+	if (!ParseCommandLine(argc, argv, commandLine, exitCode))
+		return exitCode;
+
+	if (commandLine.m_mathReport)
+	{
+		std::vector<SMathReportRow> rows;
+		RunMathReport(rows);
+		PrintMathReport(stdout, rows);
+		return MathReportPassed(rows) ? 0 : 1;
+	}
+
+	STaskScheduler scheduler(commandLine.m_numThreads, commandLine.m_pinThreads);
+
+	// jobs bring their own passes
+	if (!commandLine.m_batchFileName.empty())
+		return RenderBatch(scheduler, commandLine);
+
+	SPassGraph passes;
+	DescribeShaderPasses(passes);
+
+	SShaderModuleLoader shaderModule;
+	if (!commandLine.m_shaderModuleFileName.empty() && !shaderModule.Load(commandLine.m_shaderModuleFileName.c_str(), passes))
+		return 1;
+
+	// the workers have the shader, so all this end does is hand out tiles and write frames.
+	// Its own copy is only to check theirs against.
+	if (!commandLine.m_workerAddresses.empty())
+	{
+		SRenderCluster cluster;
+		if (!cluster.Connect(commandLine.m_workerAddresses, commandLine.m_renderSettings, passes, shaderModule))
+			return 1;
+		int result = commandLine.m_sequence
+			? RenderSequence(scheduler, passes, shaderModule, commandLine, &cluster)
+			: RenderSingleFrame(scheduler, passes, commandLine, &cluster);
+		cluster.PrintWorkers(stdout);
+		return result;
+	}
+
+	if (commandLine.m_workerPort != 0)
+		return RunRenderWorker(scheduler, passes, shaderModule, commandLine.m_workerPort,
+			commandLine.m_workerInterface.empty() ? nullptr : commandLine.m_workerInterface.c_str());
+
+	if (commandLine.m_benchmark)
+		return BenchmarkRenders(scheduler, passes, commandLine);
+
+	if (!commandLine.m_referenceFileName.empty())
+		return CompareWithReference(scheduler, passes, commandLine);
+
+	if (commandLine.m_sequence)
+		return RenderSequence(scheduler, passes, shaderModule, commandLine, nullptr);
+
+	int result = RenderSingleFrame(scheduler, passes, commandLine);
+	if (!commandLine.m_watch)
+		return result;
+
+	// the scheduler, textures and buffer allocations stay warm from one render to the next,
+	// while the buffers' contents start over as each render is frame 0 again
+	fprintf(stderr, "Watching %s for changes, Ctrl+C to stop\n", commandLine.m_shaderModuleFileName.c_str());
+	while (true)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		if (!shaderModule.ReloadIfChanged(passes))
+			continue;
+		passes.Reset();
+		RenderSingleFrame(scheduler, passes, commandLine);
+	}
+}
@@ -1,398 +1,2109 @@
 #pragma once
 
+#include "glslMath.h"
 #include <assert.h>
 #include <cmath>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include <utility>
 
-struct vec2
+// GLSL overloads every math function for float. Make sure unqualified calls pick the float
+// versions (and abs doesn't pick the C int one) on every compiler, not just MSVC. Shader
+// code is compiled inside namespace Scalar, whose versions of the transcendentals (at the
+// end of this file) hide these so they follow the precision tier of glslMath.h.
+using std::abs;
+using std::acos;
+using std::asin;
+using std::atan;
+using std::ceil;
+using std::cos;
+using std::exp;
+using std::floor;
+using std::isinf;
+using std::isnan;
+using std::log;
+using std::pow;
+using std::round;
+using std::sin;
+using std::sqrt;
+using std::tan;
+using std::trunc;
+
+// Vector + - * / work out a whole vector per operation, unless GLSL_EXPRESSION_TEMPLATES is
+// set to 1 (for every file, on the compiler command line) to make them lazy. See "Vector
+// arithmetic" below.
+#ifndef GLSL_EXPRESSION_TEMPLATES
+	#define GLSL_EXPRESSION_TEMPLATES 0
+#endif
+
+// Inlined even in unoptimized builds where the compiler allows it (not MSVC's /Od)
+#ifdef _MSC_VER
+	#define GLSL_FORCEINLINE __forceinline
+#else
+	#define GLSL_FORCEINLINE inline __attribute__((always_inline))
+#endif
+
+template <typename T> struct tvec2;
+template <typename T> struct tvec3;
+template <typename T> struct tvec4;
+
+//-------------------------------------------------------------------------------------
+// Swizzles
+//-------------------------------------------------------------------------------------
+
+// The vector type with a given number of components
+template <typename T, size_t N> struct SVecOfSize;
+template <typename T> struct SVecOfSize<T, 2> { typedef tvec2<T> type; };
+template <typename T> struct SVecOfSize<T, 3> { typedef tvec3<T> type; };
+template <typename T> struct SVecOfSize<T, 4> { typedef tvec4<T> type; };
+
+// Whether a list of component indices names each component at most once
+template <size_t INDEX, size_t... OTHERS> struct SIndexNotIn { static const bool value = true; };
+template <size_t INDEX, size_t FIRST, size_t... REST>
+struct SIndexNotIn<INDEX, FIRST, REST...>
+{
+	static const bool value = INDEX != FIRST && SIndexNotIn<INDEX, REST...>::value;
+};
+
+template <size_t... I> struct SUniqueIndices { static const bool value = true; };
+template <size_t FIRST, size_t... REST>
+struct SUniqueIndices<FIRST, REST...>
+{
+	static const bool value = SIndexNotIn<FIRST, REST...>::value && SUniqueIndices<REST...>::value;
+};
+
+// A swizzle such as v.zyx. Every swizzle of a vector is a member of a union with the
+// vector's components. Each member of the union, the x, y, z, w struct, the r, g, b, a
+// and s, t, p, q ones and every swizzle, is a struct of just the vector's N components as
+// T, so they all share that common initial sequence and any of them may read components
+// written through another. A swizzle reads and writes them in place, with no copy per
+// access and no type punning. Reading gives a vector, writing is only allowed when no
+// component is repeated (v.xy = ... but not v.xx = ...).
+//
+// SSwizzleAccess has the reads and writes, and SSwizzle below adds the components, one
+// specialization per vector size, as a struct's data members have to be declared in one
+// class for it to share an initial sequence with the others.
+template <typename TSWIZZLE, typename T, size_t... I>
+struct SSwizzleAccess
+{
+	typedef typename SVecOfSize<T, sizeof...(I)>::type TVec;
+
+	operator TVec () const { return TVec(Self().Component(I)...); }
+
+	TSWIZZLE& operator = (const TVec& v)
+	{
+		static_assert(SUniqueIndices<I...>::value, "Can't write to a swizzle that repeats a component");
+		const size_t indices[] = { I... };
+		const TVec source = v; // v may be this vector, so read it all before writing
+		for (size_t i = 0; i < sizeof...(I); ++i)
+			Self().Component(indices[i]) = source[i];
+		return Self();
+	}
+
+	TSWIZZLE& operator += (const TVec& v) { return *this = TVec(*this) + v; }
+	TSWIZZLE& operator -= (const TVec& v) { return *this = TVec(*this) - v; }
+	TSWIZZLE& operator *= (const TVec& v) { return *this = TVec(*this) * v; }
+	TSWIZZLE& operator /= (const TVec& v) { return *this = TVec(*this) / v; }
+	TSWIZZLE& operator += (T v) { return *this = TVec(*this) + v; }
+	TSWIZZLE& operator -= (T v) { return *this = TVec(*this) - v; }
+	TSWIZZLE& operator *= (T v) { return *this = TVec(*this) * v; }
+	TSWIZZLE& operator /= (T v) { return *this = TVec(*this) / v; }
+
+private:
+	TSWIZZLE& Self () { return static_cast<TSWIZZLE&>(*this); }
+	const TSWIZZLE& Self () const { return static_cast<const TSWIZZLE&>(*this); }
+};
+
+template <typename T, size_t N, size_t... I> struct SSwizzle;
+
+template <typename T, size_t... I>
+struct SSwizzle<T, 2, I...> : SSwizzleAccess<SSwizzle<T, 2, I...>, T, I...>
+{
+	using SSwizzleAccess<SSwizzle, T, I...>::operator =;
+	SSwizzle& operator = (const SSwizzle& v) { return *this = typename SSwizzle::TVec(v); }
+
+	T& Component (size_t i) { return i == 0 ? m_0 : m_1; }
+	const T& Component (size_t i) const { return i == 0 ? m_0 : m_1; }
+
+	T m_0, m_1;
+};
+
+template <typename T, size_t... I>
+struct SSwizzle<T, 3, I...> : SSwizzleAccess<SSwizzle<T, 3, I...>, T, I...>
+{
+	using SSwizzleAccess<SSwizzle, T, I...>::operator =;
+	SSwizzle& operator = (const SSwizzle& v) { return *this = typename SSwizzle::TVec(v); }
+
+	T& Component (size_t i) { return i == 0 ? m_0 : (i == 1 ? m_1 : m_2); }
+	const T& Component (size_t i) const { return i == 0 ? m_0 : (i == 1 ? m_1 : m_2); }
+
+	T m_0, m_1, m_2;
+};
+
+template <typename T, size_t... I>
+struct SSwizzle<T, 4, I...> : SSwizzleAccess<SSwizzle<T, 4, I...>, T, I...>
+{
+	using SSwizzleAccess<SSwizzle, T, I...>::operator =;
+	SSwizzle& operator = (const SSwizzle& v) { return *this = typename SSwizzle::TVec(v); }
+
+	T& Component (size_t i) { return i == 0 ? m_0 : (i == 1 ? m_1 : (i == 2 ? m_2 : m_3)); }
+	const T& Component (size_t i) const { return i == 0 ? m_0 : (i == 1 ? m_1 : (i == 2 ? m_2 : m_3)); }
+
+	T m_0, m_1, m_2, m_3;
+};
+
+template <typename T> struct SIsSwizzle { static const bool value = false; };
+template <typename T, size_t N, size_t... I> struct SIsSwizzle<SSwizzle<T, N, I...>> { static const bool value = true; };
+
+// Swizzle members for every combination of 2 to 4 of a vector's components, for one set
+// of component names. GLSL_SWIZZLES_VEC4(x, y, z, w) declares xy, yx, ..., wwww.
+#define GLSL_SWIZZLE2(A,IA, B,IB)                  SSwizzle<T, c_numElements, IA, IB> A##B;
+#define GLSL_SWIZZLE3(A,IA, B,IB, C,IC)            SSwizzle<T, c_numElements, IA, IB, IC> A##B##C;
+#define GLSL_SWIZZLE4(A,IA, B,IB, C,IC, D,ID)      SSwizzle<T, c_numElements, IA, IB, IC, ID> A##B##C##D;
+
+#define GLSL_SWIZZLES_VEC2_3(N0,N1, A,IA, B,IB, C,IC) \
+	GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N0,0) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N1,1)
+#define GLSL_SWIZZLES_VEC2_2(N0,N1, A,IA, B,IB) \
+	GLSL_SWIZZLE3(A,IA, B,IB, N0,0) GLSL_SWIZZLE3(A,IA, B,IB, N1,1) \
+	GLSL_SWIZZLES_VEC2_3(N0,N1, A,IA, B,IB, N0,0) GLSL_SWIZZLES_VEC2_3(N0,N1, A,IA, B,IB, N1,1)
+#define GLSL_SWIZZLES_VEC2_1(N0,N1, A,IA) \
+	GLSL_SWIZZLE2(A,IA, N0,0) GLSL_SWIZZLE2(A,IA, N1,1) \
+	GLSL_SWIZZLES_VEC2_2(N0,N1, A,IA, N0,0) GLSL_SWIZZLES_VEC2_2(N0,N1, A,IA, N1,1)
+#define GLSL_SWIZZLES_VEC2(N0,N1) \
+	GLSL_SWIZZLES_VEC2_1(N0,N1, N0,0) GLSL_SWIZZLES_VEC2_1(N0,N1, N1,1)
+
+#define GLSL_SWIZZLES_VEC3_3(N0,N1,N2, A,IA, B,IB, C,IC) \
+	GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N0,0) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N1,1) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N2,2)
+#define GLSL_SWIZZLES_VEC3_2(N0,N1,N2, A,IA, B,IB) \
+	GLSL_SWIZZLE3(A,IA, B,IB, N0,0) GLSL_SWIZZLE3(A,IA, B,IB, N1,1) GLSL_SWIZZLE3(A,IA, B,IB, N2,2) \
+	GLSL_SWIZZLES_VEC3_3(N0,N1,N2, A,IA, B,IB, N0,0) GLSL_SWIZZLES_VEC3_3(N0,N1,N2, A,IA, B,IB, N1,1) GLSL_SWIZZLES_VEC3_3(N0,N1,N2, A,IA, B,IB, N2,2)
+#define GLSL_SWIZZLES_VEC3_1(N0,N1,N2, A,IA) \
+	GLSL_SWIZZLE2(A,IA, N0,0) GLSL_SWIZZLE2(A,IA, N1,1) GLSL_SWIZZLE2(A,IA, N2,2) \
+	GLSL_SWIZZLES_VEC3_2(N0,N1,N2, A,IA, N0,0) GLSL_SWIZZLES_VEC3_2(N0,N1,N2, A,IA, N1,1) GLSL_SWIZZLES_VEC3_2(N0,N1,N2, A,IA, N2,2)
+#define GLSL_SWIZZLES_VEC3(N0,N1,N2) \
+	GLSL_SWIZZLES_VEC3_1(N0,N1,N2, N0,0) GLSL_SWIZZLES_VEC3_1(N0,N1,N2, N1,1) GLSL_SWIZZLES_VEC3_1(N0,N1,N2, N2,2)
+
+#define GLSL_SWIZZLES_VEC4_3(N0,N1,N2,N3, A,IA, B,IB, C,IC) \
+	GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N0,0) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N1,1) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N2,2) GLSL_SWIZZLE4(A,IA, B,IB, C,IC, N3,3)
+#define GLSL_SWIZZLES_VEC4_2(N0,N1,N2,N3, A,IA, B,IB) \
+	GLSL_SWIZZLE3(A,IA, B,IB, N0,0) GLSL_SWIZZLE3(A,IA, B,IB, N1,1) GLSL_SWIZZLE3(A,IA, B,IB, N2,2) GLSL_SWIZZLE3(A,IA, B,IB, N3,3) \
+	GLSL_SWIZZLES_VEC4_3(N0,N1,N2,N3, A,IA, B,IB, N0,0) GLSL_SWIZZLES_VEC4_3(N0,N1,N2,N3, A,IA, B,IB, N1,1) \
+	GLSL_SWIZZLES_VEC4_3(N0,N1,N2,N3, A,IA, B,IB, N2,2) GLSL_SWIZZLES_VEC4_3(N0,N1,N2,N3, A,IA, B,IB, N3,3)
+#define GLSL_SWIZZLES_VEC4_1(N0,N1,N2,N3, A,IA) \
+	GLSL_SWIZZLE2(A,IA, N0,0) GLSL_SWIZZLE2(A,IA, N1,1) GLSL_SWIZZLE2(A,IA, N2,2) GLSL_SWIZZLE2(A,IA, N3,3) \
+	GLSL_SWIZZLES_VEC4_2(N0,N1,N2,N3, A,IA, N0,0) GLSL_SWIZZLES_VEC4_2(N0,N1,N2,N3, A,IA, N1,1) \
+	GLSL_SWIZZLES_VEC4_2(N0,N1,N2,N3, A,IA, N2,2) GLSL_SWIZZLES_VEC4_2(N0,N1,N2,N3, A,IA, N3,3)
+#define GLSL_SWIZZLES_VEC4(N0,N1,N2,N3) \
+	GLSL_SWIZZLES_VEC4_1(N0,N1,N2,N3, N0,0) GLSL_SWIZZLES_VEC4_1(N0,N1,N2,N3, N1,1) \
+	GLSL_SWIZZLES_VEC4_1(N0,N1,N2,N3, N2,2) GLSL_SWIZZLES_VEC4_1(N0,N1,N2,N3, N3,3)
+
+//-------------------------------------------------------------------------------------
+// Vectors
+//-------------------------------------------------------------------------------------
+
+// The vector types are templated on their element type so the same code works for a
+// single pixel (float) and for a packet of pixels at once (see glslPacket.h). The
+// components can be named xyzw, rgba or stpq, like in GLSL.
+
+template <typename T>
+struct tvec2
+{
+	typedef T element_type;
+	static const size_t c_numElements = 2;
+
+	tvec2(T v = T(0.0f))
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = v;
+	}
+	tvec2(T _x, T _y)
+	{
+		x = _x;
+		y = _y;
+	}
+	template <typename U>
+	explicit tvec2(const tvec2<U>& v)
+	{
+		x = T(v.x);
+		y = T(v.y);
+	}
+	tvec2(const tvec2& v) = default;
+
+	// works out a lazy expression (see GLSL_EXPRESSION_TEMPLATES) one component at a time
+	template <typename E, typename = typename std::enable_if<std::is_same<typename E::TResult, tvec2>::value>::type>
+	GLSL_FORCEINLINE tvec2(const E& e)
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = e[i];
+	}
+
+	tvec2& operator = (const tvec2& v)
+	{
+		x = v.x;
+		y = v.y;
+		return *this;
+	}
+
+	union
+	{
+		struct { T x, y; };
+		struct { T r, g; };
+		struct { T s, t; };
+		GLSL_SWIZZLES_VEC2(x, y)
+		GLSL_SWIZZLES_VEC2(r, g)
+		GLSL_SWIZZLES_VEC2(s, t)
+	};
+
+	T& operator[] (size_t i) { return i == 0 ? x : y; }
+	const T& operator[] (size_t i) const { return i == 0 ? x : y; }
+};
+
+template <typename T>
+struct tvec3
+{
+	typedef T element_type;
+	static const size_t c_numElements = 3;
+
+	tvec3(T v = T(0.0f))
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = v;
+	}
+	tvec3(T _x, T _y, T _z)
+	{
+		x = _x;
+		y = _y;
+		z = _z;
+	}
+	tvec3(const tvec2<T>& v2, T _z)
+	{
+		x = v2.x;
+		y = v2.y;
+		z = _z;
+	}
+	tvec3(T _x, const tvec2<T>& v2)
+	{
+		x = _x;
+		y = v2.x;
+		z = v2.y;
+	}
+	template <typename U>
+	explicit tvec3(const tvec3<U>& v)
+	{
+		x = T(v.x);
+		y = T(v.y);
+		z = T(v.z);
+	}
+	tvec3(const tvec3& v) = default;
+
+	// works out a lazy expression (see GLSL_EXPRESSION_TEMPLATES) one component at a time
+	template <typename E, typename = typename std::enable_if<std::is_same<typename E::TResult, tvec3>::value>::type>
+	GLSL_FORCEINLINE tvec3(const E& e)
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = e[i];
+	}
+
+	tvec3& operator = (const tvec3& v)
+	{
+		x = v.x;
+		y = v.y;
+		z = v.z;
+		return *this;
+	}
+
+	union
+	{
+		struct { T x, y, z; };
+		struct { T r, g, b; };
+		struct { T s, t, p; };
+		GLSL_SWIZZLES_VEC3(x, y, z)
+		GLSL_SWIZZLES_VEC3(r, g, b)
+		GLSL_SWIZZLES_VEC3(s, t, p)
+	};
+
+	T& operator[] (size_t i) { return i == 0 ? x : (i == 1 ? y : z); }
+	const T& operator[] (size_t i) const { return i == 0 ? x : (i == 1 ? y : z); }
+};
+
+template <typename T>
+struct tvec4
+{
+	typedef T element_type;
+	static const size_t c_numElements = 4;
+
+	tvec4(T v = T(0.0f))
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = v;
+	}
+	tvec4(const tvec2<T>& v2, T _z, T _w)
+	{
+		x = v2.x;
+		y = v2.y;
+		z = _z;
+		w = _w;
+	}
+	tvec4(const tvec2<T>& v2a, const tvec2<T>& v2b)
+	{
+		x = v2a.x;
+		y = v2a.y;
+		z = v2b.x;
+		w = v2b.y;
+	}
+	tvec4(const tvec3<T>& v3, T _w)
+	{
+		x = v3.x;
+		y = v3.y;
+		z = v3.z;
+		w = _w;
+	}
+	tvec4(T _x, const tvec3<T>& v3)
+	{
+		x = _x;
+		y = v3.x;
+		z = v3.y;
+		w = v3.z;
+	}
+	tvec4(T _x, T _y, T _z, T _w)
+	{
+		x = _x;
+		y = _y;
+		z = _z;
+		w = _w;
+	}
+	template <typename U>
+	explicit tvec4(const tvec4<U>& v)
+	{
+		x = T(v.x);
+		y = T(v.y);
+		z = T(v.z);
+		w = T(v.w);
+	}
+	tvec4(const tvec4& v) = default;
+
+	// works out a lazy expression (see GLSL_EXPRESSION_TEMPLATES) one component at a time
+	template <typename E, typename = typename std::enable_if<std::is_same<typename E::TResult, tvec4>::value>::type>
+	GLSL_FORCEINLINE tvec4(const E& e)
+	{
+		for (size_t i = 0; i < c_numElements; ++i)
+			(*this)[i] = e[i];
+	}
+
+	tvec4& operator = (const tvec4& v)
+	{
+		x = v.x;
+		y = v.y;
+		z = v.z;
+		w = v.w;
+		return *this;
+	}
+
+	union
+	{
+		struct { T x, y, z, w; };
+		struct { T r, g, b, a; };
+		struct { T s, t, p, q; };
+		GLSL_SWIZZLES_VEC4(x, y, z, w)
+		GLSL_SWIZZLES_VEC4(r, g, b, a)
+		GLSL_SWIZZLES_VEC4(s, t, p, q)
+	};
+
+	T& operator[] (size_t i) { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+	const T& operator[] (size_t i) const { return i == 0 ? x : (i == 1 ? y : (i == 2 ? z : w)); }
+};
+
+typedef tvec2<float> vec2;
+typedef tvec3<float> vec3;
+typedef tvec4<float> vec4;
+
+typedef tvec2<int> ivec2;
+typedef tvec3<int> ivec3;
+typedef tvec4<int> ivec4;
+
+typedef tvec2<unsigned int> uvec2;
+typedef tvec3<unsigned int> uvec3;
+typedef tvec4<unsigned int> uvec4;
+
+typedef tvec2<bool> bvec2;
+typedef tvec3<bool> bvec3;
+typedef tvec4<bool> bvec4;
+
+template <typename T> struct SIsVec { static const bool value = false; };
+template <typename T> struct SIsVec<tvec2<T>> { static const bool value = true; };
+template <typename T> struct SIsVec<tvec3<T>> { static const bool value = true; };
+template <typename T> struct SIsVec<tvec4<T>> { static const bool value = true; };
+
+// Swizzles and lazy expressions (see GLSL_EXPRESSION_TEMPLATES) aren't vectors but read as
+// one, TVecOf<T>
+template <typename T> struct SIsVecExpression { static const bool value = false; };
+template <typename T> struct SIsVecProxy { static const bool value = SIsSwizzle<T>::value || SIsVecExpression<T>::value; };
+template <typename T> struct SIsVecLike { static const bool value = SIsVec<T>::value || SIsVecProxy<T>::value; };
+
+template <typename T, bool VEC = SIsVec<T>::value, bool SWIZZLE = SIsSwizzle<T>::value, bool EXPRESSION = SIsVecExpression<T>::value> struct SVecOf { };
+template <typename T> struct SVecOf<T, true, false, false> { typedef T type; };
+template <typename T> struct SVecOf<T, false, true, false> { typedef typename T::TVec type; };
+template <typename T> struct SVecOf<T, false, false, true> { typedef typename T::TResult type; };
+
+template <typename T>
+using TVecOf = typename SVecOf<T>::type;
+
+// The vector templates below only exist for vector types, and return RET
+template <typename T, typename RET = T>
+using TVecOnly = typename std::enable_if<SIsVec<T>::value, RET>::type;
+
+// GLSL's genType: float or a float vector. glslPacket.h adds SFloatPacket. The geometric
+// functions are written once for all of them, with TElement the type of one component.
+template <typename T> struct SIsGenType { static const bool value = SIsVec<T>::value || std::is_same<T, float>::value; };
+
+template <typename T, typename RET = T>
+using TGenTypeOnly = typename std::enable_if<SIsGenType<T>::value, RET>::type;
+
+template <typename T, bool VEC = SIsVec<T>::value> struct SElementType { typedef T type; };
+template <typename T> struct SElementType<T, true> { typedef typename T::element_type type; };
+
+template <typename T>
+using TElement = typename SElementType<T>::type;
+
+// The bvec a comparison of two vectors of type T gives: bool components for a float
+// vector, SMaskPacket ones for a packet vector
+template <typename T>
+using TElementCompare = decltype(std::declval<typename T::element_type>() < std::declval<typename T::element_type>());
+
+template <typename T>
+using TBoolVec = typename SVecOfSize<TElementCompare<T>, T::c_numElements>::type;
+
+//-------------------------------------------------------------------------------------
+// Scalar functions. glslPacket.h has the same for SFloatPacket, and the vector versions
+// further down apply them to each component.
+//-------------------------------------------------------------------------------------
+inline float radians (float x)
+{
+	return x * 0.0174532925f;
+}
+
+//-------------------------------------------------------------------------------------
+inline float degrees (float x)
+{
+	return x * 57.2957795f;
+}
+
+//-------------------------------------------------------------------------------------
+inline float sign (float x)
+{
+	return x > 0.0f ? 1.0f : (x < 0.0f ? -1.0f : 0.0f);
+}
+
+//-------------------------------------------------------------------------------------
+inline float roundEven (float x)
+{
+	// the default rounding mode rounds halfway cases to the even neighbor
+	return std::nearbyint(x);
+}
+
+//-------------------------------------------------------------------------------------
+inline float mod (float value, float modulus)
+{
+	return MathMod(value, modulus);
+}
+
+//-------------------------------------------------------------------------------------
+inline float fract (float value)
+{
+	return MathFract(value);
+}
+
+//-------------------------------------------------------------------------------------
+inline float modf (float value, float& whole)
+{
+	// the whole part goes to whole, the fraction with the sign of value is returned
+	whole = std::trunc(value);
+	return value - whole;
+}
+
+//-------------------------------------------------------------------------------------
+inline float inversesqrt (float value)
+{
+	return MathInverseSqrt(value);
+}
+
+//-------------------------------------------------------------------------------------
+inline float clamp(float value, float min, float max)
+{
+	if (value < min)
+		return min;
+	else if (value > max)
+		return max;
+	else
+		return value;
+}
+
+//-------------------------------------------------------------------------------------
+inline float min (float a, float b)
+{
+	return a < b ? a : b;
+}
+
+//-------------------------------------------------------------------------------------
+inline float max (float a, float b)
+{
+	return a > b ? a : b;
+}
+
+//-------------------------------------------------------------------------------------
+inline float mix (float a, float b, float blend)
+{
+	return a * (1.0f - blend) + b * blend;
+}
+
+//-------------------------------------------------------------------------------------
+inline float mix (float a, float b, bool selectB)
+{
+	return selectB ? b : a;
+}
+
+//-------------------------------------------------------------------------------------
+inline float step (float threshold, float value)
+{
+	return value >= threshold ? 1.0f : 0.0f;
+}
+
+//-------------------------------------------------------------------------------------
+inline float smoothstep (float min, float max, float value)
+{
+	float t = clamp((value - min) / (max - min), 0.0f, 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+//-------------------------------------------------------------------------------------
+inline float dot (float a, float b)
+{
+	return a * b;
+}
+
+//-------------------------------------------------------------------------------------
+inline float length (float value)
+{
+	return std::fabs(value);
+}
+
+//-------------------------------------------------------------------------------------
+// Vec vs Vec operations
+//-------------------------------------------------------------------------------------
+
+// The compound assignments and comparisons work the same whether vector arithmetic is
+// eager or lazy (see GLSL_EXPRESSION_TEMPLATES below)
+template<typename T>
+TVecOnly<T, T&> operator += (T& A, const T& B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] += B[i];
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator -= (T& A, const T& B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] -= B[i];
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator *= (T& A, const T& B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] *= B[i];
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator /= (T& A, const T& B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] /= B[i];
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+// == and != compare whole vectors, like GLSL. For packets they give a mask of the lanes
+// whose vectors are (not) equal.
+template<typename T>
+TVecOnly<T, TElementCompare<T>> operator == (const T& A, const T& B)
+{
+	TElementCompare<T> ret = A[0] == B[0];
+	for (size_t i = 1; i < T::c_numElements; ++i)
+		ret = ret && A[i] == B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, TElementCompare<T>> operator != (const T& A, const T& B)
+{
+	return !(A == B);
+}
+
+//-------------------------------------------------------------------------------------
+// Vec vs Float operations
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator += (T& A, typename T::element_type B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] += B;
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator -= (T& A, typename T::element_type B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] -= B;
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator *= (T& A, typename T::element_type B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] *= B;
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, T&> operator /= (T& A, typename T::element_type B)
+{
+	// Do the operation
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		A[i] /= B;
+	return A;
+}
+
+//-------------------------------------------------------------------------------------
+// Vector arithmetic
+//-------------------------------------------------------------------------------------
+
+#if !GLSL_EXPRESSION_TEMPLATES
+
+// Each operation works out a whole vector and returns it
+template<typename T>
+TVecOnly<T> operator - (const T& A)
+{
+	// Unary minus
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = -A[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator + (const T& A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] + B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator - (const T& A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] - B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator * (const T& A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] * B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator / (const T& A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] / B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator + (const T& A, typename T::element_type B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] + B;
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator - (const T& A, typename T::element_type B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] - B;
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator * (const T& A, typename T::element_type B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] * B;
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator / (const T& A, typename T::element_type B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A[i] / B;
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator + (typename T::element_type A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A + B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator - (typename T::element_type A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A - B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator * (typename T::element_type A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A * B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator / (typename T::element_type A, const T& B)
+{
+	// Do the operation
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = A / B[i];
+	return ret;
+}
+
+#else
+
+// Lazy vector arithmetic. An operation returns an expression holding its operands
+// rather than a vector, and the vector an expression is assigned or passed to works the
+// whole of it out one component at a time, in one loop, so a + b * c + d makes no
+// temporary vectors. Unoptimized builds keep every temporary the eager operators make,
+// and even optimized ones don't always get rid of them all. Each component still goes
+// through the same operations in the same order, so the results don't change.
+//
+// An expression isn't a vector though, so GLSL that takes a component of one, like
+// (a + b).x, or picks between two with ?:, needs it wrapped in its type first, as in
+// vec3(a + b).x. Builtins take expressions like they take swizzles (see ToVec()).
+//
+// Operands are held by what they are: a vector by reference, as it outlives the
+// expression; a swizzle as the vector it reads as, so v = v.yx + 1.0 doesn't read a
+// component it has already written; a scalar by value, as the same value for every
+// component; and an expression by value, as it is only a few references and scalars.
+template <typename TVEC>
+struct SVecRef
+{
+	typedef TVEC TResult;
+	GLSL_FORCEINLINE explicit SVecRef (const TVEC& v) : m_v(v) { }
+	GLSL_FORCEINLINE const typename TVEC::element_type& operator[] (size_t i) const { return m_v[i]; }
+	const TVEC& m_v;
+};
+
+template <typename TVEC>
+struct SVecCopy
+{
+	typedef TVEC TResult;
+	template <typename TSwizzle>
+	GLSL_FORCEINLINE explicit SVecCopy (const TSwizzle& v) : m_v(v) { }
+	GLSL_FORCEINLINE const typename TVEC::element_type& operator[] (size_t i) const { return m_v[i]; }
+	TVEC m_v;
+};
+
+template <typename TVEC>
+struct SVecScalar
+{
+	typedef TVEC TResult;
+	GLSL_FORCEINLINE explicit SVecScalar (const typename TVEC::element_type& value) : m_value(value) { }
+	GLSL_FORCEINLINE const typename TVEC::element_type& operator[] (size_t) const { return m_value; }
+	typename TVEC::element_type m_value;
+};
+
+template <typename OP, typename A>
+struct SVecUnary
+{
+	typedef typename A::TResult TResult;
+	template <typename X>
+	GLSL_FORCEINLINE explicit SVecUnary (const X& a) : m_a(a) { }
+	GLSL_FORCEINLINE typename TResult::element_type operator[] (size_t i) const { return OP::Apply(m_a[i]); }
+	A m_a;
+};
+
+template <typename OP, typename A, typename B>
+struct SVecBinary
+{
+	typedef typename A::TResult TResult;
+	template <typename X, typename Y>
+	GLSL_FORCEINLINE SVecBinary (const X& a, const Y& b) : m_a(a), m_b(b) { }
+	GLSL_FORCEINLINE typename TResult::element_type operator[] (size_t i) const { return OP::Apply(m_a[i], m_b[i]); }
+	A m_a;
+	B m_b;
+};
+
+template <typename OP, typename A> struct SIsVecExpression<SVecUnary<OP, A>> { static const bool value = true; };
+template <typename OP, typename A, typename B> struct SIsVecExpression<SVecBinary<OP, A, B>> { static const bool value = true; };
+
+// How an expression of vectors TVEC holds an operand of type X
+template <typename TVEC, typename X, bool VEC = SIsVec<X>::value, bool SWIZZLE = SIsSwizzle<X>::value, bool EXPRESSION = SIsVecExpression<X>::value>
+struct SVecOperand { typedef SVecScalar<TVEC> type; };
+template <typename TVEC, typename X> struct SVecOperand<TVEC, X, true, false, false> { typedef SVecRef<TVEC> type; };
+template <typename TVEC, typename X> struct SVecOperand<TVEC, X, false, true, false> { typedef SVecCopy<TVEC> type; };
+template <typename TVEC, typename X> struct SVecOperand<TVEC, X, false, false, true> { typedef X type; };
+
+// The vector type an operation on A and B gives, if they are two vectors of the same
+// type (or swizzles or expressions reading as one), or a vector and a scalar that converts
+// to its components. Otherwise there is no type, and the operator isn't there.
+template <typename A, typename B, bool VEC_A = SIsVecLike<A>::value, bool VEC_B = SIsVecLike<B>::value>
+struct SVecOperands { };
+template <typename A, typename B>
+struct SVecOperands<A, B, true, true> : std::enable_if<std::is_same<TVecOf<A>, TVecOf<B>>::value, TVecOf<A>> { };
+template <typename A, typename B>
+struct SVecOperands<A, B, true, false> : std::enable_if<std::is_convertible<B, typename TVecOf<A>::element_type>::value, TVecOf<A>> { };
+template <typename A, typename B>
+struct SVecOperands<A, B, false, true> : std::enable_if<std::is_convertible<A, typename TVecOf<B>::element_type>::value, TVecOf<B>> { };
+
+template <typename OP, typename TVEC, typename A>
+using TVecUnary = SVecUnary<OP, typename SVecOperand<TVEC, A>::type>;
+
+template <typename OP, typename TVEC, typename A, typename B>
+using TVecBinary = SVecBinary<OP, typename SVecOperand<TVEC, A>::type, typename SVecOperand<TVEC, B>::type>;
+
+struct SVecNegate { template <typename T> static GLSL_FORCEINLINE T Apply (const T& a) { return -a; } };
+struct SVecAdd { template <typename T> static GLSL_FORCEINLINE T Apply (const T& a, const T& b) { return a + b; } };
+struct SVecSubtract { template <typename T> static GLSL_FORCEINLINE T Apply (const T& a, const T& b) { return a - b; } };
+struct SVecMultiply { template <typename T> static GLSL_FORCEINLINE T Apply (const T& a, const T& b) { return a * b; } };
+struct SVecDivide { template <typename T> static GLSL_FORCEINLINE T Apply (const T& a, const T& b) { return a / b; } };
+
+//-------------------------------------------------------------------------------------
+template <typename A, typename TVEC = typename std::enable_if<SIsVecLike<A>::value, TVecOf<A>>::type>
+GLSL_FORCEINLINE TVecUnary<SVecNegate, TVEC, A> operator - (const A& a)
+{
+	return TVecUnary<SVecNegate, TVEC, A>(a);
+}
+
+//-------------------------------------------------------------------------------------
+#define GLSL_LAZY_OPERATOR(OPERATOR, OP) \
+	template <typename A, typename B, typename TVEC = typename SVecOperands<A, B>::type> \
+	GLSL_FORCEINLINE TVecBinary<OP, TVEC, A, B> operator OPERATOR (const A& a, const B& b) \
+	{ \
+		return TVecBinary<OP, TVEC, A, B>(a, b); \
+	}
+
+GLSL_LAZY_OPERATOR(+, SVecAdd)
+GLSL_LAZY_OPERATOR(-, SVecSubtract)
+GLSL_LAZY_OPERATOR(*, SVecMultiply)
+GLSL_LAZY_OPERATOR(/, SVecDivide)
+
+#undef GLSL_LAZY_OPERATOR
+
+//-------------------------------------------------------------------------------------
+// A compound assignment works an expression out straight into the vector. Component i of
+// an expression only reads component i of the vectors in it, so v += v * 2.0 is safe.
+#define GLSL_LAZY_ASSIGN(OPERATOR) \
+	template <typename T, typename E> \
+	GLSL_FORCEINLINE typename std::enable_if<SIsVecExpression<E>::value && std::is_same<T, TVecOf<E>>::value, T&>::type operator OPERATOR (T& A, const E& B) \
+	{ \
+		for (size_t i = 0; i < T::c_numElements; ++i) \
+			A[i] OPERATOR B[i]; \
+		return A; \
+	}
+
+GLSL_LAZY_ASSIGN(+=)
+GLSL_LAZY_ASSIGN(-=)
+GLSL_LAZY_ASSIGN(*=)
+GLSL_LAZY_ASSIGN(/=)
+
+#undef GLSL_LAZY_ASSIGN
+#endif
+
+//-------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, typename T::element_type> dot (const T& A, const T& B)
+{
+	// Do the operation
+	typename T::element_type ret = 0.0f;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret += A[i] * B[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, typename T::element_type> length(const T& V)
+{
+	// Do the operation
+	typename T::element_type length = 0.0f;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		length += V[i] * V[i];
+	length = sqrt(length);
+	return length;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> normalize(const T& V)
+{
+	// Do the operation. The approximate tiers multiply by one reciprocal square root
+	// instead of dividing every component, like a GPU.
+#if GLSL_MATH_PRECISION == GLSL_MATH_EXACT
+	return V / length(V);
+#else
+	return V * MathInverseSqrt(dot(V, V));
+#endif
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+tvec3<T> cross (const tvec3<T>& a, const tvec3<T>& b)
+{
+	return tvec3<T>
+	(
+		a[1] * b[2] - a[2] * b[1],
+		a[2] * b[0] - a[0] * b[2],
+		a[0] * b[1] - a[1] * b[0]
+	);
+}
+
+//-------------------------------------------------------------------------------------
+// The geometric functions below work on any genType. They are written without branches,
+// so a packet of pixels never diverges in them.
+template<typename T>
+TGenTypeOnly<T, TElement<T>> distance (const T& A, const T& B)
+{
+	return length(A - B);
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TGenTypeOnly<T> faceforward (const T& N, const T& I, const T& Nref)
+{
+	// N if dot(Nref, I) < 0, else -N
+	return N * (step(0.0f, dot(Nref, I)) * -2.0f + 1.0f);
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TGenTypeOnly<T> reflect (const T& I, const T& N)
+{
+	return I - N * (dot(N, I) * 2.0f);
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TGenTypeOnly<T> refract (const T& I, const T& N, TElement<T> eta)
+{
+	// zero on total internal reflection, where k < 0
+	TElement<T> d = dot(N, I);
+	TElement<T> k = 1.0f - eta * eta * (1.0f - d * d);
+	T ret = I * eta - N * (eta * d + sqrt(max(k, 0.0f)));
+	return ret * step(0.0f, k);
+}
+
+//-------------------------------------------------------------------------------------
+// Component-wise functions. FUNCTION(vec) applies the scalar function ELEMENT to each
+// component, and the two argument versions take a vector or a float as their second
+// argument. They are plain loops over a fixed number of components, which compilers
+// unroll and vectorize, and ELEMENT resolves to the packet version for packet vectors.
+#define GLSL_COMPONENTWISE_1(FUNCTION, ELEMENT) \
+	template<typename T> \
+	TVecOnly<T> FUNCTION (const T& A) \
+	{ \
+		T ret; \
+		for (size_t i = 0; i < T::c_numElements; ++i) \
+			ret[i] = ELEMENT(A[i]); \
+		return ret; \
+	}
+
+#define GLSL_COMPONENTWISE_2(FUNCTION, ELEMENT) \
+	template<typename T> \
+	TVecOnly<T> FUNCTION (const T& A, const T& B) \
+	{ \
+		T ret; \
+		for (size_t i = 0; i < T::c_numElements; ++i) \
+			ret[i] = ELEMENT(A[i], B[i]); \
+		return ret; \
+	} \
+	template<typename T> \
+	TVecOnly<T> FUNCTION (const T& A, typename T::element_type B) \
+	{ \
+		T ret; \
+		for (size_t i = 0; i < T::c_numElements; ++i) \
+			ret[i] = ELEMENT(A[i], B); \
+		return ret; \
+	}
+
+GLSL_COMPONENTWISE_1(radians, radians)
+GLSL_COMPONENTWISE_1(degrees, degrees)
+GLSL_COMPONENTWISE_1(sin, MathSin)
+GLSL_COMPONENTWISE_1(cos, MathCos)
+GLSL_COMPONENTWISE_1(tan, MathTan)
+GLSL_COMPONENTWISE_1(asin, MathAsin)
+GLSL_COMPONENTWISE_1(acos, MathAcos)
+GLSL_COMPONENTWISE_1(atan, MathAtan)
+GLSL_COMPONENTWISE_1(sinh, MathSinh)
+GLSL_COMPONENTWISE_1(cosh, MathCosh)
+GLSL_COMPONENTWISE_1(tanh, MathTanh)
+GLSL_COMPONENTWISE_1(asinh, MathAsinh)
+GLSL_COMPONENTWISE_1(acosh, MathAcosh)
+GLSL_COMPONENTWISE_1(atanh, MathAtanh)
+GLSL_COMPONENTWISE_1(exp, MathExp)
+GLSL_COMPONENTWISE_1(log, MathLog)
+GLSL_COMPONENTWISE_1(exp2, MathExp2)
+GLSL_COMPONENTWISE_1(log2, MathLog2)
+GLSL_COMPONENTWISE_1(sqrt, sqrt)
+GLSL_COMPONENTWISE_1(inversesqrt, MathInverseSqrt)
+GLSL_COMPONENTWISE_1(abs, abs)
+GLSL_COMPONENTWISE_1(sign, sign)
+GLSL_COMPONENTWISE_1(floor, floor)
+GLSL_COMPONENTWISE_1(ceil, ceil)
+GLSL_COMPONENTWISE_1(trunc, trunc)
+GLSL_COMPONENTWISE_1(round, round)
+GLSL_COMPONENTWISE_1(roundEven, roundEven)
+GLSL_COMPONENTWISE_1(fract, MathFract)
+
+GLSL_COMPONENTWISE_2(atan, MathAtan2)
+GLSL_COMPONENTWISE_2(pow, MathPow)
+GLSL_COMPONENTWISE_2(mod, MathMod)
+GLSL_COMPONENTWISE_2(min, min)
+GLSL_COMPONENTWISE_2(max, max)
+
+#undef GLSL_COMPONENTWISE_1
+#undef GLSL_COMPONENTWISE_2
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> modf (const T& A, T& whole)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = modf(A[i], whole[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> clamp (const T& A, const T& minimum, const T& maximum)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = clamp(A[i], minimum[i], maximum[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> clamp (const T& A, typename T::element_type minimum, typename T::element_type maximum)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = clamp(A[i], minimum, maximum);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> mix (const T& A, const T& B, const T& blend)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = mix(A[i], B[i], blend[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> mix (const T& A, const T& B, typename T::element_type blend)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = mix(A[i], B[i], blend);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+// Picks B's component where the bvec is true, A's where it is false
+template<typename T>
+TVecOnly<T> mix (const T& A, const T& B, const TBoolVec<T>& selectB)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = mix(A[i], B[i], selectB[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> step (const T& threshold, const T& A)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = step(threshold[i], A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> step (typename T::element_type threshold, const T& A)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = step(threshold, A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> smoothstep (const T& minimum, const T& maximum, const T& A)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = smoothstep(minimum[i], maximum[i], A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> smoothstep (typename T::element_type minimum, typename T::element_type maximum, const T& A)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = smoothstep(minimum, maximum, A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, TBoolVec<T>> isnan (const T& A)
+{
+	TBoolVec<T> ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = isnan(A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, TBoolVec<T>> isinf (const T& A)
+{
+	TBoolVec<T> ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = isinf(A[i]);
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+// Vector relational functions. They give a bvec; any() and all() reduce one to a single
+// bool, or for packets to a mask with one bit per lane. GLSL's not() can't be declared
+// because not is a C++ keyword, but ! works on a bvec instead.
+#define GLSL_VECTOR_RELATIONAL(FUNCTION, OPERATOR) \
+	template<typename T> \
+	TVecOnly<T, TBoolVec<T>> FUNCTION (const T& A, const T& B) \
+	{ \
+		TBoolVec<T> ret; \
+		for (size_t i = 0; i < T::c_numElements; ++i) \
+			ret[i] = A[i] OPERATOR B[i]; \
+		return ret; \
+	}
+
+GLSL_VECTOR_RELATIONAL(lessThan, <)
+GLSL_VECTOR_RELATIONAL(lessThanEqual, <=)
+GLSL_VECTOR_RELATIONAL(greaterThan, >)
+GLSL_VECTOR_RELATIONAL(greaterThanEqual, >=)
+GLSL_VECTOR_RELATIONAL(equal, ==)
+GLSL_VECTOR_RELATIONAL(notEqual, !=)
+
+#undef GLSL_VECTOR_RELATIONAL
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, typename T::element_type> any (const T& A)
+{
+	typename T::element_type ret = A[0];
+	for (size_t i = 1; i < T::c_numElements; ++i)
+		ret = ret || A[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T, typename T::element_type> all (const T& A)
+{
+	typename T::element_type ret = A[0];
+	for (size_t i = 1; i < T::c_numElements; ++i)
+		ret = ret && A[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+template<typename T>
+TVecOnly<T> operator ! (const T& A)
+{
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = !A[i];
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+// Swizzle and expression arguments
+//-------------------------------------------------------------------------------------
+
+// A swizzle or lazy expression passed to any of the vector templates above becomes the
+// vector it reads as
+template <typename T>
+typename std::enable_if<!SIsVecProxy<T>::value, const T&>::type ToVec (const T& v) { return v; }
+
+template <typename T>
+typename std::enable_if<SIsVecProxy<T>::value, TVecOf<T>>::type ToVec (const T& v) { return TVecOf<T>(v); }
+
+template <typename... ARGS> struct SAnyVecProxy { static const bool value = false; };
+template <typename FIRST, typename... REST>
+struct SAnyVecProxy<FIRST, REST...>
 {
-	vec2(float v = 0.0f)
-	{
-		for (size_t i = 0; i < c_numElements; ++i)
-			(*this)[i] = v;
-	}
-	vec2(float _x, float _y)
-		: x(_x)
-		, y(_y)
-	{ }
+	static const bool value = SIsVecProxy<FIRST>::value || SAnyVecProxy<REST...>::value;
+};
 
-	float x, y;
+#define GLSL_SWIZZLE_ARGS_1(FUNCTION) \
+	template <typename A, typename = typename std::enable_if<SAnyVecProxy<A>::value>::type> \
+	auto FUNCTION (const A& a) -> decltype(FUNCTION(ToVec(a))) \
+	{ return FUNCTION(ToVec(a)); }
 
-	static const size_t c_numElements = 2;
+#define GLSL_SWIZZLE_ARGS_2(FUNCTION) \
+	template <typename A, typename B, typename = typename std::enable_if<SAnyVecProxy<A, B>::value>::type> \
+	auto FUNCTION (const A& a, const B& b) -> decltype(FUNCTION(ToVec(a), ToVec(b))) \
+	{ return FUNCTION(ToVec(a), ToVec(b)); }
+
+#define GLSL_SWIZZLE_ARGS_3(FUNCTION) \
+	template <typename A, typename B, typename C, typename = typename std::enable_if<SAnyVecProxy<A, B, C>::value>::type> \
+	auto FUNCTION (const A& a, const B& b, const C& c) -> decltype(FUNCTION(ToVec(a), ToVec(b), ToVec(c))) \
+	{ return FUNCTION(ToVec(a), ToVec(b), ToVec(c)); }
+
+#define GLSL_SWIZZLE_ARGS_ASSIGN(FUNCTION) \
+	template <typename A, typename B, typename = typename std::enable_if<SIsVec<A>::value && SIsSwizzle<B>::value>::type> \
+	auto FUNCTION (A& a, const B& b) -> decltype(FUNCTION(a, ToVec(b))) \
+	{ return FUNCTION(a, ToVec(b)); }
+
+#if !GLSL_EXPRESSION_TEMPLATES
+// lazy arithmetic takes swizzles itself
+GLSL_SWIZZLE_ARGS_1(operator -)
+GLSL_SWIZZLE_ARGS_2(operator +)
+GLSL_SWIZZLE_ARGS_2(operator -)
+GLSL_SWIZZLE_ARGS_2(operator *)
+GLSL_SWIZZLE_ARGS_2(operator /)
+#endif
+GLSL_SWIZZLE_ARGS_1(operator !)
+GLSL_SWIZZLE_ARGS_2(operator ==)
+GLSL_SWIZZLE_ARGS_2(operator !=)
+GLSL_SWIZZLE_ARGS_ASSIGN(operator +=)
+GLSL_SWIZZLE_ARGS_ASSIGN(operator -=)
+GLSL_SWIZZLE_ARGS_ASSIGN(operator *=)
+GLSL_SWIZZLE_ARGS_ASSIGN(operator /=)
+GLSL_SWIZZLE_ARGS_2(dot)
+GLSL_SWIZZLE_ARGS_1(length)
+GLSL_SWIZZLE_ARGS_1(normalize)
+GLSL_SWIZZLE_ARGS_2(cross)
+GLSL_SWIZZLE_ARGS_2(distance)
+GLSL_SWIZZLE_ARGS_3(faceforward)
+GLSL_SWIZZLE_ARGS_2(reflect)
+GLSL_SWIZZLE_ARGS_3(refract)
+GLSL_SWIZZLE_ARGS_1(radians)
+GLSL_SWIZZLE_ARGS_1(degrees)
+GLSL_SWIZZLE_ARGS_1(sin)
+GLSL_SWIZZLE_ARGS_1(cos)
+GLSL_SWIZZLE_ARGS_1(tan)
+GLSL_SWIZZLE_ARGS_1(asin)
+GLSL_SWIZZLE_ARGS_1(acos)
+GLSL_SWIZZLE_ARGS_1(atan)
+GLSL_SWIZZLE_ARGS_1(sinh)
+GLSL_SWIZZLE_ARGS_1(cosh)
+GLSL_SWIZZLE_ARGS_1(tanh)
+GLSL_SWIZZLE_ARGS_1(asinh)
+GLSL_SWIZZLE_ARGS_1(acosh)
+GLSL_SWIZZLE_ARGS_1(atanh)
+GLSL_SWIZZLE_ARGS_1(exp)
+GLSL_SWIZZLE_ARGS_1(log)
+GLSL_SWIZZLE_ARGS_1(exp2)
+GLSL_SWIZZLE_ARGS_1(log2)
+GLSL_SWIZZLE_ARGS_1(sqrt)
+GLSL_SWIZZLE_ARGS_1(inversesqrt)
+GLSL_SWIZZLE_ARGS_1(abs)
+GLSL_SWIZZLE_ARGS_1(sign)
+GLSL_SWIZZLE_ARGS_1(floor)
+GLSL_SWIZZLE_ARGS_1(ceil)
+GLSL_SWIZZLE_ARGS_1(trunc)
+GLSL_SWIZZLE_ARGS_1(round)
+GLSL_SWIZZLE_ARGS_1(roundEven)
+GLSL_SWIZZLE_ARGS_1(fract)
+GLSL_SWIZZLE_ARGS_2(atan)
+GLSL_SWIZZLE_ARGS_2(pow)
+GLSL_SWIZZLE_ARGS_2(mod)
+GLSL_SWIZZLE_ARGS_2(min)
+GLSL_SWIZZLE_ARGS_2(max)
+GLSL_SWIZZLE_ARGS_3(clamp)
+GLSL_SWIZZLE_ARGS_3(mix)
+GLSL_SWIZZLE_ARGS_2(step)
+GLSL_SWIZZLE_ARGS_3(smoothstep)
+GLSL_SWIZZLE_ARGS_1(isnan)
+GLSL_SWIZZLE_ARGS_1(isinf)
+GLSL_SWIZZLE_ARGS_2(lessThan)
+GLSL_SWIZZLE_ARGS_2(lessThanEqual)
+GLSL_SWIZZLE_ARGS_2(greaterThan)
+GLSL_SWIZZLE_ARGS_2(greaterThanEqual)
+GLSL_SWIZZLE_ARGS_2(equal)
+GLSL_SWIZZLE_ARGS_2(notEqual)
+GLSL_SWIZZLE_ARGS_1(any)
+GLSL_SWIZZLE_ARGS_1(all)
+
+//-------------------------------------------------------------------------------------
+// Matrices
+//-------------------------------------------------------------------------------------
+
+// The number of components in a list of matrix constructor arguments
+template <typename T, bool VEC = SIsVecLike<T>::value> struct SArgComponents { static const size_t value = 1; };
+template <typename T> struct SArgComponents<T, true> { static const size_t value = TVecOf<T>::c_numElements; };
 
-	float& operator[] (size_t i) { return (&x)[i]; }
-	float operator[] (size_t i) const { return (&x)[i]; }
-
-	// xy
-	__declspec(property(get = get_xy, put = put_xy)) vec2 xy;
-	inline vec2 get_xy() const { return{ x, y }; }
-	inline void put_xy(vec2 v) { *this = v.xy; }
-	// yx
-	__declspec(property(get = get_yx, put = put_yx)) vec2 yx;
-	inline vec2 get_yx() const { return{ y, x }; }
-	inline void put_yx(vec2 v) { *this = v.yx; }
+template <typename... ARGS> struct SComponentCount { static const size_t value = 0; };
+template <typename FIRST, typename... REST>
+struct SComponentCount<FIRST, REST...>
+{
+	static const size_t value = SArgComponents<FIRST>::value + SComponentCount<REST...>::value;
 };
 
-struct vec3
+// Writes the components of matrix constructor arguments out in order
+template <typename T, typename U>
+typename std::enable_if<!SIsVecLike<U>::value>::type AppendComponent (T* components, size_t& count, const U& value)
 {
-	vec3(float v = 0.0f)
-	{
-		for (size_t i = 0; i < c_numElements; ++i)
-			(*this)[i] = v;
-	}
-	vec3(float _x, float _y, float _z)
-		: x(_x)
-		, y(_y)
-		, z(_z)
-	{ }
-    vec3(const vec2& v2, float _z)
-        : x(v2.x)
-        , y(v2.y)
-        , z(_z)
-    { }
+	components[count++] = T(value);
+}
+
+template <typename T, typename U>
+TVecOnly<U, void> AppendComponent (T* components, size_t& count, const U& value)
+{
+	for (size_t i = 0; i < U::c_numElements; ++i)
+		components[count++] = T(value[i]);
+}
 
-	float x, y, z;
+template <typename T, typename U>
+typename std::enable_if<SIsVecProxy<U>::value>::type AppendComponent (T* components, size_t& count, const U& value)
+{
+	AppendComponent(components, count, ToVec(value));
+}
 
-	static const size_t c_numElements = 3;
+template <typename T>
+void AppendComponents (T* components, size_t& count) { }
 
-	float& operator[] (size_t i) { return (&x)[i]; }
-	float operator[] (size_t i) const { return (&x)[i]; }
-
-	// xy
-	__declspec(property(get = get_xy, put = put_xy)) vec2 xy;
-	inline vec2 get_xy() const { return{ x, y }; }
-	inline void put_xy(vec2 v) { this->x = v.x;  this->y = v.y; }
-	// yx
-	__declspec(property(get = get_yx, put = put_yx)) vec2 yx;
-	inline vec2 get_yx() const { return{ y, x }; }
-	inline void put_yx(vec2 v) { this->y = v.x;  this->x = v.y; }
-	// xz
-	__declspec(property(get = get_xz, put = put_xz)) vec2 xz;
-	inline vec2 get_xz() const { return{ x, z }; }
-	inline void put_xz(vec2 v) { this->x = v.x;  this->z = v.y; }
-	// zx
-	__declspec(property(get = get_zx, put = put_zx)) vec2 zx;
-	inline vec2 get_zx() const { return{ z, x }; }
-	inline void put_zx(vec2 v) { this->z = v.x;  this->x = v.y; }
-
-    // yzx
-    __declspec(property(get = get_yzx, put = put_yzx)) vec3 yzx;
-    inline vec3 get_yzx() const { return{ y, z, x }; }
-    inline void put_yzx(vec3 v) { this->y = v.x;  this->z = v.y; this->x = v.z; }
-};
+template <typename T, typename FIRST, typename... REST>
+void AppendComponents (T* components, size_t& count, const FIRST& first, const REST&... rest)
+{
+	AppendComponent(components, count, first);
+	AppendComponents(components, count, rest...);
+}
 
-struct vec4
+// A matrix of COLUMNS columns with ROWS components each (GLSL's matCxR), stored column
+// major like GLSL: m[i] is column i. Each column is a vector, so a matrix times a vector
+// is a sum of whole columns scaled by the vector's components, which needs no shuffles,
+// and with SFloatPacket components every column is a structure-of-arrays packet vector.
+template <typename T, size_t COLUMNS, size_t ROWS>
+struct tmat
 {
-	vec4(float v = 0.0f)
+	typedef T element_type;
+	typedef typename SVecOfSize<T, ROWS>::type TColumn;
+	typedef typename SVecOfSize<T, COLUMNS>::type TRow;
+	static const size_t c_numColumns = COLUMNS;
+	static const size_t c_numRows = ROWS;
+
+	// all zero
+	tmat() { }
+
+	// diagonal, so mat3(1.0) is the identity
+	explicit tmat(T diagonal)
 	{
-		for (size_t i = 0; i < c_numElements; ++i)
-			(*this)[i] = v;
+		for (size_t i = 0; i < COLUMNS && i < ROWS; ++i)
+			m_columns[i][i] = diagonal;
 	}
-	vec4(const vec2& v2, float _z, float _w)
-		: x(v2.x)
-		, y(v2.y)
-		, z(_z)
-		, w(_w)
-	{ }
-	vec4(const vec3& v3, float _w)
-		: x(v3.x)
-		, y(v3.y)
-		, z(v3.z)
-		, w(w)
-	{ }
-	vec4(float _x, float _y, float _z, float _w)
-		: x(_x)
-		, y(_y)
-		, z(_z)
-		, w(_w)
-	{ }
 
-	float x, y, z, w;
+	// from another size of matrix: the part they share is copied and the rest is taken
+	// from the identity
+	template <size_t OTHER_COLUMNS, size_t OTHER_ROWS>
+	explicit tmat(const tmat<T, OTHER_COLUMNS, OTHER_ROWS>& m)
+	{
+		for (size_t column = 0; column < COLUMNS; ++column)
+		{
+			for (size_t row = 0; row < ROWS; ++row)
+				m_columns[column][row] = (column < OTHER_COLUMNS && row < OTHER_ROWS) ? m[column][row] : T(column == row ? 1.0f : 0.0f);
+		}
+	}
 
-	static const size_t c_numElements = 4;
+	// from columns, from components in column major order, or from any mix of vectors and
+	// scalars that adds up to the right number of components
+	template <typename FIRST, typename SECOND, typename... REST>
+	tmat(const FIRST& first, const SECOND& second, const REST&... rest)
+	{
+		static_assert(SComponentCount<FIRST, SECOND, REST...>::value == COLUMNS * ROWS, "Wrong number of components for this matrix");
+		T components[COLUMNS * ROWS];
+		size_t count = 0;
+		AppendComponents(components, count, first, second, rest...);
+		for (size_t column = 0; column < COLUMNS; ++column)
+		{
+			for (size_t row = 0; row < ROWS; ++row)
+				m_columns[column][row] = components[column * ROWS + row];
+		}
+	}
 
-	float& operator[] (size_t i) { return (&x)[i]; }
-	float operator[] (size_t i) const { return (&x)[i]; }
+	TColumn& operator[] (size_t i) { return m_columns[i]; }
+	const TColumn& operator[] (size_t i) const { return m_columns[i]; }
 
-	// xy
-	__declspec(property(get = get_xy, put = put_xy)) vec2 xy;
-	inline vec2 get_xy() const { return{ x, y }; }
-	inline void put_xy(vec2 v) { this->x = v.x;  this->y = v.y; }
+	TColumn m_columns[COLUMNS];
 };
 
+typedef tmat<float, 2, 2> mat2;
+typedef tmat<float, 3, 3> mat3;
+typedef tmat<float, 4, 4> mat4;
+typedef tmat<float, 2, 2> mat2x2;
+typedef tmat<float, 2, 3> mat2x3;
+typedef tmat<float, 2, 4> mat2x4;
+typedef tmat<float, 3, 2> mat3x2;
+typedef tmat<float, 3, 3> mat3x3;
+typedef tmat<float, 3, 4> mat3x4;
+typedef tmat<float, 4, 2> mat4x2;
+typedef tmat<float, 4, 3> mat4x3;
+typedef tmat<float, 4, 4> mat4x4;
 
 //-------------------------------------------------------------------------------------
-// Vec vs Vec operations
-//-------------------------------------------------------------------------------------
-
-template<typename T>
-T operator - (const T& A)
+template <typename T, size_t C, size_t R>
+typename tmat<T, C, R>::TColumn operator * (const tmat<T, C, R>& m, const typename tmat<T, C, R>::TRow& v)
 {
-	// Unary minus
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = -A[i];
+	// the columns scaled by the components of v
+	typename tmat<T, C, R>::TColumn ret = m[0] * v[0];
+	for (size_t column = 1; column < C; ++column)
+		ret += m[column] * v[column];
 	return ret;
 }
 
-template<typename T>
-T operator + (const T& A, const T& B)
+//-------------------------------------------------------------------------------------
+template <typename T, size_t C, size_t R>
+typename tmat<T, C, R>::TRow operator * (const typename tmat<T, C, R>::TColumn& v, const tmat<T, C, R>& m)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] + B[i];
+	// v as a row vector, so component i is v dotted with column i
+	typename tmat<T, C, R>::TRow ret;
+	for (size_t column = 0; column < C; ++column)
+		ret[column] = dot(v, m[column]);
 	return ret;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator - (const T& A, const T& B)
+template <typename T, size_t C, size_t R, size_t C2>
+tmat<T, C2, R> operator * (const tmat<T, C, R>& A, const tmat<T, C2, C>& B)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] - B[i];
+	tmat<T, C2, R> ret;
+	for (size_t column = 0; column < C2; ++column)
+		ret[column] = A * B[column];
 	return ret;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator -= (T& A, const T& B)
+template <typename T, size_t C, size_t R>
+tmat<T, C, R>& operator *= (tmat<T, C, R>& A, const tmat<T, C, C>& B)
 {
-	// Do the operation
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		A[i] -= B[i];
+	A = A * B;
 	return A;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator * (const T& A, const T& B)
+// Component-wise operations: + and - of two matrices, and every operation with a scalar
+#define GLSL_MATRIX_COMPONENTWISE(OPERATOR) \
+	template <typename T, size_t C, size_t R> \
+	tmat<T, C, R> operator OPERATOR (const tmat<T, C, R>& A, const tmat<T, C, R>& B) \
+	{ \
+		tmat<T, C, R> ret; \
+		for (size_t column = 0; column < C; ++column) \
+			ret[column] = A[column] OPERATOR B[column]; \
+		return ret; \
+	} \
+	template <typename T, size_t C, size_t R> \
+	tmat<T, C, R> operator OPERATOR (const tmat<T, C, R>& A, typename tmat<T, C, R>::element_type B) \
+	{ \
+		tmat<T, C, R> ret; \
+		for (size_t column = 0; column < C; ++column) \
+			ret[column] = A[column] OPERATOR B; \
+		return ret; \
+	} \
+	template <typename T, size_t C, size_t R> \
+	tmat<T, C, R> operator OPERATOR (typename tmat<T, C, R>::element_type A, const tmat<T, C, R>& B) \
+	{ \
+		tmat<T, C, R> ret; \
+		for (size_t column = 0; column < C; ++column) \
+			ret[column] = A OPERATOR B[column]; \
+		return ret; \
+	}
+
+GLSL_MATRIX_COMPONENTWISE(+)
+GLSL_MATRIX_COMPONENTWISE(-)
+
+#undef GLSL_MATRIX_COMPONENTWISE
+
+//-------------------------------------------------------------------------------------
+template <typename T, size_t C, size_t R>
+tmat<T, C, R> operator * (const tmat<T, C, R>& A, typename tmat<T, C, R>::element_type B)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] * B[i];
+	tmat<T, C, R> ret;
+	for (size_t column = 0; column < C; ++column)
+		ret[column] = A[column] * B;
 	return ret;
 }
 
-//-------------------------------------------------------------------------------------
-template<typename T>
-T operator / (const T& A, const T& B)
+template <typename T, size_t C, size_t R>
+tmat<T, C, R> operator * (typename tmat<T, C, R>::element_type A, const tmat<T, C, R>& B)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] / B[i];
-	return ret;
+	return B * A;
 }
 
-//-------------------------------------------------------------------------------------
-// Vec vs Float operations
-//-------------------------------------------------------------------------------------
-template<typename T>
-T operator + (const T& A, float B)
+template <typename T, size_t C, size_t R>
+tmat<T, C, R> operator / (const tmat<T, C, R>& A, typename tmat<T, C, R>::element_type B)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] + B;
+	tmat<T, C, R> ret;
+	for (size_t column = 0; column < C; ++column)
+		ret[column] = A[column] / B;
 	return ret;
 }
 
-//-------------------------------------------------------------------------------------
-template<typename T>
-T operator - (const T& A, float B)
+template <typename T, size_t C, size_t R>
+tmat<T, C, R> operator - (const tmat<T, C, R>& A)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] - B;
+	tmat<T, C, R> ret;
+	for (size_t column = 0; column < C; ++column)
+		ret[column] = -A[column];
 	return ret;
 }
 
+template <typename T, size_t C, size_t R>
+tmat<T, C, R>& operator += (tmat<T, C, R>& A, const tmat<T, C, R>& B) { A = A + B; return A; }
+
+template <typename T, size_t C, size_t R>
+tmat<T, C, R>& operator -= (tmat<T, C, R>& A, const tmat<T, C, R>& B) { A = A - B; return A; }
+
+template <typename T, size_t C, size_t R>
+tmat<T, C, R>& operator *= (tmat<T, C, R>& A, typename tmat<T, C, R>::element_type B) { A = A * B; return A; }
+
+template <typename T, size_t C, size_t R>
+tmat<T, C, R>& operator /= (tmat<T, C, R>& A, typename tmat<T, C, R>::element_type B) { A = A / B; return A; }
+
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator * (const T& A, float B)
+template <typename T, size_t C, size_t R>
+tmat<T, C, R> matrixCompMult (const tmat<T, C, R>& A, const tmat<T, C, R>& B)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] * B;
+	tmat<T, C, R> ret;
+	for (size_t column = 0; column < C; ++column)
+		ret[column] = A[column] * B[column];
 	return ret;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator += (T& A, float B)
+// The column vector c times the row vector r
+template <typename COLUMN, typename ROW>
+TVecOnly<COLUMN, tmat<typename COLUMN::element_type, ROW::c_numElements, COLUMN::c_numElements>> outerProduct (const COLUMN& c, const ROW& r)
 {
-    // Do the operation
-    for (size_t i = 0; i < T::c_numElements; ++i)
-        A[i] += B;
-    return A;
+	tmat<typename COLUMN::element_type, ROW::c_numElements, COLUMN::c_numElements> ret;
+	for (size_t column = 0; column < ROW::c_numElements; ++column)
+		ret[column] = c * r[column];
+	return ret;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator *= (T& A, float B)
+template <typename T, size_t C, size_t R>
+tmat<T, R, C> transpose (const tmat<T, C, R>& m)
 {
-	// Do the operation
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		A[i] *= B;
-	return A;
+	tmat<T, R, C> ret;
+	for (size_t column = 0; column < C; ++column)
+	{
+		for (size_t row = 0; row < R; ++row)
+			ret[row][column] = m[column][row];
+	}
+	return ret;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T operator / (const T& A, float B)
+template <typename T>
+T determinant (const tmat<T, 2, 2>& m)
 {
-	// Do the operation
-	T ret;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = A[i] / B;
-	return ret;
+	return m[0][0] * m[1][1] - m[1][0] * m[0][1];
 }
 
-//-------------------------------------------------------------------------------------
-// Functions
-//-------------------------------------------------------------------------------------
-template<typename T>
-float dot (const T& A, const T& B)
+template <typename T>
+T determinant (const tmat<T, 3, 3>& m)
 {
-	// Do the operation
-	float ret = 0.0;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret += A[i] * B[i];
-	return ret;
+	return dot(m[0], cross(m[1], m[2]));
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-float length(const T& V)
+// The 4x4 determinant and inverse work on the top three rows of each column as 3D vectors
+// a, b, c, d and the bottom row as x, y, z, w, which turns the cofactors into cross and
+// dot products (Lengyel, Foundations of Game Engine Development, volume 1)
+template <typename T>
+struct SMatrix4Cofactors
 {
-	// Do the operation
-	float length = 0.0;
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		length += V[i] * V[i];
-	length = sqrt(length);
-	return length;
+	SMatrix4Cofactors (const tmat<T, 4, 4>& m)
+		: a(m[0].xyz), b(m[1].xyz), c(m[2].xyz), d(m[3].xyz)
+		, x(m[0].w), y(m[1].w), z(m[2].w), w(m[3].w)
+	{
+		s = cross(a, b);
+		t = cross(c, d);
+		u = a * y - b * x;
+		v = c * w - d * z;
+		determinant = dot(s, v) + dot(t, u);
+	}
+
+	tvec3<T> a, b, c, d;
+	T x, y, z, w;
+	tvec3<T> s, t, u, v;
+	T determinant;
+};
+
+template <typename T>
+T determinant (const tmat<T, 4, 4>& m)
+{
+	return SMatrix4Cofactors<T>(m).determinant;
 }
 
 //-------------------------------------------------------------------------------------
-template<typename T>
-T normalize(const T& V)
+// Like GLSL, the result is undefined for a singular matrix
+template <typename T>
+tmat<T, 2, 2> inverse (const tmat<T, 2, 2>& m)
 {
-	// Do the operation
-	return V / length(V);
+	T inverseDeterminant = T(1.0f) / determinant(m);
+	return tmat<T, 2, 2>(m[1][1], -m[0][1], -m[1][0], m[0][0]) * inverseDeterminant;
 }
 
-//-------------------------------------------------------------------------------------
-template<typename T>
-T fract(const T& A)
+template <typename T>
+tmat<T, 3, 3> inverse (const tmat<T, 3, 3>& m)
 {
-	// Do the operation
-	return mod(A, 1.0f);
+	// the rows of the inverse are the cross products of pairs of columns
+	tvec3<T> r0 = cross(m[1], m[2]);
+	tvec3<T> r1 = cross(m[2], m[0]);
+	tvec3<T> r2 = cross(m[0], m[1]);
+	T inverseDeterminant = T(1.0f) / dot(m[0], r0);
+	return transpose(tmat<T, 3, 3>(r0, r1, r2)) * inverseDeterminant;
 }
 
-//-------------------------------------------------------------------------------------
 template <typename T>
-T mod (const T& A, float modulus)
+tmat<T, 4, 4> inverse (const tmat<T, 4, 4>& m)
 {
-	// Do the operation
-	T ret(0.0f);
-	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = mod(A[i], modulus);
-	return ret;
+	SMatrix4Cofactors<T> f(m);
+	T inverseDeterminant = T(1.0f) / f.determinant;
+	tvec3<T> s = f.s * inverseDeterminant;
+	tvec3<T> t = f.t * inverseDeterminant;
+	tvec3<T> u = f.u * inverseDeterminant;
+	tvec3<T> v = f.v * inverseDeterminant;
+
+	// rows of the inverse
+	tmat<T, 4, 4> rows(
+		tvec4<T>(cross(f.b, v) + t * f.y, -dot(f.b, t)),
+		tvec4<T>(cross(v, f.a) - t * f.x, dot(f.a, t)),
+		tvec4<T>(cross(f.d, u) + s * f.w, -dot(f.d, s)),
+		tvec4<T>(cross(u, f.c) - s * f.z, dot(f.c, s)));
+	return transpose(rows);
 }
 
+GLSL_SWIZZLE_ARGS_2(outerProduct)
+
 //-------------------------------------------------------------------------------------
-template <>
-inline float mod<float>(const float& A, float modulus)
+// Shader inputs
+//-------------------------------------------------------------------------------------
+struct STexture;
+
+// The filter and wrap settings of a Shadertoy channel
+enum class ETextureFilter
 {
-	return fmodf(A, modulus);
-}
+	Nearest,
+	Linear,     // bilinear
+	Mipmap,     // trilinear between mip levels
+};
+
+enum class ETextureWrap
+{
+	Clamp,
+	Repeat,
+};
+
+// What an iChannel is bound to. An unbound channel samples as black, like on Shadertoy.
+struct SSampler2D
+{
+	SSampler2D()
+		: m_texture(nullptr)
+		, m_filter(ETextureFilter::Linear)
+		, m_wrap(ETextureWrap::Clamp)
+	{ }
+
+	const STexture* m_texture;
+	ETextureFilter m_filter;
+	ETextureWrap m_wrap;
+};
 
 //-------------------------------------------------------------------------------------
-template <>
-inline double mod<double>(const double& A, float modulus)
+struct SRenderContext
 {
-	return fmodf(A, modulus);
-}
+	SRenderContext()
+		: m_iGlobalTime(0.0f)
+		, m_iTimeDelta(0.0f)
+		, m_iFrame(0)
+	{ }
+
+	float m_iGlobalTime;
+	float m_iTimeDelta;
+	int m_iFrame;
+	vec3 m_iResolution;
+	vec4 m_iMouse;
+	vec4 m_iDate;
+	vec3 m_iChannelResolution[4];
+	SSampler2D m_iChannel[4];
+};
 
 //-------------------------------------------------------------------------------------
-inline float clamp(float value, float min, float max)
+// The render context of the current thread. Each render thread binds the context of
+// the frame it is working on, so frames with different uniforms can render at once.
+inline const SRenderContext*& CurrentRenderContext ()
 {
-	if (value < min)
-		return min;
-	else if (value > max)
-		return max;
-	else
-		return value;
+	static thread_local const SRenderContext* s_renderContext = nullptr;
+	return s_renderContext;
 }
 
 //-------------------------------------------------------------------------------------
-inline float min (float a, float b)
+inline const SRenderContext& GetRenderContext ()
 {
-	return a < b ? a : b;
+	assert(CurrentRenderContext() != nullptr);
+	return *CurrentRenderContext();
 }
 
 //-------------------------------------------------------------------------------------
-inline float step (float threshold, float value)
+// Binds a render context to the current thread for as long as it is in scope. A shader
+// module has its own copy of CurrentRenderContext(), which is bound through slot.
+struct SRenderContextBinding
 {
-	return value >= threshold ? 1.0f : 0.0f;
-}
+	SRenderContextBinding(const SRenderContext& context)
+		: SRenderContextBinding(context, CurrentRenderContext())
+	{ }
+
+	SRenderContextBinding(const SRenderContext& context, const SRenderContext*& slot)
+		: m_slot(slot)
+		, m_previous(slot)
+	{
+		m_slot = &context;
+	}
+
+	~SRenderContextBinding()
+	{
+		m_slot = m_previous;
+	}
+
+	const SRenderContext*& m_slot;
+	const SRenderContext* m_previous;
+};
 
 //-------------------------------------------------------------------------------------
-inline float mod (float value, float modulus)
+// The uniforms of an SRenderContext, one bit each, for recording which of them a shader
+// read (see SShaderQuadSlot::m_uniformsRead)
+const uint32_t c_uniformTime                = 1u << 0;     // iGlobalTime and iTime
+const uint32_t c_uniformTimeDelta           = 1u << 1;
+const uint32_t c_uniformFrame               = 1u << 2;
+const uint32_t c_uniformResolution          = 1u << 3;
+const uint32_t c_uniformMouse               = 1u << 4;
+const uint32_t c_uniformDate                = 1u << 5;
+const uint32_t c_uniformChannelResolution   = 1u << 6;
+const uint32_t c_uniformChannel0            = 1u << 7;     // up to c_uniformChannel0 << 3
+const uint32_t c_uniformAll                 = (c_uniformChannel0 << 4) - 1;
+
+// Which uniforms differ between two render contexts. Floats are compared bit for bit, so
+// a NaN that stays NaN is unchanged. Channels compare by what they sample, not by the
+// contents of their textures.
+inline uint32_t ChangedUniforms (const SRenderContext& a, const SRenderContext& b)
 {
-	float ret = std::fmodf(value, modulus);
-	if (ret < 0.0f)
-		ret += modulus;
-	return ret;
+	uint32_t changed = 0;
+	if (memcmp(&a.m_iGlobalTime, &b.m_iGlobalTime, sizeof(a.m_iGlobalTime)))
+		changed |= c_uniformTime;
+	if (memcmp(&a.m_iTimeDelta, &b.m_iTimeDelta, sizeof(a.m_iTimeDelta)))
+		changed |= c_uniformTimeDelta;
+	if (a.m_iFrame != b.m_iFrame)
+		changed |= c_uniformFrame;
+	if (memcmp(&a.m_iResolution, &b.m_iResolution, sizeof(a.m_iResolution)))
+		changed |= c_uniformResolution;
+	if (memcmp(&a.m_iMouse, &b.m_iMouse, sizeof(a.m_iMouse)))
+		changed |= c_uniformMouse;
+	if (memcmp(&a.m_iDate, &b.m_iDate, sizeof(a.m_iDate)))
+		changed |= c_uniformDate;
+	if (memcmp(a.m_iChannelResolution, b.m_iChannelResolution, sizeof(a.m_iChannelResolution)))
+		changed |= c_uniformChannelResolution;
+	for (size_t channel = 0; channel < 4; ++channel)
+	{
+		const SSampler2D& samplerA = a.m_iChannel[channel];
+		const SSampler2D& samplerB = b.m_iChannel[channel];
+		if (samplerA.m_texture != samplerB.m_texture || samplerA.m_filter != samplerB.m_filter || samplerA.m_wrap != samplerB.m_wrap)
+			changed |= c_uniformChannel0 << channel;
+	}
+	return changed;
 }
 
+// The render context, noting that the shader read uniforms
+inline const SRenderContext& ReadUniforms (uint32_t uniforms);
+
+//-------------------------------------------------------------------------------------
+// Shadertoy uniform names, so shader source can use them unchanged
+#define iGlobalTime         (ReadUniforms(c_uniformTime).m_iGlobalTime)
+#define iTime               (ReadUniforms(c_uniformTime).m_iGlobalTime)
+#define iTimeDelta          (ReadUniforms(c_uniformTimeDelta).m_iTimeDelta)
+#define iFrame              (ReadUniforms(c_uniformFrame).m_iFrame)
+#define iResolution         (ReadUniforms(c_uniformResolution).m_iResolution)
+#define iMouse              (ReadUniforms(c_uniformMouse).m_iMouse)
+#define iDate               (ReadUniforms(c_uniformDate).m_iDate)
+#define iChannelResolution  (ReadUniforms(c_uniformChannelResolution).m_iChannelResolution)
+#define iChannel0           (ReadUniforms(c_uniformChannel0).m_iChannel[0])
+#define iChannel1           (ReadUniforms(c_uniformChannel0 << 1).m_iChannel[1])
+#define iChannel2           (ReadUniforms(c_uniformChannel0 << 2).m_iChannel[2])
+#define iChannel3           (ReadUniforms(c_uniformChannel0 << 3).m_iChannel[3])
+
+//-------------------------------------------------------------------------------------
+// Screen space derivatives. A GPU shades pixels in 2x2 quads and gets dFdx() etc by
+// swapping values between them. A packet does the same between its lanes (see
+// glslPacket.h). A scalar invocation only sees its own pixel, so when a shader uses
+// derivatives the renderer runs the four pixels of each quad on fibers of their own,
+// and each call swaps values through this. See SQuadRunner in QuadRunner.h.
 //-------------------------------------------------------------------------------------
-inline vec3 cross (const vec3& a, const vec3& b)
+struct SShaderQuad
 {
-	return vec3
-	(
-		a[1] * b[2] - a[2] * b[1],
-		a[2] * b[0] - a[0] * b[2],
-		a[0] * b[1] - a[1] * b[0]
-	);
+	// Posts m_values[m_exchanges & 1][m_invocation] and returns once every invocation of
+	// the quad still running has posted too
+	void (*m_exchange)(SShaderQuad& quad);
+
+	size_t m_invocation;        // the one running now: bit 0 is x & 1, bit 1 is y & 1
+	size_t m_exchanges;         // completed so far; values are double buffered by it
+	vec4 m_values[2][4];
+	uint32_t m_posted[2];       // which invocations posted, one bit each
+};
+
+// The operations the op counting build of a shader (see glslCounted.h) has run on a
+// thread, which only go up
+struct SOpCounts
+{
+	uint64_t Total () const { return m_alu + m_transcendentals + m_branches + m_textures; }
+
+	uint64_t m_alu;
+	uint64_t m_transcendentals;
+	uint64_t m_branches;
+	uint64_t m_textures;
+};
+
+// The quad the current thread is shading, or null for a lone pixel. A lone pixel's
+// derivatives are 0 and set m_derivativesUsed, so the renderer knows to shade it again
+// in a quad. The uniforms the shader reads are added to m_uniformsRead (c_uniformTime
+// etc), which the renderer clears to find out what a tile depends on, and the op counting
+// build counts into m_opCounts.
+struct SShaderQuadSlot
+{
+	SShaderQuad* m_quad;
+	bool m_derivativesUsed;
+	uint32_t m_uniformsRead;
+	SOpCounts m_opCounts;
+};
+
+inline SShaderQuadSlot& CurrentShaderQuad ()
+{
+	static thread_local SShaderQuadSlot s_slot = { nullptr, false, 0, { 0, 0, 0, 0 } };
+	return s_slot;
 }
 
-//-------------------------------------------------------------------------------------
+inline const SRenderContext& ReadUniforms (uint32_t uniforms)
+{
+	CurrentShaderQuad().m_uniformsRead |= uniforms;
+	return GetRenderContext();
+}
+
+// The differences across the quad, right minus left and top minus bottom, of the
+// first components components of value. A neighbour that has already returned from
+// mainImage() counts as having this invocation's value, so its difference is 0.
+inline void QuadDifferences (const vec4& value, size_t components, vec4& dx, vec4& dy)
+{
+	SShaderQuadSlot& slot = CurrentShaderQuad();
+	if (!slot.m_quad)
+	{
+		slot.m_derivativesUsed = true;
+		dx = vec4(0.0f);
+		dy = vec4(0.0f);
+		return;
+	}
+
+	SShaderQuad& quad = *slot.m_quad;
+	const size_t invocation = quad.m_invocation;
+	const size_t buffer = quad.m_exchanges & 1;
+	quad.m_values[buffer][invocation] = value;
+	quad.m_exchange(quad);
+
+	const vec4* values = quad.m_values[buffer];
+	const uint32_t posted = quad.m_posted[buffer];
+	const vec4& xNeighbour = (posted & (1u << (invocation ^ 1))) ? values[invocation ^ 1] : value;
+	const vec4& yNeighbour = (posted & (1u << (invocation ^ 2))) ? values[invocation ^ 2] : value;
+	for (size_t i = 0; i < components; ++i)
+	{
+		dx[i] = (invocation & 1) ? value[i] - xNeighbour[i] : xNeighbour[i] - value[i];
+		dy[i] = (invocation & 2) ? value[i] - yNeighbour[i] : yNeighbour[i] - value[i];
+	}
+}
+
+inline float dFdx (float p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f, 0.0f), 1, dx, dy); return dx[0]; }
+inline float dFdy (float p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f, 0.0f), 1, dx, dy); return dy[0]; }
+inline float fwidth (float p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f, 0.0f), 1, dx, dy); return std::abs(dx[0]) + std::abs(dy[0]); }
+
+inline vec2 dFdx (const vec2& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f), 2, dx, dy); return dx.xy; }
+inline vec2 dFdy (const vec2& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f), 2, dx, dy); return dy.xy; }
+inline vec2 fwidth (const vec2& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f, 0.0f), 2, dx, dy); return abs(dx.xy) + abs(dy.xy); }
+
+inline vec3 dFdx (const vec3& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f), 3, dx, dy); return dx.xyz; }
+inline vec3 dFdy (const vec3& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f), 3, dx, dy); return dy.xyz; }
+inline vec3 fwidth (const vec3& p) { vec4 dx, dy; QuadDifferences(vec4(p, 0.0f), 3, dx, dy); return abs(dx.xyz) + abs(dy.xyz); }
+
+inline vec4 dFdx (const vec4& p) { vec4 dx, dy; QuadDifferences(p, 4, dx, dy); return dx; }
+inline vec4 dFdy (const vec4& p) { vec4 dx, dy; QuadDifferences(p, 4, dx, dy); return dy; }
+inline vec4 fwidth (const vec4& p) { vec4 dx, dy; QuadDifferences(p, 4, dx, dy); return abs(dx) + abs(dy); }
+
+// packet vectors, component by component (the packet versions of the element functions
+// are in glslPacket.h)
 template<typename T>
-T mix (const T& A, const T& B, float blend)
+TVecOnly<T> dFdx (const T& p)
 {
-    T ret;
-    for (size_t i = 0; i < T::c_numElements; ++i)
-        ret[i] = A[i] * (1.0f - blend) + B[i] * blend;
-    return ret;
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = dFdx(p[i]);
+	return ret;
 }
 
-//-------------------------------------------------------------------------------------
 template<typename T>
-T pow(const T& A, float p)
+TVecOnly<T> dFdy (const T& p)
 {
 	T ret;
 	for (size_t i = 0; i < T::c_numElements; ++i)
-		ret[i] = pow(A[i], p);
+		ret[i] = dFdy(p[i]);
 	return ret;
 }
 
-//-------------------------------------------------------------------------------------
-inline float smoothstep (float min, float max, float value)
+template<typename T>
+TVecOnly<T> fwidth (const T& p)
 {
-    float t = (value - min) / (max - min);
-    t = clamp(t, 0.0f, 1.0f);
-    return 3.0*t*t - 2.0 * t*t*t;
+	T ret;
+	for (size_t i = 0; i < T::c_numElements; ++i)
+		ret[i] = fwidth(p[i]);
+	return ret;
 }
 
+GLSL_SWIZZLE_ARGS_1(dFdx)
+GLSL_SWIZZLE_ARGS_1(dFdy)
+GLSL_SWIZZLE_ARGS_1(fwidth)
+
 //-------------------------------------------------------------------------------------
-extern float iGlobalTime;
-extern vec3 iResolution;
-extern vec4 iMouse;
+// Texture lookups, implemented in Texture.cpp. uv (0,0) is the bottom left corner of the
+// texture, and texel row 0 is its bottom row, matching fragCoord. texture() doesn't pick
+// its mip level from the derivatives of uv; it samples level 0 plus any bias.
+vec4 texture (const SSampler2D& sampler, const vec2& uv);
+vec4 texture (const SSampler2D& sampler, const vec2& uv, float bias);
+vec4 textureLod (const SSampler2D& sampler, const vec2& uv, float lod);
+vec4 texelFetch (const SSampler2D& sampler, const ivec2& texel, int lod);
+ivec2 textureSize (const SSampler2D& sampler, int lod);
+
+//-------------------------------------------------------------------------------------
+// Shader code, compiled one pixel per call inside this namespace by mainScalar.cpp. The
+// C library's float overloads can't be replaced at global scope (MSVC defines them there
+// too), so the transcendentals are declared again here, where they hide the global ones
+// and follow the precision tier of glslMath.h. Vectors and swizzles still find the vector
+// versions above through argument dependent lookup.
+//-------------------------------------------------------------------------------------
+namespace Scalar
+{
+	inline float sin (float x) { return MathSin(x); }
+	inline float cos (float x) { return MathCos(x); }
+	inline float tan (float x) { return MathTan(x); }
+	inline float asin (float x) { return MathAsin(x); }
+	inline float acos (float x) { return MathAcos(x); }
+	inline float atan (float x) { return MathAtan(x); }
+	inline float atan (float y, float x) { return MathAtan2(y, x); }
+	inline float exp (float x) { return MathExp(x); }
+	inline float log (float x) { return MathLog(x); }
+	inline float exp2 (float x) { return MathExp2(x); }
+	inline float log2 (float x) { return MathLog2(x); }
+	inline float pow (float x, float y) { return MathPow(x, y); }
+	inline float sinh (float x) { return MathSinh(x); }
+	inline float cosh (float x) { return MathCosh(x); }
+	inline float tanh (float x) { return MathTanh(x); }
+	inline float asinh (float x) { return MathAsinh(x); }
+	inline float acosh (float x) { return MathAcosh(x); }
+	inline float atanh (float x) { return MathAtanh(x); }
 
-extern void mainImage(vec4& fragColor, vec2 fragCoord);
\ No newline at end of file
+	void mainImage(vec4& fragColor, vec2 fragCoord);
+}
\ No newline at end of file
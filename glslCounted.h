@@ -0,0 +1,323 @@
+#pragma once
+
+// Op counting mode, for estimating what a shader would cost on a GPU. SCountedFloat holds
+// one float, and every operator and builtin on it adds what it would issue on a GPU to
+// the counts of the current thread's SShaderQuadSlot (see glslAdapters.h). mainCounted.cpp
+// compiles the shader in main.cpp a third time with float standing for SCountedFloat, the
+// way mainPacket.cpp does for packets, so the unchanged source shades one pixel per call
+// and counts as it goes. Each operation gets its value from the float version, so the
+// pixels are the scalar path's bit for bit. Only -opcounts renders call this build, so
+// normal renders never touch the counts.
+//
+// Costs are per component, as a scalar GPU architecture issues them:
+//
+//     + - * compare, min, max, floor, ceil, fract, sign, step, ...     1 ALU
+//     negate, abs                                                      free (source modifiers)
+//     clamp, mix                                                       2 ALU
+//     / (a reciprocal and a multiply)                                  1 transcendental, 1 ALU
+//     sqrt, inversesqrt, sin, cos, exp2, log2                          1 transcendental
+//     exp, log                                                         1 transcendental, 1 ALU
+//     pow (log2, multiply, exp2)                                       2 transcendentals, 1 ALU
+//     tan (sin, cos and a divide)                                      3 transcendentals, 1 ALU
+//     mod (x - y * floor(x / y))                                       1 transcendental, 3 ALU
+//     asin, acos, atan (polynomials)                                   1 transcendental, 8 ALU
+//     smoothstep                                                       1 transcendental, 6 ALU
+//
+// Vector builtins (cross, reflect, distance, ...) count the component operations they are
+// made of, except dot, length and normalize, which count the way GPUs run them: a multiply
+// then a multiply-add per further component (two ALU ops each), plus a sqrt for length and
+// an inversesqrt and a multiply per component for normalize. Branching on a comparison
+// (if, ?:, a loop condition) counts a branch, and && || ! between comparisons an ALU op
+// each. Texture lookups count a texture op. Integer math isn't counted.
+//
+// As with packets, comparisons give their own bool type, so a comparison can't be stored
+// in a plain bool.
+
+#include "glslAdapters.h"
+#include <stdint.h>
+
+//-------------------------------------------------------------------------------------
+inline void CountOps (uint64_t alu, uint64_t transcendentals = 0)
+{
+	SOpCounts& counts = CurrentShaderQuad().m_opCounts;
+	counts.m_alu += alu;
+	counts.m_transcendentals += transcendentals;
+}
+
+//-------------------------------------------------------------------------------------
+// The result of a comparison. Branching on it counts a branch. Like a packet's mask it
+// isn't made from a bool implicitly, so mix(a, b, 0.5) isn't ambiguous.
+//-------------------------------------------------------------------------------------
+struct SCountedBool
+{
+	// left uninitialized like a bool, so they can live in the bvec unions
+	SCountedBool() = default;
+	explicit SCountedBool(bool value)
+		: m_value(value)
+	{ }
+
+	explicit operator bool() const
+	{
+		++CurrentShaderQuad().m_opCounts.m_branches;
+		return m_value;
+	}
+
+	bool m_value;
+};
+
+inline SCountedBool operator && (SCountedBool a, SCountedBool b) { CountOps(1); return SCountedBool(a.m_value && b.m_value); }
+inline SCountedBool operator || (SCountedBool a, SCountedBool b) { CountOps(1); return SCountedBool(a.m_value || b.m_value); }
+inline SCountedBool operator ! (SCountedBool a) { CountOps(1); return SCountedBool(!a.m_value); }
+
+//-------------------------------------------------------------------------------------
+// One float, counting the operations done with it
+//-------------------------------------------------------------------------------------
+struct SCountedFloat
+{
+	// left uninitialized like a float, so they can live in the vector unions
+	SCountedFloat() = default;
+	SCountedFloat(float f)
+		: m_value(f)
+	{ }
+
+	// for int(x) and the conversions back to float vectors
+	explicit operator float() const { return m_value; }
+
+	SCountedFloat& operator += (const SCountedFloat& b) { CountOps(1); m_value += b.m_value; return *this; }
+	SCountedFloat& operator -= (const SCountedFloat& b) { CountOps(1); m_value -= b.m_value; return *this; }
+	SCountedFloat& operator *= (const SCountedFloat& b) { CountOps(1); m_value *= b.m_value; return *this; }
+	SCountedFloat& operator /= (const SCountedFloat& b) { CountOps(1, 1); m_value /= b.m_value; return *this; }
+
+	float m_value;
+};
+
+// A counted float is a genType (see glslAdapters.h), so distance, reflect etc take them too
+template <> struct SIsGenType<SCountedFloat> { static const bool value = true; };
+
+inline SCountedFloat operator - (const SCountedFloat& a) { return -a.m_value; }
+inline SCountedFloat operator + (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return a.m_value + b.m_value; }
+inline SCountedFloat operator - (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return a.m_value - b.m_value; }
+inline SCountedFloat operator * (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return a.m_value * b.m_value; }
+inline SCountedFloat operator / (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1, 1); return a.m_value / b.m_value; }
+
+inline SCountedBool operator < (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value < b.m_value); }
+inline SCountedBool operator <= (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value <= b.m_value); }
+inline SCountedBool operator > (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value > b.m_value); }
+inline SCountedBool operator >= (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value >= b.m_value); }
+inline SCountedBool operator == (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value == b.m_value); }
+inline SCountedBool operator != (const SCountedFloat& a, const SCountedFloat& b) { CountOps(1); return SCountedBool(a.m_value != b.m_value); }
+
+//-------------------------------------------------------------------------------------
+// The builtins in the precision tier of this build (see glslMath.h), computed by the
+// float versions. The vector versions in glslAdapters.h call these per component.
+//-------------------------------------------------------------------------------------
+#define GLSL_COUNTED_1(FUNCTION, ALU, TRANSCENDENTALS, VALUE) \
+	inline SCountedFloat FUNCTION (const SCountedFloat& a) { CountOps(ALU, TRANSCENDENTALS); return VALUE(a.m_value); }
+
+#define GLSL_COUNTED_2(FUNCTION, ALU, TRANSCENDENTALS, VALUE) \
+	inline SCountedFloat FUNCTION (const SCountedFloat& a, const SCountedFloat& b) { CountOps(ALU, TRANSCENDENTALS); return VALUE(a.m_value, b.m_value); }
+
+GLSL_COUNTED_1(MathSin, 0, 1, MathSin)
+GLSL_COUNTED_1(MathCos, 0, 1, MathCos)
+GLSL_COUNTED_1(MathTan, 1, 3, MathTan)
+GLSL_COUNTED_1(MathAsin, 8, 1, MathAsin)
+GLSL_COUNTED_1(MathAcos, 8, 1, MathAcos)
+GLSL_COUNTED_1(MathAtan, 8, 1, MathAtan)
+GLSL_COUNTED_1(MathExp, 1, 1, MathExp)
+GLSL_COUNTED_1(MathLog, 1, 1, MathLog)
+GLSL_COUNTED_1(MathExp2, 0, 1, MathExp2)
+GLSL_COUNTED_1(MathLog2, 0, 1, MathLog2)
+GLSL_COUNTED_1(MathSinh, 4, 2, MathSinh)
+GLSL_COUNTED_1(MathCosh, 4, 2, MathCosh)
+GLSL_COUNTED_1(MathTanh, 4, 2, MathTanh)
+GLSL_COUNTED_1(MathAsinh, 4, 2, MathAsinh)
+GLSL_COUNTED_1(MathAcosh, 4, 2, MathAcosh)
+GLSL_COUNTED_1(MathAtanh, 4, 2, MathAtanh)
+GLSL_COUNTED_1(MathInverseSqrt, 0, 1, MathInverseSqrt)
+GLSL_COUNTED_1(MathFract, 1, 0, MathFract)
+GLSL_COUNTED_2(MathAtan2, 10, 1, MathAtan2)
+GLSL_COUNTED_2(MathPow, 1, 2, MathPow)
+GLSL_COUNTED_2(MathMod, 3, 1, MathMod)
+
+//-------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------
+GLSL_COUNTED_1(sin, 0, 1, MathSin)
+GLSL_COUNTED_1(cos, 0, 1, MathCos)
+GLSL_COUNTED_1(tan, 1, 3, MathTan)
+GLSL_COUNTED_1(asin, 8, 1, MathAsin)
+GLSL_COUNTED_1(acos, 8, 1, MathAcos)
+GLSL_COUNTED_1(atan, 8, 1, MathAtan)
+GLSL_COUNTED_1(exp, 1, 1, MathExp)
+GLSL_COUNTED_1(log, 1, 1, MathLog)
+GLSL_COUNTED_1(exp2, 0, 1, MathExp2)
+GLSL_COUNTED_1(log2, 0, 1, MathLog2)
+GLSL_COUNTED_1(sinh, 4, 2, MathSinh)
+GLSL_COUNTED_1(cosh, 4, 2, MathCosh)
+GLSL_COUNTED_1(tanh, 4, 2, MathTanh)
+GLSL_COUNTED_1(asinh, 4, 2, MathAsinh)
+GLSL_COUNTED_1(acosh, 4, 2, MathAcosh)
+GLSL_COUNTED_1(atanh, 4, 2, MathAtanh)
+GLSL_COUNTED_1(sqrt, 0, 1, std::sqrt)
+GLSL_COUNTED_1(inversesqrt, 0, 1, MathInverseSqrt)
+GLSL_COUNTED_1(abs, 0, 0, std::fabs)
+GLSL_COUNTED_1(sign, 1, 0, sign)
+GLSL_COUNTED_1(floor, 1, 0, std::floor)
+GLSL_COUNTED_1(ceil, 1, 0, std::ceil)
+GLSL_COUNTED_1(trunc, 1, 0, std::trunc)
+GLSL_COUNTED_1(round, 1, 0, std::round)
+GLSL_COUNTED_1(roundEven, 1, 0, roundEven)
+GLSL_COUNTED_1(fract, 1, 0, MathFract)
+GLSL_COUNTED_1(radians, 1, 0, radians)
+GLSL_COUNTED_1(degrees, 1, 0, degrees)
+GLSL_COUNTED_1(length, 0, 0, length)
+
+GLSL_COUNTED_2(atan, 10, 1, MathAtan2)
+GLSL_COUNTED_2(pow, 1, 2, MathPow)
+GLSL_COUNTED_2(mod, 3, 1, MathMod)
+GLSL_COUNTED_2(min, 1, 0, min)
+GLSL_COUNTED_2(max, 1, 0, max)
+GLSL_COUNTED_2(step, 1, 0, step)
+GLSL_COUNTED_2(dot, 1, 0, dot)
+
+#undef GLSL_COUNTED_1
+#undef GLSL_COUNTED_2
+
+inline SCountedBool isnan (const SCountedFloat& a) { CountOps(1); return SCountedBool(std::isnan(a.m_value)); }
+inline SCountedBool isinf (const SCountedFloat& a) { CountOps(1); return SCountedBool(std::isinf(a.m_value)); }
+
+//-------------------------------------------------------------------------------------
+inline SCountedFloat modf (const SCountedFloat& a, SCountedFloat& whole)
+{
+	CountOps(2);
+	return modf(a.m_value, whole.m_value);
+}
+
+//-------------------------------------------------------------------------------------
+inline SCountedFloat clamp (const SCountedFloat& value, const SCountedFloat& min, const SCountedFloat& max)
+{
+	CountOps(2);
+	return clamp(value.m_value, min.m_value, max.m_value);
+}
+
+//-------------------------------------------------------------------------------------
+inline SCountedFloat mix (const SCountedFloat& a, const SCountedFloat& b, const SCountedFloat& blend)
+{
+	CountOps(2);
+	return mix(a.m_value, b.m_value, blend.m_value);
+}
+
+//-------------------------------------------------------------------------------------
+// a select, rather than a branch
+inline SCountedFloat mix (const SCountedFloat& a, const SCountedFloat& b, SCountedBool selectB)
+{
+	CountOps(1);
+	return selectB.m_value ? b : a;
+}
+
+//-------------------------------------------------------------------------------------
+inline SCountedFloat smoothstep (const SCountedFloat& min, const SCountedFloat& max, const SCountedFloat& value)
+{
+	CountOps(6, 1);
+	return smoothstep(min.m_value, max.m_value, value.m_value);
+}
+
+//-------------------------------------------------------------------------------------
+// Screen space derivatives: a difference within the quad each, and fwidth adds two
+//-------------------------------------------------------------------------------------
+inline SCountedFloat dFdx (const SCountedFloat& p) { CountOps(1); return dFdx(p.m_value); }
+inline SCountedFloat dFdy (const SCountedFloat& p) { CountOps(1); return dFdy(p.m_value); }
+inline SCountedFloat fwidth (const SCountedFloat& p) { CountOps(3); return fwidth(p.m_value); }
+
+//-------------------------------------------------------------------------------------
+// dot, length and normalize of vectors, counted as a GPU runs them and computed by the
+// float versions
+//-------------------------------------------------------------------------------------
+#define GLSL_COUNTED_GEOMETRIC(N) \
+	inline SCountedFloat dot (const tvec##N<SCountedFloat>& A, const tvec##N<SCountedFloat>& B) \
+	{ \
+		CountOps(N * 2 - 1); \
+		return dot(vec##N(A), vec##N(B)); \
+	} \
+	inline SCountedFloat length (const tvec##N<SCountedFloat>& V) \
+	{ \
+		CountOps(N * 2 - 1, 1); \
+		return length(vec##N(V)); \
+	} \
+	inline tvec##N<SCountedFloat> normalize (const tvec##N<SCountedFloat>& V) \
+	{ \
+		CountOps(N * 3 - 1, 1); \
+		return tvec##N<SCountedFloat>(normalize(vec##N(V))); \
+	}
+
+GLSL_COUNTED_GEOMETRIC(2)
+GLSL_COUNTED_GEOMETRIC(3)
+GLSL_COUNTED_GEOMETRIC(4)
+
+#undef GLSL_COUNTED_GEOMETRIC
+
+//-------------------------------------------------------------------------------------
+// The counting versions of the shader types and entry point, defined by compiling main.cpp
+// in mainCounted.cpp
+//-------------------------------------------------------------------------------------
+namespace Counted
+{
+	typedef tvec2<SCountedFloat> vec2;
+	typedef tvec3<SCountedFloat> vec3;
+	typedef tvec4<SCountedFloat> vec4;
+
+	// integer math isn't counted, so integer vectors stay ints
+	typedef ::ivec2 ivec2;
+	typedef ::ivec3 ivec3;
+	typedef ::ivec4 ivec4;
+
+	typedef tvec2<SCountedBool> bvec2;
+	typedef tvec3<SCountedBool> bvec3;
+	typedef tvec4<SCountedBool> bvec4;
+
+	typedef tmat<SCountedFloat, 2, 2> mat2;
+	typedef tmat<SCountedFloat, 3, 3> mat3;
+	typedef tmat<SCountedFloat, 4, 4> mat4;
+	typedef tmat<SCountedFloat, 2, 2> mat2x2;
+	typedef tmat<SCountedFloat, 2, 3> mat2x3;
+	typedef tmat<SCountedFloat, 2, 4> mat2x4;
+	typedef tmat<SCountedFloat, 3, 2> mat3x2;
+	typedef tmat<SCountedFloat, 3, 3> mat3x3;
+	typedef tmat<SCountedFloat, 3, 4> mat3x4;
+	typedef tmat<SCountedFloat, 4, 2> mat4x2;
+	typedef tmat<SCountedFloat, 4, 3> mat4x3;
+	typedef tmat<SCountedFloat, 4, 4> mat4x4;
+
+	void mainImage(vec4& fragColor, vec2 fragCoord);
+
+	//-------------------------------------------------------------------------------------
+	// Texture lookups count a texture op and otherwise are the scalar ones
+	inline void CountTextureOp ()
+	{
+		++CurrentShaderQuad().m_opCounts.m_textures;
+	}
+
+	inline vec4 texture (const SSampler2D& sampler, const vec2& uv)
+	{
+		CountTextureOp();
+		return vec4(::texture(sampler, ::vec2(uv)));
+	}
+
+	inline vec4 texture (const SSampler2D& sampler, const vec2& uv, SCountedFloat bias)
+	{
+		CountTextureOp();
+		return vec4(::texture(sampler, ::vec2(uv), bias.m_value));
+	}
+
+	inline vec4 textureLod (const SSampler2D& sampler, const vec2& uv, SCountedFloat lod)
+	{
+		CountTextureOp();
+		return vec4(::textureLod(sampler, ::vec2(uv), lod.m_value));
+	}
+
+	inline vec4 texelFetch (const SSampler2D& sampler, const ivec2& texel, int lod)
+	{
+		CountTextureOp();
+		return vec4(::texelFetch(sampler, texel, lod));
+	}
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+// Precision tiers for the transcendental builtins (sin, pow, exp2, atan, sinh, ...) and for
+// mod, picked at build time by defining GLSL_MATH_PRECISION as one of:
+//
+//   GLSL_MATH_EXACT  the C library, a correctly rounded or nearly so result (the default)
+//   GLSL_MATH_GPU    polynomials with about the error of GPU hardware, computed the way
+//                    GPUs do: pow(x, y) is exp2(y * log2(x)), mod(x, y) is
+//                    x - y * floor(x / y), and sin and cos reduce their argument in single
+//                    precision, so they lose accuracy for large angles like on a GPU
+//   GLSL_MATH_FAST   lower degree polynomials, good to about 1e-4
+//
+// The GPU tier is the one to use when comparing against Shadertoy. The approximations are
+// templates written with nothing but arithmetic, floor, min/max and selects, so the same
+// code runs on a float and on an SFloatPacket (see glslPacket.h, which has the packet
+// versions of the primitives below) and a packet gives each lane the same bits as the
+// scalar path. -mathreport prints each function's error and speed in every tier.
+
+#include <cmath>
+#include <float.h>
+#include <limits>
+#include <stdint.h>
+#include <string.h>
+
+#define GLSL_MATH_EXACT 0
+#define GLSL_MATH_GPU   1
+#define GLSL_MATH_FAST  2
+
+#ifndef GLSL_MATH_PRECISION
+	#define GLSL_MATH_PRECISION GLSL_MATH_EXACT
+#endif
+
+//-------------------------------------------------------------------------------------
+// Primitives the approximations are built from
+//-------------------------------------------------------------------------------------
+inline float MathSelect (bool condition, float ifTrue, float ifFalse) { return condition ? ifTrue : ifFalse; }
+
+// min and max keep the second argument when either is NaN, like the SSE instructions
+inline float MathMin (float a, float b) { return a < b ? a : b; }
+inline float MathMax (float a, float b) { return a > b ? a : b; }
+inline float MathFloor (float a) { return std::floor(a); }
+inline float MathAbs (float a) { return std::fabs(a); }
+inline float MathSqrt (float a) { return std::sqrt(a); }
+
+//-------------------------------------------------------------------------------------
+// 2^n for a whole number n from -127 (which gives 0) to 128 (which gives infinity), made
+// by writing n straight into the exponent bits
+inline float MathPow2i (float n)
+{
+	uint32_t bits = uint32_t(int32_t(n) + 127) << 23;
+	float ret;
+	memcpy(&ret, &bits, sizeof(ret));
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+// Splits a into mantissa * 2^exponent with the mantissa in [1, 2). Only meaningful for
+// positive, normal, finite a.
+inline float MathSplitExponent (float a, float& exponent)
+{
+	uint32_t bits;
+	memcpy(&bits, &a, sizeof(bits));
+	exponent = float(int32_t((bits >> 23) & 0xff) - 127);
+	bits = (bits & 0x007fffff) | 0x3f800000;
+	float mantissa;
+	memcpy(&mantissa, &bits, sizeof(mantissa));
+	return mantissa;
+}
+
+//-------------------------------------------------------------------------------------
+// Approximations, for TIER GLSL_MATH_GPU or GLSL_MATH_FAST. The polynomials are minimax
+// fits of each tier's degree.
+//-------------------------------------------------------------------------------------
+template <int TIER, typename T>
+T ApproxExp2 (T x)
+{
+	// 2^x = 2^whole * 2^fraction. Clamping to [-127, 128] makes the whole part flush to 0
+	// below the normal range and go to infinity above it, and keeps NaN.
+	T clamped = MathMin(T(128.0f), MathMax(T(-127.0f), x));
+	T whole = MathFloor(clamped);
+	T f = clamped - whole;
+	T p;
+	if (TIER == GLSL_MATH_FAST)
+		p = ((T(7.8024516803e-02f) * f + T(2.2606716374e-01f)) * f + T(6.9583353764e-01f)) * f + T(9.9992521870e-01f);
+	else
+		p = (((((T(2.1701760583e-04f) * f + T(1.2439835331e-03f)) * f + T(9.6788245381e-03f)) * f
+			+ T(5.5483350426e-02f)) * f + T(2.4022983433e-01f)) * f + T(6.9314698400e-01f)) * f + T(1.0f);
+	return p * MathPow2i(whole);
+}
+
+//-------------------------------------------------------------------------------------
+template <int TIER, typename T>
+T ApproxLog2 (T x)
+{
+	// log2(x) = exponent + log2(mantissa), with the mantissa moved into [sqrt(1/2), sqrt(2)]
+	// and its log taken from the series in t = (m - 1) / (m + 1), which converges quickly there
+	T exponent;
+	T mantissa = MathSplitExponent(x, exponent);
+	auto high = mantissa > T(1.41421356f);
+	mantissa = MathSelect(high, mantissa * T(0.5f), mantissa);
+	exponent = MathSelect(high, exponent + T(1.0f), exponent);
+
+	T t = (mantissa - T(1.0f)) / (mantissa + T(1.0f));
+	T t2 = t * t;
+	T p;
+	if (TIER == GLSL_MATH_FAST)
+		p = T(9.7912806373e-01f) * t2 + T(2.8853258665e+00f);
+	else
+		p = ((T(4.3173555150e-01f) * t2 + T(5.7671439883e-01f)) * t2 + T(9.6179884747e-01f)) * t2 + T(2.8853900798e+00f);
+	T ret = exponent + t * p;
+
+	// zero and denormals give -infinity like on a GPU, negative numbers and NaN give NaN
+	const T infinity = T(std::numeric_limits<float>::infinity());
+	ret = MathSelect(x < T(FLT_MIN), -infinity, ret);
+	ret = MathSelect(!(x >= T(0.0f)), T(std::numeric_limits<float>::quiet_NaN()), ret);
+	return MathSelect(x == infinity, infinity, ret);
+}
+
+//-------------------------------------------------------------------------------------
+// sin(2 pi turns)
+template <int TIER, typename T>
+T ApproxSinTurns (T turns)
+{
+	// bring the angle into [-1/2, 1/2] turns, then fold it into [-1/4, 1/4] with
+	// sin(pi - a) = sin(a)
+	T q = turns - MathFloor(turns + T(0.5f));
+	T half = MathSelect(q < T(0.0f), T(-0.5f), T(0.5f));
+	q = MathSelect(MathAbs(q) > T(0.25f), half - q, q);
+
+	T q2 = q * q;
+	T p;
+	if (TIER == GLSL_MATH_FAST)
+		p = (T(7.3585519466e+01f) * q2 + T(-4.1095243089e+01f)) * q2 + T(6.2812800840e+00f);
+	else
+		p = (((T(3.9536631280e+01f) * q2 + T(-7.6549771624e+01f)) * q2 + T(8.1601003564e+01f)) * q2
+			+ T(-4.1341655022e+01f)) * q2 + T(6.2831851600e+00f);
+	return q * p;
+}
+
+//-------------------------------------------------------------------------------------
+// atan(y / x) in the quadrant of (x, y), like atan2
+template <int TIER, typename T>
+T ApproxAtan2 (T y, T x)
+{
+	// the polynomial covers [0, 1], the rest comes from atan(a) = pi/2 - atan(1/a) and the
+	// quadrant. atan(0, 0) is 0.
+	T absX = MathAbs(x);
+	T absY = MathAbs(y);
+	T high = MathMax(absX, absY);
+	T a = MathMin(absX, absY) / high;
+	a = MathSelect(high == T(0.0f), T(0.0f), a);
+
+	T a2 = a * a;
+	T p;
+	if (TIER == GLSL_MATH_FAST)
+		p = ((T(-3.8986510217e-02f) * a2 + T(1.4626445956e-01f)) * a2 + T(-3.2117496971e-01f)) * a2 + T(9.9921381326e-01f);
+	else
+		p = ((((((T(-4.0547441777e-03f) * a2 + T(2.1863626677e-02f)) * a2 + T(-5.5913339413e-02f)) * a2
+			+ T(9.6422755783e-02f)) * a2 + T(-1.3908662030e-01f)) * a2 + T(1.9946572603e-01f)) * a2
+			+ T(-3.3329861445e-01f)) * a2 + T(9.9999933576e-01f);
+	T ret = a * p;
+
+	ret = MathSelect(absY > absX, T(1.57079633f) - ret, ret);
+	ret = MathSelect(x < T(0.0f), T(3.14159265f) - ret, ret);
+	return MathSelect(y < T(0.0f), -ret, ret);
+}
+
+//-------------------------------------------------------------------------------------
+template <int TIER, typename T> T ApproxSin (T x) { return ApproxSinTurns<TIER>(x * T(0.159154943f)); }
+template <int TIER, typename T> T ApproxCos (T x) { return ApproxSinTurns<TIER>(x * T(0.159154943f) + T(0.25f)); }
+template <int TIER, typename T> T ApproxTan (T x) { return ApproxSin<TIER>(x) / ApproxCos<TIER>(x); }
+template <int TIER, typename T> T ApproxAtan (T x) { return ApproxAtan2<TIER>(x, T(1.0f)); }
+template <int TIER, typename T> T ApproxExp (T x) { return ApproxExp2<TIER>(x * T(1.44269504f)); }
+template <int TIER, typename T> T ApproxLog (T x) { return ApproxLog2<TIER>(x) * T(0.693147181f); }
+template <int TIER, typename T> T ApproxPow (T x, T y) { return ApproxExp2<TIER>(y * ApproxLog2<TIER>(x)); }
+
+//-------------------------------------------------------------------------------------
+// The hyperbolic functions from exp and log, the way a GPU expands them. tanh clamps its
+// argument first, beyond which it is 1 in float anyway, so exp can't overflow to inf/inf.
+template <int TIER, typename T>
+T ApproxSinh (T x)
+{
+	T e = ApproxExp<TIER>(x);
+	return (e - T(1.0f) / e) * T(0.5f);
+}
+
+template <int TIER, typename T>
+T ApproxCosh (T x)
+{
+	T e = ApproxExp<TIER>(x);
+	return (e + T(1.0f) / e) * T(0.5f);
+}
+
+template <int TIER, typename T>
+T ApproxTanh (T x)
+{
+	T e = ApproxExp<TIER>(MathMin(T(10.0f), MathMax(T(-10.0f), x)) * T(2.0f));
+	return (e - T(1.0f)) / (e + T(1.0f));
+}
+
+template <int TIER, typename T>
+T ApproxAsinh (T x)
+{
+	T a = MathAbs(x);
+	T ret = ApproxLog<TIER>(a + MathSqrt(a * a + T(1.0f)));
+	return MathSelect(x < T(0.0f), -ret, ret);
+}
+
+template <int TIER, typename T> T ApproxAcosh (T x) { return ApproxLog<TIER>(x + MathSqrt(x * x - T(1.0f))); }
+template <int TIER, typename T> T ApproxAtanh (T x) { return ApproxLog<TIER>((T(1.0f) + x) / (T(1.0f) - x)) * T(0.5f); }
+
+//-------------------------------------------------------------------------------------
+// asin and acos are NaN outside [-1, 1]
+template <int TIER, typename T>
+T ApproxAsin (T x)
+{
+	T ret = ApproxAtan2<TIER>(x, MathSqrt((T(1.0f) - x) * (T(1.0f) + x)));
+	return MathSelect(!(MathAbs(x) <= T(1.0f)), T(std::numeric_limits<float>::quiet_NaN()), ret);
+}
+
+template <int TIER, typename T>
+T ApproxAcos (T x)
+{
+	T ret = ApproxAtan2<TIER>(MathSqrt((T(1.0f) - x) * (T(1.0f) + x)), x);
+	return MathSelect(!(MathAbs(x) <= T(1.0f)), T(std::numeric_limits<float>::quiet_NaN()), ret);
+}
+
+//-------------------------------------------------------------------------------------
+// GLSL's definition of mod, which doesn't take the sign of x
+template <typename T> T ApproxMod (T x, T y) { return x - y * MathFloor(x / y); }
+
+//-------------------------------------------------------------------------------------
+// The exact tier's mod, the C library's fmod moved to GLSL's convention of taking the
+// sign of y. fmod itself is exact, so this is the true remainder rounded once.
+inline float ExactMod (float x, float y)
+{
+	float ret = std::fmod(x, y);
+	if (ret != 0.0f && (ret < 0.0f) != (y < 0.0f))
+		ret += y;
+	return ret;
+}
+
+//-------------------------------------------------------------------------------------
+// The builtins in the tier of this build, for a float. glslPacket.h has the same for
+// packets, and glslAdapters.h makes sin() etc in shader code call these.
+//-------------------------------------------------------------------------------------
+#if GLSL_MATH_PRECISION == GLSL_MATH_EXACT
+
+inline float MathSin (float x) { return std::sin(x); }
+inline float MathCos (float x) { return std::cos(x); }
+inline float MathTan (float x) { return std::tan(x); }
+inline float MathAsin (float x) { return std::asin(x); }
+inline float MathAcos (float x) { return std::acos(x); }
+inline float MathAtan (float x) { return std::atan(x); }
+inline float MathAtan2 (float y, float x) { return std::atan2(y, x); }
+inline float MathExp (float x) { return std::exp(x); }
+inline float MathLog (float x) { return std::log(x); }
+inline float MathExp2 (float x) { return std::exp2(x); }
+inline float MathLog2 (float x) { return std::log2(x); }
+inline float MathPow (float x, float y) { return std::pow(x, y); }
+inline float MathSinh (float x) { return std::sinh(x); }
+inline float MathCosh (float x) { return std::cosh(x); }
+inline float MathTanh (float x) { return std::tanh(x); }
+inline float MathAsinh (float x) { return std::asinh(x); }
+inline float MathAcosh (float x) { return std::acosh(x); }
+inline float MathAtanh (float x) { return std::atanh(x); }
+
+inline float MathMod (float x, float y) { return ExactMod(x, y); }
+
+#else
+
+inline float MathSin (float x) { return ApproxSin<GLSL_MATH_PRECISION>(x); }
+inline float MathCos (float x) { return ApproxCos<GLSL_MATH_PRECISION>(x); }
+inline float MathTan (float x) { return ApproxTan<GLSL_MATH_PRECISION>(x); }
+inline float MathAsin (float x) { return ApproxAsin<GLSL_MATH_PRECISION>(x); }
+inline float MathAcos (float x) { return ApproxAcos<GLSL_MATH_PRECISION>(x); }
+inline float MathAtan (float x) { return ApproxAtan<GLSL_MATH_PRECISION>(x); }
+inline float MathAtan2 (float y, float x) { return ApproxAtan2<GLSL_MATH_PRECISION>(y, x); }
+inline float MathExp (float x) { return ApproxExp<GLSL_MATH_PRECISION>(x); }
+inline float MathLog (float x) { return ApproxLog<GLSL_MATH_PRECISION>(x); }
+inline float MathExp2 (float x) { return ApproxExp2<GLSL_MATH_PRECISION>(x); }
+inline float MathLog2 (float x) { return ApproxLog2<GLSL_MATH_PRECISION>(x); }
+inline float MathPow (float x, float y) { return ApproxPow<GLSL_MATH_PRECISION>(x, y); }
+inline float MathSinh (float x) { return ApproxSinh<GLSL_MATH_PRECISION>(x); }
+inline float MathCosh (float x) { return ApproxCosh<GLSL_MATH_PRECISION>(x); }
+inline float MathTanh (float x) { return ApproxTanh<GLSL_MATH_PRECISION>(x); }
+inline float MathAsinh (float x) { return ApproxAsinh<GLSL_MATH_PRECISION>(x); }
+inline float MathAcosh (float x) { return ApproxAcosh<GLSL_MATH_PRECISION>(x); }
+inline float MathAtanh (float x) { return ApproxAtanh<GLSL_MATH_PRECISION>(x); }
+
+inline float MathMod (float x, float y) { return ApproxMod(x, y); }
+
+#endif
+
+// GPUs have an instruction for it, but 1/sqrt is as fast as an estimate plus refinement
+// on a CPU and gives the same bits on every instruction set
+inline float MathInverseSqrt (float x) { return 1.0f / std::sqrt(x); }
+
+// fract is x - floor(x) in every tier. That subtraction is exact except when a tiny
+// negative x rounds up to 1.0, which GLSL's definition does too, and it is much cheaper
+// than going through fmod.
+template <typename T> T MathFract (T x) { return x - MathFloor(x); }
@@ -0,0 +1,600 @@
+#pragma once
+
+// Packet execution mode. SFloatPacket holds one float per pixel for GLSL_PACKET_WIDTH
+// pixels, and tvecN<SFloatPacket> is the structure-of-arrays vector over those lanes.
+// mainPacket.cpp compiles the shader in main.cpp a second time with float standing for
+// SFloatPacket, so the same source shades a whole packet of pixels per call.
+//
+// Comparisons give an SMaskPacket. Branching on a mask (if, ?:, &&, ||) is fine as long
+// as every lane agrees. When lanes disagree the packet is flagged as diverged and the
+// renderer shades those pixels again one at a time on the scalar path, so divergent
+// if/return in shader code still gives correct results.
+//
+// The instruction set is picked from the compiler's target flags: AVX-512 (16 lanes),
+// AVX2 (8 lanes), SSE2 (4 lanes), or a plain C++ fallback (4 lanes). Define
+// GLSL_PACKET_FORCE_SCALAR to use the fallback regardless.
+
+#include "glslAdapters.h"
+#include <stdint.h>
+
+#if !defined(GLSL_PACKET_FORCE_SCALAR) && defined(__AVX512F__)
+	#define GLSL_PACKET_AVX512 1
+	#define GLSL_PACKET_WIDTH 16
+	#include <immintrin.h>
+#elif !defined(GLSL_PACKET_FORCE_SCALAR) && defined(__AVX2__)
+	#define GLSL_PACKET_AVX2 1
+	#define GLSL_PACKET_WIDTH 8
+	#include <immintrin.h>
+#elif !defined(GLSL_PACKET_FORCE_SCALAR) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define GLSL_PACKET_SSE2 1
+	#define GLSL_PACKET_WIDTH 4
+	#include <emmintrin.h>
+	#if defined(__SSE4_1__) || defined(__AVX__)
+		#include <smmintrin.h>
+	#endif
+#else
+	#define GLSL_PACKET_SCALAR 1
+	#define GLSL_PACKET_WIDTH 4
+#endif
+
+// The pixel footprint of a packet. Lane i shades pixel (i % width, i / width), so a packet
+// covers a small square-ish block, which keeps lanes coherent.
+#if GLSL_PACKET_WIDTH == 16
+	const size_t c_packetWidthPixels = 4;
+	const size_t c_packetHeightPixels = 4;
+#elif GLSL_PACKET_WIDTH == 8
+	const size_t c_packetWidthPixels = 4;
+	const size_t c_packetHeightPixels = 2;
+#else
+	const size_t c_packetWidthPixels = 2;
+	const size_t c_packetHeightPixels = 2;
+#endif
+
+//-------------------------------------------------------------------------------------
+// Register level operations for each instruction set. Comparisons return one bit per lane.
+//-------------------------------------------------------------------------------------
+#if GLSL_PACKET_AVX512
+
+typedef __m512 TPacketRegister;
+
+inline TPacketRegister PacketSet1 (float f) { return _mm512_set1_ps(f); }
+inline TPacketRegister PacketLoad (const float* lanes) { return _mm512_loadu_ps(lanes); }
+inline void PacketStore (float* lanes, TPacketRegister a) { _mm512_storeu_ps(lanes, a); }
+inline TPacketRegister PacketAdd (TPacketRegister a, TPacketRegister b) { return _mm512_add_ps(a, b); }
+inline TPacketRegister PacketSub (TPacketRegister a, TPacketRegister b) { return _mm512_sub_ps(a, b); }
+inline TPacketRegister PacketMul (TPacketRegister a, TPacketRegister b) { return _mm512_mul_ps(a, b); }
+inline TPacketRegister PacketDiv (TPacketRegister a, TPacketRegister b) { return _mm512_div_ps(a, b); }
+inline TPacketRegister PacketMin (TPacketRegister a, TPacketRegister b) { return _mm512_min_ps(a, b); }
+inline TPacketRegister PacketMax (TPacketRegister a, TPacketRegister b) { return _mm512_max_ps(a, b); }
+inline TPacketRegister PacketSqrt (TPacketRegister a) { return _mm512_sqrt_ps(a); }
+inline TPacketRegister PacketFloor (TPacketRegister a) { return _mm512_roundscale_ps(a, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline TPacketRegister PacketNeg (TPacketRegister a) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi32(int(0x80000000)))); }
+inline TPacketRegister PacketAbs (TPacketRegister a) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+inline uint32_t PacketLess (TPacketRegister a, TPacketRegister b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+inline uint32_t PacketLessEqual (TPacketRegister a, TPacketRegister b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+inline uint32_t PacketEqual (TPacketRegister a, TPacketRegister b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+inline uint32_t PacketNotEqual (TPacketRegister a, TPacketRegister b) { return _mm512_cmp_ps_mask(a, b, _CMP_NEQ_UQ); }
+inline TPacketRegister PacketSelect (uint32_t mask, TPacketRegister ifFalse, TPacketRegister ifTrue) { return _mm512_mask_blend_ps(__mmask16(mask), ifFalse, ifTrue); }
+inline TPacketRegister PacketPow2i (TPacketRegister n) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23)); }
+inline TPacketRegister PacketSplitExponent (TPacketRegister a, TPacketRegister& exponent)
+{
+	__m512i bits = _mm512_castps_si512(a);
+	exponent = _mm512_cvtepi32_ps(_mm512_sub_epi32(_mm512_and_si512(_mm512_srli_epi32(bits, 23), _mm512_set1_epi32(0xff)), _mm512_set1_epi32(127)));
+	return _mm512_castsi512_ps(_mm512_or_si512(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f800000)));
+}
+// right minus left and top minus bottom within each 2x2 quad of lanes. A row is 128 bits.
+inline TPacketRegister PacketQuadDifferenceX (TPacketRegister a) { return _mm512_sub_ps(_mm512_permute_ps(a, 0xf5), _mm512_permute_ps(a, 0xa0)); }
+inline TPacketRegister PacketQuadDifferenceY (TPacketRegister a) { return _mm512_sub_ps(_mm512_shuffle_f32x4(a, a, _MM_SHUFFLE(3, 3, 1, 1)), _mm512_shuffle_f32x4(a, a, _MM_SHUFFLE(2, 2, 0, 0))); }
+
+#elif GLSL_PACKET_AVX2
+
+typedef __m256 TPacketRegister;
+
+inline TPacketRegister PacketSet1 (float f) { return _mm256_set1_ps(f); }
+inline TPacketRegister PacketLoad (const float* lanes) { return _mm256_loadu_ps(lanes); }
+inline void PacketStore (float* lanes, TPacketRegister a) { _mm256_storeu_ps(lanes, a); }
+inline TPacketRegister PacketAdd (TPacketRegister a, TPacketRegister b) { return _mm256_add_ps(a, b); }
+inline TPacketRegister PacketSub (TPacketRegister a, TPacketRegister b) { return _mm256_sub_ps(a, b); }
+inline TPacketRegister PacketMul (TPacketRegister a, TPacketRegister b) { return _mm256_mul_ps(a, b); }
+inline TPacketRegister PacketDiv (TPacketRegister a, TPacketRegister b) { return _mm256_div_ps(a, b); }
+inline TPacketRegister PacketMin (TPacketRegister a, TPacketRegister b) { return _mm256_min_ps(a, b); }
+inline TPacketRegister PacketMax (TPacketRegister a, TPacketRegister b) { return _mm256_max_ps(a, b); }
+inline TPacketRegister PacketSqrt (TPacketRegister a) { return _mm256_sqrt_ps(a); }
+inline TPacketRegister PacketFloor (TPacketRegister a) { return _mm256_floor_ps(a); }
+inline TPacketRegister PacketNeg (TPacketRegister a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+inline TPacketRegister PacketAbs (TPacketRegister a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+inline uint32_t PacketLess (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ))); }
+inline uint32_t PacketLessEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ))); }
+inline uint32_t PacketEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ))); }
+inline uint32_t PacketNotEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_NEQ_UQ))); }
+inline TPacketRegister PacketSelect (uint32_t mask, TPacketRegister ifFalse, TPacketRegister ifTrue)
+{
+	// spread the mask bits back out to one all-ones or all-zeros lane each
+	const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256i laneMask = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int(mask)), laneBits), laneBits);
+	return _mm256_blendv_ps(ifFalse, ifTrue, _mm256_castsi256_ps(laneMask));
+}
+inline TPacketRegister PacketPow2i (TPacketRegister n) { return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23)); }
+inline TPacketRegister PacketSplitExponent (TPacketRegister a, TPacketRegister& exponent)
+{
+	__m256i bits = _mm256_castps_si256(a);
+	exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_and_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0xff)), _mm256_set1_epi32(127)));
+	return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+}
+// right minus left and top minus bottom within each 2x2 quad of lanes. A row is 128 bits.
+inline TPacketRegister PacketQuadDifferenceX (TPacketRegister a) { return _mm256_sub_ps(_mm256_permute_ps(a, 0xf5), _mm256_permute_ps(a, 0xa0)); }
+inline TPacketRegister PacketQuadDifferenceY (TPacketRegister a) { return _mm256_sub_ps(_mm256_permute2f128_ps(a, a, 0x11), _mm256_permute2f128_ps(a, a, 0x00)); }
+
+#elif GLSL_PACKET_SSE2
+
+typedef __m128 TPacketRegister;
+
+inline TPacketRegister PacketSet1 (float f) { return _mm_set1_ps(f); }
+inline TPacketRegister PacketLoad (const float* lanes) { return _mm_loadu_ps(lanes); }
+inline void PacketStore (float* lanes, TPacketRegister a) { _mm_storeu_ps(lanes, a); }
+inline TPacketRegister PacketAdd (TPacketRegister a, TPacketRegister b) { return _mm_add_ps(a, b); }
+inline TPacketRegister PacketSub (TPacketRegister a, TPacketRegister b) { return _mm_sub_ps(a, b); }
+inline TPacketRegister PacketMul (TPacketRegister a, TPacketRegister b) { return _mm_mul_ps(a, b); }
+inline TPacketRegister PacketDiv (TPacketRegister a, TPacketRegister b) { return _mm_div_ps(a, b); }
+inline TPacketRegister PacketMin (TPacketRegister a, TPacketRegister b) { return _mm_min_ps(a, b); }
+inline TPacketRegister PacketMax (TPacketRegister a, TPacketRegister b) { return _mm_max_ps(a, b); }
+inline TPacketRegister PacketSqrt (TPacketRegister a) { return _mm_sqrt_ps(a); }
+inline TPacketRegister PacketNeg (TPacketRegister a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline TPacketRegister PacketAbs (TPacketRegister a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline uint32_t PacketLess (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm_movemask_ps(_mm_cmplt_ps(a, b))); }
+inline uint32_t PacketLessEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm_movemask_ps(_mm_cmple_ps(a, b))); }
+inline uint32_t PacketEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm_movemask_ps(_mm_cmpeq_ps(a, b))); }
+inline uint32_t PacketNotEqual (TPacketRegister a, TPacketRegister b) { return uint32_t(_mm_movemask_ps(_mm_cmpneq_ps(a, b))); }
+inline TPacketRegister PacketSelect (uint32_t mask, TPacketRegister ifFalse, TPacketRegister ifTrue)
+{
+	// spread the mask bits back out to one all-ones or all-zeros lane each
+	const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+	__m128 laneMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(int(mask)), laneBits), laneBits));
+	return _mm_or_ps(_mm_and_ps(laneMask, ifTrue), _mm_andnot_ps(laneMask, ifFalse));
+}
+inline TPacketRegister PacketPow2i (TPacketRegister n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23)); }
+inline TPacketRegister PacketSplitExponent (TPacketRegister a, TPacketRegister& exponent)
+{
+	__m128i bits = _mm_castps_si128(a);
+	exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127)));
+	return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+}
+// right minus left and top minus bottom within the 2x2 quad of lanes
+inline TPacketRegister PacketQuadDifferenceX (TPacketRegister a) { return _mm_sub_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0))); }
+inline TPacketRegister PacketQuadDifferenceY (TPacketRegister a) { return _mm_sub_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 2, 3, 2)), _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 1, 0))); }
+#if defined(__SSE4_1__) || defined(__AVX__)
+inline TPacketRegister PacketFloor (TPacketRegister a) { return _mm_floor_ps(a); }
+#else
+inline TPacketRegister PacketFloor (TPacketRegister a)
+{
+	float lanes[4];
+	_mm_storeu_ps(lanes, a);
+	for (size_t i = 0; i < 4; ++i)
+		lanes[i] = std::floor(lanes[i]);
+	return _mm_loadu_ps(lanes);
+}
+#endif
+
+#else // GLSL_PACKET_SCALAR
+
+struct TPacketRegister
+{
+	float m_lanes[GLSL_PACKET_WIDTH];
+};
+
+#define GLSL_PACKET_LANEWISE(expression) \
+	TPacketRegister ret; \
+	for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i) \
+		ret.m_lanes[i] = expression; \
+	return ret;
+
+#define GLSL_PACKET_COMPARE(expression) \
+	uint32_t ret = 0; \
+	for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i) \
+		ret |= (expression) ? (1u << i) : 0u; \
+	return ret;
+
+inline TPacketRegister PacketSet1 (float f) { GLSL_PACKET_LANEWISE(f) }
+inline TPacketRegister PacketLoad (const float* lanes) { GLSL_PACKET_LANEWISE(lanes[i]) }
+inline void PacketStore (float* lanes, TPacketRegister a) { for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i) lanes[i] = a.m_lanes[i]; }
+inline TPacketRegister PacketAdd (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] + b.m_lanes[i]) }
+inline TPacketRegister PacketSub (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] - b.m_lanes[i]) }
+inline TPacketRegister PacketMul (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] * b.m_lanes[i]) }
+inline TPacketRegister PacketDiv (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] / b.m_lanes[i]) }
+inline TPacketRegister PacketMin (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] < b.m_lanes[i] ? a.m_lanes[i] : b.m_lanes[i]) }
+inline TPacketRegister PacketMax (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_LANEWISE(a.m_lanes[i] > b.m_lanes[i] ? a.m_lanes[i] : b.m_lanes[i]) }
+inline TPacketRegister PacketSqrt (TPacketRegister a) { GLSL_PACKET_LANEWISE(std::sqrt(a.m_lanes[i])) }
+inline TPacketRegister PacketFloor (TPacketRegister a) { GLSL_PACKET_LANEWISE(std::floor(a.m_lanes[i])) }
+inline TPacketRegister PacketNeg (TPacketRegister a) { GLSL_PACKET_LANEWISE(-a.m_lanes[i]) }
+inline TPacketRegister PacketAbs (TPacketRegister a) { GLSL_PACKET_LANEWISE(std::fabs(a.m_lanes[i])) }
+inline uint32_t PacketLess (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_COMPARE(a.m_lanes[i] < b.m_lanes[i]) }
+inline uint32_t PacketLessEqual (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_COMPARE(a.m_lanes[i] <= b.m_lanes[i]) }
+inline uint32_t PacketEqual (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_COMPARE(a.m_lanes[i] == b.m_lanes[i]) }
+inline uint32_t PacketNotEqual (TPacketRegister a, TPacketRegister b) { GLSL_PACKET_COMPARE(a.m_lanes[i] != b.m_lanes[i]) }
+inline TPacketRegister PacketSelect (uint32_t mask, TPacketRegister ifFalse, TPacketRegister ifTrue) { GLSL_PACKET_LANEWISE((mask & (1u << i)) ? ifTrue.m_lanes[i] : ifFalse.m_lanes[i]) }
+inline TPacketRegister PacketPow2i (TPacketRegister n) { GLSL_PACKET_LANEWISE(MathPow2i(n.m_lanes[i])) }
+inline TPacketRegister PacketSplitExponent (TPacketRegister a, TPacketRegister& exponent) { GLSL_PACKET_LANEWISE(MathSplitExponent(a.m_lanes[i], exponent.m_lanes[i])) }
+inline TPacketRegister PacketQuadDifferenceX (TPacketRegister a) { GLSL_PACKET_LANEWISE(a.m_lanes[i | 1] - a.m_lanes[i & ~size_t(1)]) }
+inline TPacketRegister PacketQuadDifferenceY (TPacketRegister a) { GLSL_PACKET_LANEWISE(a.m_lanes[i | c_packetWidthPixels] - a.m_lanes[i & ~c_packetWidthPixels]) }
+
+#undef GLSL_PACKET_LANEWISE
+#undef GLSL_PACKET_COMPARE
+
+#endif
+
+//-------------------------------------------------------------------------------------
+// Set when a packet branched on a mask whose lanes disagree. The renderer clears it
+// before shading a packet and falls back to the scalar path for that packet if it's set.
+inline bool& PacketDiverged ()
+{
+	static thread_local bool s_diverged = false;
+	return s_diverged;
+}
+
+//-------------------------------------------------------------------------------------
+// One bool per lane, stored as one bit per lane
+//-------------------------------------------------------------------------------------
+struct SMaskPacket
+{
+	static const uint32_t c_allLanes = uint32_t((uint64_t(1) << GLSL_PACKET_WIDTH) - 1);
+
+	// left uninitialized like a bool, so masks can live in the bvec unions
+	SMaskPacket() = default;
+	explicit SMaskPacket(uint32_t bits)
+		: m_bits(bits)
+	{ }
+
+	// Used when shader code branches on a comparison. Only meaningful if all lanes agree,
+	// otherwise the packet gets flagged so the renderer can redo it one pixel at a time.
+	explicit operator bool() const
+	{
+		if (m_bits == 0)
+			return false;
+		if (m_bits != c_allLanes)
+			PacketDiverged() = true;
+		return true;
+	}
+
+	uint32_t m_bits;
+};
+
+inline SMaskPacket operator && (SMaskPacket a, SMaskPacket b) { return SMaskPacket(a.m_bits & b.m_bits); }
+inline SMaskPacket operator || (SMaskPacket a, SMaskPacket b) { return SMaskPacket(a.m_bits | b.m_bits); }
+inline SMaskPacket operator ! (SMaskPacket a) { return SMaskPacket(~a.m_bits & SMaskPacket::c_allLanes); }
+inline bool any (SMaskPacket a) { return a.m_bits != 0; }
+inline bool all (SMaskPacket a) { return a.m_bits == SMaskPacket::c_allLanes; }
+
+//-------------------------------------------------------------------------------------
+// One float per lane
+//-------------------------------------------------------------------------------------
+struct SFloatPacket
+{
+	static const size_t c_numLanes = GLSL_PACKET_WIDTH;
+
+	// left uninitialized like a float, so packets can live in the vector unions
+	SFloatPacket() = default;
+	SFloatPacket(float f)
+		: m_value(PacketSet1(f))
+	{ }
+	explicit SFloatPacket(TPacketRegister value)
+		: m_value(value)
+	{ }
+
+	static SFloatPacket Load(const float* lanes) { return SFloatPacket(PacketLoad(lanes)); }
+	void Store(float* lanes) const { PacketStore(lanes, m_value); }
+
+	SFloatPacket& operator += (const SFloatPacket& b) { m_value = PacketAdd(m_value, b.m_value); return *this; }
+	SFloatPacket& operator -= (const SFloatPacket& b) { m_value = PacketSub(m_value, b.m_value); return *this; }
+	SFloatPacket& operator *= (const SFloatPacket& b) { m_value = PacketMul(m_value, b.m_value); return *this; }
+	SFloatPacket& operator /= (const SFloatPacket& b) { m_value = PacketDiv(m_value, b.m_value); return *this; }
+
+	TPacketRegister m_value;
+};
+
+// A packet is a genType (see glslAdapters.h), so distance, reflect etc take packets too
+template <> struct SIsGenType<SFloatPacket> { static const bool value = true; };
+
+inline SFloatPacket operator - (const SFloatPacket& a) { return SFloatPacket(PacketNeg(a.m_value)); }
+inline SFloatPacket operator + (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketAdd(a.m_value, b.m_value)); }
+inline SFloatPacket operator - (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketSub(a.m_value, b.m_value)); }
+inline SFloatPacket operator * (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketMul(a.m_value, b.m_value)); }
+inline SFloatPacket operator / (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketDiv(a.m_value, b.m_value)); }
+
+inline SMaskPacket operator < (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketLess(a.m_value, b.m_value)); }
+inline SMaskPacket operator <= (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketLessEqual(a.m_value, b.m_value)); }
+inline SMaskPacket operator > (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketLess(b.m_value, a.m_value)); }
+inline SMaskPacket operator >= (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketLessEqual(b.m_value, a.m_value)); }
+inline SMaskPacket operator == (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketEqual(a.m_value, b.m_value)); }
+inline SMaskPacket operator != (const SFloatPacket& a, const SFloatPacket& b) { return SMaskPacket(PacketNotEqual(a.m_value, b.m_value)); }
+
+//-------------------------------------------------------------------------------------
+// Masked selection, for writing branch free shader code that never diverges
+//-------------------------------------------------------------------------------------
+inline SFloatPacket select (SMaskPacket mask, const SFloatPacket& ifTrue, const SFloatPacket& ifFalse)
+{
+	return SFloatPacket(PacketSelect(mask.m_bits, ifFalse.m_value, ifTrue.m_value));
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket mix (const SFloatPacket& a, const SFloatPacket& b, SMaskPacket mask)
+{
+	return select(mask, b, a);
+}
+
+//-------------------------------------------------------------------------------------
+// Runs a scalar function on each lane. Used for the C library's transcendentals, so each
+// lane gets exactly the value the scalar path computes.
+//-------------------------------------------------------------------------------------
+template <typename F>
+SFloatPacket PacketPerLane (const SFloatPacket& a, F function)
+{
+	float lanes[GLSL_PACKET_WIDTH];
+	a.Store(lanes);
+	for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i)
+		lanes[i] = function(lanes[i]);
+	return SFloatPacket::Load(lanes);
+}
+
+//-------------------------------------------------------------------------------------
+template <typename F>
+SFloatPacket PacketPerLane (const SFloatPacket& a, const SFloatPacket& b, F function)
+{
+	float lanesA[GLSL_PACKET_WIDTH];
+	float lanesB[GLSL_PACKET_WIDTH];
+	a.Store(lanesA);
+	b.Store(lanesB);
+	for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i)
+		lanesA[i] = function(lanesA[i], lanesB[i]);
+	return SFloatPacket::Load(lanesA);
+}
+
+//-------------------------------------------------------------------------------------
+template <typename F>
+SFloatPacket PacketPerLane (const SFloatPacket& a, const SFloatPacket& b, const SFloatPacket& c, F function)
+{
+	float lanesA[GLSL_PACKET_WIDTH];
+	float lanesB[GLSL_PACKET_WIDTH];
+	float lanesC[GLSL_PACKET_WIDTH];
+	a.Store(lanesA);
+	b.Store(lanesB);
+	c.Store(lanesC);
+	for (size_t i = 0; i < GLSL_PACKET_WIDTH; ++i)
+		lanesA[i] = function(lanesA[i], lanesB[i], lanesC[i]);
+	return SFloatPacket::Load(lanesA);
+}
+
+//-------------------------------------------------------------------------------------
+// The primitives the approximations of glslMath.h are built from, so the same templates
+// shade packets
+//-------------------------------------------------------------------------------------
+inline SFloatPacket MathSelect (SMaskPacket condition, const SFloatPacket& ifTrue, const SFloatPacket& ifFalse) { return select(condition, ifTrue, ifFalse); }
+inline SFloatPacket MathMin (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketMin(a.m_value, b.m_value)); }
+inline SFloatPacket MathMax (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketMax(a.m_value, b.m_value)); }
+inline SFloatPacket MathFloor (const SFloatPacket& a) { return SFloatPacket(PacketFloor(a.m_value)); }
+inline SFloatPacket MathAbs (const SFloatPacket& a) { return SFloatPacket(PacketAbs(a.m_value)); }
+inline SFloatPacket MathSqrt (const SFloatPacket& a) { return SFloatPacket(PacketSqrt(a.m_value)); }
+inline SFloatPacket MathPow2i (const SFloatPacket& n) { return SFloatPacket(PacketPow2i(n.m_value)); }
+inline SFloatPacket MathSplitExponent (const SFloatPacket& a, SFloatPacket& exponent) { return SFloatPacket(PacketSplitExponent(a.m_value, exponent.m_value)); }
+
+//-------------------------------------------------------------------------------------
+// The builtins in the precision tier of this build (see glslMath.h). The exact tier runs
+// the C library on each lane, so each lane gets exactly the value the scalar path computes.
+//-------------------------------------------------------------------------------------
+#if GLSL_MATH_PRECISION == GLSL_MATH_EXACT
+
+inline SFloatPacket MathSin (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathSin(x); }); }
+inline SFloatPacket MathCos (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathCos(x); }); }
+inline SFloatPacket MathTan (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathTan(x); }); }
+inline SFloatPacket MathAsin (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAsin(x); }); }
+inline SFloatPacket MathAcos (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAcos(x); }); }
+inline SFloatPacket MathAtan (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAtan(x); }); }
+inline SFloatPacket MathAtan2 (const SFloatPacket& y, const SFloatPacket& x) { return PacketPerLane(y, x, [](float a, float b) { return MathAtan2(a, b); }); }
+inline SFloatPacket MathExp (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathExp(x); }); }
+inline SFloatPacket MathLog (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathLog(x); }); }
+inline SFloatPacket MathExp2 (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathExp2(x); }); }
+inline SFloatPacket MathLog2 (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathLog2(x); }); }
+inline SFloatPacket MathPow (const SFloatPacket& a, const SFloatPacket& b) { return PacketPerLane(a, b, [](float x, float y) { return MathPow(x, y); }); }
+inline SFloatPacket MathMod (const SFloatPacket& a, const SFloatPacket& b) { return PacketPerLane(a, b, [](float x, float y) { return MathMod(x, y); }); }
+inline SFloatPacket MathSinh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathSinh(x); }); }
+inline SFloatPacket MathCosh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathCosh(x); }); }
+inline SFloatPacket MathTanh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathTanh(x); }); }
+inline SFloatPacket MathAsinh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAsinh(x); }); }
+inline SFloatPacket MathAcosh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAcosh(x); }); }
+inline SFloatPacket MathAtanh (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return MathAtanh(x); }); }
+
+#else
+
+inline SFloatPacket MathSin (const SFloatPacket& a) { return ApproxSin<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathCos (const SFloatPacket& a) { return ApproxCos<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathTan (const SFloatPacket& a) { return ApproxTan<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAsin (const SFloatPacket& a) { return ApproxAsin<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAcos (const SFloatPacket& a) { return ApproxAcos<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAtan (const SFloatPacket& a) { return ApproxAtan<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAtan2 (const SFloatPacket& y, const SFloatPacket& x) { return ApproxAtan2<GLSL_MATH_PRECISION>(y, x); }
+inline SFloatPacket MathExp (const SFloatPacket& a) { return ApproxExp<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathLog (const SFloatPacket& a) { return ApproxLog<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathExp2 (const SFloatPacket& a) { return ApproxExp2<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathLog2 (const SFloatPacket& a) { return ApproxLog2<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathPow (const SFloatPacket& a, const SFloatPacket& b) { return ApproxPow<GLSL_MATH_PRECISION>(a, b); }
+inline SFloatPacket MathMod (const SFloatPacket& a, const SFloatPacket& b) { return ApproxMod(a, b); }
+inline SFloatPacket MathSinh (const SFloatPacket& a) { return ApproxSinh<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathCosh (const SFloatPacket& a) { return ApproxCosh<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathTanh (const SFloatPacket& a) { return ApproxTanh<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAsinh (const SFloatPacket& a) { return ApproxAsinh<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAcosh (const SFloatPacket& a) { return ApproxAcosh<GLSL_MATH_PRECISION>(a); }
+inline SFloatPacket MathAtanh (const SFloatPacket& a) { return ApproxAtanh<GLSL_MATH_PRECISION>(a); }
+
+#endif
+
+inline SFloatPacket MathInverseSqrt (const SFloatPacket& a) { return SFloatPacket(1.0f) / MathSqrt(a); }
+
+//-------------------------------------------------------------------------------------
+// Functions
+//-------------------------------------------------------------------------------------
+inline SFloatPacket sqrt (const SFloatPacket& a) { return SFloatPacket(PacketSqrt(a.m_value)); }
+inline SFloatPacket inversesqrt (const SFloatPacket& a) { return MathInverseSqrt(a); }
+inline SFloatPacket abs (const SFloatPacket& a) { return SFloatPacket(PacketAbs(a.m_value)); }
+inline SFloatPacket floor (const SFloatPacket& a) { return SFloatPacket(PacketFloor(a.m_value)); }
+inline SFloatPacket min (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketMin(a.m_value, b.m_value)); }
+inline SFloatPacket max (const SFloatPacket& a, const SFloatPacket& b) { return SFloatPacket(PacketMax(a.m_value, b.m_value)); }
+
+inline SFloatPacket sin (const SFloatPacket& a) { return MathSin(a); }
+inline SFloatPacket cos (const SFloatPacket& a) { return MathCos(a); }
+inline SFloatPacket tan (const SFloatPacket& a) { return MathTan(a); }
+inline SFloatPacket asin (const SFloatPacket& a) { return MathAsin(a); }
+inline SFloatPacket acos (const SFloatPacket& a) { return MathAcos(a); }
+inline SFloatPacket atan (const SFloatPacket& a) { return MathAtan(a); }
+inline SFloatPacket atan (const SFloatPacket& y, const SFloatPacket& x) { return MathAtan2(y, x); }
+inline SFloatPacket exp (const SFloatPacket& a) { return MathExp(a); }
+inline SFloatPacket log (const SFloatPacket& a) { return MathLog(a); }
+inline SFloatPacket exp2 (const SFloatPacket& a) { return MathExp2(a); }
+inline SFloatPacket log2 (const SFloatPacket& a) { return MathLog2(a); }
+inline SFloatPacket pow (const SFloatPacket& a, const SFloatPacket& b) { return MathPow(a, b); }
+inline SFloatPacket mod (const SFloatPacket& a, const SFloatPacket& b) { return MathMod(a, b); }
+inline SFloatPacket fract (const SFloatPacket& a) { return MathFract(a); }
+inline SFloatPacket sinh (const SFloatPacket& a) { return MathSinh(a); }
+inline SFloatPacket cosh (const SFloatPacket& a) { return MathCosh(a); }
+inline SFloatPacket tanh (const SFloatPacket& a) { return MathTanh(a); }
+inline SFloatPacket asinh (const SFloatPacket& a) { return MathAsinh(a); }
+inline SFloatPacket acosh (const SFloatPacket& a) { return MathAcosh(a); }
+inline SFloatPacket atanh (const SFloatPacket& a) { return MathAtanh(a); }
+
+inline SFloatPacket radians (const SFloatPacket& a) { return a * SFloatPacket(0.0174532925f); }
+inline SFloatPacket degrees (const SFloatPacket& a) { return a * SFloatPacket(57.2957795f); }
+inline SFloatPacket ceil (const SFloatPacket& a) { return -floor(-a); }
+inline SFloatPacket trunc (const SFloatPacket& a) { return select(a < SFloatPacket(0.0f), ceil(a), floor(a)); }
+inline SFloatPacket round (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return std::round(x); }); }
+inline SFloatPacket roundEven (const SFloatPacket& a) { return PacketPerLane(a, [](float x) { return roundEven(x); }); }
+inline SFloatPacket dot (const SFloatPacket& a, const SFloatPacket& b) { return a * b; }
+inline SFloatPacket length (const SFloatPacket& a) { return abs(a); }
+inline SMaskPacket isnan (const SFloatPacket& a) { return a != a; }
+inline SMaskPacket isinf (const SFloatPacket& a) { return abs(a) == SFloatPacket(std::numeric_limits<float>::infinity()); }
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket sign (const SFloatPacket& a)
+{
+	return select(a > SFloatPacket(0.0f), SFloatPacket(1.0f), select(a < SFloatPacket(0.0f), SFloatPacket(-1.0f), SFloatPacket(0.0f)));
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket modf (const SFloatPacket& a, SFloatPacket& whole)
+{
+	whole = trunc(a);
+	return a - whole;
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket mix (const SFloatPacket& a, const SFloatPacket& b, const SFloatPacket& blend)
+{
+	return a * (SFloatPacket(1.0f) - blend) + b * blend;
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket clamp (const SFloatPacket& value, const SFloatPacket& min, const SFloatPacket& max)
+{
+	return select(value < min, min, select(value > max, max, value));
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket step (const SFloatPacket& threshold, const SFloatPacket& value)
+{
+	return select(value >= threshold, SFloatPacket(1.0f), SFloatPacket(0.0f));
+}
+
+//-------------------------------------------------------------------------------------
+inline SFloatPacket smoothstep (const SFloatPacket& min, const SFloatPacket& max, const SFloatPacket& value)
+{
+	SFloatPacket t = clamp((value - min) / (max - min), SFloatPacket(0.0f), SFloatPacket(1.0f));
+	return t * t * (SFloatPacket(3.0f) - SFloatPacket(2.0f) * t);
+}
+
+//-------------------------------------------------------------------------------------
+// Screen space derivatives, between the lanes of each 2x2 quad of pixels in the packet.
+// The renderer starts packets on even coordinates, so these are the quads a GPU (and
+// the scalar path) would use.
+//-------------------------------------------------------------------------------------
+inline SFloatPacket dFdx (const SFloatPacket& p) { return SFloatPacket(PacketQuadDifferenceX(p.m_value)); }
+inline SFloatPacket dFdy (const SFloatPacket& p) { return SFloatPacket(PacketQuadDifferenceY(p.m_value)); }
+inline SFloatPacket fwidth (const SFloatPacket& p) { return abs(dFdx(p)) + abs(dFdy(p)); }
+
+//-------------------------------------------------------------------------------------
+// The packet versions of the shader types and entry point, defined by compiling main.cpp
+// in mainPacket.cpp
+//-------------------------------------------------------------------------------------
+namespace Packet
+{
+	typedef tvec2<SFloatPacket> vec2;
+	typedef tvec3<SFloatPacket> vec3;
+	typedef tvec4<SFloatPacket> vec4;
+
+	// int isn't packetized, so integer vectors are packets of whole numbers stored as
+	// floats. texelFetch() truncates them per lane like the int conversion would.
+	typedef tvec2<SFloatPacket> ivec2;
+	typedef tvec3<SFloatPacket> ivec3;
+	typedef tvec4<SFloatPacket> ivec4;
+
+	// a bvec holds one mask per component, with a bit per lane
+	typedef tvec2<SMaskPacket> bvec2;
+	typedef tvec3<SMaskPacket> bvec3;
+	typedef tvec4<SMaskPacket> bvec4;
+
+	typedef tmat<SFloatPacket, 2, 2> mat2;
+	typedef tmat<SFloatPacket, 3, 3> mat3;
+	typedef tmat<SFloatPacket, 4, 4> mat4;
+	typedef tmat<SFloatPacket, 2, 2> mat2x2;
+	typedef tmat<SFloatPacket, 2, 3> mat2x3;
+	typedef tmat<SFloatPacket, 2, 4> mat2x4;
+	typedef tmat<SFloatPacket, 3, 2> mat3x2;
+	typedef tmat<SFloatPacket, 3, 3> mat3x3;
+	typedef tmat<SFloatPacket, 3, 4> mat3x4;
+	typedef tmat<SFloatPacket, 4, 2> mat4x2;
+	typedef tmat<SFloatPacket, 4, 3> mat4x3;
+	typedef tmat<SFloatPacket, 4, 4> mat4x4;
+
+	void mainImage(vec4& fragColor, vec2 fragCoord);
+
+	//-------------------------------------------------------------------------------------
+	// Texture lookups go a lane at a time through the scalar versions, since each lane
+	// reads from its own place in memory anyway
+	template <typename LAMBDA>
+	inline vec4 PacketTextureLookup (const vec2& coord, const LAMBDA& lookup)
+	{
+		float x[GLSL_PACKET_WIDTH];
+		float y[GLSL_PACKET_WIDTH];
+		float color[4][GLSL_PACKET_WIDTH];
+		coord.x.Store(x);
+		coord.y.Store(y);
+		for (size_t lane = 0; lane < GLSL_PACKET_WIDTH; ++lane)
+		{
+			::vec4 laneColor = lookup(lane, x[lane], y[lane]);
+			for (size_t channel = 0; channel < 4; ++channel)
+				color[channel][lane] = laneColor[channel];
+		}
+		return vec4(SFloatPacket::Load(color[0]), SFloatPacket::Load(color[1]), SFloatPacket::Load(color[2]), SFloatPacket::Load(color[3]));
+	}
+
+	//-------------------------------------------------------------------------------------
+	inline vec4 texture (const SSampler2D& sampler, const vec2& uv)
+	{
+		return PacketTextureLookup(uv, [&sampler](size_t, float u, float v) { return ::texture(sampler, ::vec2(u, v)); });
+	}
+
+	inline vec4 texture (const SSampler2D& sampler, const vec2& uv, SFloatPacket bias)
+	{
+		float laneBias[GLSL_PACKET_WIDTH];
+		bias.Store(laneBias);
+		return PacketTextureLookup(uv, [&sampler, &laneBias](size_t lane, float u, float v) { return ::texture(sampler, ::vec2(u, v), laneBias[lane]); });
+	}
+
+	inline vec4 textureLod (const SSampler2D& sampler, const vec2& uv, SFloatPacket lod)
+	{
+		float laneLod[GLSL_PACKET_WIDTH];
+		lod.Store(laneLod);
+		return PacketTextureLookup(uv, [&sampler, &laneLod](size_t lane, float u, float v) { return ::textureLod(sampler, ::vec2(u, v), laneLod[lane]); });
+	}
+
+	inline vec4 texelFetch (const SSampler2D& sampler, const ivec2& texel, int lod)
+	{
+		return PacketTextureLookup(texel, [&sampler, lod](size_t, float x, float y) { return ::texelFetch(sampler, ::ivec2(int(x), int(y)), lod); });
+	}
+}
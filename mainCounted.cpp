@@ -0,0 +1,41 @@
+// Compiles the shader in main.cpp (and any buffer passes) a third time, counting the
+// operations each pixel runs: float stands for SCountedFloat and vec2/vec3/vec4 resolve
+// to the Counted:: vectors, so the unchanged shader source adds to the op counts as it
+// shades. Only -opcounts renders call it. See glslCounted.h.
+
+#include "glslCounted.h"
+#include "Settings.h"
+
+#if SHADER_OP_COUNTS
+
+// vector uniforms are converted to counted vectors, scalar ones convert as they are used
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (Counted::vec3(ReadUniforms(c_uniformResolution).m_iResolution))
+#define iMouse              (Counted::vec4(ReadUniforms(c_uniformMouse).m_iMouse))
+#define iDate               (Counted::vec4(ReadUniforms(c_uniformDate).m_iDate))
+
+#define float SCountedFloat
+
+namespace Counted
+{
+#include "main.cpp"
+
+#if SHADER_BUFFER_A
+#include "bufferA.cpp"
+#endif
+#if SHADER_BUFFER_B
+#include "bufferB.cpp"
+#endif
+#if SHADER_BUFFER_C
+#include "bufferC.cpp"
+#endif
+#if SHADER_BUFFER_D
+#include "bufferD.cpp"
+#endif
+}
+
+#undef float
+
+#endif
@@ -0,0 +1,87 @@
+// Render kernels specialized for the frame sizes listed in Settings.h. For each one,
+// FixedKernel.inl compiles the shader in main.cpp again, for single pixels and for packets,
+// with iResolution (and with SHADER_FIXED_STILL_FRAME, iTime and iMouse) replaced by
+// constants, and instantiates the tile loops of RenderTile.h calling that copy directly.
+// The compiler can then inline the shader into the loops, fold fragCoord / iResolution.xy
+// and the like, and drop the branches the constants decide. Whole tiles are also looped
+// over with compile time bounds.
+//
+// SubmitTiles() asks FindFixedKernel() for a kernel whose constants match the frame's
+// uniforms and uses the generic kernel when there is none. Both shade the same pixels.
+
+#include "RenderTile.h"
+#include "Settings.h"
+
+#ifdef SHADER_FIXED_SIZE_0
+#define FIXED_KERNEL FixedSize0
+#define FIXED_KERNEL_SIZE SHADER_FIXED_SIZE_0
+#include "FixedKernel.inl"
+#undef FIXED_KERNEL
+#undef FIXED_KERNEL_SIZE
+#endif
+
+#ifdef SHADER_FIXED_SIZE_1
+#define FIXED_KERNEL FixedSize1
+#define FIXED_KERNEL_SIZE SHADER_FIXED_SIZE_1
+#include "FixedKernel.inl"
+#undef FIXED_KERNEL
+#undef FIXED_KERNEL_SIZE
+#endif
+
+#ifdef SHADER_FIXED_SIZE_2
+#define FIXED_KERNEL FixedSize2
+#define FIXED_KERNEL_SIZE SHADER_FIXED_SIZE_2
+#include "FixedKernel.inl"
+#undef FIXED_KERNEL
+#undef FIXED_KERNEL_SIZE
+#endif
+
+#ifdef SHADER_FIXED_SIZE_3
+#define FIXED_KERNEL FixedSize3
+#define FIXED_KERNEL_SIZE SHADER_FIXED_SIZE_3
+#include "FixedKernel.inl"
+#undef FIXED_KERNEL
+#undef FIXED_KERNEL_SIZE
+#endif
+
+//-------------------------------------------------------------------------------------
+static bool FixedKernelMatches (const SFixedKernel& kernel, const SRenderContext& context)
+{
+	if (context.m_iResolution.x != float(kernel.m_width) || context.m_iResolution.y != float(kernel.m_height) || context.m_iResolution.z != 1.0f)
+		return false;
+
+#if SHADER_FIXED_STILL_FRAME
+	if (context.m_iGlobalTime != c_timeSeconds || any(notEqual(context.m_iMouse, vec4(0.0f))))
+		return false;
+#endif
+
+	return true;
+}
+
+//-------------------------------------------------------------------------------------
+const SFixedKernel* FindFixedKernel (const SRenderContext& context)
+{
+	static const SFixedKernel* const s_kernels[] =
+	{
+#ifdef SHADER_FIXED_SIZE_0
+		&FixedSize0::c_kernel,
+#endif
+#ifdef SHADER_FIXED_SIZE_1
+		&FixedSize1::c_kernel,
+#endif
+#ifdef SHADER_FIXED_SIZE_2
+		&FixedSize2::c_kernel,
+#endif
+#ifdef SHADER_FIXED_SIZE_3
+		&FixedSize3::c_kernel,
+#endif
+		nullptr
+	};
+
+	for (const SFixedKernel* const* kernel = s_kernels; *kernel; ++kernel)
+	{
+		if (FixedKernelMatches(**kernel, context))
+			return *kernel;
+	}
+	return nullptr;
+}
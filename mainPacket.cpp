@@ -0,0 +1,38 @@
+// Compiles the shader in main.cpp (and any buffer passes) a second time for packet
+// execution: float stands for SFloatPacket and vec2/vec3/vec4 resolve to the Packet::
+// structure-of-arrays vectors, so the unchanged shader source shades GLSL_PACKET_WIDTH
+// pixels per call. See glslPacket.h.
+
+#include "glslPacket.h"
+#include "Settings.h"
+
+// vector uniforms are broadcast to every lane, scalar ones stay scalar and get
+// broadcast when they meet per-lane values
+#undef iResolution
+#undef iMouse
+#undef iDate
+#define iResolution         (Packet::vec3(ReadUniforms(c_uniformResolution).m_iResolution))
+#define iMouse              (Packet::vec4(ReadUniforms(c_uniformMouse).m_iMouse))
+#define iDate               (Packet::vec4(ReadUniforms(c_uniformDate).m_iDate))
+
+#define float SFloatPacket
+
+namespace Packet
+{
+#include "main.cpp"
+
+#if SHADER_BUFFER_A
+#include "bufferA.cpp"
+#endif
+#if SHADER_BUFFER_B
+#include "bufferB.cpp"
+#endif
+#if SHADER_BUFFER_C
+#include "bufferC.cpp"
+#endif
+#if SHADER_BUFFER_D
+#include "bufferD.cpp"
+#endif
+}
+
+#undef float
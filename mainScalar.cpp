@@ -0,0 +1,26 @@
+// Compiles the shader in main.cpp (and any buffer passes) for one pixel per mainImage()
+// call, inside namespace Scalar. Its overloads of sin, pow etc hide the C library's, so
+// shader code follows the precision tier picked in glslMath.h. main.cpp and the buffer
+// sources aren't compiled on their own; mainPacket.cpp compiles them again for packets,
+// and mainCounted.cpp to count ops.
+
+#include "glslAdapters.h"
+#include "Settings.h"
+
+namespace Scalar
+{
+#include "main.cpp"
+
+#if SHADER_BUFFER_A
+#include "bufferA.cpp"
+#endif
+#if SHADER_BUFFER_B
+#include "bufferB.cpp"
+#endif
+#if SHADER_BUFFER_C
+#include "bufferC.cpp"
+#endif
+#if SHADER_BUFFER_D
+#include "bufferD.cpp"
+#endif
+}